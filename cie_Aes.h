@@ -0,0 +1,49 @@
+/**************************************************************************/
+/*!
+    @file     cie_Aes.h
+    @author   Developers Italia
+	@license  BSD (see License)
+
+	Definition of the cie_Aes class, the AES-128 block cipher (FIPS 197) used by PACE and by the secure
+	messaging that follows it. The round keys are expanded once in setKey() and kept.
+	On AVR the S-boxes live in flash
+
+	@section  HISTORY
+
+	v1.0  - First definition of the class
+
+*/
+/**************************************************************************/
+#ifndef CIE_AES
+#define CIE_AES
+#include <Arduino.h>
+
+#if defined(__AVR__)
+  #include <avr/pgmspace.h>
+  #define AES_CONSTANTS                       PROGMEM
+  #define AES_CONSTANT(table, index)          (pgm_read_byte(&(table)[index]))
+#else
+  #define AES_CONSTANTS
+  #define AES_CONSTANT(table, index)          ((table)[index])
+#endif
+
+#define AES_BLOCK_LENGTH                      (0x10)
+#define AES_KEY_LENGTH                        (0x10)
+#define AES_ROUNDS                            (0x0A)
+
+class cie_Aes {
+  public:
+    cie_Aes();
+    ~cie_Aes();
+    void setKey(const byte *key);
+    void encryptBlock(byte *block);
+    void decryptBlock(byte *block);
+    void clear();
+
+  private:
+    void addRoundKey(byte *block, const byte round);
+
+    byte _roundKeys[(AES_ROUNDS + 1) * AES_BLOCK_LENGTH];
+};
+
+#endif
@@ -0,0 +1,179 @@
+/**************************************************************************/
+/*!
+    @file     cie_AesSecureMessaging.cpp
+    @author   Developers Italia
+    @license  BSD (see License)
+
+	Implementation of the cie_AesSecureMessaging class
+	See F.2 Secure messaging in BSI TR-03110 part 3 and RFC 4493 for CMAC
+
+	@section  HISTORY
+
+	v1.0  - First implementation of the class
+*/
+/**************************************************************************/
+#include "cie_AesSecureMessaging.h"
+
+/**************************************************************************/
+/*!
+  @brief Wipes the keys
+*/
+/**************************************************************************/
+cie_AesSecureMessaging::~cie_AesSecureMessaging() {
+  end();
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Expands the round keys and computes the CMAC subkeys without starting the session
+
+  @param encKey The pointer to the SM_KEY_LENGTH bytes encryption key
+  @param macKey The pointer to the SM_KEY_LENGTH bytes MAC key
+*/
+/**************************************************************************/
+void cie_AesSecureMessaging::setKeys(const byte *encKey, const byte *macKey) {
+  _enc.setKey(encKey);
+  _mac.setKey(macKey);
+  //K1 doubles the encryption of the null block, K2 doubles K1
+  memset(_k1, 0, AES_BLOCK_LENGTH);
+  _mac.encryptBlock(_k1);
+  doubleSubkey(_k1);
+  memcpy(_k2, _k1, AES_BLOCK_LENGTH);
+  doubleSubkey(_k2);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Gets the block length of AES, which is also the length of the send sequence counter
+
+  @returns AES_BLOCK_LENGTH
+*/
+/**************************************************************************/
+byte cie_AesSecureMessaging::getBlockLength() {
+  return AES_BLOCK_LENGTH;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Computes the full CMAC of data which isn't padded beforehand, e.g. the PACE authentication tokens
+
+  @param data The pointer to the data
+  @param length The length of the data
+  @param cmac The pointer to the AES_BLOCK_LENGTH bytes CMAC
+*/
+/**************************************************************************/
+void cie_AesSecureMessaging::computeCmac(const byte *data, const word length, byte *cmac) {
+  memset(cmac, 0, AES_BLOCK_LENGTH);
+  word offset = 0;
+  while (length - offset > AES_BLOCK_LENGTH) {
+    for (byte i = 0; i < AES_BLOCK_LENGTH; i++) {
+      cmac[i] ^= data[offset++];
+    }
+    _mac.encryptBlock(cmac);
+  }
+  //A whole last block takes K1, an incomplete one is padded and takes K2
+  byte remaining = (byte) (length - offset);
+  const byte *subkey = remaining == AES_BLOCK_LENGTH ? _k1 : _k2;
+  for (byte i = 0; i < AES_BLOCK_LENGTH; i++) {
+    byte value = i < remaining ? data[offset + i] : (i == remaining ? SM_PADDING_START : 0x00);
+    cmac[i] ^= value ^ subkey[i];
+  }
+  _mac.encryptBlock(cmac);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Encrypts a block with AES
+
+  @param block The pointer to the AES_BLOCK_LENGTH bytes block
+*/
+/**************************************************************************/
+void cie_AesSecureMessaging::encryptBlock(byte *block) {
+  _enc.encryptBlock(block);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Decrypts a block with AES
+
+  @param block The pointer to the AES_BLOCK_LENGTH bytes block
+*/
+/**************************************************************************/
+void cie_AesSecureMessaging::decryptBlock(byte *block) {
+  _enc.decryptBlock(block);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Chains a block of the CMAC
+
+  @param block The pointer to the AES_BLOCK_LENGTH bytes MAC state
+*/
+/**************************************************************************/
+void cie_AesSecureMessaging::macBlock(byte *block) {
+  _mac.encryptBlock(block);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Ends the CMAC: secure messaging pads the data beforehand, so the last block is always whole and takes K1
+
+  @param block The pointer to the AES_BLOCK_LENGTH bytes MAC state
+*/
+/**************************************************************************/
+void cie_AesSecureMessaging::macLastBlock(byte *block) {
+  for (byte i = 0; i < AES_BLOCK_LENGTH; i++) {
+    block[i] ^= _k1[i];
+  }
+  _mac.encryptBlock(block);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Gets the initialization vector of the cryptograms, the send sequence counter encrypted with the encryption key
+
+  @param iv The pointer to the AES_BLOCK_LENGTH bytes initialization vector
+*/
+/**************************************************************************/
+void cie_AesSecureMessaging::initialVector(byte *iv) {
+  memcpy(iv, _ssc, AES_BLOCK_LENGTH);
+  _enc.encryptBlock(iv);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Wipes the round keys and the CMAC subkeys
+*/
+/**************************************************************************/
+void cie_AesSecureMessaging::clearKeys() {
+  _enc.clear();
+  _mac.clear();
+  memset(_k1, 0, AES_BLOCK_LENGTH);
+  memset(_k2, 0, AES_BLOCK_LENGTH);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Doubles a CMAC subkey in GF(2^128)
+
+  @param subkey The pointer to the AES_BLOCK_LENGTH bytes subkey
+*/
+/**************************************************************************/
+void cie_AesSecureMessaging::doubleSubkey(byte *subkey) {
+  byte carry = subkey[0] >> 7;
+  for (byte i = 0; i < AES_BLOCK_LENGTH - 1; i++) {
+    subkey[i] = (byte) ((subkey[i] << 1) | (subkey[i + 1] >> 7));
+  }
+  //Constant time: the mask is all ones when the top bit was set
+  subkey[AES_BLOCK_LENGTH - 1] = (byte) ((subkey[AES_BLOCK_LENGTH - 1] << 1) ^ ((byte) -carry & AES_CMAC_RB));
+}
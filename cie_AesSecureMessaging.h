@@ -0,0 +1,49 @@
+/**************************************************************************/
+/*!
+    @file     cie_AesSecureMessaging.h
+    @author   Developers Italia
+	@license  BSD (see License)
+
+	Definition of the cie_AesSecureMessaging class, the secure messaging established by PACE (BSI TR-03110):
+	AES-128 encryption with the encrypted send sequence counter as initialization vector and CMAC
+	truncated to SM_MAC_LENGTH bytes. Round keys and CMAC subkeys are computed once per session
+
+	@section  HISTORY
+
+	v1.0  - First definition of the class
+
+*/
+/**************************************************************************/
+#ifndef CIE_AES_SECURE_MESSAGING
+#define CIE_AES_SECURE_MESSAGING
+#include "cie_SecureMessaging.h"
+#include "cie_Aes.h"
+
+//The last byte of the CMAC subkeys gets this when the doubling overflows
+#define AES_CMAC_RB                           (0x87)
+
+class cie_AesSecureMessaging : public cie_SecureMessaging {
+  public:
+    ~cie_AesSecureMessaging();
+    void setKeys(const byte *encKey, const byte *macKey);
+    byte getBlockLength();
+    void computeCmac(const byte *data, const word length, byte *cmac);
+
+  protected:
+    void encryptBlock(byte *block);
+    void decryptBlock(byte *block);
+    void macBlock(byte *block);
+    void macLastBlock(byte *block);
+    void initialVector(byte *iv);
+    void clearKeys();
+
+  private:
+    static void doubleSubkey(byte *subkey);
+
+    cie_Aes _enc;
+    cie_Aes _mac;
+    byte _k1[AES_BLOCK_LENGTH];
+    byte _k2[AES_BLOCK_LENGTH];
+};
+
+#endif
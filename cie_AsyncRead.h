@@ -0,0 +1,30 @@
+/**************************************************************************/
+/*!
+    @file     cie_AsyncRead.h
+    @author   Developers Italia
+	@license  BSD (see License)
+
+	Definition of the cie_AsyncRead structure holding the state of a non-blocking Elementary File read
+
+	@section  HISTORY
+
+	v1.0  - First definition of the structure
+
+*/
+/**************************************************************************/
+#ifndef CIE_ASYNC_READ
+#define CIE_ASYNC_READ
+#include <Arduino.h>
+#include "cie_EFPath.h"
+
+struct cie_AsyncRead {
+    cie_EFPath filePath;
+    byte *contentBuffer;
+    word *contentLength;
+    word capacity;
+    word offset;
+    byte lengthStrategy;
+    byte step;
+};
+
+#endif
@@ -9,6 +9,9 @@
 
 	@section  HISTORY
 
+	v1.3  - Bounded stack and heap: no variable length array for OIDs, no allocation for length octets
+	v1.2  - Encapsulated subjectKeyIdentifier, public keys only in BIT STRINGs
+	v1.1  - Read-ahead window: octets are fetched a window at a time while parsing
 	v1.0  - Reading of fragments and binary values
 */
 /**************************************************************************/
@@ -19,8 +22,22 @@
 
 cie_BerReader::cie_BerReader (cie_PN532 *cie) :
 _cie(cie),
-_currentOffset(0)
+_currentOffset(0),
+_windowOffset(0),
+_windowLength(0),
+_fileLength(0)
 {   
+  _window = new byte[BER_READER_WINDOW_LENGTH];
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Frees resources
+*/
+/**************************************************************************/
+cie_BerReader::~cie_BerReader() {
+  delete [] _window;
 }
 
 
@@ -37,6 +54,10 @@ _currentOffset(0)
 /**************************************************************************/
 bool cie_BerReader::readTriples(const cie_EFPath filePath, cieBerTripleCallbackFunc callback, word *length, const byte maxDepth) {
   resetCursor();
+  //The window is valid only while parsing: the card might have changed since
+  _filePath = filePath;
+  _windowLength = 0;
+  _fileLength = 0;
   if (maxDepth < 1) {
     PN532DEBUGPRINT.println(F("Warning: you choose a maxDepth of 0 which won't read any triple"));
     return true;
@@ -45,9 +66,10 @@ bool cie_BerReader::readTriples(const cie_EFPath filePath, cieBerTripleCallbackF
   byte currentDepth = 1;
   byte triplesCount = 0;
   cie_BerTriple *tripleStack = new cie_BerTriple[maxDepth];
-  bool willEncapsulate = false; 
+  //Type of the BIT STRING or OCTET STRING expected to encapsulate other triples, 0x00 if none
+  unsigned int encapsulatingType = 0x00;
 
-  byte oid_subjectKeyIdentifier[] = {0x67, 0x81, 0x08, 0x01, 0x01, 0x01}; //2.5.29.14 
+  byte oid_subjectKeyIdentifier[] = {0x55, 0x1D, 0x0E}; //2.5.29.14
   byte oid_keyUsage[] = {0x55, 0x1D, 0x0F}; //2.5.29.15
   byte oid_authorityKeyIdentifier[] = {0x55, 0x1D, 0x23}; //2.5.29.35
   byte oid_rsaEncryption[] = {0x2A, 0x86, 0x48, 0x86, 0xF7, 0x0D, 0x01, 0x01, 0x01}; //1.2.840.113549.1.1.1
@@ -62,29 +84,38 @@ bool cie_BerReader::readTriples(const cie_EFPath filePath, cieBerTripleCallbackF
     }
     if (*length == 0) {
       *length = tripleLength;
+      _fileLength = tripleLength;
     }
     tripleStack[currentDepth-1].depth = currentDepth;
 
-    byte isBinaryString = tripleStack[currentDepth-1].type == 0x03 || tripleStack[currentDepth-1].type == 0x04;
-    bool isObjectIdentifier = tripleStack[currentDepth-1].type == 0x06;
+    bool isUniversal = tripleStack[currentDepth-1].classification == 0x00;
+    byte isBinaryString = isUniversal && (tripleStack[currentDepth-1].type == 0x03 || tripleStack[currentDepth-1].type == 0x04);
+    bool isObjectIdentifier = isUniversal && tripleStack[currentDepth-1].type == 0x06;
     //Some OCTET STRINGS and BIT STRING might be encapsulating other ASN.1 triples
     //Find them by their preceding Object Identifier
-    if (isObjectIdentifier)
+    if (isObjectIdentifier && tripleStack[currentDepth-1].contentLength > OID_MAX_LENGTH)
+    {
+      //Longer than any OID looked for: the card decides the length, it mustn't decide the stack usage too
+      encapsulatingType = 0x00;
+    }
+    else if (isObjectIdentifier)
     {
-      byte oid[tripleStack[currentDepth-1].contentLength]; 
-      _cie->readBinaryContent(filePath, oid, tripleStack[currentDepth-1].contentOffset, tripleStack[currentDepth-1].contentLength);
+      byte oid[OID_MAX_LENGTH];
+      fetchOctets(filePath, oid, tripleStack[currentDepth-1].contentOffset, tripleStack[currentDepth-1].contentLength);
 
       if (areEqual(oid, tripleStack[currentDepth-1].contentLength, oid_subjectKeyIdentifier, sizeof(oid_subjectKeyIdentifier)) ||
           areEqual(oid, tripleStack[currentDepth-1].contentLength, oid_keyUsage, sizeof(oid_keyUsage)) || 
           areEqual(oid, tripleStack[currentDepth-1].contentLength, oid_authorityKeyIdentifier, sizeof(oid_authorityKeyIdentifier)) || 
-          areEqual(oid, tripleStack[currentDepth-1].contentLength, oid_rsaEncryption, sizeof(oid_rsaEncryption)) || 
           (areEqual(oid, tripleStack[currentDepth-1].contentLength, oid_mRTDSignatureData, sizeof(oid_mRTDSignatureData)) && (currentDepth+1<=maxDepth))) {
-        willEncapsulate = true;
+        encapsulatingType = 0x04;
+      } else if (areEqual(oid, tripleStack[currentDepth-1].contentLength, oid_rsaEncryption, sizeof(oid_rsaEncryption))) {
+        //The public key is in a BIT STRING, while a signature following this OID in a SignerInfo is just an OCTET STRING
+        encapsulatingType = 0x03;
       } else {
-        willEncapsulate = false;
+        encapsulatingType = 0x00;
       }
-    } else if (isBinaryString && willEncapsulate) {
-      willEncapsulate = false;
+    } else if (isBinaryString && tripleStack[currentDepth-1].type == encapsulatingType) {
+      encapsulatingType = 0x00;
       tripleStack[currentDepth-1].encoding = 0x01;
     }
 
@@ -157,6 +188,7 @@ bool cie_BerReader::readTriples(const cie_EFPath filePath, cieBerTripleCallbackF
   } while(_currentOffset < *length);
 
   delete [] tripleStack;
+  _windowLength = 0;
   return result;
 }
 
@@ -188,18 +220,17 @@ bool cie_BerReader::readTriple(const cie_EFPath filePath, cie_BerTriple *triple,
 
 /**************************************************************************/
 /*!
-  @brief Reads the binary content of a triple into the buffer
+  @brief Reads the binary content of a triple into the buffer, e.g. from the callback passed to readTriples().
+         It doesn't move the cursor, so parsing goes on from where it was
   
   @param triple The triple to be read
-  @param buffer The pointer to the buffer where the binary content will be written to
+  @param buffer The pointer to the buffer where the binary content will be written to (contentLength bytes)
 
   @returns  A value indicating whether the operation succeeded or not
 */
 /**************************************************************************/
 bool cie_BerReader::readTripleValue(const cie_BerTriple triple, byte *buffer) {
-  resetCursor();
-  //TODO leggi valore
-  return true;
+  return fetchOctets(_filePath, buffer, triple.contentOffset, triple.contentLength);
 }
 
 
@@ -235,18 +266,23 @@ bool cie_BerReader::detectLength(const cie_EFPath filePath, word *contentOffset,
         PN532DEBUGPRINT.println(F("Invalid value for a BER encoded file length"));
         return false;
       }
+      if (*lengthOctets > sizeof(word)) {
+        PN532DEBUGPRINT.println(F("Sorry, we don't support lengths of more than 2 octets"));
+        return false;
+      }
       *contentLength = 0;
-      byte *buffer = new byte[*lengthOctets];
-      readOctets(filePath, buffer, *lengthOctets);
       //The following octets encode, as big-endian, the length (which may be 0) as a number of octets.
       for (byte i = 0; i < *lengthOctets; i++)
       {
+        byte octet;
+        if (!readOctet(filePath, &octet)) {
+          return false;
+        }
         *contentLength <<= 8;
-        *contentLength |= buffer[i];
+        *contentLength |= octet;
       }
       //Don't forget to add the first length octet
       *lengthOctets+=1;
-      delete [] buffer;
   } else  {
       //Definite, short
       *contentLength = *lengthOctets;
@@ -330,7 +366,7 @@ bool cie_BerReader::detectTag (const cie_EFPath filePath, byte *classification,
 */
 /**************************************************************************/
 bool cie_BerReader::readOctets(const cie_EFPath filePath, byte *buffer, const word offset, const word length) {
-  if (!_cie->readBinaryContent(filePath, buffer, offset, length)) {
+  if (!fetchOctets(filePath, buffer, offset, length)) {
     return false;
   }
   _currentOffset = offset+length;
@@ -338,6 +374,45 @@ bool cie_BerReader::readOctets(const cie_EFPath filePath, byte *buffer, const wo
 }
 
 
+/**************************************************************************/
+/*!
+  @brief Reads bytes from the read-ahead window, refilling it with a single READ BINARY when they're not there
+  
+  @param filePath a structure indicating the parent Dedicated File (either ROOT_MF or CIE_DF), the selection mode (either SELECT_BY_EFID or SELECT_BY_SFI) and the file identifier (either a sfi or an efid)	
+  @param buffer The pointer to the buffer which will contain the octets
+  @param offset The offset from which we should read
+  @param length The number of bytes to read
+
+  @returns  A value indicating whether the operation succeeded or not
+*/
+/**************************************************************************/
+bool cie_BerReader::fetchOctets(const cie_EFPath filePath, byte *buffer, const word offset, const word length) {
+  if (offset >= _windowOffset && offset + length <= _windowOffset + _windowLength) {
+    memcpy(buffer, _window + (offset - _windowOffset), length);
+    return true;
+  }
+  if (length > BER_READER_WINDOW_LENGTH) {
+    return _cie->readBinaryContent(filePath, buffer, offset, length);
+  }
+  //Don't read past the end of the file: until its length is known, just read its first tag and length octets
+  word windowLength = BER_READER_WINDOW_LENGTH;
+  if (_fileLength == 0 && length <= BER_HEADER_LENGTH) {
+    windowLength = BER_HEADER_LENGTH;
+  } else if (_fileLength > 0 && offset + windowLength > _fileLength) {
+    windowLength = offset + length < _fileLength ? _fileLength - offset : length;
+  }
+  _windowLength = 0;
+  if (!_cie->readBinaryContent(filePath, _window, offset, windowLength)) {
+    //The file might be shorter than the window
+    return windowLength > length && _cie->readBinaryContent(filePath, buffer, offset, length);
+  }
+  _windowOffset = offset;
+  _windowLength = windowLength;
+  memcpy(buffer, _window, length);
+  return true;
+}
+
+
 /**************************************************************************/
 /*!
   @brief Reads bytes from the file
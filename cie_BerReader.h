@@ -9,6 +9,7 @@
 	
 	@section  HISTORY
 
+	v1.1  - Read-ahead window, reading of triple values
 	v1.0  - First definition
 	
 */
@@ -27,23 +28,36 @@ class cie_PN532;
 #define BER_READER_MAX_OFFSET   (2048)
 #define BER_READER_MAX_LENGTH   (2048)
 #define BER_READER_MAX_COUNT    (200)
+//Octets fetched with each READ BINARY while parsing, instead of one at a time
+#if defined(__AVR__)
+  #define BER_READER_WINDOW_LENGTH (0x40)
+#else
+  #define BER_READER_WINDOW_LENGTH (0xE4)
+#endif
 
 
 class cie_BerReader
 {
   public:
     cie_BerReader(cie_PN532 *cie);
+    ~cie_BerReader();
     bool readTriples(const cie_EFPath filePath, cieBerTripleCallbackFunc callback, word *length, const byte maxDepth);
+    bool readTripleValue(const cie_BerTriple triple, byte *buffer);
     
   private:
     cie_PN532 *_cie;
     word _currentOffset;
+    cie_EFPath _filePath;
+    byte *_window;
+    word _windowOffset;
+    word _windowLength;
+    word _fileLength;
     void resetCursor();
     bool areEqual(byte *buffer1, byte length1, byte *buffer2, byte length2);
     void readBinaryContent(const cie_EFPath filePath, const word offset, const word length);
 
     bool readTriple(const cie_EFPath filePath, cie_BerTriple *triple, word *length);
-    bool readTripleValue(const cie_BerTriple triple, byte *buffer);
+    bool fetchOctets(const cie_EFPath filePath, byte *buffer, const word offset, const word length);
     bool detectLength(const cie_EFPath filePath, word *contentOffset, word *contentLength, byte *lengthOctets);
     bool detectTag (const cie_EFPath filePath, byte *classification, byte *encoding, unsigned int *type, byte *tagOctets);
     bool readOctets(const cie_EFPath filePath, byte *buffer, const word offset, const word length);
@@ -0,0 +1,47 @@
+/**************************************************************************/
+/*!
+    @file     cie_Cycles.h
+    @author   Developers Italia
+	@license  BSD (see License)
+
+	A CPU cycle counter to measure how long an operation takes on each board:
+	the DWT cycle counter on Cortex-M3 and newer, the CCOUNT register on ESP8266 and ESP32,
+	the time stamp counter on x86 hosts and micros() scaled by the clock frequency elsewhere
+
+	@section  HISTORY
+
+	v1.0  - First definition
+
+*/
+/**************************************************************************/
+#ifndef CIE_CYCLES
+#define CIE_CYCLES
+#include <Arduino.h>
+
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__)
+  #define CIE_DEMCR                           (*(volatile uint32_t *) 0xE000EDFC)
+  #define CIE_DWT_CTRL                        (*(volatile uint32_t *) 0xE0001000)
+  #define CIE_DWT_CYCCNT                      (*(volatile uint32_t *) 0xE0001004)
+#endif
+
+inline unsigned long cie_cycles() {
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__)
+  if ((CIE_DWT_CTRL & 0x01) == 0) {
+    //Enable the trace unit, then the cycle counter
+    CIE_DEMCR |= 0x01000000;
+    CIE_DWT_CYCCNT = 0;
+    CIE_DWT_CTRL |= 0x01;
+  }
+  return CIE_DWT_CYCCNT;
+#elif defined(ESP8266) || defined(ESP32)
+  return ESP.getCycleCount();
+#elif (defined(__x86_64__) || defined(__i386__)) && !defined(ARDUINO)
+  return (unsigned long) __builtin_ia32_rdtsc();
+#elif defined(F_CPU)
+  return micros() * (F_CPU / 1000000L);
+#else
+  return micros();
+#endif
+}
+
+#endif
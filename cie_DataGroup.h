@@ -0,0 +1,46 @@
+/**************************************************************************/
+/*!
+    @file     cie_DataGroup.h
+    @author   Developers Italia
+	@license  BSD (see License)
+
+	Definition of the cie_DataGroup structure mapping a data group listed in the EF_SOD to the Elementary File it hashes,
+	and of the cie_SodCheck structure holding the state of a passive authentication while the EF_SOD is parsed
+
+	@section  HISTORY
+
+	v1.1  - The data groups verified are tracked one by one, each file has its own length strategy
+	v1.0  - First definition of the structures
+
+*/
+/**************************************************************************/
+#ifndef CIE_DATA_GROUP
+#define CIE_DATA_GROUP
+#include <Arduino.h>
+#include "cie_EFPath.h"
+#include "cie_Hash.h"
+
+//Data groups a passive authentication can check at once, one bit each in cie_SodCheck::verifiedDataGroups
+#define SOD_MAX_DATA_GROUPS                   (0x10)
+
+struct cie_DataGroup {
+    word number;
+    cie_EFPath filePath;
+    //The length of the file if lengthStrategy is FIXED_LENGTH
+    word length;
+    byte lengthStrategy;
+};
+
+struct cie_SodCheck {
+    const cie_DataGroup *dataGroups;
+    byte dataGroupCount;
+    bool afterSignatureDataOid;
+    word ldsEnd;
+    byte ldsDepth;
+    cie_Hash *hash;
+    word dataGroup;
+    word verifiedDataGroups;
+    bool failed;
+};
+
+#endif
@@ -0,0 +1,313 @@
+/**************************************************************************/
+/*!
+    @file     cie_Des.cpp
+    @author   Developers Italia
+    @license  BSD (see License)
+
+	Implementation of the cie_Des class. The rounds combine each S-box with the P permutation in a single
+	table lookup, and the subkeys are stored already split in the 6 bits groups the lookups need
+
+	@section  HISTORY
+
+	v1.0  - First implementation of the class
+*/
+/**************************************************************************/
+#include "cie_Des.h"
+
+//S-boxes followed by the P permutation, in a frame rotated left by one bit
+static const uint32_t DES_SP1[64] DES_CONSTANTS = {
+  0x01010400, 0x00000000, 0x00010000, 0x01010404, 0x01010004, 0x00010404, 0x00000004, 0x00010000,
+  0x00000400, 0x01010400, 0x01010404, 0x00000400, 0x01000404, 0x01010004, 0x01000000, 0x00000004,
+  0x00000404, 0x01000400, 0x01000400, 0x00010400, 0x00010400, 0x01010000, 0x01010000, 0x01000404,
+  0x00010004, 0x01000004, 0x01000004, 0x00010004, 0x00000000, 0x00000404, 0x00010404, 0x01000000,
+  0x00010000, 0x01010404, 0x00000004, 0x01010000, 0x01010400, 0x01000000, 0x01000000, 0x00000400,
+  0x01010004, 0x00010000, 0x00010400, 0x01000004, 0x00000400, 0x00000004, 0x01000404, 0x00010404,
+  0x01010404, 0x00010004, 0x01010000, 0x01000404, 0x01000004, 0x00000404, 0x00010404, 0x01010400,
+  0x00000404, 0x01000400, 0x01000400, 0x00000000, 0x00010004, 0x00010400, 0x00000000, 0x01010004
+};
+static const uint32_t DES_SP2[64] DES_CONSTANTS = {
+  0x80108020, 0x80008000, 0x00008000, 0x00108020, 0x00100000, 0x00000020, 0x80100020, 0x80008020,
+  0x80000020, 0x80108020, 0x80108000, 0x80000000, 0x80008000, 0x00100000, 0x00000020, 0x80100020,
+  0x00108000, 0x00100020, 0x80008020, 0x00000000, 0x80000000, 0x00008000, 0x00108020, 0x80100000,
+  0x00100020, 0x80000020, 0x00000000, 0x00108000, 0x00008020, 0x80108000, 0x80100000, 0x00008020,
+  0x00000000, 0x00108020, 0x80100020, 0x00100000, 0x80008020, 0x80100000, 0x80108000, 0x00008000,
+  0x80100000, 0x80008000, 0x00000020, 0x80108020, 0x00108020, 0x00000020, 0x00008000, 0x80000000,
+  0x00008020, 0x80108000, 0x00100000, 0x80000020, 0x00100020, 0x80008020, 0x80000020, 0x00100020,
+  0x00108000, 0x00000000, 0x80008000, 0x00008020, 0x80000000, 0x80100020, 0x80108020, 0x00108000
+};
+static const uint32_t DES_SP3[64] DES_CONSTANTS = {
+  0x00000208, 0x08020200, 0x00000000, 0x08020008, 0x08000200, 0x00000000, 0x00020208, 0x08000200,
+  0x00020008, 0x08000008, 0x08000008, 0x00020000, 0x08020208, 0x00020008, 0x08020000, 0x00000208,
+  0x08000000, 0x00000008, 0x08020200, 0x00000200, 0x00020200, 0x08020000, 0x08020008, 0x00020208,
+  0x08000208, 0x00020200, 0x00020000, 0x08000208, 0x00000008, 0x08020208, 0x00000200, 0x08000000,
+  0x08020200, 0x08000000, 0x00020008, 0x00000208, 0x00020000, 0x08020200, 0x08000200, 0x00000000,
+  0x00000200, 0x00020008, 0x08020208, 0x08000200, 0x08000008, 0x00000200, 0x00000000, 0x08020008,
+  0x08000208, 0x00020000, 0x08000000, 0x08020208, 0x00000008, 0x00020208, 0x00020200, 0x08000008,
+  0x08020000, 0x08000208, 0x00000208, 0x08020000, 0x00020208, 0x00000008, 0x08020008, 0x00020200
+};
+static const uint32_t DES_SP4[64] DES_CONSTANTS = {
+  0x00802001, 0x00002081, 0x00002081, 0x00000080, 0x00802080, 0x00800081, 0x00800001, 0x00002001,
+  0x00000000, 0x00802000, 0x00802000, 0x00802081, 0x00000081, 0x00000000, 0x00800080, 0x00800001,
+  0x00000001, 0x00002000, 0x00800000, 0x00802001, 0x00000080, 0x00800000, 0x00002001, 0x00002080,
+  0x00800081, 0x00000001, 0x00002080, 0x00800080, 0x00002000, 0x00802080, 0x00802081, 0x00000081,
+  0x00800080, 0x00800001, 0x00802000, 0x00802081, 0x00000081, 0x00000000, 0x00000000, 0x00802000,
+  0x00002080, 0x00800080, 0x00800081, 0x00000001, 0x00802001, 0x00002081, 0x00002081, 0x00000080,
+  0x00802081, 0x00000081, 0x00000001, 0x00002000, 0x00800001, 0x00002001, 0x00802080, 0x00800081,
+  0x00002001, 0x00002080, 0x00800000, 0x00802001, 0x00000080, 0x00800000, 0x00002000, 0x00802080
+};
+static const uint32_t DES_SP5[64] DES_CONSTANTS = {
+  0x00000100, 0x02080100, 0x02080000, 0x42000100, 0x00080000, 0x00000100, 0x40000000, 0x02080000,
+  0x40080100, 0x00080000, 0x02000100, 0x40080100, 0x42000100, 0x42080000, 0x00080100, 0x40000000,
+  0x02000000, 0x40080000, 0x40080000, 0x00000000, 0x40000100, 0x42080100, 0x42080100, 0x02000100,
+  0x42080000, 0x40000100, 0x00000000, 0x42000000, 0x02080100, 0x02000000, 0x42000000, 0x00080100,
+  0x00080000, 0x42000100, 0x00000100, 0x02000000, 0x40000000, 0x02080000, 0x42000100, 0x40080100,
+  0x02000100, 0x40000000, 0x42080000, 0x02080100, 0x40080100, 0x00000100, 0x02000000, 0x42080000,
+  0x42080100, 0x00080100, 0x42000000, 0x42080100, 0x02080000, 0x00000000, 0x40080000, 0x42000000,
+  0x00080100, 0x02000100, 0x40000100, 0x00080000, 0x00000000, 0x40080000, 0x02080100, 0x40000100
+};
+static const uint32_t DES_SP6[64] DES_CONSTANTS = {
+  0x20000010, 0x20400000, 0x00004000, 0x20404010, 0x20400000, 0x00000010, 0x20404010, 0x00400000,
+  0x20004000, 0x00404010, 0x00400000, 0x20000010, 0x00400010, 0x20004000, 0x20000000, 0x00004010,
+  0x00000000, 0x00400010, 0x20004010, 0x00004000, 0x00404000, 0x20004010, 0x00000010, 0x20400010,
+  0x20400010, 0x00000000, 0x00404010, 0x20404000, 0x00004010, 0x00404000, 0x20404000, 0x20000000,
+  0x20004000, 0x00000010, 0x20400010, 0x00404000, 0x20404010, 0x00400000, 0x00004010, 0x20000010,
+  0x00400000, 0x20004000, 0x20000000, 0x00004010, 0x20000010, 0x20404010, 0x00404000, 0x20400000,
+  0x00404010, 0x20404000, 0x00000000, 0x20400010, 0x00000010, 0x00004000, 0x20400000, 0x00404010,
+  0x00004000, 0x00400010, 0x20004010, 0x00000000, 0x20404000, 0x20000000, 0x00400010, 0x20004010
+};
+static const uint32_t DES_SP7[64] DES_CONSTANTS = {
+  0x00200000, 0x04200002, 0x04000802, 0x00000000, 0x00000800, 0x04000802, 0x00200802, 0x04200800,
+  0x04200802, 0x00200000, 0x00000000, 0x04000002, 0x00000002, 0x04000000, 0x04200002, 0x00000802,
+  0x04000800, 0x00200802, 0x00200002, 0x04000800, 0x04000002, 0x04200000, 0x04200800, 0x00200002,
+  0x04200000, 0x00000800, 0x00000802, 0x04200802, 0x00200800, 0x00000002, 0x04000000, 0x00200800,
+  0x04000000, 0x00200800, 0x00200000, 0x04000802, 0x04000802, 0x04200002, 0x04200002, 0x00000002,
+  0x00200002, 0x04000000, 0x04000800, 0x00200000, 0x04200800, 0x00000802, 0x00200802, 0x04200800,
+  0x00000802, 0x04000002, 0x04200802, 0x04200000, 0x00200800, 0x00000000, 0x00000002, 0x04200802,
+  0x00000000, 0x00200802, 0x04200000, 0x00000800, 0x04000002, 0x04000800, 0x00000800, 0x00200002
+};
+static const uint32_t DES_SP8[64] DES_CONSTANTS = {
+  0x10001040, 0x00001000, 0x00040000, 0x10041040, 0x10000000, 0x10001040, 0x00000040, 0x10000000,
+  0x00040040, 0x10040000, 0x10041040, 0x00041000, 0x10041000, 0x00041040, 0x00001000, 0x00000040,
+  0x10040000, 0x10000040, 0x10001000, 0x00001040, 0x00041000, 0x00040040, 0x10040040, 0x10041000,
+  0x00001040, 0x00000000, 0x00000000, 0x10040040, 0x10000040, 0x10001000, 0x00041040, 0x00040000,
+  0x00041040, 0x00040000, 0x10041000, 0x00001000, 0x00000040, 0x10040040, 0x00001000, 0x00041040,
+  0x10001000, 0x00000040, 0x10000040, 0x10040000, 0x10040040, 0x10000000, 0x00040000, 0x10001040,
+  0x00000000, 0x10041040, 0x00040040, 0x10000040, 0x10040000, 0x10001000, 0x10001040, 0x00000000,
+  0x10041040, 0x00041000, 0x00041000, 0x00001040, 0x00001040, 0x00040040, 0x10000000, 0x10041000
+};
+//Permuted choice 1 and 2, rotations of the key halves
+static const byte DES_PC1[56] = {
+  56, 48, 40, 32, 24, 16,  8,  0, 57, 49, 41, 33, 25, 17,
+   9,  1, 58, 50, 42, 34, 26, 18, 10,  2, 59, 51, 43, 35,
+  62, 54, 46, 38, 30, 22, 14,  6, 61, 53, 45, 37, 29, 21,
+  13,  5, 60, 52, 44, 36, 28, 20, 12,  4, 27, 19, 11,  3
+};
+static const byte DES_PC2[48] = {
+  13, 16, 10, 23,  0,  4,  2, 27, 14,  5, 20,  9,
+  22, 18, 11,  3, 25,  7, 15,  6, 26, 19, 12,  1,
+  40, 51, 30, 36, 46, 54, 29, 39, 50, 44, 32, 47,
+  43, 48, 38, 55, 33, 52, 45, 41, 49, 35, 28, 31
+};
+static const byte DES_ROTATIONS[16] = { 1, 2, 4, 6, 8, 10, 12, 14, 15, 17, 19, 21, 23, 25, 27, 28 };
+
+#define DES_SWAP(a, b, shift, mask) \
+  work = (((a) >> (shift)) ^ (b)) & (mask); \
+  (b) ^= work; \
+  (a) ^= (work << (shift));
+#define DES_ROUND(target, source, subkeys) \
+  work = ((source) << 28 | (source) >> 4) ^ (subkeys)[0]; \
+  f = DES_CONSTANT(DES_SP7, work & 0x3F) | DES_CONSTANT(DES_SP5, (work >> 8) & 0x3F) \
+    | DES_CONSTANT(DES_SP3, (work >> 16) & 0x3F) | DES_CONSTANT(DES_SP1, (work >> 24) & 0x3F); \
+  work = (source) ^ (subkeys)[1]; \
+  f |= DES_CONSTANT(DES_SP8, work & 0x3F) | DES_CONSTANT(DES_SP6, (work >> 8) & 0x3F) \
+    | DES_CONSTANT(DES_SP4, (work >> 16) & 0x3F) | DES_CONSTANT(DES_SP2, (work >> 24) & 0x3F); \
+  (target) ^= f;
+
+/**************************************************************************/
+/*!
+  @brief Creates a cipher without a key, call setKey() before using it
+*/
+/**************************************************************************/
+cie_Des::cie_Des() :
+_triple(false)
+{
+  clear();
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Wipes the key schedule
+*/
+/**************************************************************************/
+cie_Des::~cie_Des() {
+  clear();
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Expands the key schedule, once for all the blocks that will follow
+
+  @param key The pointer to the key (parity bits are ignored)
+  @param keyLength Either DES_KEY_LENGTH (DES) or DES3_KEY_LENGTH (two keys 3DES EDE)
+*/
+/**************************************************************************/
+void cie_Des::setKey(const byte *key, const byte keyLength) {
+  _triple = keyLength == DES3_KEY_LENGTH;
+  expandKey(key, _schedule[0]);
+  if (_triple) {
+    expandKey(key + DES_KEY_LENGTH, _schedule[1]);
+  }
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Encrypts a block in place
+
+  @param block The pointer to the DES_BLOCK_LENGTH bytes block
+*/
+/**************************************************************************/
+void cie_Des::encryptBlock(byte *block) {
+  crypt(block, _schedule[0], false);
+  if (_triple) {
+    crypt(block, _schedule[1], true);
+    crypt(block, _schedule[0], false);
+  }
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Decrypts a block in place
+
+  @param block The pointer to the DES_BLOCK_LENGTH bytes block
+*/
+/**************************************************************************/
+void cie_Des::decryptBlock(byte *block) {
+  crypt(block, _schedule[0], true);
+  if (_triple) {
+    crypt(block, _schedule[1], false);
+    crypt(block, _schedule[0], true);
+  }
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Encrypts a block in place with single DES and the first key only,
+         as the retail MAC (ISO/IEC 9797-1 algorithm 3) does for all but its last block
+
+  @param block The pointer to the DES_BLOCK_LENGTH bytes block
+*/
+/**************************************************************************/
+void cie_Des::encryptBlockFirstKey(byte *block) {
+  crypt(block, _schedule[0], false);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Wipes the key schedule
+*/
+/**************************************************************************/
+void cie_Des::clear() {
+  memset(_schedule, 0, sizeof(_schedule));
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Computes the 16 subkeys of a DES key, already split in the 6 bits groups used by each S-box
+
+  @param key The pointer to the DES_KEY_LENGTH bytes key
+  @param schedule The pointer to the DES_SCHEDULE_LENGTH words of the schedule
+*/
+/**************************************************************************/
+void cie_Des::expandKey(const byte *key, uint32_t *schedule) {
+  byte permuted[56];
+  byte rotated[56];
+  for (byte i = 0; i < 56; i++) {
+    byte bit = DES_PC1[i];
+    permuted[i] = (key[bit >> 3] >> (7 - (bit & 7))) & 1;
+  }
+  for (byte round = 0; round < 16; round++) {
+    //Each half of 28 bits rotates on its own
+    for (byte i = 0; i < 56; i++) {
+      byte half = i < 28 ? 0 : 28;
+      byte bit = i - half + DES_ROTATIONS[round];
+      rotated[i] = permuted[half + (bit < 28 ? bit : bit - 28)];
+    }
+    uint32_t left = 0;
+    uint32_t right = 0;
+    for (byte i = 0; i < 24; i++) {
+      left |= (uint32_t) rotated[DES_PC2[i]] << (23 - i);
+      right |= (uint32_t) rotated[DES_PC2[i + 24]] << (23 - i);
+    }
+    //Groups for S-boxes 1, 3, 5, 7 in the first word and 2, 4, 6, 8 in the second
+    schedule[2 * round] = ((left & 0x00FC0000) << 6) | ((left & 0x00000FC0) << 10)
+                        | ((right & 0x00FC0000) >> 10) | ((right & 0x00000FC0) >> 6);
+    schedule[2 * round + 1] = ((left & 0x0003F000) << 12) | ((left & 0x0000003F) << 16)
+                            | ((right & 0x0003F000) >> 4) | (right & 0x0000003F);
+  }
+  memset(permuted, 0, sizeof(permuted));
+  memset(rotated, 0, sizeof(rotated));
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Runs the 16 rounds of DES on a block in place
+
+  @param block The pointer to the DES_BLOCK_LENGTH bytes block
+  @param schedule The key schedule
+  @param decrypt Whether to use the subkeys in reverse order
+*/
+/**************************************************************************/
+void cie_Des::crypt(byte *block, const uint32_t *schedule, const bool decrypt) {
+  uint32_t left = ((uint32_t) block[0] << 24) | ((uint32_t) block[1] << 16) | ((uint32_t) block[2] << 8) | block[3];
+  uint32_t right = ((uint32_t) block[4] << 24) | ((uint32_t) block[5] << 16) | ((uint32_t) block[6] << 8) | block[7];
+  uint32_t work;
+  uint32_t f;
+
+  //Initial permutation as a sequence of swaps, leaving both halves rotated left by one bit
+  DES_SWAP(left, right, 4, 0x0F0F0F0F);
+  DES_SWAP(left, right, 16, 0x0000FFFF);
+  DES_SWAP(right, left, 2, 0x33333333);
+  DES_SWAP(right, left, 8, 0x00FF00FF);
+  right = (right << 1) | (right >> 31);
+  work = (left ^ right) & 0xAAAAAAAA;
+  left ^= work;
+  right ^= work;
+  left = (left << 1) | (left >> 31);
+
+  const uint32_t *subkeys = decrypt ? schedule + DES_SCHEDULE_LENGTH - 2 : schedule;
+  int8_t step = decrypt ? -2 : 2;
+  for (byte round = 0; round < 8; round++) {
+    DES_ROUND(left, right, subkeys);
+    subkeys += step;
+    DES_ROUND(right, left, subkeys);
+    subkeys += step;
+  }
+
+  //Final permutation, the inverse of the initial one
+  right = (right << 31) | (right >> 1);
+  work = (left ^ right) & 0xAAAAAAAA;
+  left ^= work;
+  right ^= work;
+  left = (left << 31) | (left >> 1);
+  DES_SWAP(left, right, 8, 0x00FF00FF);
+  DES_SWAP(left, right, 2, 0x33333333);
+  DES_SWAP(right, left, 16, 0x0000FFFF);
+  DES_SWAP(right, left, 4, 0x0F0F0F0F);
+
+  block[0] = (byte) (right >> 24);
+  block[1] = (byte) (right >> 16);
+  block[2] = (byte) (right >> 8);
+  block[3] = (byte) right;
+  block[4] = (byte) (left >> 24);
+  block[5] = (byte) (left >> 16);
+  block[6] = (byte) (left >> 8);
+  block[7] = (byte) left;
+}
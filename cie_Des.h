@@ -0,0 +1,54 @@
+/**************************************************************************/
+/*!
+    @file     cie_Des.h
+    @author   Developers Italia
+	@license  BSD (see License)
+
+	Definition of the cie_Des class, the DES block cipher (FIPS 46-3) with one key or two keys (3DES EDE),
+	as used by the IAS ECC secure messaging. The key schedule is expanded once in setKey() and kept.
+	On AVR the S-box tables live in flash
+
+	@section  HISTORY
+
+	v1.0  - First definition of the class
+
+*/
+/**************************************************************************/
+#ifndef CIE_DES
+#define CIE_DES
+#include <Arduino.h>
+
+#if defined(__AVR__)
+  #include <avr/pgmspace.h>
+  #define DES_CONSTANTS                       PROGMEM
+  #define DES_CONSTANT(table, index)          (pgm_read_dword(&(table)[index]))
+#else
+  #define DES_CONSTANTS
+  #define DES_CONSTANT(table, index)          ((table)[index])
+#endif
+
+#define DES_BLOCK_LENGTH                      (0x08)
+#define DES_KEY_LENGTH                        (0x08)
+#define DES3_KEY_LENGTH                       (0x10)
+//Two subkeys words for each of the 16 rounds
+#define DES_SCHEDULE_LENGTH                   (0x20)
+
+class cie_Des {
+  public:
+    cie_Des();
+    ~cie_Des();
+    void setKey(const byte *key, const byte keyLength);
+    void encryptBlock(byte *block);
+    void decryptBlock(byte *block);
+    void encryptBlockFirstKey(byte *block);
+    void clear();
+
+  private:
+    static void expandKey(const byte *key, uint32_t *schedule);
+    static void crypt(byte *block, const uint32_t *schedule, const bool decrypt);
+
+    uint32_t _schedule[2][DES_SCHEDULE_LENGTH];
+    bool _triple;
+};
+
+#endif
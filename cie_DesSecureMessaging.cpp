@@ -0,0 +1,121 @@
+/**************************************************************************/
+/*!
+    @file     cie_DesSecureMessaging.cpp
+    @author   Developers Italia
+    @license  BSD (see License)
+
+	Implementation of the cie_DesSecureMessaging class
+	See 7.1 Secure messaging in http://www.unsads.com/specs/IASECC/IAS_ECC_v1.0.1_UK.pdf
+
+	@section  HISTORY
+
+	v1.0  - First implementation of the class
+*/
+/**************************************************************************/
+#include "cie_DesSecureMessaging.h"
+
+/**************************************************************************/
+/*!
+  @brief Wipes the keys
+*/
+/**************************************************************************/
+cie_DesSecureMessaging::~cie_DesSecureMessaging() {
+  end();
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Expands the key schedules without starting the session, e.g. for the static keys of the mutual authentication
+
+  @param encKey The pointer to the SM_KEY_LENGTH bytes encryption key
+  @param macKey The pointer to the SM_KEY_LENGTH bytes MAC key
+*/
+/**************************************************************************/
+void cie_DesSecureMessaging::setKeys(const byte *encKey, const byte *macKey) {
+  _enc.setKey(encKey, SM_KEY_LENGTH);
+  _mac.setKey(macKey, SM_KEY_LENGTH);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Gets the block length of 3DES, which is also the length of the send sequence counter
+
+  @returns DES_BLOCK_LENGTH
+*/
+/**************************************************************************/
+byte cie_DesSecureMessaging::getBlockLength() {
+  return DES_BLOCK_LENGTH;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Encrypts a block with 3DES
+
+  @param block The pointer to the DES_BLOCK_LENGTH bytes block
+*/
+/**************************************************************************/
+void cie_DesSecureMessaging::encryptBlock(byte *block) {
+  _enc.encryptBlock(block);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Decrypts a block with 3DES
+
+  @param block The pointer to the DES_BLOCK_LENGTH bytes block
+*/
+/**************************************************************************/
+void cie_DesSecureMessaging::decryptBlock(byte *block) {
+  _enc.decryptBlock(block);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Chains a block of the retail MAC (ISO/IEC 9797-1 algorithm 3): single DES with the first key
+
+  @param block The pointer to the DES_BLOCK_LENGTH bytes MAC state
+*/
+/**************************************************************************/
+void cie_DesSecureMessaging::macBlock(byte *block) {
+  _mac.encryptBlockFirstKey(block);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Ends the retail MAC: the last block takes the full 3DES
+
+  @param block The pointer to the DES_BLOCK_LENGTH bytes MAC state
+*/
+/**************************************************************************/
+void cie_DesSecureMessaging::macLastBlock(byte *block) {
+  _mac.encryptBlock(block);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Gets the initialization vector of the cryptograms, always null
+
+  @param iv The pointer to the DES_BLOCK_LENGTH bytes initialization vector
+*/
+/**************************************************************************/
+void cie_DesSecureMessaging::initialVector(byte *iv) {
+  memset(iv, 0, DES_BLOCK_LENGTH);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Wipes the key schedules
+*/
+/**************************************************************************/
+void cie_DesSecureMessaging::clearKeys() {
+  _enc.clear();
+  _mac.clear();
+}
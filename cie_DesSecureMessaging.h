@@ -0,0 +1,41 @@
+/**************************************************************************/
+/*!
+    @file     cie_DesSecureMessaging.h
+    @author   Developers Italia
+	@license  BSD (see License)
+
+	Definition of the cie_DesSecureMessaging class, the IAS ECC secure messaging: 3DES encryption with a
+	null initialization vector and retail MAC, with the session keys derived by the mutual authentication.
+	Key schedules are expanded once per session
+
+	@section  HISTORY
+
+	v1.0  - First definition of the class
+
+*/
+/**************************************************************************/
+#ifndef CIE_DES_SECURE_MESSAGING
+#define CIE_DES_SECURE_MESSAGING
+#include "cie_SecureMessaging.h"
+#include "cie_Des.h"
+
+class cie_DesSecureMessaging : public cie_SecureMessaging {
+  public:
+    ~cie_DesSecureMessaging();
+    void setKeys(const byte *encKey, const byte *macKey);
+    byte getBlockLength();
+
+  protected:
+    void encryptBlock(byte *block);
+    void decryptBlock(byte *block);
+    void macBlock(byte *block);
+    void macLastBlock(byte *block);
+    void initialVector(byte *iv);
+    void clearKeys();
+
+  private:
+    cie_Des _enc;
+    cie_Des _mac;
+};
+
+#endif
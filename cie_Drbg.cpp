@@ -0,0 +1,197 @@
+/**************************************************************************/
+/*!
+    @file     cie_Drbg.cpp
+    @author   Developers Italia
+    @license  BSD (see License)
+
+	Implementation of the cie_Drbg class. Output is the ChaCha20 keystream, and the key is replaced
+	after each request with keystream nobody has seen (fast key erasure), so past outputs can't be recovered
+
+	@section  HISTORY
+
+	v1.0  - First implementation of the class
+*/
+/**************************************************************************/
+#include "cie_Drbg.h"
+#define PN532DEBUGPRINT Serial
+
+#if defined(__linux__) && !defined(ARDUINO)
+  #include <stdio.h>
+#endif
+
+#define CHACHA_ROTATE(value, bits) (((value) << (bits)) | ((value) >> (32 - (bits))))
+#define CHACHA_QUARTER_ROUND(a, b, c, d) \
+  a += b; d ^= a; d = CHACHA_ROTATE(d, 16); \
+  c += d; b ^= c; b = CHACHA_ROTATE(b, 12); \
+  a += b; d ^= a; d = CHACHA_ROTATE(d, 8);  \
+  c += d; b ^= c; b = CHACHA_ROTATE(b, 7);
+
+/**************************************************************************/
+/*!
+  @brief Creates an unseeded generator, call begin() before generating bytes
+*/
+/**************************************************************************/
+cie_Drbg::cie_Drbg() :
+_seeded(false)
+{
+  memset(_key, 0, CHACHA_KEY_LENGTH);
+  memset(_nonce, 0, CHACHA_NONCE_LENGTH);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Wipes the key
+*/
+/**************************************************************************/
+cie_Drbg::~cie_Drbg() {
+  memset(_key, 0, CHACHA_KEY_LENGTH);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Seeds the generator with entropy gathered from the board. Call it once, e.g. in setup()
+*/
+/**************************************************************************/
+void cie_Drbg::begin() {
+  byte entropy[CHACHA_KEY_LENGTH];
+  gatherEntropy(entropy, sizeof(entropy));
+  seed(entropy, sizeof(entropy));
+  memset(entropy, 0, sizeof(entropy));
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Mixes entropy into the key: it never lowers the entropy already there
+
+  @param entropy The pointer to the entropy
+  @param entropyLength The length of the entropy
+*/
+/**************************************************************************/
+void cie_Drbg::seed(const byte *entropy, const word entropyLength) {
+  for (word i = 0; i < entropyLength; i++) {
+    _key[i % CHACHA_KEY_LENGTH] ^= entropy[i];
+  }
+  byte block[CHACHA_BLOCK_LENGTH];
+  chachaBlock(_key, 0, _nonce, block);
+  memcpy(_key, block, CHACHA_KEY_LENGTH);
+  memset(block, 0, sizeof(block));
+  _seeded = true;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Populates a buffer with random bytes
+
+  @param buffer The pointer to a byte array
+  @param length The number of random bytes to generate
+*/
+/**************************************************************************/
+void cie_Drbg::generate(byte *buffer, const word length) {
+  if (!_seeded) {
+    begin();
+  }
+  byte block[CHACHA_BLOCK_LENGTH];
+  //Block 0 is the next key, the output starts at block 1
+  uint32_t counter = 1;
+  for (word offset = 0; offset < length; offset += CHACHA_BLOCK_LENGTH) {
+    chachaBlock(_key, counter++, _nonce, block);
+    word count = length - offset < CHACHA_BLOCK_LENGTH ? length - offset : CHACHA_BLOCK_LENGTH;
+    memcpy(buffer + offset, block, count);
+  }
+  chachaBlock(_key, 0, _nonce, block);
+  memcpy(_key, block, CHACHA_KEY_LENGTH);
+  memset(block, 0, sizeof(block));
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Gathers entropy from the hardware random number generator on ESP boards, from /dev/urandom on Linux hosts,
+         or else from the noise of a floating analog pin and the timing jitter of its conversions
+
+  @param buffer The pointer to a byte array
+  @param length The number of bytes to gather
+*/
+/**************************************************************************/
+void cie_Drbg::gatherEntropy(byte *buffer, const word length) {
+#if defined(ESP32)
+  for (word i = 0; i < length; i++) {
+    buffer[i] = (byte) esp_random();
+  }
+#elif defined(ESP8266)
+  for (word i = 0; i < length; i++) {
+    buffer[i] = (byte) RANDOM_REG32;
+  }
+#elif defined(__linux__) && !defined(ARDUINO)
+  FILE *urandom = fopen("/dev/urandom", "rb");
+  if (urandom == NULL || fread(buffer, 1, length, urandom) != length) {
+    PN532DEBUGPRINT.println(F("Couldn't read entropy from /dev/urandom"));
+  }
+  if (urandom != NULL) {
+    fclose(urandom);
+  }
+#else
+  for (word i = 0; i < length; i++) {
+    byte value = 0;
+    //A few bits of entropy per sample at best: fold 16 samples into each byte
+    for (byte sample = 0; sample < 16; sample++) {
+      value = (byte) ((value << 3) | (value >> 5));
+      value ^= (byte) analogRead(CIE_ENTROPY_PIN) ^ (byte) micros();
+    }
+    buffer[i] = value;
+  }
+#endif
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Computes a ChaCha20 block (RFC 8439, section 2.3)
+
+  @param key The pointer to the 32 bytes key
+  @param counter The block counter
+  @param nonce The pointer to the 12 bytes nonce
+  @param output The pointer to a buffer of CHACHA_BLOCK_LENGTH bytes
+*/
+/**************************************************************************/
+void cie_Drbg::chachaBlock(const byte *key, const uint32_t counter, const byte *nonce, byte *output) {
+  uint32_t state[16];
+  uint32_t working[16];
+  //"expand 32-byte k"
+  state[0] = 0x61707865;
+  state[1] = 0x3320646E;
+  state[2] = 0x79622D32;
+  state[3] = 0x6B206574;
+  for (byte i = 0; i < 8; i++) {
+    state[4 + i] = (uint32_t) key[4 * i] | ((uint32_t) key[4 * i + 1] << 8) | ((uint32_t) key[4 * i + 2] << 16) | ((uint32_t) key[4 * i + 3] << 24);
+  }
+  state[12] = counter;
+  for (byte i = 0; i < 3; i++) {
+    state[13 + i] = (uint32_t) nonce[4 * i] | ((uint32_t) nonce[4 * i + 1] << 8) | ((uint32_t) nonce[4 * i + 2] << 16) | ((uint32_t) nonce[4 * i + 3] << 24);
+  }
+  memcpy(working, state, sizeof(state));
+  for (byte round = 0; round < 10; round++) {
+    //Column rounds, then diagonal rounds
+    CHACHA_QUARTER_ROUND(working[0], working[4], working[8], working[12]);
+    CHACHA_QUARTER_ROUND(working[1], working[5], working[9], working[13]);
+    CHACHA_QUARTER_ROUND(working[2], working[6], working[10], working[14]);
+    CHACHA_QUARTER_ROUND(working[3], working[7], working[11], working[15]);
+    CHACHA_QUARTER_ROUND(working[0], working[5], working[10], working[15]);
+    CHACHA_QUARTER_ROUND(working[1], working[6], working[11], working[12]);
+    CHACHA_QUARTER_ROUND(working[2], working[7], working[8], working[13]);
+    CHACHA_QUARTER_ROUND(working[3], working[4], working[9], working[14]);
+  }
+  for (byte i = 0; i < 16; i++) {
+    uint32_t value = working[i] + state[i];
+    output[4 * i] = (byte) value;
+    output[4 * i + 1] = (byte) (value >> 8);
+    output[4 * i + 2] = (byte) (value >> 16);
+    output[4 * i + 3] = (byte) (value >> 24);
+  }
+  memset(working, 0, sizeof(working));
+  memset(state, 0, sizeof(state));
+}
@@ -0,0 +1,44 @@
+/**************************************************************************/
+/*!
+    @file     cie_Drbg.h
+    @author   Developers Italia
+	@license  BSD (see License)
+
+	Definition of the cie_Drbg class, a deterministic random bit generator built on the ChaCha20 block function
+	(RFC 8439) and seeded once with entropy gathered from the board
+
+	@section  HISTORY
+
+	v1.0  - First definition of the class
+
+*/
+/**************************************************************************/
+#ifndef CIE_DRBG
+#define CIE_DRBG
+#include <Arduino.h>
+
+#define CHACHA_KEY_LENGTH                     (0x20)
+#define CHACHA_NONCE_LENGTH                   (0x0C)
+#define CHACHA_BLOCK_LENGTH                   (0x40)
+//Floating analog pin sampled for entropy on boards without a hardware random number generator
+#ifndef CIE_ENTROPY_PIN
+  #define CIE_ENTROPY_PIN                     (0)
+#endif
+
+class cie_Drbg {
+  public:
+    cie_Drbg();
+    ~cie_Drbg();
+    void begin();
+    void seed(const byte *entropy, const word entropyLength);
+    void generate(byte *buffer, const word length);
+    static void gatherEntropy(byte *buffer, const word length);
+    static void chachaBlock(const byte *key, const uint32_t counter, const byte *nonce, byte *output);
+
+  private:
+    byte _key[CHACHA_KEY_LENGTH];
+    byte _nonce[CHACHA_NONCE_LENGTH];
+    bool _seeded;
+};
+
+#endif
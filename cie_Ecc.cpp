@@ -0,0 +1,697 @@
+/**************************************************************************/
+/*!
+    @file     cie_Ecc.cpp
+    @author   Developers Italia
+    @license  BSD (see License)
+
+	Implementation of the cie_Ecc class
+	The addition formulas are algorithm 1 in "Complete addition formulas for prime order elliptic curves"
+	by Renes, Costello and Batina (https://eprint.iacr.org/2015/1060), which also double a point
+
+	@section  HISTORY
+
+	v1.0  - First implementation of the class
+*/
+/**************************************************************************/
+#include "cie_Ecc.h"
+#include "cie_Cycles.h"
+#define PN532DEBUGPRINT Serial
+
+//Domain parameters (FIPS 186-4 D.1.2.3 and RFC 5639 3.4), big endian
+static const byte ECC_NIST_P256[ECC_CURVE_CONSTANTS_LENGTH] ECC_CONSTANTS = {
+  //p
+  0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  //a
+  0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFC,
+  //b
+  0x5A, 0xC6, 0x35, 0xD8, 0xAA, 0x3A, 0x93, 0xE7, 0xB3, 0xEB, 0xBD, 0x55, 0x76, 0x98, 0x86, 0xBC,
+  0x65, 0x1D, 0x06, 0xB0, 0xCC, 0x53, 0xB0, 0xF6, 0x3B, 0xCE, 0x3C, 0x3E, 0x27, 0xD2, 0x60, 0x4B,
+  //n
+  0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xBC, 0xE6, 0xFA, 0xAD, 0xA7, 0x17, 0x9E, 0x84, 0xF3, 0xB9, 0xCA, 0xC2, 0xFC, 0x63, 0x25, 0x51,
+  //Gx
+  0x6B, 0x17, 0xD1, 0xF2, 0xE1, 0x2C, 0x42, 0x47, 0xF8, 0xBC, 0xE6, 0xE5, 0x63, 0xA4, 0x40, 0xF2,
+  0x77, 0x03, 0x7D, 0x81, 0x2D, 0xEB, 0x33, 0xA0, 0xF4, 0xA1, 0x39, 0x45, 0xD8, 0x98, 0xC2, 0x96,
+  //Gy
+  0x4F, 0xE3, 0x42, 0xE2, 0xFE, 0x1A, 0x7F, 0x9B, 0x8E, 0xE7, 0xEB, 0x4A, 0x7C, 0x0F, 0x9E, 0x16,
+  0x2B, 0xCE, 0x33, 0x57, 0x6B, 0x31, 0x5E, 0xCE, 0xCB, 0xB6, 0x40, 0x68, 0x37, 0xBF, 0x51, 0xF5
+};
+static const byte ECC_BRAINPOOL_P256R1[ECC_CURVE_CONSTANTS_LENGTH] ECC_CONSTANTS = {
+  //p
+  0xA9, 0xFB, 0x57, 0xDB, 0xA1, 0xEE, 0xA9, 0xBC, 0x3E, 0x66, 0x0A, 0x90, 0x9D, 0x83, 0x8D, 0x72,
+  0x6E, 0x3B, 0xF6, 0x23, 0xD5, 0x26, 0x20, 0x28, 0x20, 0x13, 0x48, 0x1D, 0x1F, 0x6E, 0x53, 0x77,
+  //a
+  0x7D, 0x5A, 0x09, 0x75, 0xFC, 0x2C, 0x30, 0x57, 0xEE, 0xF6, 0x75, 0x30, 0x41, 0x7A, 0xFF, 0xE7,
+  0xFB, 0x80, 0x55, 0xC1, 0x26, 0xDC, 0x5C, 0x6C, 0xE9, 0x4A, 0x4B, 0x44, 0xF3, 0x30, 0xB5, 0xD9,
+  //b
+  0x26, 0xDC, 0x5C, 0x6C, 0xE9, 0x4A, 0x4B, 0x44, 0xF3, 0x30, 0xB5, 0xD9, 0xBB, 0xD7, 0x7C, 0xBF,
+  0x95, 0x84, 0x16, 0x29, 0x5C, 0xF7, 0xE1, 0xCE, 0x6B, 0xCC, 0xDC, 0x18, 0xFF, 0x8C, 0x07, 0xB6,
+  //n
+  0xA9, 0xFB, 0x57, 0xDB, 0xA1, 0xEE, 0xA9, 0xBC, 0x3E, 0x66, 0x0A, 0x90, 0x9D, 0x83, 0x8D, 0x71,
+  0x8C, 0x39, 0x7A, 0xA3, 0xB5, 0x61, 0xA6, 0xF7, 0x90, 0x1E, 0x0E, 0x82, 0x97, 0x48, 0x56, 0xA7,
+  //Gx
+  0x8B, 0xD2, 0xAE, 0xB9, 0xCB, 0x7E, 0x57, 0xCB, 0x2C, 0x4B, 0x48, 0x2F, 0xFC, 0x81, 0xB7, 0xAF,
+  0xB9, 0xDE, 0x27, 0xE1, 0xE3, 0xBD, 0x23, 0xC2, 0x3A, 0x44, 0x53, 0xBD, 0x9A, 0xCE, 0x32, 0x62,
+  //Gy
+  0x54, 0x7E, 0xF8, 0x35, 0xC3, 0xDA, 0xC4, 0xFD, 0x97, 0xF8, 0x46, 0x1A, 0x14, 0x61, 0x1D, 0xC9,
+  0xC2, 0x77, 0x45, 0x13, 0x2D, 0xED, 0x8E, 0x54, 0x5C, 0x1D, 0x54, 0xC7, 0x2F, 0x04, 0x69, 0x97
+};
+
+/**************************************************************************/
+/*!
+  @brief Creates an engine with no curve
+*/
+/**************************************************************************/
+cie_Ecc::cie_Ecc() :
+_curve(ECC_CURVE_NONE),
+_inverse(0),
+_cycles(0)
+{
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Wipes the generator, which PACE derives from a secret nonce
+*/
+/**************************************************************************/
+cie_Ecc::~cie_Ecc() {
+  memset(_gx, 0, sizeof(_gx));
+  memset(_gy, 0, sizeof(_gy));
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Loads the domain parameters of a curve and precomputes its Montgomery constants
+
+  @param curve The curve (either ECC_CURVE_NIST_P256 or ECC_CURVE_BRAINPOOL_P256R1)
+
+  @returns A boolean value indicating whether the curve is supported
+*/
+/**************************************************************************/
+bool cie_Ecc::setCurve(const byte curve) {
+  const byte *constants;
+  switch (curve) {
+    case ECC_CURVE_NIST_P256:
+      constants = ECC_NIST_P256;
+    break;
+
+    case ECC_CURVE_BRAINPOOL_P256R1:
+      constants = ECC_BRAINPOOL_P256R1;
+    break;
+
+    default:
+      PN532DEBUGPRINT.println(F("The curve must be either ECC_CURVE_NIST_P256 or ECC_CURVE_BRAINPOOL_P256R1"));
+      return false;
+  }
+  byte coordinate[ECC_COORDINATE_LENGTH];
+  ECC_COPY_CONSTANT(coordinate, constants, 0, ECC_COORDINATE_LENGTH);
+  fromBytes(_p, coordinate);
+  ECC_COPY_CONSTANT(coordinate, constants, 3 * ECC_COORDINATE_LENGTH, ECC_COORDINATE_LENGTH);
+  fromBytes(_n, coordinate);
+
+  //Newton iteration: each step doubles the number of correct low bits of the inverse, starting from 1 bit
+  cie_Limb inverse = 1;
+  for (byte bits = 1; bits < RSA_LIMB_BITS; bits *= 2) {
+    inverse = (cie_Limb) (inverse * (cie_Limb) (2 - (cie_Limb) (_p[0] * inverse)));
+  }
+  _inverse = (cie_Limb) (0 - inverse);
+
+  //R^2 mod p by doubling 1, then R = 2^256 mod p as the Montgomery form of 1
+  memset(_rSquared, 0, sizeof(_rSquared));
+  _rSquared[0] = 1;
+  for (word bit = 0; bit < 2 * 8 * ECC_COORDINATE_LENGTH; bit++) {
+    fieldAdd(_rSquared, _rSquared, _rSquared);
+  }
+  memset(_one, 0, sizeof(_one));
+  _one[0] = 1;
+  fieldMultiply(_one, _one, _rSquared);
+
+  //Coefficients and generator in Montgomery form
+  cie_Limb *parameters[] = { _a, _b, _gx, _gy };
+  const byte positions[] = { 1, 2, 4, 5 };
+  for (byte i = 0; i < 4; i++) {
+    ECC_COPY_CONSTANT(coordinate, constants, positions[i] * ECC_COORDINATE_LENGTH, ECC_COORDINATE_LENGTH);
+    fromBytes(parameters[i], coordinate);
+    fieldMultiply(parameters[i], parameters[i], _rSquared);
+  }
+  fieldAdd(_b3, _b, _b);
+  fieldAdd(_b3, _b3, _b);
+  _curve = curve;
+  return true;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Gets the current curve
+
+  @returns The curve or ECC_CURVE_NONE
+*/
+/**************************************************************************/
+byte cie_Ecc::getCurve() {
+  return _curve;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Tells whether a scalar is a valid private key, i.e. 0 < scalar < n
+
+  @param scalar The pointer to the ECC_SCALAR_LENGTH bytes big endian scalar
+
+  @returns A boolean value indicating whether the scalar can be used
+*/
+/**************************************************************************/
+bool cie_Ecc::isValidScalar(const byte *scalar) {
+  if (_curve == ECC_CURVE_NONE) {
+    return false;
+  }
+  cie_Limb k[ECC_LIMBS];
+  cie_Limb difference[ECC_LIMBS];
+  fromBytes(k, scalar);
+  cie_Limb nonZero = 0;
+  for (byte i = 0; i < ECC_LIMBS; i++) {
+    nonZero |= k[i];
+  }
+  cie_Limb borrow = subtract(difference, k, _n);
+  memset(k, 0, sizeof(k));
+  memset(difference, 0, sizeof(difference));
+  return nonZero != 0 && borrow != 0;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Tells whether an encoded point lies on the current curve
+
+  @param point The pointer to the ECC_POINT_LENGTH bytes uncompressed point
+
+  @returns A boolean value indicating whether the point is valid
+*/
+/**************************************************************************/
+bool cie_Ecc::isOnCurve(const byte *point) {
+  cie_EccPoint p;
+  return decodePoint(&p, point);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Multiplies a point by a scalar in constant time
+
+  @param scalar The pointer to the ECC_SCALAR_LENGTH bytes big endian scalar
+  @param point The pointer to the ECC_POINT_LENGTH bytes uncompressed point, or NULL for the generator
+  @param result The pointer to the ECC_POINT_LENGTH bytes uncompressed product
+
+  @returns A boolean value indicating whether the point is valid and the product is not the point at infinity
+*/
+/**************************************************************************/
+bool cie_Ecc::multiply(const byte *scalar, const byte *point, byte *result) {
+  unsigned long startedAt = cie_cycles();
+  cie_EccPoint p;
+  bool success = _curve != ECC_CURVE_NONE;
+  if (success && point == NULL) {
+    setGenerator(&p);
+  } else if (success) {
+    success = decodePoint(&p, point);
+  }
+  if (success) {
+    ladder(&p, scalar, ECC_SCALAR_LENGTH, &p);
+    success = encodePoint(result, &p);
+  }
+  memset(&p, 0, sizeof(p));
+  _cycles = cie_cycles() - startedAt;
+  if (!success) {
+    PN532DEBUGPRINT.println(F("Couldn't multiply the point"));
+  }
+  return success;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Replaces the generator with nonce * G + point, the generic mapping of PACE
+
+  @param nonce The pointer to the big endian nonce
+  @param nonceLength The length of the nonce, up to ECC_SCALAR_LENGTH
+  @param point The pointer to the ECC_POINT_LENGTH bytes uncompressed shared point H
+
+  @returns A boolean value indicating whether the new generator is valid
+*/
+/**************************************************************************/
+bool cie_Ecc::mapGenerator(const byte *nonce, const byte nonceLength, const byte *point) {
+  if (_curve == ECC_CURVE_NONE || nonceLength > ECC_SCALAR_LENGTH) {
+    return false;
+  }
+  unsigned long startedAt = cie_cycles();
+  cie_EccPoint g;
+  cie_EccPoint h;
+  byte mapped[ECC_POINT_LENGTH];
+  bool success = decodePoint(&h, point);
+  if (success) {
+    setGenerator(&g);
+    //The nonce is usually shorter than the scalars: its length is public, so the ladder can stop there
+    ladder(&g, nonce, nonceLength, &g);
+    addPoints(&g, &g, &h);
+    success = encodePoint(mapped, &g);
+  }
+  if (success) {
+    fromBytes(_gx, mapped + 1);
+    fieldMultiply(_gx, _gx, _rSquared);
+    fromBytes(_gy, mapped + 1 + ECC_COORDINATE_LENGTH);
+    fieldMultiply(_gy, _gy, _rSquared);
+  } else {
+    PN532DEBUGPRINT.println(F("Couldn't map the generator"));
+  }
+  memset(&g, 0, sizeof(g));
+  memset(mapped, 0, ECC_POINT_LENGTH);
+  _cycles = cie_cycles() - startedAt;
+  return success;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Gets the CPU cycles taken by the last multiplication or mapping
+
+  @returns The number of cycles
+*/
+/**************************************************************************/
+unsigned long cie_Ecc::getCycles() {
+  return _cycles;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Montgomery multiplication (CIOS): result = a * b / R mod p, with a masked final subtraction
+
+  @param result The pointer to the product, which can be one of the factors
+  @param a The pointer to the first factor, less than p
+  @param b The pointer to the second factor, less than p
+*/
+/**************************************************************************/
+void cie_Ecc::fieldMultiply(cie_Limb *result, const cie_Limb *a, const cie_Limb *b) {
+  cie_Limb t[ECC_LIMBS + 2];
+  memset(t, 0, sizeof(t));
+  for (byte i = 0; i < ECC_LIMBS; i++) {
+    //t += a * b[i]
+    cie_DoubleLimb carry = 0;
+    for (byte j = 0; j < ECC_LIMBS; j++) {
+      carry += (cie_DoubleLimb) a[j] * b[i] + t[j];
+      t[j] = (cie_Limb) carry;
+      carry >>= RSA_LIMB_BITS;
+    }
+    carry += t[ECC_LIMBS];
+    t[ECC_LIMBS] = (cie_Limb) carry;
+    t[ECC_LIMBS + 1] = (cie_Limb) (carry >> RSA_LIMB_BITS);
+
+    //t = (t + m * p) / 2^RSA_LIMB_BITS, with m chosen so that the lowest limb becomes zero
+    cie_Limb m = (cie_Limb) (t[0] * _inverse);
+    carry = (cie_DoubleLimb) m * _p[0] + t[0];
+    carry >>= RSA_LIMB_BITS;
+    for (byte j = 1; j < ECC_LIMBS; j++) {
+      carry += (cie_DoubleLimb) m * _p[j] + t[j];
+      t[j - 1] = (cie_Limb) carry;
+      carry >>= RSA_LIMB_BITS;
+    }
+    carry += t[ECC_LIMBS];
+    t[ECC_LIMBS - 1] = (cie_Limb) carry;
+    t[ECC_LIMBS] = (cie_Limb) (t[ECC_LIMBS + 1] + (cie_Limb) (carry >> RSA_LIMB_BITS));
+  }
+  //t < 2p: keep t - p unless it borrowed without an overflowing t
+  cie_Limb difference[ECC_LIMBS];
+  cie_Limb borrow = subtract(difference, t, _p);
+  memcpy(result, t, ECC_LIMBS * sizeof(cie_Limb));
+  select(result, difference, (cie_Limb) (0 - (t[ECC_LIMBS] | (borrow ^ 1))));
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Modular addition in constant time
+
+  @param result The pointer to the sum, which can be one of the terms
+  @param a The pointer to the first term, less than p
+  @param b The pointer to the second term, less than p
+*/
+/**************************************************************************/
+void cie_Ecc::fieldAdd(cie_Limb *result, const cie_Limb *a, const cie_Limb *b) {
+  cie_Limb difference[ECC_LIMBS];
+  cie_Limb carry = add(result, a, b);
+  cie_Limb borrow = subtract(difference, result, _p);
+  select(result, difference, (cie_Limb) (0 - (carry | (borrow ^ 1))));
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Modular subtraction in constant time
+
+  @param result The pointer to the difference, which can be one of the terms
+  @param a The pointer to the minuend, less than p
+  @param b The pointer to the subtrahend, less than p
+*/
+/**************************************************************************/
+void cie_Ecc::fieldSubtract(cie_Limb *result, const cie_Limb *a, const cie_Limb *b) {
+  cie_Limb sum[ECC_LIMBS];
+  cie_Limb borrow = subtract(result, a, b);
+  add(sum, result, _p);
+  select(result, sum, (cie_Limb) (0 - borrow));
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Modular inversion by Fermat's little theorem, a^(p - 2). The exponent is public,
+         so the running time doesn't depend on a
+
+  @param result The pointer to the inverse, which can be a
+  @param a The pointer to the Montgomery form element to invert
+*/
+/**************************************************************************/
+void cie_Ecc::fieldInvert(cie_Limb *result, const cie_Limb *a) {
+  cie_Limb two[ECC_LIMBS];
+  cie_Limb exponent[ECC_LIMBS];
+  cie_Limb accumulator[ECC_LIMBS];
+  memset(two, 0, sizeof(two));
+  two[0] = 2;
+  subtract(exponent, _p, two);
+  memcpy(accumulator, _one, sizeof(accumulator));
+  for (int bit = 8 * ECC_COORDINATE_LENGTH - 1; bit >= 0; bit--) {
+    fieldMultiply(accumulator, accumulator, accumulator);
+    if ((exponent[bit / RSA_LIMB_BITS] >> (bit % RSA_LIMB_BITS)) & 0x01) {
+      fieldMultiply(accumulator, accumulator, a);
+    }
+  }
+  memcpy(result, accumulator, sizeof(accumulator));
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Adds two points with the complete formulas for any a, which also work when the points are
+         equal or one of them is the point at infinity
+
+  @param result The pointer to the sum, which can be one of the terms
+  @param p The pointer to the first term
+  @param q The pointer to the second term
+*/
+/**************************************************************************/
+void cie_Ecc::addPoints(cie_EccPoint *result, const cie_EccPoint *p, const cie_EccPoint *q) {
+  cie_Limb t0[ECC_LIMBS], t1[ECC_LIMBS], t2[ECC_LIMBS], t3[ECC_LIMBS], t4[ECC_LIMBS], t5[ECC_LIMBS];
+  cie_Limb x3[ECC_LIMBS], y3[ECC_LIMBS], z3[ECC_LIMBS];
+  fieldMultiply(t0, p->x, q->x);
+  fieldMultiply(t1, p->y, q->y);
+  fieldMultiply(t2, p->z, q->z);
+  fieldAdd(t3, p->x, p->y);
+  fieldAdd(t4, q->x, q->y);
+  fieldMultiply(t3, t3, t4);
+  fieldAdd(t4, t0, t1);
+  fieldSubtract(t3, t3, t4);
+  fieldAdd(t4, p->x, p->z);
+  fieldAdd(t5, q->x, q->z);
+  fieldMultiply(t4, t4, t5);
+  fieldAdd(t5, t0, t2);
+  fieldSubtract(t4, t4, t5);
+  fieldAdd(t5, p->y, p->z);
+  fieldAdd(x3, q->y, q->z);
+  fieldMultiply(t5, t5, x3);
+  fieldAdd(x3, t1, t2);
+  fieldSubtract(t5, t5, x3);
+  fieldMultiply(z3, _a, t4);
+  fieldMultiply(x3, _b3, t2);
+  fieldAdd(z3, x3, z3);
+  fieldSubtract(x3, t1, z3);
+  fieldAdd(z3, t1, z3);
+  fieldMultiply(y3, x3, z3);
+  fieldAdd(t1, t0, t0);
+  fieldAdd(t1, t1, t0);
+  fieldMultiply(t2, _a, t2);
+  fieldMultiply(t4, _b3, t4);
+  fieldAdd(t1, t1, t2);
+  fieldSubtract(t2, t0, t2);
+  fieldMultiply(t2, _a, t2);
+  fieldAdd(t4, t4, t2);
+  fieldMultiply(t0, t1, t4);
+  fieldAdd(y3, y3, t0);
+  fieldMultiply(t0, t5, t4);
+  fieldMultiply(x3, t3, x3);
+  fieldSubtract(x3, x3, t0);
+  fieldMultiply(t0, t3, t1);
+  fieldMultiply(z3, t5, z3);
+  fieldAdd(z3, z3, t0);
+  memcpy(result->x, x3, sizeof(x3));
+  memcpy(result->y, y3, sizeof(y3));
+  memcpy(result->z, z3, sizeof(z3));
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Montgomery ladder over all the bits of the scalar: each bit takes one addition and one doubling,
+         and the two running points are swapped by masks instead of branches
+
+  @param result The pointer to the product, which can be p
+  @param scalar The pointer to the big endian scalar
+  @param scalarLength The length of the scalar, up to ECC_SCALAR_LENGTH
+  @param p The pointer to the point to multiply
+*/
+/**************************************************************************/
+void cie_Ecc::ladder(cie_EccPoint *result, const byte *scalar, const byte scalarLength, const cie_EccPoint *p) {
+  cie_EccPoint r0;
+  cie_EccPoint r1;
+  //r0 = infinity (0 : 1 : 0), r1 = p
+  memset(&r0, 0, sizeof(r0));
+  memcpy(r0.y, _one, sizeof(_one));
+  memcpy(&r1, p, sizeof(r1));
+  for (int bit = 8 * scalarLength - 1; bit >= 0; bit--) {
+    cie_Limb mask = (cie_Limb) (0 - (cie_Limb) ((scalar[scalarLength - 1 - bit / 8] >> (bit % 8)) & 0x01));
+    swapPoints(&r0, &r1, mask);
+    addPoints(&r1, &r0, &r1);
+    addPoints(&r0, &r0, &r0);
+    swapPoints(&r0, &r1, mask);
+  }
+  memcpy(result, &r0, sizeof(r0));
+  memset(&r0, 0, sizeof(r0));
+  memset(&r1, 0, sizeof(r1));
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Gets the current generator in projective coordinates
+
+  @param p The pointer to the point
+*/
+/**************************************************************************/
+void cie_Ecc::setGenerator(cie_EccPoint *p) {
+  memcpy(p->x, _gx, sizeof(_gx));
+  memcpy(p->y, _gy, sizeof(_gy));
+  memcpy(p->z, _one, sizeof(_one));
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Decodes an uncompressed point, rejecting those not on the curve (e.g. invalid curve attacks)
+
+  @param p The pointer to the point in projective coordinates
+  @param point The pointer to the ECC_POINT_LENGTH bytes uncompressed point
+
+  @returns A boolean value indicating whether the point is valid
+*/
+/**************************************************************************/
+bool cie_Ecc::decodePoint(cie_EccPoint *p, const byte *point) {
+  if (_curve == ECC_CURVE_NONE || point[0] != ECC_UNCOMPRESSED_POINT) {
+    return false;
+  }
+  cie_Limb difference[ECC_LIMBS];
+  fromBytes(p->x, point + 1);
+  fromBytes(p->y, point + 1 + ECC_COORDINATE_LENGTH);
+  //Coordinates must be reduced
+  if (subtract(difference, p->x, _p) == 0 || subtract(difference, p->y, _p) == 0) {
+    return false;
+  }
+  fieldMultiply(p->x, p->x, _rSquared);
+  fieldMultiply(p->y, p->y, _rSquared);
+  memcpy(p->z, _one, sizeof(_one));
+  return isCurveEquationSatisfied(p->x, p->y);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Encodes a point in affine coordinates
+
+  @param point The pointer to the ECC_POINT_LENGTH bytes uncompressed point
+  @param p The pointer to the point in projective coordinates
+
+  @returns A boolean value indicating whether the point is not the point at infinity
+*/
+/**************************************************************************/
+bool cie_Ecc::encodePoint(byte *point, const cie_EccPoint *p) {
+  cie_Limb nonZero = 0;
+  for (byte i = 0; i < ECC_LIMBS; i++) {
+    nonZero |= p->z[i];
+  }
+  if (nonZero == 0) {
+    return false;
+  }
+  cie_Limb inverse[ECC_LIMBS];
+  cie_Limb coordinate[ECC_LIMBS];
+  cie_Limb unit[ECC_LIMBS];
+  memset(unit, 0, sizeof(unit));
+  unit[0] = 1;
+  fieldInvert(inverse, p->z);
+  //Multiplying by 1 leaves the Montgomery form
+  fieldMultiply(inverse, inverse, unit);
+  point[0] = ECC_UNCOMPRESSED_POINT;
+  fieldMultiply(coordinate, p->x, inverse);
+  toBytes(point + 1, coordinate);
+  fieldMultiply(coordinate, p->y, inverse);
+  toBytes(point + 1 + ECC_COORDINATE_LENGTH, coordinate);
+  memset(coordinate, 0, sizeof(coordinate));
+  memset(inverse, 0, sizeof(inverse));
+  return true;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Checks y^2 = x^3 + ax + b
+
+  @param x The pointer to the Montgomery form x coordinate
+  @param y The pointer to the Montgomery form y coordinate
+
+  @returns A boolean value indicating whether the point is on the curve
+*/
+/**************************************************************************/
+bool cie_Ecc::isCurveEquationSatisfied(const cie_Limb *x, const cie_Limb *y) {
+  cie_Limb left[ECC_LIMBS];
+  cie_Limb right[ECC_LIMBS];
+  fieldMultiply(left, y, y);
+  //(x^2 + a) * x + b
+  fieldMultiply(right, x, x);
+  fieldAdd(right, right, _a);
+  fieldMultiply(right, right, x);
+  fieldAdd(right, right, _b);
+  return memcmp(left, right, sizeof(left)) == 0;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Adds two numbers of ECC_LIMBS limbs
+
+  @param result The pointer to the sum, which can be one of the terms
+  @param a The pointer to the first term
+  @param b The pointer to the second term
+
+  @returns The carry (0 or 1)
+*/
+/**************************************************************************/
+cie_Limb cie_Ecc::add(cie_Limb *result, const cie_Limb *a, const cie_Limb *b) {
+  cie_DoubleLimb carry = 0;
+  for (byte i = 0; i < ECC_LIMBS; i++) {
+    carry += (cie_DoubleLimb) a[i] + b[i];
+    result[i] = (cie_Limb) carry;
+    carry >>= RSA_LIMB_BITS;
+  }
+  return (cie_Limb) carry;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Subtracts two numbers of ECC_LIMBS limbs
+
+  @param result The pointer to the difference, which can be one of the terms
+  @param a The pointer to the minuend
+  @param b The pointer to the subtrahend
+
+  @returns The borrow (0 or 1)
+*/
+/**************************************************************************/
+cie_Limb cie_Ecc::subtract(cie_Limb *result, const cie_Limb *a, const cie_Limb *b) {
+  cie_Limb borrow = 0;
+  for (byte i = 0; i < ECC_LIMBS; i++) {
+    cie_DoubleLimb difference = (cie_DoubleLimb) a[i] - b[i] - borrow;
+    result[i] = (cie_Limb) difference;
+    borrow = (cie_Limb) (difference >> (2 * RSA_LIMB_BITS - 1));
+  }
+  return borrow;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Copies a number where the mask is all ones, leaves the result untouched where it's zero
+
+  @param result The pointer to the destination
+  @param a The pointer to the source
+  @param mask Either all ones or zero
+*/
+/**************************************************************************/
+void cie_Ecc::select(cie_Limb *result, const cie_Limb *a, const cie_Limb mask) {
+  for (byte i = 0; i < ECC_LIMBS; i++) {
+    result[i] ^= mask & (result[i] ^ a[i]);
+  }
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Swaps two points where the mask is all ones
+
+  @param p The pointer to the first point
+  @param q The pointer to the second point
+  @param mask Either all ones or zero
+*/
+/**************************************************************************/
+void cie_Ecc::swapPoints(cie_EccPoint *p, cie_EccPoint *q, const cie_Limb mask) {
+  cie_Limb *a = (cie_Limb *) p;
+  cie_Limb *b = (cie_Limb *) q;
+  for (byte i = 0; i < 3 * ECC_LIMBS; i++) {
+    cie_Limb difference = mask & (a[i] ^ b[i]);
+    a[i] ^= difference;
+    b[i] ^= difference;
+  }
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Converts big endian bytes to little endian limbs
+
+  @param x The pointer to the ECC_LIMBS limbs
+  @param bytes The pointer to the ECC_COORDINATE_LENGTH bytes
+*/
+/**************************************************************************/
+void cie_Ecc::fromBytes(cie_Limb *x, const byte *bytes) {
+  memset(x, 0, ECC_LIMBS * sizeof(cie_Limb));
+  for (byte i = 0; i < ECC_COORDINATE_LENGTH; i++) {
+    byte position = ECC_COORDINATE_LENGTH - 1 - i;
+    x[position / sizeof(cie_Limb)] |= ((cie_Limb) bytes[i]) << (8 * (position % sizeof(cie_Limb)));
+  }
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Converts little endian limbs to big endian bytes
+
+  @param bytes The pointer to the ECC_COORDINATE_LENGTH bytes
+  @param x The pointer to the ECC_LIMBS limbs
+*/
+/**************************************************************************/
+void cie_Ecc::toBytes(byte *bytes, const cie_Limb *x) {
+  for (byte i = 0; i < ECC_COORDINATE_LENGTH; i++) {
+    byte position = ECC_COORDINATE_LENGTH - 1 - i;
+    bytes[i] = (byte) (x[position / sizeof(cie_Limb)] >> (8 * (position % sizeof(cie_Limb))));
+  }
+}
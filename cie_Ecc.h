@@ -0,0 +1,99 @@
+/**************************************************************************/
+/*!
+    @file     cie_Ecc.h
+    @author   Developers Italia
+	@license  BSD (see License)
+
+	Definition of the cie_Ecc class, a compact engine for the 256-bit prime curves of PACE (NIST P-256 and
+	brainpoolP256r1). Field elements are kept in Montgomery form, in limbs as wide as the CPU registers
+	(see cie_Rsa.h), and every operation taking a secret runs in constant time: masked field arithmetic,
+	complete addition formulas in projective coordinates and a Montgomery ladder with conditional swaps.
+	On AVR the curve constants live in flash
+
+	@section  HISTORY
+
+	v1.0  - First definition of the class
+
+*/
+/**************************************************************************/
+#ifndef CIE_ECC
+#define CIE_ECC
+#include <Arduino.h>
+#include "cie_Rsa.h"
+
+#if defined(__AVR__)
+  #include <avr/pgmspace.h>
+  #define ECC_CONSTANTS                       PROGMEM
+  #define ECC_COPY_CONSTANT(destination, table, offset, length) (memcpy_P((destination), (table) + (offset), (length)))
+#else
+  #define ECC_CONSTANTS
+  #define ECC_COPY_CONSTANT(destination, table, offset, length) (memcpy((destination), (table) + (offset), (length)))
+#endif
+
+//Curves, identified by their standardized domain parameter ids (BSI TR-03110 part 3, table 4)
+#define ECC_CURVE_NONE                        (0x00)
+#define ECC_CURVE_NIST_P256                   (0x0C)
+#define ECC_CURVE_BRAINPOOL_P256R1            (0x0D)
+
+//Lengths
+#define ECC_COORDINATE_LENGTH                 (0x20)
+#define ECC_SCALAR_LENGTH                     (0x20)
+//Uncompressed encoding: 04 || X || Y
+#define ECC_POINT_LENGTH                      (0x41)
+#define ECC_UNCOMPRESSED_POINT                (0x04)
+#define ECC_LIMBS                             (ECC_COORDINATE_LENGTH / sizeof(cie_Limb))
+//p, a, b, n, Gx and Gy of each curve
+#define ECC_CURVE_CONSTANTS_LENGTH            (0x06 * ECC_COORDINATE_LENGTH)
+
+//A point in projective coordinates, with Montgomery form coordinates. The point at infinity has Z = 0
+struct cie_EccPoint {
+    cie_Limb x[ECC_LIMBS];
+    cie_Limb y[ECC_LIMBS];
+    cie_Limb z[ECC_LIMBS];
+};
+
+class cie_Ecc {
+  public:
+    cie_Ecc();
+    ~cie_Ecc();
+    bool setCurve(const byte curve);
+    byte getCurve();
+    bool isValidScalar(const byte *scalar);
+    bool isOnCurve(const byte *point);
+    bool multiply(const byte *scalar, const byte *point, byte *result);
+    bool mapGenerator(const byte *nonce, const byte nonceLength, const byte *point);
+    unsigned long getCycles();
+
+  private:
+    void fieldMultiply(cie_Limb *result, const cie_Limb *a, const cie_Limb *b);
+    void fieldAdd(cie_Limb *result, const cie_Limb *a, const cie_Limb *b);
+    void fieldSubtract(cie_Limb *result, const cie_Limb *a, const cie_Limb *b);
+    void fieldInvert(cie_Limb *result, const cie_Limb *a);
+    void addPoints(cie_EccPoint *result, const cie_EccPoint *p, const cie_EccPoint *q);
+    void ladder(cie_EccPoint *result, const byte *scalar, const byte scalarLength, const cie_EccPoint *p);
+    void setGenerator(cie_EccPoint *p);
+    bool decodePoint(cie_EccPoint *p, const byte *point);
+    bool encodePoint(byte *point, const cie_EccPoint *p);
+    bool isCurveEquationSatisfied(const cie_Limb *x, const cie_Limb *y);
+    static cie_Limb add(cie_Limb *result, const cie_Limb *a, const cie_Limb *b);
+    static cie_Limb subtract(cie_Limb *result, const cie_Limb *a, const cie_Limb *b);
+    static void select(cie_Limb *result, const cie_Limb *a, const cie_Limb mask);
+    static void swapPoints(cie_EccPoint *p, cie_EccPoint *q, const cie_Limb mask);
+    static void fromBytes(cie_Limb *x, const byte *bytes);
+    static void toBytes(byte *bytes, const cie_Limb *x);
+
+    byte _curve;
+    cie_Limb _inverse;
+    cie_Limb _p[ECC_LIMBS];
+    cie_Limb _n[ECC_LIMBS];
+    cie_Limb _rSquared[ECC_LIMBS];
+    cie_Limb _one[ECC_LIMBS];
+    cie_Limb _a[ECC_LIMBS];
+    cie_Limb _b[ECC_LIMBS];
+    cie_Limb _b3[ECC_LIMBS];
+    cie_Limb _gx[ECC_LIMBS];
+    cie_Limb _gy[ECC_LIMBS];
+    unsigned long _cycles;
+};
+
+#endif
@@ -0,0 +1,140 @@
+/**************************************************************************/
+/*!
+    @file     cie_Hash.cpp
+    @author   Developers Italia
+    @license  BSD (see License)
+
+	Implementation of the cie_Hash abstract class: buffering of partial blocks and padding.
+	Subclasses just compress whole blocks
+
+	@section  HISTORY
+
+	v1.0  - First implementation of the class
+*/
+/**************************************************************************/
+#include "cie_Hash.h"
+
+/**************************************************************************/
+/*!
+  @brief Creates a hash, call begin() before feeding it
+*/
+/**************************************************************************/
+cie_Hash::cie_Hash() :
+_blockLength(0),
+_length(0)
+{
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Starts a new digest, discarding any data fed so far
+*/
+/**************************************************************************/
+void cie_Hash::begin() {
+  _blockLength = 0;
+  _length = 0;
+  initState();
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Feeds data to the hash. Whole blocks are compressed straight from the data, without copying them
+
+  @param data The pointer to the data
+  @param length The length of the data
+*/
+/**************************************************************************/
+void cie_Hash::update(const byte *data, const word length) {
+  _length += length;
+  word offset = 0;
+  if (_blockLength > 0) {
+    word count = HASH_BLOCK_LENGTH - _blockLength;
+    if (count > length) {
+      count = length;
+    }
+    memcpy(_block + _blockLength, data, count);
+    _blockLength += count;
+    offset = count;
+    if (_blockLength < HASH_BLOCK_LENGTH) {
+      return;
+    }
+    compress(_block);
+    _blockLength = 0;
+  }
+  for (; length - offset >= HASH_BLOCK_LENGTH; offset += HASH_BLOCK_LENGTH) {
+    compress(data + offset);
+  }
+  _blockLength = length - offset;
+  memcpy(_block, data + offset, _blockLength);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Pads the data fed so far and writes the digest
+
+  @param digest The pointer to a buffer of getDigestLength() bytes
+*/
+/**************************************************************************/
+void cie_Hash::finish(byte *digest) {
+  //Bit length of the message as a 64 bits big endian integer
+  byte bitLength[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+  bitLength[3] = (byte) (_length >> 29);
+  writeWord(bitLength + 4, (uint32_t) (_length << 3));
+
+  _block[_blockLength++] = 0x80;
+  if (_blockLength > HASH_BLOCK_LENGTH - sizeof(bitLength)) {
+    memset(_block + _blockLength, 0, HASH_BLOCK_LENGTH - _blockLength);
+    compress(_block);
+    _blockLength = 0;
+  }
+  memset(_block + _blockLength, 0, HASH_BLOCK_LENGTH - sizeof(bitLength) - _blockLength);
+  memcpy(_block + HASH_BLOCK_LENGTH - sizeof(bitLength), bitLength, sizeof(bitLength));
+  compress(_block);
+  writeDigest(digest);
+  memset(_block, 0, HASH_BLOCK_LENGTH);
+  _blockLength = 0;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Gets the number of bytes fed since begin()
+
+  @returns The length of the data
+*/
+/**************************************************************************/
+unsigned long cie_Hash::getLength() {
+  return _length;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Reads a 32 bits big endian word
+
+  @param buffer The pointer to the 4 bytes of the word
+  @returns The word
+*/
+/**************************************************************************/
+uint32_t cie_Hash::readWord(const byte *buffer) {
+  return ((uint32_t) buffer[0] << 24) | ((uint32_t) buffer[1] << 16) | ((uint32_t) buffer[2] << 8) | buffer[3];
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Writes a 32 bits big endian word
+
+  @param buffer The pointer to a buffer of 4 bytes
+  @param value The word
+*/
+/**************************************************************************/
+void cie_Hash::writeWord(byte *buffer, const uint32_t value) {
+  buffer[0] = (byte) (value >> 24);
+  buffer[1] = (byte) (value >> 16);
+  buffer[2] = (byte) (value >> 8);
+  buffer[3] = (byte) value;
+}
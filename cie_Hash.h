@@ -0,0 +1,72 @@
+/**************************************************************************/
+/*!
+    @file     cie_Hash.h
+    @author   Developers Italia
+	@license  BSD (see License)
+
+	Definition of the cie_Hash abstract class, an incremental Merkle-Damgard hash fed a few bytes at a time
+	(e.g. one page of an Elementary File), so that contents are hashed without being buffered.
+	On AVR the implementations are compact: round constants in flash and a rolling 16 words message schedule.
+	Define CIE_HASH_COMPACT (0 or 1) to force either implementation, e.g. to test the AVR one on a host
+
+	@section  HISTORY
+
+	v1.0  - First definition of the class
+
+*/
+/**************************************************************************/
+#ifndef CIE_HASH
+#define CIE_HASH
+#include <Arduino.h>
+
+#if !defined(CIE_HASH_COMPACT)
+  #if defined(__AVR__)
+    #define CIE_HASH_COMPACT                  (1)
+  #else
+    #define CIE_HASH_COMPACT                  (0)
+  #endif
+#endif
+
+#if defined(__AVR__)
+  #include <avr/pgmspace.h>
+  #define HASH_CONSTANTS                      PROGMEM
+  #define HASH_CONSTANT(table, index)         (pgm_read_dword(&(table)[index]))
+#else
+  #define HASH_CONSTANTS
+  #define HASH_CONSTANT(table, index)         ((table)[index])
+#endif
+
+//Hash algorithms named by the EF_SOD
+#define HASH_ALGORITHM_NONE                   (0x00)
+#define HASH_ALGORITHM_SHA1                   (0x01)
+#define HASH_ALGORITHM_SHA256                 (0x02)
+
+#define HASH_BLOCK_LENGTH                     (0x40)
+#define HASH_MAX_DIGEST_LENGTH                (0x20)
+#define HASH_ROTATE_LEFT(value, bits)         (((value) << (bits)) | ((value) >> (32 - (bits))))
+#define HASH_ROTATE_RIGHT(value, bits)        (((value) >> (bits)) | ((value) << (32 - (bits))))
+
+class cie_Hash {
+  public:
+    cie_Hash();
+    virtual ~cie_Hash() {}
+    void begin();
+    void update(const byte *data, const word length);
+    void finish(byte *digest);
+    unsigned long getLength();
+    virtual byte getDigestLength() = 0;
+
+  protected:
+    virtual void initState() = 0;
+    virtual void compress(const byte *block) = 0;
+    virtual void writeDigest(byte *digest) = 0;
+    static uint32_t readWord(const byte *buffer);
+    static void writeWord(byte *buffer, const uint32_t value);
+
+  private:
+    byte _block[HASH_BLOCK_LENGTH];
+    byte _blockLength;
+    unsigned long _length;
+};
+
+#endif
@@ -4,16 +4,241 @@
     @author   Developers Italia
     @license  BSD (see License)
 
-	Implementation of the cie_Key class describing an encryption key
+	Implementation of the cie_Key and cie_KeyDecoder classes
 
 	@section  HISTORY
 
+	v1.2  - Inline storage, RSAPublicKey decoding and SHA-1 fingerprint
+	v1.1  - Fingerprint of the modulus
 	v1.0  - First implementation of the class
 */
 /**************************************************************************/
 #include "cie_Key.h"
 
-cie_Key::~cie_Key() {
-    delete [] exponent;
-    delete [] modulus;
-}
\ No newline at end of file
+#define PN532DEBUGPRINT Serial
+
+/**************************************************************************/
+/*!
+  @brief Creates an empty key, fill it with set() or cie_PN532::readKey()
+*/
+/**************************************************************************/
+cie_Key::cie_Key() :
+exponentLength(0),
+modulusLength(0),
+_fingerprint(0),
+_hasFingerprint(false)
+{
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Copies the modulus and the exponent into the key
+
+  @param modulus The pointer to the big endian modulus
+  @param modulusLength The length of the modulus, up to KEY_MAX_MODULUS_LENGTH bytes
+  @param exponent The pointer to the big endian exponent
+  @param exponentLength The length of the exponent, up to KEY_MAX_EXPONENT_LENGTH bytes
+
+  @returns A boolean value indicating whether the key fits or not
+*/
+/**************************************************************************/
+bool cie_Key::set(const byte *modulus, const word modulusLength, const byte *exponent, const byte exponentLength) {
+  if (modulusLength == 0 || modulusLength > KEY_MAX_MODULUS_LENGTH || exponentLength == 0 || exponentLength > KEY_MAX_EXPONENT_LENGTH) {
+    PN532DEBUGPRINT.println(F("The key doesn't fit in a cie_Key"));
+    return false;
+  }
+  memmove(this->modulus, modulus, modulusLength);
+  this->modulusLength = modulusLength;
+  memmove(this->exponent, exponent, exponentLength);
+  this->exponentLength = exponentLength;
+  _hasFingerprint = false;
+  return true;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Gets the fingerprint of the modulus, e.g. to look up the precomputed RSA context of a key seen before.
+         Keys decoded by cie_KeyDecoder already have it, the others compute it on the first call
+
+  @returns The fingerprint of the modulus
+*/
+/**************************************************************************/
+unsigned long cie_Key::getFingerprint() {
+  if (!_hasFingerprint) {
+    _fingerprint = cie_Rsa::fingerprint(modulus, modulusLength);
+    _hasFingerprint = true;
+  }
+  return _fingerprint;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Starts decoding a DER encoded RSAPublicKey into a key
+
+  @param key The key to fill
+*/
+/**************************************************************************/
+cie_KeyDecoder::cie_KeyDecoder(cie_Key *key) :
+_key(key),
+_state(KEY_DECODER_TAG),
+_element(KEY_ELEMENT_SEQUENCE),
+_lengthOctets(0),
+_length(0),
+_valueOffset(0),
+_position(0),
+_end(0),
+_significant(false)
+{
+  _key->modulusLength = 0;
+  _key->exponentLength = 0;
+  _key->_hasFingerprint = false;
+  _sha1.begin();
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Decodes the next octets of the RSAPublicKey, e.g. a page just read. The modulus is hashed as it goes
+
+  @param data The pointer to the octets
+  @param length The number of octets
+
+  @returns A boolean value indicating whether the octets are a valid continuation or not
+*/
+/**************************************************************************/
+bool cie_KeyDecoder::update(const byte *data, const word length) {
+  for (word i = 0; i < length && _state != KEY_DECODER_FAILED; i++) {
+    decodeOctet(data[i]);
+  }
+  return _state != KEY_DECODER_FAILED;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Checks the RSAPublicKey is complete and sets the fingerprint of the key
+
+  @returns A boolean value indicating whether the key was decoded or not
+*/
+/**************************************************************************/
+bool cie_KeyDecoder::finish() {
+  byte digest[SHA1_DIGEST_LENGTH];
+  _sha1.finish(digest);
+  if (_state == KEY_DECODER_FAILED || _element != KEY_ELEMENT_NONE || _position != _end) {
+    PN532DEBUGPRINT.println(F("The public key is not a valid RSAPublicKey"));
+    return false;
+  }
+  //Same as cie_Rsa::fingerprint(), without hashing the modulus again
+  _key->_fingerprint = (unsigned long) digest[0] << 24 | (unsigned long) digest[1] << 16 | (unsigned long) digest[2] << 8 | digest[3];
+  _key->_hasFingerprint = true;
+  return true;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Decodes one octet: the tag, the length octets and then the value of each element in turn
+
+  @param octet The octet
+*/
+/**************************************************************************/
+void cie_KeyDecoder::decodeOctet(const byte octet) {
+  _position++;
+  switch (_state) {
+    case KEY_DECODER_TAG:
+      if (_element == KEY_ELEMENT_NONE || octet != (_element == KEY_ELEMENT_SEQUENCE ? 0x30 : 0x02)) {
+        fail();
+        return;
+      }
+      _state = KEY_DECODER_LENGTH;
+    break;
+
+    case KEY_DECODER_LENGTH:
+      if (octet == 0x81 || octet == 0x82) {
+        _lengthOctets = octet & 0b01111111;
+        _length = 0;
+        _state = KEY_DECODER_LONG_LENGTH;
+      } else if (octet < 0x80) {
+        _length = octet;
+        beginValue();
+      } else {
+        fail();
+      }
+    break;
+
+    case KEY_DECODER_LONG_LENGTH:
+      _length = (_length << 8) | octet;
+      if (--_lengthOctets == 0) {
+        beginValue();
+      }
+    break;
+
+    case KEY_DECODER_VALUE:
+      if (_element == KEY_ELEMENT_MODULUS) {
+        _key->modulus[_valueOffset] = octet;
+        //Leading zeroes are not part of the fingerprint
+        _significant = _significant || octet != 0x00;
+        if (_significant) {
+          _sha1.update(&octet, 1);
+        }
+      } else {
+        _key->exponent[_valueOffset] = octet;
+      }
+      if (++_valueOffset == _length) {
+        _element++;
+        _state = KEY_DECODER_TAG;
+      }
+    break;
+  }
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Checks the length of the element just decoded fits the key
+*/
+/**************************************************************************/
+void cie_KeyDecoder::beginValue() {
+  _valueOffset = 0;
+  switch (_element) {
+    case KEY_ELEMENT_SEQUENCE:
+      //The integers follow, as the value of the sequence
+      _end = _position + _length;
+      _element = KEY_ELEMENT_MODULUS;
+      _state = KEY_DECODER_TAG;
+    break;
+
+    case KEY_ELEMENT_MODULUS:
+      if (_length == 0 || _length > KEY_MAX_MODULUS_LENGTH) {
+        fail();
+        return;
+      }
+      _key->modulusLength = _length;
+      _state = KEY_DECODER_VALUE;
+    break;
+
+    case KEY_ELEMENT_EXPONENT:
+      if (_length == 0 || _length > KEY_MAX_EXPONENT_LENGTH) {
+        fail();
+        return;
+      }
+      _key->exponentLength = (byte) _length;
+      _state = KEY_DECODER_VALUE;
+    break;
+  }
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Stops decoding, the key is not valid
+*/
+/**************************************************************************/
+void cie_KeyDecoder::fail() {
+  _state = KEY_DECODER_FAILED;
+  _key->modulusLength = 0;
+  _key->exponentLength = 0;
+}
@@ -4,10 +4,13 @@
     @author   Developers Italia
 	@license  BSD (see License)
 	
-	Definition of the cie_Key class describing an encryption key
+	Definition of the cie_Key class describing an encryption key, and of the cie_KeyDecoder class
+	filling it from a DER encoded RSAPublicKey as the pages of the file are read
 	
 	@section  HISTORY
 
+	v1.2  - Inline storage, RSAPublicKey decoding and SHA-1 fingerprint
+	v1.1  - Fingerprint of the modulus
 	v1.0  - First definition of the class
 	
 */
@@ -16,12 +19,64 @@
 #define CIE_KEY
 
 #include <Arduino.h>
+#include "cie_Rsa.h"
+#include "cie_Sha1.h"
+
+//A DER INTEGER has a leading zero octet when the most significant bit is set
+#define KEY_MAX_MODULUS_LENGTH                (RSA_MAX_MODULUS_LENGTH + 1)
+#define KEY_MAX_EXPONENT_LENGTH               (0x04)
+//RSAPublicKey: SEQUENCE { INTEGER modulus, INTEGER publicExponent }, with up to three length octets each
+#define KEY_MAX_ENCODED_LENGTH                (4 + 4 + KEY_MAX_MODULUS_LENGTH + 4 + KEY_MAX_EXPONENT_LENGTH)
+
+//Decoder states
+#define KEY_DECODER_TAG                       (0x00)
+#define KEY_DECODER_LENGTH                    (0x01)
+#define KEY_DECODER_LONG_LENGTH               (0x02)
+#define KEY_DECODER_VALUE                     (0x03)
+#define KEY_DECODER_FAILED                    (0x04)
+
+//Elements of the RSAPublicKey, in order
+#define KEY_ELEMENT_SEQUENCE                  (0x00)
+#define KEY_ELEMENT_MODULUS                   (0x01)
+#define KEY_ELEMENT_EXPONENT                  (0x02)
+#define KEY_ELEMENT_NONE                      (0x03)
+
 class cie_Key {
   public:
-	~cie_Key();
-	byte *exponent;
+	cie_Key();
+	bool set(const byte *modulus, const word modulusLength, const byte *exponent, const byte exponentLength);
+	unsigned long getFingerprint();
+	byte exponent[KEY_MAX_EXPONENT_LENGTH];
 	byte exponentLength;
-	byte *modulus;
+	byte modulus[KEY_MAX_MODULUS_LENGTH];
 	word modulusLength;
+
+  private:
+	friend class cie_KeyDecoder;
+	unsigned long _fingerprint;
+	bool _hasFingerprint;
+};
+
+class cie_KeyDecoder {
+  public:
+	cie_KeyDecoder(cie_Key *key);
+	bool update(const byte *data, const word length);
+	bool finish();
+
+  private:
+	void decodeOctet(const byte octet);
+	void beginValue();
+	void fail();
+
+	cie_Key *_key;
+	cie_Sha1 _sha1;
+	byte _state;
+	byte _element;
+	byte _lengthOctets;
+	word _length;
+	word _valueOffset;
+	word _position;
+	word _end;
+	bool _significant;
 };
-#endif
\ No newline at end of file
+#endif
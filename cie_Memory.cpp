@@ -0,0 +1,230 @@
+/**************************************************************************/
+/*!
+    @file     cie_Memory.cpp
+    @author   Developers Italia
+    @license  BSD (see License)
+
+	Implementation of the cie_MemoryProbe class: the stack below the operation is painted when
+	it starts and scanned from the bottom when it ends, the heap in use is sampled along the way
+
+	@section  HISTORY
+
+	v1.2  - The stack is scanned from the highest end of the heap seen during the operation
+	v1.1  - The painted stack is bounded by the limit of the stack on each board
+	v1.0  - First implementation of the class
+*/
+/**************************************************************************/
+#include "cie_Memory.h"
+
+/**************************************************************************/
+/*!
+  @brief Creates a disabled probe
+*/
+/**************************************************************************/
+cie_MemoryProbe::cie_MemoryProbe() :
+_enabled(false),
+_depth(0),
+_frame(NULL),
+_paintedBottom(NULL),
+_paintClamped(false),
+_heapAtStart(0),
+_heapPeak(0),
+_heapEndPeak(NULL)
+{
+  memset(&_usage, 0, sizeof(_usage));
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Enables or disables the measurements. Painting the stack takes about a cycle per byte painted
+
+  @param enabled Whether operations are measured
+*/
+/**************************************************************************/
+void cie_MemoryProbe::setEnabled(const bool enabled) {
+  _enabled = enabled;
+  _depth = 0;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Tells whether operations are measured
+
+  @returns  A boolean value indicating whether the probe is enabled or not
+*/
+/**************************************************************************/
+bool cie_MemoryProbe::isEnabled() {
+  return _enabled;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Starts measuring an operation. Operations started by another one are part of it
+
+  @param frame The frame address of the method performing the operation
+*/
+/**************************************************************************/
+void cie_MemoryProbe::begin(byte *frame) {
+  if (!_enabled || _depth++ > 0) {
+    return;
+  }
+  _frame = frame;
+  //Finding the limit of the stack may use the heap on hosts
+  paintStack();
+  _heapAtStart = cie_heapUsed();
+  _heapPeak = _heapAtStart;
+  _heapEndPeak = NULL;
+  sampleHeap();
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Samples the heap in use during an operation, e.g. while an APDU command is exchanged
+*/
+/**************************************************************************/
+void cie_MemoryProbe::sample() {
+  if (_depth > 0) {
+    sampleHeap();
+  }
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Keeps the highest heap in use seen so far and, where the stack grows towards the heap, its highest end
+*/
+/**************************************************************************/
+void cie_MemoryProbe::sampleHeap() {
+  unsigned long heapUsed = cie_heapUsed();
+  if (heapUsed > _heapPeak) {
+    _heapPeak = heapUsed;
+  }
+#if STACK_ABOVE_HEAP
+  //The end of the heap goes down again when its top chunk is freed, but the painted stack stays overwritten
+  byte *heapEnd = stackLimit();
+  if (heapEnd > _heapEndPeak) {
+    _heapEndPeak = heapEnd;
+  }
+#endif
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Ends the measurement of an operation, unless it was started by another one
+*/
+/**************************************************************************/
+void cie_MemoryProbe::end() {
+  if (!_enabled || _depth == 0 || --_depth > 0) {
+    return;
+  }
+  sampleHeap();
+  measureStack();
+  _usage.heap = _heapPeak - _heapAtStart;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Gets the peak usage of the last operation measured
+
+  @returns  The bytes of stack (from the frame of the public method) and heap (above the heap in use when it started)
+*/
+/**************************************************************************/
+cie_MemoryUsage cie_MemoryProbe::getUsage() {
+  return _usage;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Paints the free stack below this function with STACK_PAINT_PATTERN, never past the limit of the stack
+*/
+/**************************************************************************/
+__attribute__((noinline)) void cie_MemoryProbe::paintStack() {
+  byte *top = (byte *) __builtin_frame_address(0) - STACK_PAINT_MARGIN;
+  byte *limit = stackLimit();
+  _paintedBottom = top;
+  _paintClamped = true;
+  if (limit == NULL || (uintptr_t) top <= (uintptr_t) limit + STACK_PAINT_MARGIN) {
+    //Nothing can be painted safely
+    return;
+  }
+  byte *bottom = limit + STACK_PAINT_MARGIN;
+#if !defined(__AVR__)
+  if ((uintptr_t) (top - bottom) > STACK_PAINT_LENGTH) {
+    bottom = top - STACK_PAINT_LENGTH;
+    _paintClamped = false;
+  }
+#else
+  _paintClamped = false;
+#endif
+  for (volatile byte *octet = bottom; octet < top; octet++) {
+    *octet = STACK_PAINT_PATTERN;
+  }
+  _paintedBottom = bottom;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Looks for the deepest byte of the painted stack overwritten since it was painted
+*/
+/**************************************************************************/
+__attribute__((noinline)) void cie_MemoryProbe::measureStack() {
+  volatile byte *octet = _paintedBottom;
+#if STACK_ABOVE_HEAP
+  //The heap might have grown into the painted stack
+  if (_heapEndPeak > octet) {
+    octet = _heapEndPeak;
+  }
+#endif
+  while (octet < _frame && *octet == STACK_PAINT_PATTERN) {
+    octet++;
+  }
+  _usage.stack = _frame - (byte *) octet;
+  _usage.stackOverflowed = octet == _paintedBottom || _paintClamped;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Finds the lowest address the stack of the caller may grow to
+
+  @returns  The limit of the stack: the end of the heap on AVR and ARM boards sharing the RAM between them,
+            the start of the stack of the task on ESP32 and ESP8266 and of the thread on hosts. NULL where it's unknown
+*/
+/**************************************************************************/
+byte *cie_MemoryProbe::stackLimit() {
+#if defined(__AVR__)
+  return (byte *) (__brkval == NULL ? &__heap_start : __brkval);
+#elif defined(__arm__) && !defined(__linux__)
+  return (byte *) sbrk(0);
+#elif defined(ESP32)
+  return (byte *) pxTaskGetStackStart(NULL);
+#elif defined(ESP8266)
+  //Only the loop runs on the cont stack, the system context has a stack of its own
+  byte *stackStart = (byte *) g_pcont->stack;
+  byte *frame = (byte *) __builtin_frame_address(0);
+  return frame > stackStart && frame < (byte *) g_pcont->stack_end ? stackStart : NULL;
+#elif !defined(ARDUINO) && defined(__GLIBC__)
+  pthread_attr_t attributes;
+  void *stackStart;
+  size_t stackSize;
+  if (pthread_getattr_np(pthread_self(), &attributes) != 0) {
+    return NULL;
+  }
+  bool found = pthread_attr_getstack(&attributes, &stackStart, &stackSize) == 0;
+  pthread_attr_destroy(&attributes);
+  return found ? (byte *) stackStart : NULL;
+#elif !defined(ARDUINO) && defined(__APPLE__)
+  pthread_t self = pthread_self();
+  return (byte *) pthread_get_stackaddr_np(self) - pthread_get_stacksize_np(self);
+#else
+  return NULL;
+#endif
+}
@@ -0,0 +1,124 @@
+/**************************************************************************/
+/*!
+    @file     cie_Memory.h
+    @author   Developers Italia
+	@license  BSD (see License)
+
+	The heap in use on each board: the break of the heap on AVR, the allocator statistics
+	of newlib (ARM) and glibc (Linux hosts), the heap size minus the free heap on ESP32.
+	Elsewhere it's unknown and reads as 0.
+	The cie_MemoryProbe class measures the peak stack and heap usage of an operation: the free stack
+	is painted with a pattern before the operation and the deepest byte overwritten is looked for after it
+
+	@section  HISTORY
+
+	v1.3  - The stack is scanned from the highest end of the heap seen during the operation
+	v1.2  - The painted stack is bounded by the limit of the stack on each board
+	v1.1  - Stack painting and peak usage per operation
+	v1.0  - First definition
+
+*/
+/**************************************************************************/
+#ifndef CIE_MEMORY
+#define CIE_MEMORY
+#include <Arduino.h>
+
+#if defined(__AVR__)
+  extern char __heap_start;
+  extern char *__brkval;
+#elif (defined(__arm__) && !defined(__linux__)) || defined(__GLIBC__)
+  #include <malloc.h>
+#endif
+#if defined(__arm__) && !defined(__linux__)
+  extern "C" char *sbrk(int incr);
+#elif defined(ESP32)
+  #include <freertos/FreeRTOS.h>
+  #include <freertos/task.h>
+#elif defined(ESP8266)
+  #include <cont.h>
+#elif !defined(ARDUINO) && (defined(__GLIBC__) || defined(__APPLE__))
+  #include <pthread.h>
+#endif
+
+//The stack grows down towards the heap, which may overwrite the painted stack while growing
+#if defined(__AVR__) || (defined(__arm__) && !defined(__linux__))
+  #define STACK_ABOVE_HEAP                    (1)
+#else
+  #define STACK_ABOVE_HEAP                    (0)
+#endif
+
+#define STACK_PAINT_PATTERN                   (0xA5)
+//Bytes left unpainted right below the painting function, for its own use and for interrupts
+#define STACK_PAINT_MARGIN                    (0x40)
+//Stack painted below the operation, if that much is left before the limit of the stack (the heap on AVR and ARM,
+//the stack of the task on ESP32 and ESP8266). On AVR, everything between the heap and the stack is painted instead
+#if defined(ESP8266)
+  #define STACK_PAINT_LENGTH                  (0x0800)
+#elif !defined(ARDUINO)
+  #define STACK_PAINT_LENGTH                  (0x4000)
+#else
+  #define STACK_PAINT_LENGTH                  (0x1000)
+#endif
+
+//Opens a measured operation in a public method of cie_PN532, closed when the method returns
+#define CIE_MEMORY_SCOPE(probe)               cie_MemoryScope memoryScope((probe), (byte *) __builtin_frame_address(0))
+
+inline unsigned long cie_heapUsed() {
+#if defined(__AVR__)
+  return __brkval == NULL ? 0 : (unsigned long) (__brkval - &__heap_start);
+#elif defined(ESP32)
+  return ESP.getHeapSize() - ESP.getFreeHeap();
+#elif defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+  return mallinfo2().uordblks;
+#elif (defined(__arm__) && !defined(__linux__)) || defined(__GLIBC__)
+  return mallinfo().uordblks;
+#else
+  return 0;
+#endif
+}
+
+struct cie_MemoryUsage {
+  unsigned long stack;
+  unsigned long heap;
+  //The stack usage reached the end of the painted stack, or less than STACK_PAINT_LENGTH was left
+  //to paint before the limit of the stack (none at all where the limit is unknown): the real usage may be higher
+  bool stackOverflowed;
+};
+
+class cie_MemoryProbe {
+  public:
+    cie_MemoryProbe();
+    void setEnabled(const bool enabled);
+    bool isEnabled();
+    void begin(byte *frame);
+    void sample();
+    void end();
+    cie_MemoryUsage getUsage();
+
+  private:
+    void sampleHeap();
+    void paintStack();
+    void measureStack();
+    static byte *stackLimit();
+
+    bool _enabled;
+    byte _depth;
+    byte *_frame;
+    byte *_paintedBottom;
+    bool _paintClamped;
+    unsigned long _heapAtStart;
+    unsigned long _heapPeak;
+    byte *_heapEndPeak;
+    cie_MemoryUsage _usage;
+};
+
+class cie_MemoryScope {
+  public:
+    cie_MemoryScope(cie_MemoryProbe *probe, byte *frame) : _probe(probe) { _probe->begin(frame); }
+    ~cie_MemoryScope() { _probe->end(); }
+
+  private:
+    cie_MemoryProbe *_probe;
+};
+
+#endif
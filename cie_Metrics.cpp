@@ -0,0 +1,163 @@
+/**************************************************************************/
+/*!
+    @file     cie_Metrics.cpp
+    @author   Developers Italia
+    @license  BSD (see License)
+
+	Implementation of the cie_Metrics class: a few additions and shifts per APDU command,
+	histograms saturate instead of wrapping around
+
+	@section  HISTORY
+
+	v1.0  - First implementation of the class
+*/
+/**************************************************************************/
+#include "cie_Metrics.h"
+
+/**************************************************************************/
+/*!
+  @brief Creates the counters, all zero
+*/
+/**************************************************************************/
+cie_Metrics::cie_Metrics() {
+  clear();
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Counts an APDU command with its status word and latency
+
+  @param ins The instruction byte of the plain command
+  @param answered Whether the transport got a response from the card
+  @param response The pointer to the response, ending with the status word
+  @param responseLength The length of the response
+  @param transportMicros The time spent by the reader (the link to the PN532, secure messaging), in microseconds
+  @param cardMicros The time spent by the PN532 and the card, in microseconds
+*/
+/**************************************************************************/
+void cie_Metrics::record(const byte ins, const bool answered, const byte *response, const word responseLength, const unsigned long transportMicros, const unsigned long cardMicros) {
+  cie_InsMetrics *metrics = &_ins[classify(ins)];
+  metrics->count++;
+  metrics->transportMicros += transportMicros;
+  metrics->cardMicros += cardMicros;
+  increment(&metrics->transportHistogram[bucket(transportMicros)]);
+  increment(&metrics->cardHistogram[bucket(cardMicros)]);
+  byte statusWord = METRICS_SW_NO_RESPONSE;
+  if (answered && responseLength >= 2) {
+    byte msByte = response[responseLength-2];
+    if (msByte == 0x90 && response[responseLength-1] == 0x00) {
+      statusWord = METRICS_SW_SUCCESS;
+    } else if (msByte == 0x62 || msByte == 0x63) {
+      statusWord = METRICS_SW_WARNING;
+    } else {
+      statusWord = METRICS_SW_ERROR;
+    }
+  }
+  increment(&metrics->statusWords[statusWord]);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Gets the counters of a class of instructions
+
+  @param insClass The class, e.g. METRICS_INS_READ_BINARY
+
+  @returns  The pointer to the counters, or NULL if the class doesn't exist
+*/
+/**************************************************************************/
+const cie_InsMetrics *cie_Metrics::get(const byte insClass) {
+  if (insClass >= METRICS_INS_COUNT) {
+    return NULL;
+  }
+  return &_ins[insClass];
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Sets every counter to zero
+*/
+/**************************************************************************/
+void cie_Metrics::clear() {
+  memset(_ins, 0, sizeof(_ins));
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Maps an instruction byte to its class of counters
+
+  @param ins The instruction byte
+
+  @returns  The class, e.g. METRICS_INS_SELECT
+*/
+/**************************************************************************/
+byte cie_Metrics::classify(const byte ins) {
+  switch (ins) {
+    case 0xA4:
+      return METRICS_INS_SELECT;
+    //READ BINARY, with the offset in P1-P2 or in the data field (ODD INS)
+    case 0xB0:
+    case 0xB1:
+      return METRICS_INS_READ_BINARY;
+    case 0x22:
+      return METRICS_INS_MSE;
+    case 0x88:
+      return METRICS_INS_INTERNAL_AUTHENTICATE;
+    default:
+      return METRICS_INS_OTHER;
+  }
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Finds the histogram bucket of a latency
+
+  @param micros The latency in microseconds
+
+  @returns  The bucket, from 0 to METRICS_BUCKET_COUNT - 1
+*/
+/**************************************************************************/
+byte cie_Metrics::bucket(unsigned long micros) {
+  micros >>= METRICS_FIRST_BUCKET_SHIFT;
+  byte bucket = 0;
+  while (micros != 0 && bucket < METRICS_BUCKET_COUNT - 1) {
+    micros >>= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Gets the upper limit of a histogram bucket
+
+  @param bucket The bucket, from 0 to METRICS_BUCKET_COUNT - 1
+
+  @returns  The latency in microseconds the bucket stays below, the largest unsigned long for the last one
+*/
+/**************************************************************************/
+unsigned long cie_Metrics::bucketLimit(const byte bucket) {
+  if (bucket >= METRICS_BUCKET_COUNT - 1) {
+    return (unsigned long) -1;
+  }
+  return 1UL << (METRICS_FIRST_BUCKET_SHIFT + bucket);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Increments a histogram counter unless it reached its maximum
+
+  @param counter The pointer to the counter
+*/
+/**************************************************************************/
+void cie_Metrics::increment(word *counter) {
+  if (*counter != 0xFFFF) {
+    (*counter)++;
+  }
+}
@@ -0,0 +1,72 @@
+/**************************************************************************/
+/*!
+    @file     cie_Metrics.h
+    @author   Developers Italia
+	@license  BSD (see License)
+
+	Definition of the cie_Metrics class, counters and latency histograms of the APDU commands sent
+	to the card, by instruction. Define CIE_METRICS as 0 to leave them out (the default on AVR boards)
+
+	@section  HISTORY
+
+	v1.0  - First definition of the class
+
+*/
+/**************************************************************************/
+#ifndef CIE_METRICS_COUNTERS
+#define CIE_METRICS_COUNTERS
+#include <Arduino.h>
+
+#if !defined(CIE_METRICS)
+  #if defined(__AVR__)
+    #define CIE_METRICS                       (0)
+  #else
+    #define CIE_METRICS                       (1)
+  #endif
+#endif
+
+//Instructions with their own counters, the others are counted together
+#define METRICS_INS_SELECT                    (0x00)
+#define METRICS_INS_READ_BINARY               (0x01)
+#define METRICS_INS_MSE                       (0x02)
+#define METRICS_INS_INTERNAL_AUTHENTICATE     (0x03)
+#define METRICS_INS_OTHER                     (0x04)
+#define METRICS_INS_COUNT                     (0x05)
+
+//Status words tallies: 9000, warnings (62XX and 63XX), errors and commands the card didn't answer
+#define METRICS_SW_SUCCESS                    (0x00)
+#define METRICS_SW_WARNING                    (0x01)
+#define METRICS_SW_ERROR                      (0x02)
+#define METRICS_SW_NO_RESPONSE                (0x03)
+#define METRICS_SW_COUNT                      (0x04)
+
+//Latency buckets: below 512 microseconds, then each one twice as wide, the last one up to any time (32 ms and more)
+#define METRICS_BUCKET_COUNT                  (0x08)
+#define METRICS_FIRST_BUCKET_SHIFT            (0x09)
+
+struct cie_InsMetrics {
+  unsigned long count;
+  unsigned long transportMicros;
+  unsigned long cardMicros;
+  word transportHistogram[METRICS_BUCKET_COUNT];
+  word cardHistogram[METRICS_BUCKET_COUNT];
+  word statusWords[METRICS_SW_COUNT];
+};
+
+class cie_Metrics {
+  public:
+    cie_Metrics();
+    void record(const byte ins, const bool answered, const byte *response, const word responseLength, const unsigned long transportMicros, const unsigned long cardMicros);
+    const cie_InsMetrics *get(const byte insClass);
+    void clear();
+    static byte classify(const byte ins);
+    static byte bucket(unsigned long micros);
+    static unsigned long bucketLimit(const byte bucket);
+
+  private:
+    static void increment(word *counter);
+
+    cie_InsMetrics _ins[METRICS_INS_COUNT];
+};
+
+#endif
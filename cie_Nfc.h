@@ -8,6 +8,12 @@
 
 	@section  HISTORY
 
+	v1.6  - BIT_RATE_NONE when the card is lost while negotiating the bit rate
+	v1.5  - Optional time taken by the card to answer the last command
+	v1.4  - Optional limit to the time spent waiting for a response
+	v1.3  - Optional UID and presence check of the activated card
+	v1.2  - Optional ISO/IEC 14443-4 higher bit rates
+	v1.1  - Optional autonomous polling of the RF field
 	v1.0  - Methods for initializing the library, detecting the card and sending APDU commands
 	
 */
@@ -16,12 +22,41 @@
 #define CIE_NFC
 
 #include <Arduino.h>
+
+//ISO/IEC 14443-4 bit rates in kbps
+#define BIT_RATE_NONE                         (0x0000)
+#define BIT_RATE_106                          (0x006A)
+#define BIT_RATE_212                          (0x00D4)
+#define BIT_RATE_424                          (0x01A8)
+#define BIT_RATE_848                          (0x0350)
+
+#define NO_TIMEOUT_LIMIT                      (0x0000)
+
 class cie_Nfc {
 public:
+  virtual ~cie_Nfc() {}
   virtual void begin() = 0;
   virtual bool detectCard() = 0;
   virtual bool sendCommand(byte *command, byte commandLength, byte *response, word *responseLength) = 0;
   virtual void generateRandomBytes(byte *buffer, const word offset, const byte length) = 0;
+
+  //Autonomous polling: once started, detectCard() doesn't block. Transports not supporting it return false
+  virtual bool startAutoPoll(const word pollPeriod) { return false; }
+  virtual void stopAutoPoll() {}
+
+  //Bit rate negotiation right after detection. Transports not supporting it stay at 106 kbps.
+  //BIT_RATE_NONE means the card was lost: it refused a bit rate and couldn't be activated again
+  virtual word negotiateBitRate(const word maxBitRate) { return BIT_RATE_106; }
+
+  //The activated card: transports not knowing its UID return a zero length and report it's not present anymore
+  virtual byte getUid(byte *uidBuffer) { return 0; }
+  virtual bool isCardPresent() { return false; }
+
+  //Caps the time spent waiting for the card, e.g. to meet a deadline. Transports not supporting it ignore the limit
+  virtual void limitTimeout(const word timeout) {}
+
+  //How long the card took to answer the last command, in microseconds. Transports not measuring it return 0
+  virtual unsigned long getCardMicros() { return 0; }
 };
 
 #endif
\ No newline at end of file
@@ -8,6 +8,7 @@
 
 	@section  HISTORY
 
+	v1.1  - Random bytes from a ChaCha20 DRBG seeded once in begin()
 	v1.0  - First implementation of the class
 */
 /**************************************************************************/
@@ -55,6 +56,7 @@ void cie_Nfc_Adafruit::begin() {
   PN532DEBUGPRINT.print(F("Firmware ver. ")); PN532DEBUGPRINT.print((versiondata>>16) & 0b11111111, DEC); 
   PN532DEBUGPRINT.print('.'); PN532DEBUGPRINT.println((versiondata>>8) & 0b11111111, DEC);
   _nfc->SAMConfig();
+  _drbg.begin();
 }
 
 
@@ -99,10 +101,7 @@ bool cie_Nfc_Adafruit::sendCommand(byte *command, byte commandLength, byte *resp
 */
 /**************************************************************************/
 void cie_Nfc_Adafruit::generateRandomBytes(byte *buffer, const word offset, const byte length) {
-  randomSeed(analogRead(0)*micros()); //Use an unconnected analog pin as the random seed
-  for (word i = offset; i<offset+length; i++) {
-    buffer[i] = (byte) random(256);
-  }
+  _drbg.generate(buffer + offset, length);
 }
 
 
@@ -8,11 +8,13 @@
 
 	@section  HISTORY
 
+	v1.1  - Random bytes from a ChaCha20 DRBG
 	v1.0  - First definition
 */
 /**************************************************************************/
 #include <Adafruit_PN532.h>
 #include "cie_Nfc.h"
+#include "cie_Drbg.h"
 
 #ifndef CIE_NFC_ADAFRUIT
 #define CIE_NFC_ADAFRUIT
@@ -30,6 +32,7 @@ class cie_Nfc_Adafruit : public cie_Nfc {
 
   private:
     Adafruit_PN532 *_nfc;
+    cie_Drbg _drbg;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,719 @@
+/**************************************************************************/
+/*!
+    @file     cie_Nfc_Frame.cpp
+    @author   Developers Italia
+    @license  BSD (see License)
+
+	Implementation of the cie_Nfc abstract class speaking the PN532 frame protocol directly.
+	Please refer to the PN532 User Manual, section 6.2 "Host controller communication protocol"
+	https://www.nxp.com/docs/en/user-guide/141520.pdf
+
+	@section  HISTORY
+
+	v1.8  - No halt when the PN532 is not found, detectCard() fails instead
+	v1.7  - Reports the card lost when it can't be activated again after refusing a bit rate
+	v1.6  - Time taken by the card to answer the last command
+	v1.5  - Random bytes from a ChaCha20 DRBG seeded once in begin()
+	v1.4  - Timeout limit, e.g. to meet a deadline
+	v1.3  - UID of the activated card, presence check with Diagnose
+	v1.2  - Bit rate negotiation (InPSL) with fallback to lower bit rates
+	v1.1  - Autonomous polling (InAutoPoll) for non-blocking card detection
+	v1.0  - Normal and extended information frames, IRQ driven waiting
+*/
+/**************************************************************************/
+#include "cie_Nfc_Frame.h"
+
+#define PN532DEBUGPRINT Serial
+
+volatile bool cie_Nfc_Frame::_irqFired = false;
+
+/**************************************************************************/
+/*!
+  @brief Create with the pin connected to the PN532 IRQ line
+
+  @param  irq The IRQ pin number, or NO_IRQ to poll the PN532 status instead
+*/
+/**************************************************************************/
+cie_Nfc_Frame::cie_Nfc_Frame (byte irq) :
+_irq(irq),
+_idleCallback(NULL),
+_pn532Found(false),
+_timeout(FRAME_DEFAULT_TIMEOUT),
+_timeoutLimit(NO_TIMEOUT_LIMIT),
+_cardMicros(0),
+_target(0x01),
+_uidLength(0),
+_atsLength(0),
+_autoPollPeriod(0),
+_autoPollArmed(false),
+_bitRate(FRAME_BIT_RATE_106),
+_bitRateLimit(FRAME_BIT_RATE_848)
+{
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Initializes the link and the PN532 board. If the PN532 doesn't answer, every detectCard() fails
+          until begin() is called again and finds it
+*/
+/**************************************************************************/
+void cie_Nfc_Frame::begin() {
+  if (_irq != NO_IRQ) {
+    pinMode(_irq, INPUT_PULLUP);
+    attachInterrupt(digitalPinToInterrupt(_irq), handleIrq, FALLING);
+  }
+  _pn532Found = false;
+  beginLink();
+
+  byte getFirmwareVersion[] = { FRAME_GET_FIRMWARE_VERSION };
+  byte versiondata[4];
+  word versionLength = sizeof(versiondata);
+  if (!exchange(getFirmwareVersion, sizeof(getFirmwareVersion), NULL, 0, NULL, versiondata, &versionLength) || versionLength < 3) {
+    PN532DEBUGPRINT.println(F("Didn't find PN53x board"));
+    return;
+  }
+  _pn532Found = true;
+  // Got ok data, print it out!
+  PN532DEBUGPRINT.print(F("Found chip PN5")); PN532DEBUGPRINT.println(versiondata[0], HEX);
+  PN532DEBUGPRINT.print(F("Firmware ver. ")); PN532DEBUGPRINT.print(versiondata[1], DEC);
+  PN532DEBUGPRINT.print('.'); PN532DEBUGPRINT.println(versiondata[2], DEC);
+
+  byte samConfiguration[] = {
+    FRAME_SAM_CONFIGURATION,
+    0x01, //Normal mode, the SAM is not used
+    0x14, //Timeout: 50ms * 20 = 1 second
+    0x01  //The PN532 drives the IRQ line
+  };
+  byte rfConfiguration[] = {
+    FRAME_RF_CONFIGURATION,
+    0x05, //CfgItem: MaxRetries
+    0xFF, //MxRtyATR: default
+    0x01, //MxRtyPSL: default
+    0x02  //MxRtyPassiveActivation: give up quickly when no card is in the field
+  };
+  word responseLength = 0;
+  exchange(samConfiguration, sizeof(samConfiguration), NULL, 0, NULL, NULL, &responseLength);
+  responseLength = 0;
+  exchange(rfConfiguration, sizeof(rfConfiguration), NULL, 0, NULL, NULL, &responseLength);
+  _drbg.begin();
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Attempts at detecting a card (will succeed if a card is present).
+          While autonomous polling is on, it just checks whether the PN532 found a card, without waiting
+
+  @returns  A boolean value indicating whether a card was detected or not (always false if begin() didn't find the PN532)
+*/
+/**************************************************************************/
+bool cie_Nfc_Frame::detectCard() {
+  if (!_pn532Found) {
+    return false;
+  }
+  if (_autoPollPeriod > 0) {
+    byte inAutoPoll[] = {
+      FRAME_IN_AUTO_POLL,
+      0xFF, //PollNr: endless, the PN532 answers when it finds a card
+      _autoPollPeriod, //Period: in units of 150 ms
+      0x20  //Type1: passive 106 kbps ISO/IEC14443-4A
+    };
+    if (!_autoPollArmed) {
+      _autoPollArmed = request(inAutoPoll, sizeof(inAutoPoll), NULL, 0);
+      return false;
+    }
+    if (!isReady()) {
+      return false;
+    }
+    _autoPollArmed = false;
+    _bitRate = FRAME_BIT_RATE_106;
+    _uidLength = 0;
+    byte response[FRAME_RESPONSE_HEADER_LENGTH + FRAME_MAX_UID_LENGTH + FRAME_MAX_ATS_LENGTH];
+    word responseLength = sizeof(response);
+    //NbTg, Type1, Length1, TargetData1
+    return readResponse(FRAME_IN_AUTO_POLL, NULL, response, &responseLength)
+        && responseLength >= 3 && response[0] > 0
+        && parseTarget(response + 3, responseLength - 3);
+  }
+
+  return listPassiveTarget();
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Activates a card in the field with InListPassiveTarget
+
+  @returns  A boolean value indicating whether a card was activated or not
+*/
+/**************************************************************************/
+bool cie_Nfc_Frame::listPassiveTarget() {
+  byte response[FRAME_RESPONSE_HEADER_LENGTH + FRAME_MAX_UID_LENGTH + FRAME_MAX_ATS_LENGTH];
+  word responseLength = sizeof(response);
+  byte inListPassiveTarget[] = {
+    FRAME_IN_LIST_PASSIVE_TARGET,
+    0x01, //MaxTg: just one card at a time
+    0x00  //BrTy: 106 kbps type A (ISO/IEC14443 Type A)
+  };
+  //A freshly activated card always starts at 106 kbps
+  _bitRate = FRAME_BIT_RATE_106;
+  _uidLength = 0;
+  //NbTg, TargetData1
+  return exchange(inListPassiveTarget, sizeof(inListPassiveTarget), NULL, 0, NULL, response, &responseLength)
+      && responseLength >= 1 && response[0] > 0
+      && parseTarget(response + 1, responseLength - 1);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Lets the PN532 watch the RF field by itself (InAutoPoll), so that detectCard() returns immediately
+
+  @param  pollPeriod The time between two polls in milliseconds, rounded to multiples of 150 ms
+
+  @returns  Always true, autonomous polling is supported
+*/
+/**************************************************************************/
+bool cie_Nfc_Frame::startAutoPoll(const word pollPeriod) {
+  word period = (pollPeriod + FRAME_AUTO_POLL_UNIT / 2) / FRAME_AUTO_POLL_UNIT;
+  _autoPollPeriod = period < 1 ? 1 : (period > 15 ? 15 : period);
+  return true;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Stops the autonomous polling, aborting the pending InAutoPoll command if any
+*/
+/**************************************************************************/
+void cie_Nfc_Frame::stopAutoPoll() {
+  if (_autoPollArmed) {
+    abort();
+  }
+  _autoPollArmed = false;
+  _autoPollPeriod = 0;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Switches to the fastest bit rate supported by both the PN532 and the card.
+          If the card doesn't accept a bit rate, it gets activated again and the next lower one is tried
+
+  @param  maxBitRate The fastest bit rate allowed, in kbps (BIT_RATE_106 to BIT_RATE_848)
+
+  @returns  The bit rate in use, in kbps, or BIT_RATE_NONE if the card couldn't be activated again after refusing a bit rate
+*/
+/**************************************************************************/
+word cie_Nfc_Frame::negotiateBitRate(const word maxBitRate) {
+  byte bitRates = cardBitRates() & FRAME_PN532_BIT_RATES;
+  for (byte bitRate = FRAME_BIT_RATE_848; bitRate > FRAME_BIT_RATE_106; bitRate--) {
+    if ((bitRates & (1 << (bitRate - 1))) == 0 || bitRate > _bitRateLimit || (BIT_RATE_106 << bitRate) > maxBitRate) {
+      continue;
+    }
+    if (changeBitRate(bitRate)) {
+      return BIT_RATE_106 << bitRate;
+    }
+    //The card may have been left in an unknown state, and it accepts just one PPS after activation
+    if (!listPassiveTarget()) {
+      PN532DEBUGPRINT.println(F("The card was lost while negotiating the bit rate"));
+      return BIT_RATE_NONE;
+    }
+  }
+  return BIT_RATE_106 << _bitRate;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Reads the bit rates supported by the card from the interface byte TA(1) of its ATS
+
+  @returns  One bit per bit rate supported in both directions: 0x01 212 kbps, 0x02 424 kbps, 0x04 848 kbps
+*/
+/**************************************************************************/
+byte cie_Nfc_Frame::cardBitRates() {
+  //TL, T0, TA(1): TA(1) is present when bit 5 of the format byte T0 is set
+  if (_atsLength < 3 || (_ats[1] & 0x10) == 0) {
+    return 0x00;
+  }
+  //Bits 7 to 5 are the PICC to PCD bit rates (DS), bits 3 to 1 the PCD to PICC bit rates (DR)
+  byte ta = _ats[2];
+  return (ta >> 4) & ta & 0b111;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Changes the bit rate in both directions with InPSL
+
+  @param  bitRate The bit rate code (0x00 106 kbps to 0x03 848 kbps)
+
+  @returns  A boolean value indicating whether the card accepted the bit rate or not
+*/
+/**************************************************************************/
+bool cie_Nfc_Frame::changeBitRate(const byte bitRate) {
+  byte inPsl[] = {
+    FRAME_IN_PSL,
+    _target,
+    bitRate, //BRit: PN532 to card
+    bitRate  //BRti: card to PN532
+  };
+  byte status = 0xFF;
+  word responseLength = 0;
+  if (!exchange(inPsl, sizeof(inPsl), NULL, 0, &status, NULL, &responseLength) || (status & 0b111111) != 0x00) {
+    PN532DEBUGPRINT.print(F("The card refused "));
+    PN532DEBUGPRINT.print(BIT_RATE_106 << bitRate);
+    PN532DEBUGPRINT.println(F(" kbps"));
+    return false;
+  }
+  _bitRate = bitRate;
+  return true;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Copies the UID of the activated card
+
+  @param  uidBuffer The pointer to a buffer of at least FRAME_MAX_UID_LENGTH bytes
+
+  @returns  The length of the UID, zero if no card was activated
+*/
+/**************************************************************************/
+byte cie_Nfc_Frame::getUid(byte *uidBuffer) {
+  memcpy(uidBuffer, _uid, _uidLength);
+  return _uidLength;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Checks whether the activated card is still in the field, without activating it again
+
+  @returns  A boolean value indicating whether the card answered or not
+*/
+/**************************************************************************/
+bool cie_Nfc_Frame::isCardPresent() {
+  if (_uidLength == 0) {
+    return false;
+  }
+  byte diagnose[] = { FRAME_DIAGNOSE, FRAME_DIAGNOSE_CARD_PRESENCE };
+  byte status = 0xFF;
+  word responseLength = 0;
+  bool present = exchange(diagnose, sizeof(diagnose), NULL, 0, &status, NULL, &responseLength) && status == 0x00;
+  if (!present) {
+    //Once it's gone, it must be activated again
+    _uidLength = 0;
+  }
+  return present;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Stores the target number, UID and ATS of a detected card
+
+  @param  target The target data: Tg, SENS_RES (2 bytes), SEL_RES, NFCIDLength, NFCID1, ATS
+  @param  length The length of the target data
+
+  @returns  A boolean value indicating whether the target data was valid or not
+*/
+/**************************************************************************/
+bool cie_Nfc_Frame::parseTarget(const byte *target, const word length) {
+  if (length < 5 || target[4] > FRAME_MAX_UID_LENGTH || 5 + target[4] > length) {
+    _uidLength = 0;
+    return false;
+  }
+  _target = target[0];
+  _uidLength = target[4];
+  memcpy(_uid, target + 5, _uidLength);
+  word atsOffset = 5 + _uidLength;
+  _atsLength = 0;
+  if (atsOffset < length && target[atsOffset] <= FRAME_MAX_ATS_LENGTH && atsOffset + target[atsOffset] <= length) {
+    //The first ATS byte (TL) is the length of the ATS, including itself
+    _atsLength = target[atsOffset];
+    memcpy(_ats, target + atsOffset, _atsLength);
+  }
+  return true;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Sends an APDU command to the CIE via the PN532 terminal
+
+  @param  command A pointer to the APDU command bytes
+  @param  commandLength Length of the command
+  @param  response A pointer to the buffer which will contain the response bytes
+  @param  responseLength The length of the desired response, which will be set to the actual response length
+
+  @returns  A boolean value indicating whether the operation succeeded or not
+*/
+/**************************************************************************/
+bool cie_Nfc_Frame::sendCommand(byte *command, byte commandLength, byte *response, word *responseLength) {
+  byte inDataExchange[] = { FRAME_IN_DATA_EXCHANGE, _target };
+  //The first byte in the response is the status of the exchange, the APDU response follows
+  byte status = 0xFF;
+  if (!exchange(inDataExchange, sizeof(inDataExchange), command, commandLength, &status, response, responseLength)) {
+    return false;
+  }
+  if ((status & 0b111111) != 0x00) {
+    PN532DEBUGPRINT.print(F("InDataExchange failed with status 0x"));
+    PN532DEBUGPRINT.println(status, HEX);
+    if ((status & 0b111111) <= FRAME_STATUS_MAX_RF_ERROR && _bitRate > FRAME_BIT_RATE_106) {
+      //The link is not reliable at this bit rate: next cards will be negotiated at a lower one
+      _bitRateLimit = _bitRate - 1;
+    }
+    return false;
+  }
+  return true;
+}
+
+
+/**************************************************************************/
+/*!
+    @brief  Populates a buffer with random generated bytes
+
+    @param  buffer The pointer to a byte array
+    @param  offset The starting offset in the buffer
+    @param  length The number of random bytes to generate
+
+*/
+/**************************************************************************/
+void cie_Nfc_Frame::generateRandomBytes(byte *buffer, const word offset, const byte length) {
+  _drbg.generate(buffer + offset, length);
+}
+
+
+/**************************************************************************/
+/*!
+    @brief  Gets how long the PN532 took to exchange the last command with the card, from its ACK to its response
+
+    @returns  The time in microseconds
+*/
+/**************************************************************************/
+unsigned long cie_Nfc_Frame::getCardMicros() {
+  return _cardMicros;
+}
+
+
+/**************************************************************************/
+/*!
+    @brief  Sets how long to wait for the PN532 response to a command
+
+    @param  timeout The timeout in milliseconds
+*/
+/**************************************************************************/
+void cie_Nfc_Frame::setTimeout(const word timeout) {
+  _timeout = timeout;
+}
+
+
+/**************************************************************************/
+/*!
+    @brief  Waits less than the timeout for the next responses, e.g. when a deadline is close
+
+    @param  timeout The maximum time to wait in milliseconds, or NO_TIMEOUT_LIMIT to wait up to the timeout
+*/
+/**************************************************************************/
+void cie_Nfc_Frame::limitTimeout(const word timeout) {
+  _timeoutLimit = timeout;
+}
+
+
+/**************************************************************************/
+/*!
+    @brief  Sets a function which will be invoked repeatedly while the PN532 is busy exchanging data with the card.
+            Use it to do other work or to put the CPU to sleep until irqFired() becomes true
+
+    @param  callback The function to invoke, or NULL to just yield
+*/
+/**************************************************************************/
+void cie_Nfc_Frame::setIdleCallback(cieIdleCallbackFunc callback) {
+  _idleCallback = callback;
+}
+
+
+/**************************************************************************/
+/*!
+    @brief  Tells whether the IRQ line signalled a response since the last command was sent
+
+    @returns  A boolean value indicating whether the IRQ fired or not
+*/
+/**************************************************************************/
+bool cie_Nfc_Frame::irqFired() {
+  return _irqFired;
+}
+
+
+/**************************************************************************/
+/*!
+    @brief  Sends a command frame, waits for its ACK and then for the response frame
+
+    @param  header The pointer to the command code and its parameters
+    @param  headerLength The length of the header
+    @param  data The pointer to the data following the header (can be NULL)
+    @param  dataLength The length of the data
+    @param  status The pointer to the status byte preceding the response data, for commands which have one (can be NULL)
+    @param  response The pointer to the buffer which will contain the response data (following the response code)
+    @param  responseLength The capacity of the buffer, which will be set to the actual response length
+
+    @returns  A boolean value indicating whether the operation succeeded or not
+*/
+/**************************************************************************/
+bool cie_Nfc_Frame::exchange(const byte *header, const byte headerLength, const byte *data, const word dataLength, byte *status, byte *response, word *responseLength) {
+  if (!request(header, headerLength, data, dataLength)) {
+    return false;
+  }
+  word timeout = _timeoutLimit != NO_TIMEOUT_LIMIT && _timeoutLimit < _timeout ? _timeoutLimit : _timeout;
+  //From the ACK to the response the PN532 talks to the card
+  unsigned long startedAt = micros();
+  bool ready = waitReady(timeout);
+  _cardMicros = micros() - startedAt;
+  if (!ready) {
+    PN532DEBUGPRINT.println(F("Timeout while waiting for the PN532 response"));
+    abort();
+    return false;
+  }
+  return readResponse(header[0], status, response, responseLength);
+}
+
+
+/**************************************************************************/
+/*!
+    @brief  Sends a command frame and waits for its ACK, without waiting for the response
+
+    @param  header The pointer to the command code and its parameters
+    @param  headerLength The length of the header
+    @param  data The pointer to the data following the header (can be NULL)
+    @param  dataLength The length of the data
+
+    @returns  A boolean value indicating whether the PN532 accepted the command or not
+*/
+/**************************************************************************/
+bool cie_Nfc_Frame::request(const byte *header, const byte headerLength, const byte *data, const word dataLength) {
+  if (_autoPollArmed) {
+    //The PN532 processes one command at a time
+    abort();
+    _autoPollArmed = false;
+  }
+  _irqFired = false;
+  if (!writeFrame(header, headerLength, data, dataLength)) {
+    return false;
+  }
+  if (!waitReady(FRAME_ACK_TIMEOUT) || !readAck()) {
+    PN532DEBUGPRINT.println(F("The PN532 didn't acknowledge the command"));
+    return false;
+  }
+  _irqFired = false;
+  return true;
+}
+
+
+/**************************************************************************/
+/*!
+    @brief  Writes a normal or extended information frame, without copying the data
+
+    @param  header The pointer to the command code and its parameters
+    @param  headerLength The length of the header
+    @param  data The pointer to the data following the header (can be NULL)
+    @param  dataLength The length of the data
+
+    @returns  A boolean value indicating whether the operation succeeded or not
+*/
+/**************************************************************************/
+bool cie_Nfc_Frame::writeFrame(const byte *header, const byte headerLength, const byte *data, const word dataLength) {
+  word length = 1 + headerLength + dataLength; //TFI included
+  byte checksum = FRAME_HOST_TO_PN532;
+  for (byte i = 0; i < headerLength; i++) {
+    checksum += header[i];
+  }
+  for (word i = 0; i < dataLength; i++) {
+    checksum += data[i];
+  }
+
+  byte start[] = { FRAME_PREAMBLE, FRAME_START_CODE_1, FRAME_START_CODE_2 };
+  byte normalLength[] = { (byte) length, (byte) (~length + 1) };
+  byte extendedLength[] = {
+    FRAME_EXTENDED_LENGTH, FRAME_EXTENDED_LENGTH,
+    (byte) (length >> 8), (byte) (length & 0b11111111),
+    (byte) (~((length >> 8) + (length & 0b11111111)) + 1)
+  };
+  byte tfi = FRAME_HOST_TO_PN532;
+  byte end[] = { (byte) (~checksum + 1), FRAME_POSTAMBLE };
+
+  beginWrite();
+  writeBytes(start, sizeof(start));
+  if (length > 0xFF) {
+    writeBytes(extendedLength, sizeof(extendedLength));
+  } else {
+    writeBytes(normalLength, sizeof(normalLength));
+  }
+  writeBytes(&tfi, 1);
+  writeBytes(header, headerLength);
+  if (dataLength > 0) {
+    writeBytes(data, dataLength);
+  }
+  writeBytes(end, sizeof(end));
+  endWrite();
+  return true;
+}
+
+
+/**************************************************************************/
+/*!
+    @brief  Reads the ACK frame the PN532 sends when it accepts a command
+
+    @returns  A boolean value indicating whether an ACK frame was received or not
+*/
+/**************************************************************************/
+bool cie_Nfc_Frame::readAck() {
+  const byte ack[FRAME_ACK_LENGTH] = { 0x00, 0x00, 0xFF, 0x00, 0xFF, 0x00 };
+  byte buffer[FRAME_ACK_LENGTH];
+  beginRead();
+  bool success = readBytes(buffer, FRAME_ACK_LENGTH);
+  endRead();
+  return success && memcmp(buffer, ack, FRAME_ACK_LENGTH) == 0;
+}
+
+
+/**************************************************************************/
+/*!
+    @brief  Reads a normal or extended response frame, copying its data straight into the response buffer
+
+    @param  command The command code this frame is a response to
+    @param  status The pointer to the status byte preceding the response data (can be NULL)
+    @param  response The pointer to the buffer which will contain the response data
+    @param  responseLength The capacity of the buffer, which will be set to the actual response length
+
+    @returns  A boolean value indicating whether a valid response was received or not
+*/
+/**************************************************************************/
+bool cie_Nfc_Frame::readResponse(const byte command, byte *status, byte *response, word *responseLength) {
+  byte octet = 0x00;
+  byte skippedOctets = 0;
+  byte lengths[3];
+  word length;
+  bool success = false;
+
+  beginRead();
+  //Preamble and start codes: look for the 0xFF start code
+  do {
+    if (!readBytes(&octet, 1) || ++skippedOctets > 8) {
+      endRead();
+      PN532DEBUGPRINT.println(F("Invalid PN532 response frame"));
+      return false;
+    }
+  } while (octet != FRAME_START_CODE_2);
+
+  if (!readBytes(lengths, 2)) {
+    endRead();
+    return false;
+  }
+  if (lengths[0] == FRAME_EXTENDED_LENGTH && lengths[1] == FRAME_EXTENDED_LENGTH) {
+    if (!readBytes(lengths, 3) || (byte) (lengths[0] + lengths[1] + lengths[2]) != 0x00) {
+      endRead();
+      PN532DEBUGPRINT.println(F("Invalid PN532 extended frame length"));
+      return false;
+    }
+    length = ((word) lengths[0] << 8) | lengths[1];
+  } else {
+    if ((byte) (lengths[0] + lengths[1]) != 0x00) {
+      endRead();
+      PN532DEBUGPRINT.println(F("Invalid PN532 frame length"));
+      return false;
+    }
+    length = lengths[0];
+  }
+
+  byte codes[3];
+  byte codesLength = status != NULL ? 3 : 2;
+  if (length < codesLength || !readBytes(codes, codesLength)) {
+    //A single byte frame is an error frame
+    endRead();
+    PN532DEBUGPRINT.println(F("The PN532 returned an error frame"));
+    return false;
+  }
+  byte checksum = codes[0] + codes[1];
+  if (status != NULL) {
+    *status = codes[2];
+    checksum += codes[2];
+  }
+  word dataLength = length - codesLength;
+  word copiedLength = dataLength < *responseLength ? dataLength : *responseLength;
+  bool readable = copiedLength == 0 || readBytes(response, copiedLength);
+  for (word i = 0; i < copiedLength; i++) {
+    checksum += response[i];
+  }
+  //Discard what doesn't fit in the response buffer
+  for (word i = copiedLength; i < dataLength; i++) {
+    readBytes(&octet, 1);
+    checksum += octet;
+  }
+  byte end[2];
+  if (readBytes(end, 2)) {
+    success = readable
+           && (byte) (checksum + end[0]) == 0x00
+           && codes[0] == FRAME_PN532_TO_HOST
+           && codes[1] == command + 1
+           && copiedLength == dataLength;
+  }
+  endRead();
+  *responseLength = copiedLength;
+  if (!success) {
+    PN532DEBUGPRINT.println(F("Invalid PN532 response frame"));
+  }
+  return success;
+}
+
+
+/**************************************************************************/
+/*!
+    @brief  Waits for the PN532 to be ready, invoking the idle callback in the meantime
+
+    @param  timeout The timeout in milliseconds
+
+    @returns  A boolean value indicating whether the PN532 became ready or not
+*/
+/**************************************************************************/
+bool cie_Nfc_Frame::waitReady(const word timeout) {
+  unsigned long startedAt = millis();
+  while (!isReady()) {
+    if (millis() - startedAt > timeout) {
+      return false;
+    }
+    if (_idleCallback != NULL) {
+      _idleCallback();
+    } else if (_irq == NO_IRQ) {
+      //Don't flood the link with status requests
+      delay(1);
+    } else {
+      yield();
+    }
+  }
+  return true;
+}
+
+
+/**************************************************************************/
+/*!
+    @brief  Aborts the command the PN532 is currently processing by sending an ACK frame
+*/
+/**************************************************************************/
+void cie_Nfc_Frame::abort() {
+  const byte ack[FRAME_ACK_LENGTH] = { 0x00, 0x00, 0xFF, 0x00, 0xFF, 0x00 };
+  beginWrite();
+  writeBytes(ack, FRAME_ACK_LENGTH);
+  endWrite();
+}
+
+
+/**************************************************************************/
+/*!
+    @brief  Interrupt service routine for the IRQ line. It's just a wake up signal: readiness is checked on the line level
+*/
+/**************************************************************************/
+void cie_Nfc_Frame::handleIrq() {
+  _irqFired = true;
+}
@@ -0,0 +1,136 @@
+/**************************************************************************/
+/*!
+    @file     cie_Nfc_Frame.h
+    @author   Developers Italia
+    @license  BSD (see License)
+
+	Definition of a cie_Nfc abstract class speaking the PN532 frame protocol directly,
+	leaving to subclasses just the physical link (SPI, I2C or HSU)
+
+	@section  HISTORY
+
+	v1.7  - No halt when the PN532 is not found, detectCard() fails instead
+	v1.6  - Time taken by the card to answer the last command
+	v1.5  - ChaCha20 DRBG
+	v1.4  - Timeout limit
+	v1.3  - UID and presence check with Diagnose
+	v1.2  - Bit rate negotiation with InPSL
+	v1.1  - Autonomous polling with InAutoPoll
+	v1.0  - First definition
+*/
+/**************************************************************************/
+#include "cie_Nfc.h"
+#include "cie_Drbg.h"
+
+#ifndef CIE_NFC_FRAME
+#define CIE_NFC_FRAME
+
+//Frame delimiters
+#define FRAME_PREAMBLE                        (0x00)
+#define FRAME_START_CODE_1                    (0x00)
+#define FRAME_START_CODE_2                    (0xFF)
+#define FRAME_POSTAMBLE                       (0x00)
+#define FRAME_HOST_TO_PN532                   (0xD4)
+#define FRAME_PN532_TO_HOST                   (0xD5)
+#define FRAME_EXTENDED_LENGTH                 (0xFF)
+#define FRAME_ACK_LENGTH                      (0x06)
+
+//PN532 commands
+#define FRAME_GET_FIRMWARE_VERSION            (0x02)
+#define FRAME_RF_CONFIGURATION                (0x32)
+#define FRAME_IN_DATA_EXCHANGE                (0x40)
+#define FRAME_IN_LIST_PASSIVE_TARGET          (0x4A)
+#define FRAME_IN_AUTO_POLL                    (0x60)
+#define FRAME_IN_PSL                          (0x4E)
+#define FRAME_DIAGNOSE                        (0x00)
+#define FRAME_DIAGNOSE_CARD_PRESENCE          (0x06)
+
+//Bit rates, coded as in InPSL: 106 kbps shifted left by the code
+#define FRAME_BIT_RATE_106                    (0x00)
+#define FRAME_BIT_RATE_848                    (0x03)
+//The PN532 supports 212 and 424 kbps for ISO/IEC 14443-4 type A cards (one bit per rate above 106 kbps)
+#define FRAME_PN532_BIT_RATES                 (0b011)
+//InDataExchange status codes from 0x01 (timeout) to 0x06 (bit collision) are RF errors
+#define FRAME_STATUS_MAX_RF_ERROR             (0x06)
+#define FRAME_SAM_CONFIGURATION               (0x14)
+
+//Lengths
+#define FRAME_MAX_UID_LENGTH                  (0x0A)
+#define FRAME_MAX_ATS_LENGTH                  (0x14)
+#define FRAME_RESPONSE_HEADER_LENGTH          (0x10)
+
+//Timeouts in milliseconds
+#define FRAME_ACK_TIMEOUT                     (0x0A)
+#define FRAME_DEFAULT_TIMEOUT                 (0x07D0)
+#define FRAME_AUTO_POLL_UNIT                  (0x96)
+
+#define NO_IRQ                                (0xFF)
+
+typedef void (*cieIdleCallbackFunc)(void);
+
+class cie_Nfc_Frame : public cie_Nfc {
+  public:
+    cie_Nfc_Frame(byte irq);
+
+    void begin();
+    bool detectCard();
+    bool sendCommand(byte *command, byte commandLength, byte *response, word *responseLength);
+    void generateRandomBytes(byte *buffer, const word offset, const byte length);
+    bool startAutoPoll(const word pollPeriod);
+    void stopAutoPoll();
+    word negotiateBitRate(const word maxBitRate);
+    byte getUid(byte *uidBuffer);
+    bool isCardPresent();
+    void limitTimeout(const word timeout);
+    unsigned long getCardMicros();
+
+    void setTimeout(const word timeout);
+    void setIdleCallback(cieIdleCallbackFunc callback);
+    static bool irqFired();
+
+  protected:
+    //Physical link, implemented by subclasses
+    virtual void beginLink() = 0;
+    virtual void beginWrite() = 0;
+    virtual void writeBytes(const byte *buffer, const word length) = 0;
+    virtual void endWrite() = 0;
+    virtual bool isReady() = 0;
+    virtual void beginRead() = 0;
+    virtual bool readBytes(byte *buffer, const word length) = 0;
+    virtual void endRead() = 0;
+    virtual bool waitReady(const word timeout);
+
+    byte _irq;
+    cieIdleCallbackFunc _idleCallback;
+
+  private:
+    bool exchange(const byte *header, const byte headerLength, const byte *data, const word dataLength, byte *status, byte *response, word *responseLength);
+    bool request(const byte *header, const byte headerLength, const byte *data, const word dataLength);
+    bool parseTarget(const byte *target, const word length);
+    bool listPassiveTarget();
+    byte cardBitRates();
+    bool changeBitRate(const byte bitRate);
+    bool writeFrame(const byte *header, const byte headerLength, const byte *data, const word dataLength);
+    bool readAck();
+    bool readResponse(const byte command, byte *status, byte *response, word *responseLength);
+    void abort();
+    static void handleIrq();
+
+    bool _pn532Found;
+    word _timeout;
+    word _timeoutLimit;
+    unsigned long _cardMicros;
+    byte _target;
+    byte _uid[FRAME_MAX_UID_LENGTH];
+    byte _uidLength;
+    byte _ats[FRAME_MAX_ATS_LENGTH];
+    byte _atsLength;
+    byte _autoPollPeriod;
+    bool _autoPollArmed;
+    byte _bitRate;
+    byte _bitRateLimit;
+    cie_Drbg _drbg;
+    static volatile bool _irqFired;
+};
+
+#endif
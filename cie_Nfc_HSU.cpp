@@ -0,0 +1,240 @@
+/**************************************************************************/
+/*!
+    @file     cie_Nfc_HSU.cpp
+    @author   Developers Italia
+    @license  BSD (see License)
+
+	Implementation of the cie_Nfc_Frame class over a PN532 HSU (High Speed UART) link
+	opened as a POSIX serial device, for Linux hosts. The HSU link runs at 115200 bps, 8N1
+
+	@section  HISTORY
+
+	v1.0  - Non-blocking serial file descriptor with frame timeouts
+*/
+/**************************************************************************/
+#if defined(__linux__) && !defined(ARDUINO)
+#include "cie_Nfc_HSU.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#define PN532DEBUGPRINT Serial
+
+/**************************************************************************/
+/*!
+  @brief Create with the path of the serial device the PN532 is connected to
+
+  @param  device The serial device path (e.g. /dev/ttyUSB0)
+*/
+/**************************************************************************/
+cie_Nfc_HSU::cie_Nfc_HSU (const char *device) :
+cie_Nfc_Frame(NO_IRQ),
+_device(device),
+_fd(-1),
+_ownsFd(true)
+{
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Create with a file descriptor which is already open (e.g. a pseudo-terminal)
+
+  @param  fd The file descriptor, which won't be closed by this instance
+*/
+/**************************************************************************/
+cie_Nfc_HSU::cie_Nfc_HSU (int fd) :
+cie_Nfc_Frame(NO_IRQ),
+_device(NULL),
+_fd(fd),
+_ownsFd(false)
+{
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Opens and configures the serial device, then wakes the PN532 up
+*/
+/**************************************************************************/
+void cie_Nfc_HSU::beginLink() {
+  if (_fd < 0) {
+    _fd = open(_device, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (_fd < 0) {
+      PN532DEBUGPRINT.print(F("Couldn't open the serial device "));
+      PN532DEBUGPRINT.println(_device);
+      return;
+    }
+  }
+  fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL) | O_NONBLOCK);
+
+  struct termios options;
+  if (tcgetattr(_fd, &options) == 0) {
+    cfmakeraw(&options);
+    cfsetispeed(&options, B115200);
+    cfsetospeed(&options, B115200);
+    options.c_cflag |= (CLOCAL | CREAD);
+    options.c_cflag &= ~(CSTOPB | CRTSCTS);
+    tcsetattr(_fd, TCSANOW, &options);
+  }
+  tcflush(_fd, TCIOFLUSH);
+
+  //In HSU mode the PN532 sleeps until it gets a long enough preamble
+  byte wakeup[FRAME_HSU_WAKEUP_LENGTH] = { 0x55, 0x55 };
+  writeBytes(wakeup, sizeof(wakeup));
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Starts writing a frame
+*/
+/**************************************************************************/
+void cie_Nfc_HSU::beginWrite() {
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Writes bytes to the PN532, waiting for the serial device to accept them
+
+  @param  buffer The pointer to the bytes
+  @param  length The number of bytes to write
+*/
+/**************************************************************************/
+void cie_Nfc_HSU::writeBytes(const byte *buffer, const word length) {
+  word written = 0;
+  while (written < length) {
+    ssize_t count = write(_fd, buffer + written, length - written);
+    if (count > 0) {
+      written += count;
+    } else if (count < 0 && errno != EAGAIN && errno != EINTR) {
+      return;
+    } else if (!waitFor(POLLOUT, FRAME_HSU_BYTE_TIMEOUT)) {
+      return;
+    }
+  }
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Ends writing a frame
+*/
+/**************************************************************************/
+void cie_Nfc_HSU::endWrite() {
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Tells whether the PN532 started sending a frame
+
+  @returns  A boolean value indicating whether there's data to be read or not
+*/
+/**************************************************************************/
+bool cie_Nfc_HSU::isReady() {
+  return waitFor(POLLIN, 0);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Sleeps in the kernel until the PN532 starts sending a frame. With an idle callback, it wakes up every millisecond to invoke it
+
+  @param  timeout The timeout in milliseconds
+
+  @returns  A boolean value indicating whether the PN532 became ready or not
+*/
+/**************************************************************************/
+bool cie_Nfc_HSU::waitReady(const word timeout) {
+  if (_idleCallback != NULL) {
+    return cie_Nfc_Frame::waitReady(timeout);
+  }
+  return waitFor(POLLIN, timeout);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Starts reading a frame
+*/
+/**************************************************************************/
+void cie_Nfc_HSU::beginRead() {
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Reads bytes from the PN532
+
+  @param  buffer The pointer to the buffer which will contain the bytes
+  @param  length The number of bytes to read
+
+  @returns  A boolean value indicating whether all bytes arrived in time or not
+*/
+/**************************************************************************/
+bool cie_Nfc_HSU::readBytes(byte *buffer, const word length) {
+  word received = 0;
+  while (received < length) {
+    ssize_t count = read(_fd, buffer + received, length - received);
+    if (count > 0) {
+      received += count;
+    } else if (count < 0 && errno != EAGAIN && errno != EINTR) {
+      return false;
+    } else if (!waitFor(POLLIN, FRAME_HSU_BYTE_TIMEOUT)) {
+      PN532DEBUGPRINT.println(F("Timeout while reading a PN532 frame"));
+      return false;
+    }
+  }
+  return true;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Ends reading a frame
+*/
+/**************************************************************************/
+void cie_Nfc_HSU::endRead() {
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Waits for the serial device to be readable or writable
+
+  @param  events Either POLLIN or POLLOUT
+  @param  timeout The timeout in milliseconds
+
+  @returns  A boolean value indicating whether the device became ready or not
+*/
+/**************************************************************************/
+bool cie_Nfc_HSU::waitFor(const short events, const int timeout) {
+  if (_fd < 0) {
+    return false;
+  }
+  struct pollfd descriptor = { _fd, events, 0 };
+  int result;
+  do {
+    result = ::poll(&descriptor, 1, timeout);
+  } while (result < 0 && errno == EINTR);
+  return result > 0 && (descriptor.revents & events) != 0;
+}
+
+
+/**************************************************************************/
+/*!
+    @brief Frees resources
+*/
+/**************************************************************************/
+cie_Nfc_HSU::~cie_Nfc_HSU()
+{
+  if (_ownsFd && _fd >= 0) {
+    close(_fd);
+  }
+}
+
+#endif
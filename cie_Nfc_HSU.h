@@ -0,0 +1,51 @@
+/**************************************************************************/
+/*!
+    @file     cie_Nfc_HSU.h
+    @author   Developers Italia
+    @license  BSD (see License)
+
+	Definition of the cie_Nfc_Frame class over a PN532 HSU (High Speed UART) link
+	opened as a POSIX serial device, for Linux hosts
+
+	@section  HISTORY
+
+	v1.0  - Non-blocking serial file descriptor with frame timeouts
+*/
+/**************************************************************************/
+#if defined(__linux__) && !defined(ARDUINO)
+#include "cie_Nfc_Frame.h"
+
+#ifndef CIE_NFC_HSU
+#define CIE_NFC_HSU
+
+//The longest silence allowed between two bytes of the same frame, in milliseconds
+#define FRAME_HSU_BYTE_TIMEOUT                (0x32)
+#define FRAME_HSU_WAKEUP_LENGTH               (0x10)
+
+class cie_Nfc_HSU : public cie_Nfc_Frame {
+  public:
+    cie_Nfc_HSU(const char *device);
+    cie_Nfc_HSU(int fd);
+    ~cie_Nfc_HSU();
+
+  protected:
+    void beginLink();
+    void beginWrite();
+    void writeBytes(const byte *buffer, const word length);
+    void endWrite();
+    bool isReady();
+    bool waitReady(const word timeout);
+    void beginRead();
+    bool readBytes(byte *buffer, const word length);
+    void endRead();
+
+  private:
+    bool waitFor(const short events, const int timeout);
+
+    const char *_device;
+    int _fd;
+    bool _ownsFd;
+};
+
+#endif
+#endif
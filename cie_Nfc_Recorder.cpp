@@ -0,0 +1,301 @@
+/**************************************************************************/
+/*!
+    @file     cie_Nfc_Recorder.cpp
+    @author   Developers Italia
+    @license  BSD (see License)
+
+	Implementation of a cie_Nfc decorator recording each call to another transport to a binary trace
+
+	@section  HISTORY
+
+	v1.2  - Random bytes are left out of the trace unless asked for
+	v1.1  - The time taken by the card is passed through
+	v1.0  - First implementation
+*/
+/**************************************************************************/
+#include "cie_Nfc_Recorder.h"
+
+/**************************************************************************/
+/*!
+  @brief Create a recorder of the calls to a transport
+
+  @param  nfc The transport to record, which then belongs to the recorder
+  @param  trace Where the trace is written, from begin() on
+*/
+/**************************************************************************/
+cie_Nfc_Recorder::cie_Nfc_Recorder(cie_Nfc *nfc, Print *trace) :
+_nfc(nfc),
+_trace(trace),
+_lastRecordAt(0),
+_traceLength(0),
+_recordRandomBytes(false)
+{
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Writes the header of the trace and initializes the recorded transport
+*/
+/**************************************************************************/
+void cie_Nfc_Recorder::begin() {
+  if (_traceLength == 0) {
+    writeBytes((const byte *) TRACE_MAGIC, TRACE_MAGIC_LENGTH);
+    byte version = TRACE_VERSION;
+    writeBytes(&version, 1);
+    _lastRecordAt = micros();
+  }
+  _nfc->begin();
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Detects a card and records the result
+
+  @returns  A boolean value indicating whether a card was detected or not
+*/
+/**************************************************************************/
+bool cie_Nfc_Recorder::detectCard() {
+  bool detected = _nfc->detectCard();
+  writeRecord(TRACE_DETECT);
+  writeVarint(detected);
+  return detected;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Sends an APDU command and records it with the response and the time taken
+
+  @param  command A pointer to the APDU command bytes
+  @param  commandLength Length of the command
+  @param  response A pointer to the buffer which will contain the response bytes
+  @param  responseLength The length of the desired response, then the length of the response
+
+  @returns  A boolean value indicating whether the operation succeeded or not
+*/
+/**************************************************************************/
+bool cie_Nfc_Recorder::sendCommand(byte *command, byte commandLength, byte *response, word *responseLength) {
+  //The time since the previous record is taken when the command leaves
+  writeRecord(TRACE_EXCHANGE);
+  writeVarint(commandLength);
+  writeBytes(command, commandLength);
+  bool success = _nfc->sendCommand(command, commandLength, response, responseLength);
+  word length = success ? *responseLength : 0;
+  unsigned long now = micros();
+  writeVarint(success);
+  writeVarint(now - _lastRecordAt);
+  writeVarint(length);
+  writeBytes(response, length);
+  _lastRecordAt = now;
+  return success;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Generates random bytes with the recorded transport and records their length, or the bytes themselves
+         if asked for, so that a replay sends the same challenges
+
+  @param  buffer The pointer to a byte array
+  @param  offset The starting offset in the buffer
+  @param  length The number of random bytes to generate
+*/
+/**************************************************************************/
+void cie_Nfc_Recorder::generateRandomBytes(byte *buffer, const word offset, const byte length) {
+  _nfc->generateRandomBytes(buffer, offset, length);
+  writeRecord(_recordRandomBytes ? TRACE_RANDOM : TRACE_REDACTED);
+  writeVarint(length);
+  if (_recordRandomBytes) {
+    writeBytes(buffer + offset, length);
+  }
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Starts the autonomous polling and records whether the transport supports it
+
+  @param  pollPeriod The time between two detections in milliseconds
+
+  @returns  A boolean value indicating whether the transport supports autonomous polling or not
+*/
+/**************************************************************************/
+bool cie_Nfc_Recorder::startAutoPoll(const word pollPeriod) {
+  bool started = _nfc->startAutoPoll(pollPeriod);
+  writeRecord(TRACE_AUTO_POLL);
+  writeVarint(started);
+  return started;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Stops the autonomous polling, nothing is recorded
+*/
+/**************************************************************************/
+void cie_Nfc_Recorder::stopAutoPoll() {
+  _nfc->stopAutoPoll();
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Negotiates the bit rate and records the outcome
+
+  @param  maxBitRate The fastest bit rate allowed in kbps
+
+  @returns  The bit rate in use in kbps
+*/
+/**************************************************************************/
+word cie_Nfc_Recorder::negotiateBitRate(const word maxBitRate) {
+  word bitRate = _nfc->negotiateBitRate(maxBitRate);
+  writeRecord(TRACE_BIT_RATE);
+  writeVarint(bitRate);
+  return bitRate;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Gets the UID of the activated card and records it
+
+  @param  uidBuffer The pointer to a buffer of at least RECENT_CARD_ID_LENGTH bytes
+
+  @returns  The length of the UID
+*/
+/**************************************************************************/
+byte cie_Nfc_Recorder::getUid(byte *uidBuffer) {
+  byte uidLength = _nfc->getUid(uidBuffer);
+  writeRecord(TRACE_UID);
+  writeVarint(uidLength);
+  writeBytes(uidBuffer, uidLength);
+  return uidLength;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Checks whether the card is still in the field and records the result
+
+  @returns  A boolean value indicating whether the card is present or not
+*/
+/**************************************************************************/
+bool cie_Nfc_Recorder::isCardPresent() {
+  bool present = _nfc->isCardPresent();
+  writeRecord(TRACE_PRESENCE);
+  writeVarint(present);
+  return present;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Limits the time spent waiting for the card, nothing is recorded
+
+  @param  timeout The limit in milliseconds
+*/
+/**************************************************************************/
+void cie_Nfc_Recorder::limitTimeout(const word timeout) {
+  _nfc->limitTimeout(timeout);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Gets how long the card took to answer the last command, nothing is recorded
+
+  @returns  The time in microseconds, as the transport measured it
+*/
+/**************************************************************************/
+unsigned long cie_Nfc_Recorder::getCardMicros() {
+  return _nfc->getCardMicros();
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Records the random bytes themselves: the replay then sends the same challenges and derives the same
+         session keys, but anyone reading the trace can decrypt the secure messaging session
+
+  @param  record Whether to record the random bytes or only their length
+*/
+/**************************************************************************/
+void cie_Nfc_Recorder::setRecordRandomBytes(const bool record) {
+  _recordRandomBytes = record;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Gets the number of bytes written to the trace so far
+
+  @returns  The length of the trace
+*/
+/**************************************************************************/
+unsigned long cie_Nfc_Recorder::getTraceLength() {
+  return _traceLength;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Starts a record with its type and the time since the previous one
+
+  @param  type The record type (e.g. TRACE_EXCHANGE)
+*/
+/**************************************************************************/
+void cie_Nfc_Recorder::writeRecord(const byte type) {
+  unsigned long now = micros();
+  writeBytes(&type, 1);
+  writeVarint(now - _lastRecordAt);
+  _lastRecordAt = now;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Writes an unsigned LEB128 varint
+
+  @param  value The value
+*/
+/**************************************************************************/
+void cie_Nfc_Recorder::writeVarint(unsigned long value) {
+  byte varint[TRACE_MAX_VARINT_LENGTH];
+  byte length = 0;
+  do {
+    varint[length] = value & 0b01111111;
+    value >>= 7;
+    if (value != 0) {
+      varint[length] |= 0b10000000;
+    }
+    length++;
+  } while (value != 0);
+  writeBytes(varint, length);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Writes bytes to the trace
+
+  @param  buffer The pointer to the bytes
+  @param  length The number of bytes
+*/
+/**************************************************************************/
+void cie_Nfc_Recorder::writeBytes(const byte *buffer, const word length) {
+  if (length > 0) {
+    _traceLength += _trace->write(buffer, length);
+  }
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Frees resources, the recorded transport included
+*/
+/**************************************************************************/
+cie_Nfc_Recorder::~cie_Nfc_Recorder() {
+  delete _nfc;
+}
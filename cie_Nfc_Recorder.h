@@ -0,0 +1,57 @@
+/**************************************************************************/
+/*!
+    @file     cie_Nfc_Recorder.h
+    @author   Developers Italia
+    @license  BSD (see License)
+
+	Definition of a cie_Nfc decorator recording each call to another transport, with its outcome
+	and timestamp, to a binary trace (see cie_Trace.h) written to any Print: a serial port, a file...
+	The random bytes are the key material of the session (K.IFD, the PACE ephemeral keys), so by default
+	only their length is recorded: keep traces recorded with setRecordRandomBytes(true) as secret as the keys
+
+	@section  HISTORY
+
+	v1.2  - Random bytes are left out of the trace unless asked for
+	v1.1  - The time taken by the card is passed through
+	v1.0  - First definition
+*/
+/**************************************************************************/
+#include "cie_Nfc.h"
+#include "cie_Trace.h"
+
+#ifndef CIE_NFC_RECORDER
+#define CIE_NFC_RECORDER
+
+class cie_Nfc_Recorder : public cie_Nfc {
+  public:
+    cie_Nfc_Recorder(cie_Nfc *nfc, Print *trace);
+    ~cie_Nfc_Recorder();
+
+    void begin();
+    bool detectCard();
+    bool sendCommand(byte *command, byte commandLength, byte *response, word *responseLength);
+    void generateRandomBytes(byte *buffer, const word offset, const byte length);
+    bool startAutoPoll(const word pollPeriod);
+    void stopAutoPoll();
+    word negotiateBitRate(const word maxBitRate);
+    byte getUid(byte *uidBuffer);
+    bool isCardPresent();
+    void limitTimeout(const word timeout);
+    unsigned long getCardMicros();
+
+    void setRecordRandomBytes(const bool record);
+    unsigned long getTraceLength();
+
+  private:
+    void writeRecord(const byte type);
+    void writeVarint(unsigned long value);
+    void writeBytes(const byte *buffer, const word length);
+
+    cie_Nfc *_nfc;
+    Print *_trace;
+    unsigned long _lastRecordAt;
+    unsigned long _traceLength;
+    bool _recordRandomBytes;
+};
+
+#endif
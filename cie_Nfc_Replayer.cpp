@@ -0,0 +1,511 @@
+/**************************************************************************/
+/*!
+    @file     cie_Nfc_Replayer.cpp
+    @author   Developers Italia
+    @license  BSD (see License)
+
+	Implementation of a cie_Nfc transport playing back a trace written by cie_Nfc_Recorder
+
+	@section  HISTORY
+
+	v1.2  - Random bytes left out of the trace are generated deterministically
+	v1.1  - Lengths near the largest unsigned long don't wrap around the end of the range
+	v1.0  - First implementation
+*/
+/**************************************************************************/
+#include "cie_Nfc_Replayer.h"
+#include "cie_RecentCards.h"
+
+#define PN532DEBUGPRINT Serial
+
+/**************************************************************************/
+/*!
+  @brief Create a transport playing back a trace
+
+  @param  trace The pointer to the trace, which must outlive the replayer
+  @param  traceLength The length of the trace
+*/
+/**************************************************************************/
+cie_Nfc_Replayer::cie_Nfc_Replayer(const byte *trace, const unsigned long traceLength) :
+_trace(trace),
+_traceLength(traceLength),
+_position(TRACE_HEADER_LENGTH),
+_record(NULL),
+_recordType(0),
+_recordLength(0),
+_lenient(false),
+_realTime(false),
+_diverged(false),
+_exchangeCount(0),
+_skippedExchangeCount(0)
+{
+  //The same bytes on every replay of the trace
+  _drbg.seed((const byte *) TRACE_MAGIC, TRACE_MAGIC_LENGTH);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Checks the header of the trace
+*/
+/**************************************************************************/
+void cie_Nfc_Replayer::begin() {
+  if (!isValid()) {
+    PN532DEBUGPRINT.println(F("Not a trace, or a trace of another version"));
+    _diverged = true;
+  }
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Plays back a detection. Once the trace is over, no card is detected anymore
+
+  @returns  A boolean value indicating whether a card was detected or not
+*/
+/**************************************************************************/
+bool cie_Nfc_Replayer::detectCard() {
+  if (isFinished() || !findRecord(TRACE_DETECT, NULL, 0)) {
+    return false;
+  }
+  return readResult();
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Plays back an APDU command: it must be the recorded one (in lenient mode, the next recorded one
+         equal to it). With real time replay, this takes as long as the recorded exchange
+
+  @param  command A pointer to the APDU command bytes
+  @param  commandLength Length of the command
+  @param  response A pointer to the buffer which will contain the response bytes
+  @param  responseLength The length of the desired response, then the length of the response
+
+  @returns  A boolean value indicating whether the operation succeeded or not
+*/
+/**************************************************************************/
+bool cie_Nfc_Replayer::sendCommand(byte *command, byte commandLength, byte *response, word *responseLength) {
+  if (!findRecord(TRACE_EXCHANGE, command, commandLength)) {
+    return false;
+  }
+  unsigned long position = _record - _trace;
+  unsigned long end = position + _recordLength;
+  unsigned long recordedCommandLength;
+  unsigned long success;
+  unsigned long duration;
+  unsigned long recordedResponseLength;
+  const byte *recordedCommand;
+  const byte *recordedResponse;
+  if (!readVarint(&position, end, &recordedCommandLength)
+      || !readBytes(&position, end, recordedCommandLength, &recordedCommand)
+      || !readVarint(&position, end, &success)
+      || !readVarint(&position, end, &duration)
+      || !readVarint(&position, end, &recordedResponseLength)
+      || !readBytes(&position, end, recordedResponseLength, &recordedResponse)) {
+    PN532DEBUGPRINT.println(F("The recorded exchange is malformed"));
+    diverge();
+    return false;
+  }
+  if (recordedResponseLength > *responseLength) {
+    PN532DEBUGPRINT.println(F("The recorded response doesn't fit the response buffer"));
+    diverge();
+    return false;
+  }
+  if (_realTime) {
+    delay(duration / 1000);
+    delayMicroseconds(duration % 1000);
+  }
+  memcpy(response, recordedResponse, recordedResponseLength);
+  *responseLength = recordedResponseLength;
+  _exchangeCount++;
+  return success != 0;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Plays back random bytes, so that the challenges are the recorded ones. If only their length was
+         recorded, the bytes come from a generator with a fixed seed: the commands carrying them won't
+         match the recorded ones
+
+  @param  buffer The pointer to a byte array
+  @param  offset The starting offset in the buffer
+  @param  length The number of random bytes to generate
+*/
+/**************************************************************************/
+void cie_Nfc_Replayer::generateRandomBytes(byte *buffer, const word offset, const byte length) {
+  memset(buffer + offset, 0, length);
+  if (!findRecord(TRACE_RANDOM, NULL, 0)) {
+    return;
+  }
+  unsigned long position = _record - _trace;
+  unsigned long end = position + _recordLength;
+  unsigned long recordedLength;
+  const byte *recordedBytes;
+  if (!readVarint(&position, end, &recordedLength)
+      || recordedLength != length
+      || (_recordType == TRACE_RANDOM && !readBytes(&position, end, recordedLength, &recordedBytes))) {
+    PN532DEBUGPRINT.println(F("The recorded random bytes are malformed or have another length"));
+    diverge();
+    return;
+  }
+  if (_recordType == TRACE_REDACTED) {
+    _drbg.generate(buffer + offset, length);
+    return;
+  }
+  memcpy(buffer + offset, recordedBytes, length);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Plays back whether the autonomous polling started
+
+  @param  pollPeriod The time between two detections in milliseconds, ignored
+
+  @returns  A boolean value indicating whether the recorded transport supports autonomous polling or not
+*/
+/**************************************************************************/
+bool cie_Nfc_Replayer::startAutoPoll(const word pollPeriod) {
+  return findRecord(TRACE_AUTO_POLL, NULL, 0) && readResult();
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Plays back the bit rate negotiation
+
+  @param  maxBitRate The fastest bit rate allowed in kbps, ignored
+
+  @returns  The recorded bit rate in kbps
+*/
+/**************************************************************************/
+word cie_Nfc_Replayer::negotiateBitRate(const word maxBitRate) {
+  if (!findRecord(TRACE_BIT_RATE, NULL, 0)) {
+    return BIT_RATE_106;
+  }
+  unsigned long position = _record - _trace;
+  unsigned long bitRate;
+  if (!readVarint(&position, position + _recordLength, &bitRate)) {
+    diverge();
+    return BIT_RATE_106;
+  }
+  return (word) bitRate;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Plays back the UID of the activated card
+
+  @param  uidBuffer The pointer to a buffer of at least RECENT_CARD_ID_LENGTH bytes
+
+  @returns  The length of the recorded UID
+*/
+/**************************************************************************/
+byte cie_Nfc_Replayer::getUid(byte *uidBuffer) {
+  if (!findRecord(TRACE_UID, NULL, 0)) {
+    return 0;
+  }
+  unsigned long position = _record - _trace;
+  unsigned long end = position + _recordLength;
+  unsigned long uidLength;
+  const byte *uid;
+  if (!readVarint(&position, end, &uidLength)
+      || !readBytes(&position, end, uidLength, &uid)
+      || uidLength > RECENT_CARD_ID_LENGTH) {
+    PN532DEBUGPRINT.println(F("The recorded UID is malformed or too long"));
+    diverge();
+    return 0;
+  }
+  memcpy(uidBuffer, uid, uidLength);
+  return (byte) uidLength;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Plays back whether the card was still in the field. Once the trace is over, it's not
+
+  @returns  A boolean value indicating whether the card is present or not
+*/
+/**************************************************************************/
+bool cie_Nfc_Replayer::isCardPresent() {
+  if (isFinished()) {
+    return false;
+  }
+  return findRecord(TRACE_PRESENCE, NULL, 0) && readResult();
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Lets the replay skip recorded calls which are not made anymore
+
+  @param  lenient Whether recorded calls can be skipped or not
+*/
+/**************************************************************************/
+void cie_Nfc_Replayer::setLenient(const bool lenient) {
+  _lenient = lenient;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Makes each exchange take as long as it took when it was recorded
+
+  @param  realTime Whether to wait for the recorded duration or not
+*/
+/**************************************************************************/
+void cie_Nfc_Replayer::setRealTime(const bool realTime) {
+  _realTime = realTime;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Checks the trace starts with the header of this version of the format, or of an older one
+
+  @returns  A boolean value indicating whether the trace can be played back or not
+*/
+/**************************************************************************/
+bool cie_Nfc_Replayer::isValid() {
+  return _traceLength >= TRACE_HEADER_LENGTH
+    && memcmp(_trace, TRACE_MAGIC, TRACE_MAGIC_LENGTH) == 0
+    && _trace[TRACE_MAGIC_LENGTH] >= TRACE_OLDEST_VERSION
+    && _trace[TRACE_MAGIC_LENGTH] <= TRACE_VERSION;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Tells whether every record of the trace was played back
+
+  @returns  A boolean value indicating whether the trace is over or not
+*/
+/**************************************************************************/
+bool cie_Nfc_Replayer::isFinished() {
+  return _position >= _traceLength;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Tells whether a call didn't match the trace: from then on every call fails
+
+  @returns  A boolean value indicating whether the replay diverged from the trace or not
+*/
+/**************************************************************************/
+bool cie_Nfc_Replayer::hasDiverged() {
+  return _diverged;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Counts the APDU commands played back
+
+  @returns  The number of APDU commands
+*/
+/**************************************************************************/
+word cie_Nfc_Replayer::getExchangeCount() {
+  return _exchangeCount;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Counts the recorded APDU commands the library didn't send in lenient mode
+
+  @returns  The number of skipped APDU commands
+*/
+/**************************************************************************/
+word cie_Nfc_Replayer::getSkippedExchangeCount() {
+  return _skippedExchangeCount;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Finds the record for the current call: the next one, or in lenient mode the first one of its type
+         (and with the same command for exchanges). Random bytes may have been recorded or left out.
+         Nothing is consumed if there's no such record
+
+  @param  type The record type
+  @param  command The APDU command an exchange must have, or NULL for other records
+  @param  commandLength The length of the command
+
+  @returns  A boolean value indicating whether the record was found or not
+*/
+/**************************************************************************/
+bool cie_Nfc_Replayer::findRecord(const byte type, const byte *command, const byte commandLength) {
+  unsigned long position = _position;
+  word skippedExchanges = 0;
+  byte recordType;
+  const byte *content;
+  unsigned long contentLength;
+  while (!_diverged && readRecord(&position, &recordType, &content, &contentLength)) {
+    bool found = recordType == type || (type == TRACE_RANDOM && recordType == TRACE_REDACTED);
+    if (found && command != NULL) {
+      unsigned long commandPosition = content - _trace;
+      unsigned long recordedCommandLength;
+      const byte *recordedCommand;
+      found = readVarint(&commandPosition, commandPosition + contentLength, &recordedCommandLength)
+        && recordedCommandLength == commandLength
+        && readBytes(&commandPosition, commandPosition + contentLength, commandLength, &recordedCommand)
+        && memcmp(recordedCommand, command, commandLength) == 0;
+    }
+    if (found) {
+      _record = content;
+      _recordType = recordType;
+      _recordLength = contentLength;
+      _position = position;
+      _skippedExchangeCount += skippedExchanges;
+      return true;
+    }
+    if (!_lenient) {
+      break;
+    }
+    if (recordType == TRACE_EXCHANGE) {
+      skippedExchanges++;
+    }
+  }
+  diverge();
+  return false;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Reads a record: its type and the fields following the timestamp
+
+  @param  position The position of the record in the trace, then the position of the next one
+  @param  type The pointer to the record type
+  @param  content The pointer to the first field after the timestamp
+  @param  contentLength The length of the fields
+
+  @returns  A boolean value indicating whether a well formed record was read or not
+*/
+/**************************************************************************/
+bool cie_Nfc_Replayer::readRecord(unsigned long *position, byte *type, const byte **content, unsigned long *contentLength) {
+  unsigned long next = *position;
+  unsigned long delta;
+  if (next >= _traceLength) {
+    return false;
+  }
+  *type = _trace[next++];
+  if (!readVarint(&next, _traceLength, &delta)) {
+    return false;
+  }
+  *content = _trace + next;
+  unsigned long value;
+  const byte *bytes;
+  bool wellFormed;
+  switch (*type) {
+    case TRACE_DETECT:
+    case TRACE_BIT_RATE:
+    case TRACE_PRESENCE:
+    case TRACE_AUTO_POLL:
+    case TRACE_REDACTED:
+      wellFormed = readVarint(&next, _traceLength, &value);
+    break;
+
+    case TRACE_RANDOM:
+    case TRACE_UID:
+      wellFormed = readVarint(&next, _traceLength, &value) && readBytes(&next, _traceLength, value, &bytes);
+    break;
+
+    case TRACE_EXCHANGE:
+      //Command, result, duration and response
+      wellFormed = readVarint(&next, _traceLength, &value) && readBytes(&next, _traceLength, value, &bytes)
+        && readVarint(&next, _traceLength, &value) && readVarint(&next, _traceLength, &value)
+        && readVarint(&next, _traceLength, &value) && readBytes(&next, _traceLength, value, &bytes);
+    break;
+
+    default:
+      wellFormed = false;
+  }
+  if (!wellFormed) {
+    PN532DEBUGPRINT.println(F("Malformed record in the trace"));
+    return false;
+  }
+  *contentLength = next - (*content - _trace);
+  *position = next;
+  return true;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Reads an unsigned LEB128 varint
+
+  @param  position The position of the varint, then the position after it
+  @param  end The end of the readable range
+  @param  value The pointer to the value
+
+  @returns  A boolean value indicating whether a varint was read or not
+*/
+/**************************************************************************/
+bool cie_Nfc_Replayer::readVarint(unsigned long *position, const unsigned long end, unsigned long *value) {
+  *value = 0;
+  for (byte i = 0; i < TRACE_MAX_VARINT_LENGTH && *position < end; i++) {
+    byte octet = _trace[(*position)++];
+    *value |= ((unsigned long) (octet & 0b01111111)) << (7 * i);
+    if ((octet & 0b10000000) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Gets bytes of the trace
+
+  @param  position The position of the bytes, then the position after them
+  @param  end The end of the readable range
+  @param  length The number of bytes
+  @param  bytes The pointer to the bytes in the trace
+
+  @returns  A boolean value indicating whether the bytes are all in the readable range or not
+*/
+/**************************************************************************/
+bool cie_Nfc_Replayer::readBytes(unsigned long *position, const unsigned long end, const unsigned long length, const byte **bytes) {
+  //The sum of the position and the length could wrap around
+  if (*position > end || length > end - *position) {
+    return false;
+  }
+  *bytes = _trace + *position;
+  *position += length;
+  return true;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Reads the result of the current record, the only field of some records
+
+  @returns  The recorded result
+*/
+/**************************************************************************/
+bool cie_Nfc_Replayer::readResult() {
+  unsigned long position = _record - _trace;
+  unsigned long result;
+  return readVarint(&position, position + _recordLength, &result) && result != 0;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Reports the first call not matching the trace
+*/
+/**************************************************************************/
+void cie_Nfc_Replayer::diverge() {
+  if (!_diverged) {
+    PN532DEBUGPRINT.print(F("The replay diverged from the trace at offset "));
+    PN532DEBUGPRINT.println(_position);
+  }
+  _diverged = true;
+}
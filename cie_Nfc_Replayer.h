@@ -0,0 +1,69 @@
+/**************************************************************************/
+/*!
+    @file     cie_Nfc_Replayer.h
+    @author   Developers Italia
+    @license  BSD (see License)
+
+	Definition of a cie_Nfc transport playing back a trace written by cie_Nfc_Recorder: each call gets
+	the outcome recorded for it, as long as the calls are the recorded ones in the same order.
+	In lenient mode, recorded calls the library doesn't make anymore are skipped, e.g. to compare the
+	APDU commands of a session before and after a change of the library.
+	Random bytes left out of the trace are played back from a generator with a fixed seed
+
+	@section  HISTORY
+
+	v1.1  - Random bytes left out of the trace are generated deterministically
+	v1.0  - First definition
+*/
+/**************************************************************************/
+#include "cie_Nfc.h"
+#include "cie_Trace.h"
+#include "cie_Drbg.h"
+
+#ifndef CIE_NFC_REPLAYER
+#define CIE_NFC_REPLAYER
+
+class cie_Nfc_Replayer : public cie_Nfc {
+  public:
+    cie_Nfc_Replayer(const byte *trace, const unsigned long traceLength);
+
+    void begin();
+    bool detectCard();
+    bool sendCommand(byte *command, byte commandLength, byte *response, word *responseLength);
+    void generateRandomBytes(byte *buffer, const word offset, const byte length);
+    bool startAutoPoll(const word pollPeriod);
+    word negotiateBitRate(const word maxBitRate);
+    byte getUid(byte *uidBuffer);
+    bool isCardPresent();
+
+    void setLenient(const bool lenient);
+    void setRealTime(const bool realTime);
+    bool isValid();
+    bool isFinished();
+    bool hasDiverged();
+    word getExchangeCount();
+    word getSkippedExchangeCount();
+
+  private:
+    bool findRecord(const byte type, const byte *command, const byte commandLength);
+    bool readRecord(unsigned long *position, byte *type, const byte **content, unsigned long *contentLength);
+    bool readVarint(unsigned long *position, const unsigned long end, unsigned long *value);
+    bool readBytes(unsigned long *position, const unsigned long end, const unsigned long length, const byte **bytes);
+    bool readResult();
+    void diverge();
+
+    const byte *_trace;
+    unsigned long _traceLength;
+    unsigned long _position;
+    const byte *_record;
+    byte _recordType;
+    unsigned long _recordLength;
+    bool _lenient;
+    bool _realTime;
+    bool _diverged;
+    word _exchangeCount;
+    word _skippedExchangeCount;
+    cie_Drbg _drbg;
+};
+
+#endif
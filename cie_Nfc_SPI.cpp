@@ -0,0 +1,243 @@
+/**************************************************************************/
+/*!
+    @file     cie_Nfc_SPI.cpp
+    @author   Developers Italia
+    @license  BSD (see License)
+
+	Implementation of the cie_Nfc_Frame class over an SPI link to the PN532.
+	The PN532 expects LSB first, mode 0 transfers
+
+	@section  HISTORY
+
+	v1.1  - Hardware SPI, with whole frame (DMA) transfers where the core supports them
+	v1.0  - Software SPI with an optional IRQ line
+*/
+/**************************************************************************/
+#include <SPI.h>
+#include "cie_Nfc_SPI.h"
+
+//Cores which can move a whole buffer in one call, by DMA or by the SPI FIFO
+#if defined(ARDUINO_ARCH_ESP32)
+  #define SPI_BLOCK_WRITE(buffer, length) SPI.writeBytes(buffer, length)
+  #define SPI_BLOCK_READ(buffer, length)  SPI.transferBytes(NULL, buffer, length)
+#elif defined(ARDUINO_SAMD_ADAFRUIT) || defined(CORE_TEENSY)
+  #define SPI_BLOCK_WRITE(buffer, length) SPI.transfer(buffer, NULL, length)
+  #define SPI_BLOCK_READ(buffer, length)  SPI.transfer(NULL, buffer, length)
+#else
+  //In-place transfer: the buffer content is sent out while it's being overwritten, that's fine for reads
+  #define SPI_BLOCK_READ(buffer, length)  SPI.transfer(buffer, length)
+#endif
+
+static const SPISettings spiSettings(FRAME_SPI_CLOCK, LSBFIRST, SPI_MODE0);
+
+/**************************************************************************/
+/*!
+  @brief Create with the hardware SPI peripheral (on the Arduino Uno: SCK 13, MISO 12, MOSI 11)
+
+  @param  ss The SS pin number
+  @param  irq The IRQ pin number (it must support interrupts), or NO_IRQ to poll the PN532 status instead
+*/
+/**************************************************************************/
+cie_Nfc_SPI::cie_Nfc_SPI (byte ss, byte irq) : cie_Nfc_SPI(HARDWARE_SPI, HARDWARE_SPI, HARDWARE_SPI, ss, irq) {
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Create with a customized wiring
+
+  @param  clk The CLK pin number
+  @param  miso The MISO pin number
+  @param  mosi The MOSI pin number
+  @param  ss The SS pin number
+  @param  irq The IRQ pin number (it must support interrupts), or NO_IRQ to poll the PN532 status instead
+*/
+/**************************************************************************/
+cie_Nfc_SPI::cie_Nfc_SPI (byte clk, byte miso, byte mosi, byte ss, byte irq) :
+cie_Nfc_Frame(irq),
+_clk(clk),
+_miso(miso),
+_mosi(mosi),
+_ss(ss)
+{
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Configures the pins and wakes the PN532 up
+*/
+/**************************************************************************/
+void cie_Nfc_SPI::beginLink() {
+  pinMode(_ss, OUTPUT);
+  digitalWrite(_ss, HIGH);
+  if (_clk == HARDWARE_SPI) {
+    SPI.begin();
+  } else {
+    pinMode(_clk, OUTPUT);
+    pinMode(_mosi, OUTPUT);
+    pinMode(_miso, INPUT);
+    digitalWrite(_clk, LOW);
+  }
+  //Keeping SS low for a while wakes the PN532 up
+  select();
+  delay(2);
+  deselect();
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Starts writing a frame
+*/
+/**************************************************************************/
+void cie_Nfc_SPI::beginWrite() {
+  select();
+  transfer(FRAME_SPI_DATA_WRITE);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Writes bytes to the PN532
+
+  @param  buffer The pointer to the bytes
+  @param  length The number of bytes to write
+*/
+/**************************************************************************/
+void cie_Nfc_SPI::writeBytes(const byte *buffer, const word length) {
+#ifdef SPI_BLOCK_WRITE
+  if (_clk == HARDWARE_SPI) {
+    SPI_BLOCK_WRITE(buffer, length);
+    return;
+  }
+#endif
+  for (word i = 0; i < length; i++) {
+    transfer(buffer[i]);
+  }
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Ends writing a frame
+*/
+/**************************************************************************/
+void cie_Nfc_SPI::endWrite() {
+  deselect();
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Tells whether the PN532 has a frame ready to be read. With an IRQ line, this costs no SPI traffic at all
+
+  @returns  A boolean value indicating whether the PN532 is ready or not
+*/
+/**************************************************************************/
+bool cie_Nfc_SPI::isReady() {
+  if (_irq != NO_IRQ) {
+    //The PN532 keeps the IRQ line low until the frame has been read
+    return digitalRead(_irq) == LOW;
+  }
+  select();
+  transfer(FRAME_SPI_STATUS_READ);
+  byte status = transfer(0x00);
+  deselect();
+  return (status & FRAME_SPI_READY) == FRAME_SPI_READY;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Starts reading a frame
+*/
+/**************************************************************************/
+void cie_Nfc_SPI::beginRead() {
+  select();
+  transfer(FRAME_SPI_DATA_READ);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Reads bytes from the PN532
+
+  @param  buffer The pointer to the buffer which will contain the bytes
+  @param  length The number of bytes to read
+
+  @returns  Always true, SPI reads can't fail
+*/
+/**************************************************************************/
+bool cie_Nfc_SPI::readBytes(byte *buffer, const word length) {
+  if (_clk == HARDWARE_SPI) {
+    SPI_BLOCK_READ(buffer, length);
+    return true;
+  }
+  for (word i = 0; i < length; i++) {
+    buffer[i] = transfer(0x00);
+  }
+  return true;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Ends reading a frame
+*/
+/**************************************************************************/
+void cie_Nfc_SPI::endRead() {
+  deselect();
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Exchanges a byte over SPI, least significant bit first
+
+  @param  data The byte to send
+
+  @returns  The byte received
+*/
+/**************************************************************************/
+byte cie_Nfc_SPI::transfer(const byte data) {
+  if (_clk == HARDWARE_SPI) {
+    return SPI.transfer(data);
+  }
+  byte received = 0;
+  for (byte i = 0; i < 8; i++) {
+    digitalWrite(_mosi, (data >> i) & 0b1 ? HIGH : LOW);
+    digitalWrite(_clk, HIGH);
+    if (digitalRead(_miso) == HIGH) {
+      received |= (1 << i);
+    }
+    digitalWrite(_clk, LOW);
+  }
+  return received;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Selects the PN532 on the SPI bus
+*/
+/**************************************************************************/
+void cie_Nfc_SPI::select() {
+  if (_clk == HARDWARE_SPI) {
+    SPI.beginTransaction(spiSettings);
+  }
+  digitalWrite(_ss, LOW);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Releases the SPI bus
+*/
+/**************************************************************************/
+void cie_Nfc_SPI::deselect() {
+  digitalWrite(_ss, HIGH);
+  if (_clk == HARDWARE_SPI) {
+    SPI.endTransaction();
+  }
+}
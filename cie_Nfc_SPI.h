@@ -0,0 +1,56 @@
+/**************************************************************************/
+/*!
+    @file     cie_Nfc_SPI.h
+    @author   Developers Italia
+    @license  BSD (see License)
+
+	Definition of the cie_Nfc_Frame class over an SPI link to the PN532
+
+	@section  HISTORY
+
+	v1.1  - Hardware SPI, with whole frame (DMA) transfers where the core supports them
+	v1.0  - Software SPI with an optional IRQ line
+*/
+/**************************************************************************/
+#include "cie_Nfc_Frame.h"
+
+#ifndef CIE_NFC_SPI
+#define CIE_NFC_SPI
+
+//SPI operations, sent as the first byte of each transaction
+#define FRAME_SPI_DATA_WRITE                  (0x01)
+#define FRAME_SPI_STATUS_READ                 (0x02)
+#define FRAME_SPI_DATA_READ                   (0x03)
+#define FRAME_SPI_READY                       (0x01)
+
+//The PN532 SPI clock can go up to 5 MHz
+#define FRAME_SPI_CLOCK                       (5000000)
+#define HARDWARE_SPI                          (0xFF)
+
+class cie_Nfc_SPI : public cie_Nfc_Frame {
+  public:
+    cie_Nfc_SPI(byte ss, byte irq);
+    cie_Nfc_SPI(byte clk, byte miso, byte mosi, byte ss, byte irq);
+
+  protected:
+    void beginLink();
+    void beginWrite();
+    void writeBytes(const byte *buffer, const word length);
+    void endWrite();
+    bool isReady();
+    void beginRead();
+    bool readBytes(byte *buffer, const word length);
+    void endRead();
+
+  private:
+    byte transfer(const byte data);
+    void select();
+    void deselect();
+
+    byte _clk;
+    byte _miso;
+    byte _mosi;
+    byte _ss;
+};
+
+#endif
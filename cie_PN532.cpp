@@ -22,6 +22,21 @@
 
 #define PN532DEBUGPRINT Serial
 
+cie_PN532 *cie_PN532::_sodChecker = NULL;
+
+//Object identifiers looked for in the EF_SOD
+static const byte oid_signedData[] = {0x2A, 0x86, 0x48, 0x86, 0xF7, 0x0D, 0x01, 0x07, 0x02}; //1.2.840.113549.1.7.2
+static const byte oid_mRTDSignatureData[] = {0x67, 0x81, 0x08, 0x01, 0x01, 0x01}; //2.23.136.1.1.1
+static const byte oid_messageDigest[] = {0x2A, 0x86, 0x48, 0x86, 0xF7, 0x0D, 0x01, 0x09, 0x04}; //1.2.840.113549.1.9.4
+static const byte oid_rsaEncryption[] = {0x2A, 0x86, 0x48, 0x86, 0xF7, 0x0D, 0x01, 0x01, 0x01}; //1.2.840.113549.1.1.1
+static const byte oid_sha1WithRSAEncryption[] = {0x2A, 0x86, 0x48, 0x86, 0xF7, 0x0D, 0x01, 0x01, 0x05}; //1.2.840.113549.1.1.5
+static const byte oid_sha256WithRSAEncryption[] = {0x2A, 0x86, 0x48, 0x86, 0xF7, 0x0D, 0x01, 0x01, 0x0B}; //1.2.840.113549.1.1.11
+static const byte oid_sha1[] = {0x2B, 0x0E, 0x03, 0x02, 0x1A}; //1.3.14.3.2.26
+static const byte oid_sha256[] = {0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x01}; //2.16.840.1.101.3.4.2.1
+static const byte oid_subjectKeyIdentifier[] = {0x55, 0x1D, 0x0E}; //2.5.29.14
+//PACE protocol looked for in the EF.CardAccess
+static const byte oid_PACE_ECDH_GM_AES_CBC_CMAC_128[] = {0x04, 0x00, 0x7F, 0x00, 0x07, 0x02, 0x02, 0x04, 0x02, 0x02}; //0.4.0.127.0.7.2.2.4.2.2
+
 /**************************************************************************/
 /*!
   @brief Create with the typical breakout wiring, as described by Adafruit: https://learn.adafruit.com/adafruit-pn532-rfid-nfc/breakout-wiring
@@ -65,8 +80,30 @@ cie_PN532::cie_PN532 (cie_Nfc *nfc)
 void cie_PN532::initFields() {
   _currentDedicatedFile = NULL_DF;
   _currentElementaryFile = NULL_EF;
+  _bitRate = BIT_RATE_106;
+  _maxBitRate = BIT_RATE_848;
+  _apduCount = 0;
+  _repeatedTap = false;
+  _telemetry = NULL;
+  _tapOpen = false;
+  _tapStartedAt = 0;
+  _tapEndedAt = 0;
+  _deadline = NO_DEADLINE;
+  _lastError = CIE_ERROR_NONE;
+  _contentRead = 0;
+  _verificationCycles = 0;
+  _challengeCount = 0;
+  _asyncRead.step = ASYNC_STEP_IDLE;
+  _asyncRead.offset = READ_FROM_START;
   _berReader = new cie_BerReader(this);
   _atrReader = new cie_AtrReader(this);
+  _rsa = new cie_Rsa();
+  _readHash = NULL;
+  _trustAnchor = NULL;
+  _secureMessaging = NULL;
+  _deviceEncKey = NULL;
+  _deviceMacKey = NULL;
+  _deviceSerialNumber = NULL;
   verbose = false;
 }
 
@@ -78,25 +115,367 @@ void cie_PN532::initFields() {
 /**************************************************************************/
 void cie_PN532::begin() {
   _nfc->begin();
+  refillChallenges();
   PN532DEBUGPRINT.println(F("PN53x initialized, waiting for a CIE card..."));
 }
 
 
 /**************************************************************************/
 /*!
-  @brief  Dumps all values present in the CIE. Call this in your loop
+  @brief  Detects a card. Call this in your loop.
+          With a hold-off time set, cards seen lately are not reported again (see isRepeatedTap())
+
+  @returns  A boolean value indicating whether a new card was detected or not
 */
 /**************************************************************************/
 bool cie_PN532::detectCard() {
-  bool success = _nfc->detectCard();
-  if (success) {
-    _currentDedicatedFile = NULL_DF;
-    _currentDedicatedFile = NULL_EF;
+  CIE_MEMORY_SCOPE(&_memoryProbe);
+  endTap();
+  _repeatedTap = isRestingCard();
+  if (_repeatedTap) {
+    return false;
+  }
+  //A new activation resets the card, and its secure messaging session with it
+  if (_secureMessaging != NULL) {
+    _secureMessaging->end();
+  }
+  if (!_nfc->detectCard()) {
+    //Nobody is waiting: a good time to prepare the challenges for the next taps
+    refillChallenges();
+    return false;
+  }
+  startTap();
+  _currentDedicatedFile = NULL_DF;
+  _currentElementaryFile = NULL_EF;
+  _apduCount = 0;
+  //This must happen right after activation, before any APDU
+  _bitRate = _nfc->negotiateBitRate(_maxBitRate);
+  if (_bitRate == BIT_RATE_NONE) {
+    //Not a tap: the card is gone
+    _tapOpen = false;
+    return false;
+  }
+  if (_recentCards.getHoldOff() == NO_HOLD_OFF) {
+    return true;
+  }
+
+  //Random UIDs change on each activation: the SN_ICC tells one card from another
+  byte id[RECENT_CARD_ID_LENGTH];
+  word idLength = getStableUid(id);
+  if (idLength == 0) {
+    idLength = EF_SN_ICC_LENGTH;
+    if (!read_EF_SN_ICC(id, &idLength)) {
+      return true;
+    }
+  }
+  _repeatedTap = _recentCards.seen(id, idLength);
+  return !_repeatedTap;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Waits for a card to enter the field, using autonomous polling when the terminal supports it
+
+  @param  timeout The maximum time to wait in milliseconds (0 waits forever)
+  @param  pollPeriod The time between two detections in milliseconds
+
+  @returns  A boolean value indicating whether a card was detected or not
+*/
+/**************************************************************************/
+bool cie_PN532::waitForCard(const unsigned long timeout, const word pollPeriod) {
+  CIE_MEMORY_SCOPE(&_memoryProbe);
+  bool autoPoll = _nfc->startAutoPoll(pollPeriod);
+  unsigned long startedAt = millis();
+  bool success = false;
+  while (!(success = detectCard())) {
+    if (timeout > 0 && millis() - startedAt >= timeout) {
+      break;
+    }
+    //While auto polling, the terminal is watching the field by itself
+    delay(autoPoll ? 1 : pollPeriod);
+  }
+  if (autoPoll) {
+    _nfc->stopAutoPoll();
   }
   return success;
 }
 
 
+/**************************************************************************/
+/*!
+  @brief  Lets the terminal watch the field by itself, so that detectCard() returns immediately.
+          Call stopAutoPoll() once the card was detected
+
+  @param  pollPeriod The time between two detections in milliseconds
+
+  @returns  A boolean value indicating whether the terminal supports autonomous polling or not
+*/
+/**************************************************************************/
+bool cie_PN532::startAutoPoll(const word pollPeriod) {
+  return _nfc->startAutoPoll(pollPeriod);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Stops the autonomous polling started with startAutoPoll()
+*/
+/**************************************************************************/
+void cie_PN532::stopAutoPoll() {
+  _nfc->stopAutoPoll();
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Gets the bit rate negotiated with the last detected card
+
+  @returns  The bit rate in kbps (BIT_RATE_106 to BIT_RATE_848), BIT_RATE_NONE if the card was lost while negotiating it
+*/
+/**************************************************************************/
+word cie_PN532::getBitRate() {
+  return _bitRate;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Limits the bit rate negotiated with the next detected cards, e.g. when the antenna is poorly tuned
+
+  @param  maxBitRate The fastest bit rate allowed in kbps (BIT_RATE_106 to BIT_RATE_848)
+*/
+/**************************************************************************/
+void cie_PN532::setMaxBitRate(const word maxBitRate) {
+  _maxBitRate = maxBitRate;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Detects a card and reads its EF_ID_Servizi with as few exchanges as possible, e.g. for a turnstile.
+          The CIE DF is selected right after activation by its AID, without selecting the IAS application first,
+          and the bit rate is not negotiated: that's IDENTIFY_EXCHANGE_BUDGET exchanges with the PN532 from field entry.
+          Cards refusing the direct selection cost two more APDU commands
+
+  @param  contentBuffer The pointer to data containing the contents of the file
+  @param  contentLength The length of the file
+
+  @returns  A boolean value indicating whether a card was detected and identified or not
+*/
+/**************************************************************************/
+bool cie_PN532::identify(byte *contentBuffer, word *contentLength) {
+  CIE_MEMORY_SCOPE(&_memoryProbe);
+  //When this fails with APDU commands sent, a card was detected but couldn't be read
+  _apduCount = 0;
+  endTap();
+  _repeatedTap = isRestingCard();
+  if (_repeatedTap) {
+    return false;
+  }
+  //A new activation resets the card, and its secure messaging session with it
+  if (_secureMessaging != NULL) {
+    _secureMessaging->end();
+  }
+  if (!_nfc->detectCard()) {
+    return false;
+  }
+  startTap();
+  _currentDedicatedFile = NULL_DF;
+  _currentElementaryFile = NULL_EF;
+  _bitRate = BIT_RATE_106;
+  bool holdOff = _recentCards.getHoldOff() != NO_HOLD_OFF;
+  byte uid[RECENT_CARD_ID_LENGTH];
+  byte uidLength = holdOff ? getStableUid(uid) : 0;
+  if (uidLength > 0 && (_repeatedTap = _recentCards.seen(uid, uidLength))) {
+    return false;
+  }
+  if (selectCieDedicatedFile()) {
+    _currentDedicatedFile = CIE_DF;
+  }
+  if (!read_EF_ID_Servizi(contentBuffer, contentLength)) {
+    return false;
+  }
+  //Random UIDs change on each activation: the ID_Servizi tells one card from another
+  if (holdOff && uidLength == 0) {
+    _repeatedTap = _recentCards.seen(contentBuffer, *contentLength);
+  }
+  return !_repeatedTap;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Counts the APDU commands sent since the last detected card (or the last call to identify())
+
+  @returns  The number of APDU commands
+*/
+/**************************************************************************/
+word cie_PN532::getApduCount() {
+  return _apduCount;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Gets the counters of the APDU commands sent so far (or since the last call to clearMetrics()):
+          how many, how they ended and how long they took, the time of the reader apart from the time of the card
+
+  @param  insClass The class of instructions, e.g. METRICS_INS_READ_BINARY
+
+  @returns  The pointer to the counters, or NULL if the class doesn't exist or CIE_METRICS is 0
+*/
+/**************************************************************************/
+const cie_InsMetrics *cie_PN532::getMetrics(const byte insClass) {
+#if CIE_METRICS
+  return _metrics.get(insClass);
+#else
+  return NULL;
+#endif
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Sets the counters of the APDU commands to zero
+*/
+/**************************************************************************/
+void cie_PN532::clearMetrics() {
+#if CIE_METRICS
+  _metrics.clear();
+#endif
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Reports taps, APDU commands and cache lookups to a telemetry, which sums them up in a frame
+          once per period (call telemetry->update() in your loop)
+
+  @param  telemetry The telemetry, or NULL to stop reporting
+*/
+/**************************************************************************/
+void cie_PN532::setTelemetry(cie_Telemetry *telemetry) {
+  _telemetry = telemetry;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Measures the peak stack and heap usage of each public operation (see getMemoryUsage()).
+          The free stack is painted at the start of each operation, which takes some time
+
+  @param  enabled Whether operations are measured
+*/
+/**************************************************************************/
+void cie_PN532::setMemoryProbe(const bool enabled) {
+  _memoryProbe.setEnabled(enabled);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Gets the peak usage of the last public operation, while the memory probe is enabled.
+          Operations called by another one, e.g. the reads of isCardValid(), are part of it
+
+  @returns  The bytes of stack used from the frame of the operation down, and the bytes of heap allocated above the heap in use when it started
+*/
+/**************************************************************************/
+cie_MemoryUsage cie_PN532::getMemoryUsage() {
+  return _memoryProbe.getUsage();
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Starts timing a tap, right after the card was activated
+*/
+/**************************************************************************/
+void cie_PN532::startTap() {
+  _tapOpen = true;
+  _tapStartedAt = micros();
+  _tapEndedAt = _tapStartedAt;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Reports the tap in progress to the telemetry, from the activation of the card to its last APDU command.
+          Repeated taps are not reported
+*/
+/**************************************************************************/
+void cie_PN532::endTap() {
+  if (_tapOpen && _telemetry != NULL && !_repeatedTap) {
+    _telemetry->recordTap(_tapEndedAt - _tapStartedAt);
+  }
+  _tapOpen = false;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Suppresses duplicate taps: cards seen within the hold-off time are not reported by detectCard() and identify().
+          A card resting on the reader is checked for presence without sending any APDU command
+
+  @param  holdOff The time in milliseconds a card is remembered after it was last seen, or NO_HOLD_OFF (the default)
+*/
+/**************************************************************************/
+void cie_PN532::setHoldOff(const unsigned long holdOff) {
+  _recentCards.setHoldOff(holdOff);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Tells whether the last call to detectCard() or identify() failed because the card was seen lately
+
+  @returns  A boolean value indicating whether the last tap was suppressed or not
+*/
+/**************************************************************************/
+bool cie_PN532::isRepeatedTap() {
+  return _repeatedTap;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Sets a deadline for the next operations, e.g. isCardValid() or a few file reads.
+          Once it's exceeded, no more APDU commands are sent and operations fail with CIE_ERROR_DEADLINE_EXCEEDED.
+          Reads of Elementary Files report the length of the content read so far
+
+  @param  timeout The time available from now, in milliseconds
+*/
+/**************************************************************************/
+void cie_PN532::setDeadline(const unsigned long timeout) {
+  _deadlineStart = millis();
+  _deadline = timeout;
+  _lastError = CIE_ERROR_NONE;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Removes the deadline set with setDeadline()
+*/
+/**************************************************************************/
+void cie_PN532::clearDeadline() {
+  _deadline = NO_DEADLINE;
+  _nfc->limitTimeout(NO_TIMEOUT_LIMIT);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Tells why the last APDU command failed
+
+  @returns  CIE_ERROR_NONE, CIE_ERROR_COMMAND_FAILED or CIE_ERROR_DEADLINE_EXCEEDED
+*/
+/**************************************************************************/
+byte cie_PN532::getLastError() {
+  return _lastError;
+}
+
+
 /**************************************************************************/
 /*!
     @brief  Prints an hex representation of a buffer
@@ -122,6 +501,40 @@ void cie_PN532::printHex(byte *buffer, const word length) {
   PN532DEBUGPRINT.println();
 }
 
+/**************************************************************************/
+/*!
+  @brief  Reads the DG1 of the ICAO application, the data of the machine readable zone. It needs PACE first
+
+  @param  contentBuffer The pointer to data containing the contents of the file
+  @param  contentLength The length of the file
+	
+  @returns  A boolean value indicating whether the operation succeeded or not
+*/
+/**************************************************************************/
+bool cie_PN532::read_DG1(byte *contentBuffer, word *contentLength) {
+  CIE_MEMORY_SCOPE(&_memoryProbe);
+  cie_EFPath filePath = { ICAO_DF, SELECT_BY_SFI, 0x01 }; //efid 0x0101
+  return readElementaryFile(filePath, contentBuffer, contentLength, AUTODETECT_BER_LENGTH);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Reads the DG11 of the ICAO application, the additional personal details. It needs PACE first
+
+  @param  contentBuffer The pointer to data containing the contents of the file
+  @param  contentLength The length of the file
+	
+  @returns  A boolean value indicating whether the operation succeeded or not
+*/
+/**************************************************************************/
+bool cie_PN532::read_DG11(byte *contentBuffer, word *contentLength) {
+  CIE_MEMORY_SCOPE(&_memoryProbe);
+  cie_EFPath filePath = { ICAO_DF, SELECT_BY_SFI, 0x0B }; //efid 0x010B
+  return readElementaryFile(filePath, contentBuffer, contentLength, AUTODETECT_BER_LENGTH);
+}
+
+
 /**************************************************************************/
 /*!
   @brief  Reads the binary content the EF_DH elementary file
@@ -133,6 +546,7 @@ void cie_PN532::printHex(byte *buffer, const word length) {
 */
 /**************************************************************************/
 bool cie_PN532::read_EF_DH(byte *contentBuffer, word *contentLength) {
+  CIE_MEMORY_SCOPE(&_memoryProbe);
   //cie_EFPath filePath = { ROOT_MF, SELECT_BY_SFI, 0x1B }; //efid 0xD004
   cie_EFPath filePath = { ROOT_MF, SELECT_BY_EFID, 0xD004 }; //efid 0xD004
   return readElementaryFile(filePath, contentBuffer, contentLength, AUTODETECT_BER_LENGTH);
@@ -150,6 +564,7 @@ bool cie_PN532::read_EF_DH(byte *contentBuffer, word *contentLength) {
 */
 /**************************************************************************/
 bool cie_PN532::read_EF_ATR(byte *contentBuffer, word *contentLength) {
+  CIE_MEMORY_SCOPE(&_memoryProbe);
   cie_EFPath filePath = { ROOT_MF, SELECT_BY_SFI, 0x1D }; //efid 0x2F01
   return readElementaryFile(filePath, contentBuffer, contentLength, AUTODETECT_ATR_LENGTH);
 }
@@ -166,6 +581,7 @@ bool cie_PN532::read_EF_ATR(byte *contentBuffer, word *contentLength) {
 */
 /**************************************************************************/
 bool cie_PN532::read_EF_SN_ICC(byte *contentBuffer, word *contentLength) {
+  CIE_MEMORY_SCOPE(&_memoryProbe);
   cie_EFPath filePath = { ROOT_MF, SELECT_BY_EFID, 0xD003 }; //What's the sfi for this file?
   *contentLength = clamp(*contentLength, EF_SN_ICC_LENGTH);
   return readElementaryFile(filePath, contentBuffer, contentLength, FIXED_LENGTH);
@@ -183,6 +599,7 @@ bool cie_PN532::read_EF_SN_ICC(byte *contentBuffer, word *contentLength) {
 */
 /**************************************************************************/
 bool cie_PN532::read_EF_ID_Servizi(byte *contentBuffer, word *contentLength) {
+  CIE_MEMORY_SCOPE(&_memoryProbe);
   cie_EFPath filePath = { CIE_DF, SELECT_BY_SFI, 0x01 }; //efid 0x1001
   *contentLength = clamp(*contentLength, EF_ID_SERVIZI_LENGTH);
   return readElementaryFile(filePath, contentBuffer, contentLength, FIXED_LENGTH);
@@ -199,6 +616,7 @@ bool cie_PN532::read_EF_ID_Servizi(byte *contentBuffer, word *contentLength) {
 */
 /**************************************************************************/
 bool cie_PN532::read_EF_Int_Kpub(cie_Key *key) {
+  CIE_MEMORY_SCOPE(&_memoryProbe);
   cie_EFPath filePath = { CIE_DF, SELECT_BY_SFI, 0x04 }; //efid 0x1004
   return readKey(filePath, key);
 }
@@ -214,6 +632,7 @@ bool cie_PN532::read_EF_Int_Kpub(cie_Key *key) {
 */
 /**************************************************************************/
 bool cie_PN532::read_EF_Servizi_Int_Kpub(cie_Key *key) {
+  CIE_MEMORY_SCOPE(&_memoryProbe);
   cie_EFPath filePath = { CIE_DF, SELECT_BY_SFI, 0x05 }; //efid 0x1005
   return readKey(filePath, key);
 }
@@ -226,16 +645,17 @@ bool cie_PN532::read_EF_Servizi_Int_Kpub(cie_Key *key) {
 */
 /**************************************************************************/
 bool cie_PN532::isCardValid() {
-  cie_Key *key = new cie_Key();
-  if (!read_EF_Servizi_Int_Kpub(key)) {
+  CIE_MEMORY_SCOPE(&_memoryProbe);
+  cie_Key key;
+  if (!read_EF_Servizi_Int_Kpub(&key)) {
     return false;
   }
-  word responseLength = key->modulusLength + STATUS_WORD_LENGTH;
+  word responseLength = key.modulusLength + STATUS_WORD_LENGTH;
   byte *response = new byte[responseLength];
 
   byte challengeLength = CHALLENGE_LENGTH;
   byte *challenge = new byte[challengeLength];
-  _nfc->generateRandomBytes(challenge, 0, challengeLength);
+  takeChallenge(challenge);
 
   bool success = true;
   //Steps for checking this is not a cloned card
@@ -245,7 +665,7 @@ bool cie_PN532::isCardValid() {
   //4. Check if EF.Servizi_int.Kpub has a correct signature in EF_SOD
   if (!select_SDO_Servizi_Int_Kpriv()
       || !internalAuthenticate(response, &responseLength, challenge, challengeLength)
-      || !verifyInternalAuthenticateResponse(key, response, responseLength, challenge, challengeLength)
+      || !verifyInternalAuthenticateResponse(&key, response, responseLength, challenge, challengeLength)
     //|| !verify_Servizi_Int_Kpub(...)
   ) {
     success = false;
@@ -257,6 +677,74 @@ bool cie_PN532::isCardValid() {
 }
 
 
+/**************************************************************************/
+/*!
+  @brief  Generates the challenges missing from the pool. detectCard() calls this while no card is in the field,
+          call it yourself if you detect cards some other way
+
+*/
+/**************************************************************************/
+void cie_PN532::refillChallenges() {
+  if (_challengeCount >= CHALLENGE_POOL_SIZE) {
+    return;
+  }
+  _nfc->generateRandomBytes(_challenges[_challengeCount], 0, (CHALLENGE_POOL_SIZE - _challengeCount) * CHALLENGE_LENGTH);
+  _challengeCount = CHALLENGE_POOL_SIZE;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Takes a challenge from the pool, or generates one if the pool is empty. Each challenge is used once
+
+  @param  challenge The pointer to a buffer of CHALLENGE_LENGTH bytes
+*/
+/**************************************************************************/
+void cie_PN532::takeChallenge(byte *challenge) {
+  if (_telemetry != NULL) {
+    _telemetry->recordCacheLookup(TELEMETRY_CACHE_CHALLENGE_POOL, _challengeCount > 0);
+  }
+  if (_challengeCount == 0) {
+    _nfc->generateRandomBytes(challenge, 0, CHALLENGE_LENGTH);
+    return;
+  }
+  _challengeCount--;
+  memcpy(challenge, _challenges[_challengeCount], CHALLENGE_LENGTH);
+  memset(_challenges[_challengeCount], 0, CHALLENGE_LENGTH);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Prepares the RSA engine for a public key, reusing its precomputed context if it's cached
+
+  @param  key The pointer to the public key
+
+  @returns  A boolean value indicating whether the key can be used or not
+*/
+/**************************************************************************/
+bool cie_PN532::setRsaModulus(cie_Key *key) {
+  word cacheHits = _rsa->getCacheHits();
+  bool success = _rsa->setModulus(key->modulus, key->modulusLength, key->getFingerprint());
+  if (_telemetry != NULL) {
+    _telemetry->recordCacheLookup(TELEMETRY_CACHE_RSA_CONTEXT, _rsa->getCacheHits() != cacheHits);
+  }
+  return success;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Gets the CPU cycles taken by the RSA verification in the last call to isCardValid()
+
+  @returns  The number of cycles (see cie_Cycles.h for how they're measured on each board)
+*/
+/**************************************************************************/
+unsigned long cie_PN532::getVerificationCycles() {
+  return _verificationCycles;
+}
+
+
 /**************************************************************************/
 /*!
   @brief  Print the binary content of the EF_SOD elementary file
@@ -267,13 +755,14 @@ bool cie_PN532::isCardValid() {
 */
 /**************************************************************************/
 bool cie_PN532::print_EF_SOD(word *contentLength) {
+  CIE_MEMORY_SCOPE(&_memoryProbe);
   cie_EFPath filePath = { CIE_DF, SELECT_BY_SFI, 0x06 }; //efid 0x1006
   if (!determineLength(filePath, contentLength, AUTODETECT_BER_LENGTH)) {
         return false;
   }
   word offset = READ_FROM_START;
   while (offset < *contentLength) {
-    word contentPageLength = clamp(*contentLength-offset, PAGE_LENGTH);
+    word contentPageLength = clamp(*contentLength-offset, getPageLength());
     byte *pageBuffer = new byte[contentPageLength];
     bool success = readBinaryContent(filePath, pageBuffer, offset, contentPageLength);
     if (success) {
@@ -300,6 +789,7 @@ bool cie_PN532::print_EF_SOD(word *contentLength) {
 */
 /**************************************************************************/
 bool cie_PN532::parse_EF_SOD(cieBerTripleCallbackFunc callback) {
+  CIE_MEMORY_SCOPE(&_memoryProbe);
   word payloadLength;
   cie_EFPath filePath = { CIE_DF, SELECT_BY_SFI, 0x06 }; //efid 0x1006
   return _berReader->readTriples(filePath, callback, &payloadLength, 30);
@@ -308,12 +798,607 @@ bool cie_PN532::parse_EF_SOD(cieBerTripleCallbackFunc callback) {
 
 /**************************************************************************/
 /*!
-  @brief  Selects the SDO.Servizi_Int.Kpriv private key for internal authentication
-  
-  @returns  A boolean value indicating whether the operation succeeded or not
+  @brief  Performs the passive authentication of the card: checks the EF_ID_Servizi and the EF_Servizi_Int_Kpub
+          against the hashes listed in the EF_SOD. The signature of the EF_SOD is not verified here
+	
+  @returns  A boolean value indicating whether the files match their hashes or not
 */
 /**************************************************************************/
-bool cie_PN532::select_SDO_Servizi_Int_Kpriv() {
+bool cie_PN532::verify_EF_SOD() {
+  CIE_MEMORY_SCOPE(&_memoryProbe);
+  const cie_DataGroup dataGroups[] = {
+    { DG_ID_SERVIZI, { CIE_DF, SELECT_BY_SFI, 0x01 }, EF_ID_SERVIZI_LENGTH, FIXED_LENGTH },
+    //The length of the key depends on its size
+    { DG_SERVIZI_INT_KPUB, { CIE_DF, SELECT_BY_SFI, 0x05 }, 0, AUTODETECT_BER_LENGTH }
+  };
+  return verify_EF_SOD(dataGroups, sizeof(dataGroups) / sizeof(cie_DataGroup));
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Parses the EF_SOD and, as soon as the hash of a data group is found, hashes its Elementary File and compares the digests.
+          It stops at the first mismatch, and right after the LDSSecurityObject (the certificates are not parsed)
+
+  @param  dataGroups The data groups to check, with the path and the length (or length strategy) of their Elementary Files. Data groups not listed are skipped
+  @param  dataGroupCount The number of data groups, up to SOD_MAX_DATA_GROUPS
+	
+  @returns  A boolean value indicating whether every data group listed was found in the EF_SOD and its file matches the hash or not
+*/
+/**************************************************************************/
+bool cie_PN532::verify_EF_SOD(const cie_DataGroup *dataGroups, const byte dataGroupCount) {
+  CIE_MEMORY_SCOPE(&_memoryProbe);
+  if (dataGroupCount == 0 || dataGroupCount > SOD_MAX_DATA_GROUPS) {
+    PN532DEBUGPRINT.println(F("Too many or no data groups to check"));
+    return false;
+  }
+  _sodCheck.dataGroups = dataGroups;
+  _sodCheck.dataGroupCount = dataGroupCount;
+  _sodCheck.afterSignatureDataOid = false;
+  _sodCheck.ldsEnd = 0;
+  _sodCheck.ldsDepth = 0;
+  _sodCheck.hash = NULL;
+  _sodCheck.verifiedDataGroups = 0;
+  _sodCheck.failed = false;
+  //The BER reader takes a plain function as callback
+  _sodChecker = this;
+  bool parsed = parse_EF_SOD(onSodTriple);
+  _sodChecker = NULL;
+  delete _sodCheck.hash;
+  _sodCheck.hash = NULL;
+  if (!parsed || _sodCheck.failed) {
+    return false;
+  }
+  for (byte i = 0; i < dataGroupCount; i++) {
+    if ((_sodCheck.verifiedDataGroups & ((word) 1 << i)) == 0) {
+      PN532DEBUGPRINT.print(F("The data group was not found in the EF_SOD: "));
+      PN532DEBUGPRINT.println(dataGroups[i].number, HEX);
+      return false;
+    }
+  }
+  return true;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Forwards the triples of the EF_SOD to the instance running verify_EF_SOD()
+*/
+/**************************************************************************/
+bool cie_PN532::onSodTriple(cie_BerTriple *triple) {
+  return _sodChecker->checkSodTriple(triple);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Looks for the LDSSecurityObject in the EF_SOD and checks each data group as soon as its hash is read.
+          LDSSecurityObject ::= SEQUENCE { version, hashAlgorithm SEQUENCE { OID, ... }, dataGroupHashValues SEQUENCE OF
+          SEQUENCE { dataGroupNumber INTEGER, dataGroupHashValue OCTET STRING } }
+
+  @param  triple The triple just read
+	
+  @returns  A boolean value indicating whether parsing should go on or not
+*/
+/**************************************************************************/
+bool cie_PN532::checkSodTriple(cie_BerTriple *triple) {
+  bool isUniversal = triple->classification == 0x00;
+  bool isObjectIdentifier = isUniversal && triple->type == 0x06;
+  bool isOctetString = isUniversal && triple->type == 0x04;
+  byte value[HASH_MAX_DIGEST_LENGTH];
+  bool hasShortValue = triple->contentLength <= sizeof(value);
+  if (hasShortValue && (isObjectIdentifier || isOctetString || triple->type == 0x02)) {
+    if (!_berReader->readTripleValue(*triple, value)) {
+      _sodCheck.failed = true;
+      return false;
+    }
+  }
+
+  //The LDSSecurityObject is encapsulated in the OCTET STRING following the mRTDSignatureData OID
+  if (_sodCheck.ldsEnd == 0) {
+    if (isObjectIdentifier) {
+      _sodCheck.afterSignatureDataOid = triple->contentLength == sizeof(oid_mRTDSignatureData) && memcmp(value, oid_mRTDSignatureData, sizeof(oid_mRTDSignatureData)) == 0;
+    } else if (isOctetString && _sodCheck.afterSignatureDataOid) {
+      _sodCheck.ldsEnd = triple->contentOffset + triple->contentLength;
+      _sodCheck.ldsDepth = triple->depth;
+    }
+    return true;
+  }
+  if (triple->offset >= _sodCheck.ldsEnd) {
+    //Every hash was checked, no need to parse the certificates and the signature
+    return false;
+  }
+
+  byte depth = triple->depth - _sodCheck.ldsDepth;
+  if (depth == 3 && isObjectIdentifier && _sodCheck.hash == NULL) {
+    _sodCheck.hash = createHash(hashAlgorithmOf(value, triple->contentLength));
+    if (_sodCheck.hash == NULL) {
+      PN532DEBUGPRINT.println(F("The hash algorithm of the EF_SOD is not supported"));
+      _sodCheck.failed = true;
+      return false;
+    }
+  } else if (depth == 4 && isUniversal && triple->type == 0x02 && triple->contentLength <= 2) {
+    _sodCheck.dataGroup = triple->contentLength == 2 ? (word) (value[0] << 8 | value[1]) : value[0];
+  } else if (depth == 4 && isOctetString) {
+    const cie_DataGroup *dataGroup = NULL;
+    byte index = 0;
+    for (byte i = 0; i < _sodCheck.dataGroupCount; i++) {
+      if (_sodCheck.dataGroups[i].number == _sodCheck.dataGroup) {
+        dataGroup = &_sodCheck.dataGroups[i];
+        index = i;
+      }
+    }
+    if (dataGroup == NULL) {
+      return true;
+    }
+    byte digest[HASH_MAX_DIGEST_LENGTH];
+    word contentLength = dataGroup->length;
+    byte lengthStrategy = dataGroup->lengthStrategy;
+    if (lengthStrategy == AUTODETECT_BER_LENGTH) {
+      //The BER reader is still parsing the EF_SOD: the length comes from the header of the file, as in readKey()
+      byte header[BER_HEADER_LENGTH];
+      if (!readBinaryContent(dataGroup->filePath, header, READ_FROM_START, BER_HEADER_LENGTH)
+          || !decodeBerLength(header, BER_HEADER_LENGTH, &contentLength)) {
+        PN532DEBUGPRINT.print(F("Couldn't read the length of the data group: "));
+        PN532DEBUGPRINT.println(_sodCheck.dataGroup, HEX);
+        _sodCheck.failed = true;
+        return false;
+      }
+      lengthStrategy = FIXED_LENGTH;
+    }
+    if (_sodCheck.hash == NULL
+        || triple->contentLength != _sodCheck.hash->getDigestLength()
+        || !hashElementaryFile(dataGroup->filePath, _sodCheck.hash, digest, &contentLength, lengthStrategy)
+        || memcmp(value, digest, triple->contentLength) != 0) {
+      PN532DEBUGPRINT.print(F("The hash of the data group doesn't match: "));
+      PN532DEBUGPRINT.println(_sodCheck.dataGroup, HEX);
+      _sodCheck.failed = true;
+      return false;
+    }
+    _sodCheck.verifiedDataGroups |= (word) 1 << index;
+  }
+  return true;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Sets the key of the Country Signing CA, which signs the document signer certificates. Verified certificates are forgotten
+
+  @param  trustAnchor The public key of the CSCA. It's not copied, it must outlive this instance
+*/
+/**************************************************************************/
+void cie_PN532::setTrustAnchor(cie_Key *trustAnchor) {
+  _trustAnchor = trustAnchor;
+  _signerCache.clear();
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Counts the document signer certificates found already verified by verify_EF_SOD_Signature()
+
+  @returns  The number of RSA verifications with the trust anchor saved
+*/
+/**************************************************************************/
+word cie_PN532::getSignerCacheHits() {
+  return _signerCache.getHits();
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Verifies the signature of the EF_SOD: the document signer certificate must be signed by the trust anchor,
+          the messageDigest signed attribute must match the LDSSecurityObject and the signed attributes must be signed by
+          the document signer. Certificates already verified are not verified again (see getSignerCacheHits()).
+          Validity dates and revocation are not checked
+	
+  @returns  A boolean value indicating whether the EF_SOD is authentic or not
+*/
+/**************************************************************************/
+bool cie_PN532::verify_EF_SOD_Signature() {
+  CIE_MEMORY_SCOPE(&_memoryProbe);
+  cie_EFPath filePath = { CIE_DF, SELECT_BY_SFI, 0x06 }; //efid 0x1006
+  memset(&_sodLayout, 0, sizeof(_sodLayout));
+  _sodChecker = this;
+  bool parsed = parse_EF_SOD(onSodLayoutTriple);
+  _sodChecker = NULL;
+  cie_SodLayout *layout = &_sodLayout;
+  if (layout->unsupported) {
+    PN532DEBUGPRINT.println(F("The signature algorithm of the EF_SOD is not supported"));
+    return false;
+  }
+  if (!parsed || layout->tbsCertificate.length == 0 || layout->certificateSignature.length == 0
+      || layout->modulus.length == 0 || layout->modulus.length > KEY_MAX_MODULUS_LENGTH
+      || layout->exponent.length == 0 || layout->exponent.length > KEY_MAX_EXPONENT_LENGTH
+      || layout->content.length == 0 || layout->signedAttributes.length == 0
+      || layout->messageDigest.length == 0 || layout->signature.length == 0) {
+    PN532DEBUGPRINT.println(F("Couldn't find the document signer certificate and the signature in the EF_SOD"));
+    return false;
+  }
+
+  cie_Key signer;
+  signer.modulusLength = layout->modulus.length;
+  signer.exponentLength = (byte) layout->exponent.length;
+  bool success = readBinaryContent(filePath, signer.modulus, layout->modulus.offset, signer.modulusLength)
+    && readBinaryContent(filePath, signer.exponent, layout->exponent.offset, signer.exponentLength)
+    && verifyDocumentSigner(filePath, &signer);
+
+  //The messageDigest attribute binds the signature to the LDSSecurityObject
+  cie_Hash *hash = createHash(layout->hashAlgorithm);
+  byte digest[HASH_MAX_DIGEST_LENGTH];
+  byte messageDigest[HASH_MAX_DIGEST_LENGTH];
+  word contentLength = layout->content.length;
+  if (success && hash == NULL) {
+    PN532DEBUGPRINT.println(F("The hash algorithm of the EF_SOD is not supported"));
+    success = false;
+  }
+  if (success) {
+    hash->begin();
+    success = hashRange(filePath, hash, layout->content.offset, &contentLength)
+      && layout->messageDigest.length == hash->getDigestLength()
+      && readBinaryContent(filePath, messageDigest, layout->messageDigest.offset, layout->messageDigest.length);
+    hash->finish(digest);
+    if (success && memcmp(digest, messageDigest, layout->messageDigest.length) != 0) {
+      PN532DEBUGPRINT.println(F("The messageDigest doesn't match the LDSSecurityObject"));
+      success = false;
+    }
+  }
+  delete hash;
+
+  //Signed attributes are signed with their SET OF tag, instead of the [0] found in the SignerInfo
+  success = success && verifySignedRange(filePath, &signer, layout->hashAlgorithm, layout->signedAttributes, 0x31, layout->signature);
+  return success;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Checks the document signer certificate has been signed by the trust anchor, unless it was verified before
+
+  @param  filePath The path of the EF_SOD
+  @param  signer The public key found in the certificate
+
+  @returns  A boolean value indicating whether the certificate is trusted or not
+*/
+/**************************************************************************/
+bool cie_PN532::verifyDocumentSigner(const cie_EFPath filePath, cie_Key *signer) {
+  cie_SodLayout *layout = &_sodLayout;
+  byte keyDigest[SHA256_DIGEST_LENGTH];
+  cie_Sha256 sha256;
+  sha256.begin();
+  sha256.update(signer->modulus, signer->modulusLength);
+  sha256.update(signer->exponent, signer->exponentLength);
+  sha256.finish(keyDigest);
+  byte keyIdentifier[SIGNER_KEY_IDENTIFIER_LENGTH];
+  byte keyIdentifierLength = 0;
+  if (layout->keyIdentifier.length > 0 && layout->keyIdentifier.length <= SIGNER_KEY_IDENTIFIER_LENGTH
+      && readBinaryContent(filePath, keyIdentifier, layout->keyIdentifier.offset, layout->keyIdentifier.length)) {
+    keyIdentifierLength = (byte) layout->keyIdentifier.length;
+  }
+  bool cached = keyIdentifierLength > 0 && _signerCache.contains(keyIdentifier, keyIdentifierLength, keyDigest);
+  if (_telemetry != NULL) {
+    _telemetry->recordCacheLookup(TELEMETRY_CACHE_SIGNER, cached);
+  }
+  if (cached) {
+    return true;
+  }
+
+  if (_trustAnchor == NULL) {
+    PN532DEBUGPRINT.println(F("Set a trust anchor to verify the document signer"));
+    return false;
+  }
+  if (!verifySignedRange(filePath, _trustAnchor, layout->certificateHashAlgorithm, layout->tbsCertificate, 0x00, layout->certificateSignature)) {
+    PN532DEBUGPRINT.println(F("The document signer certificate is not signed by the trust anchor"));
+    return false;
+  }
+  _signerCache.add(keyIdentifier, keyIdentifierLength, keyDigest);
+  return true;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Verifies a PKCS#1 v1.5 signature of part of the EF_SOD, hashing it straight from the card
+
+  @param  filePath The path of the EF_SOD
+  @param  key The public key of the signer
+  @param  hashAlgorithm The hash algorithm (either HASH_ALGORITHM_SHA1 or HASH_ALGORITHM_SHA256)
+  @param  range The signed part
+  @param  tag The tag to hash in place of the first octet of the signed part, or 0x00 to hash it as it is
+  @param  signatureRange The signature
+
+  @returns  A boolean value indicating whether the signature is valid or not
+*/
+/**************************************************************************/
+bool cie_PN532::verifySignedRange(const cie_EFPath filePath, cie_Key *key, const byte hashAlgorithm, const cie_SodRange range, const byte tag, const cie_SodRange signatureRange) {
+  cie_Hash *hash = createHash(hashAlgorithm);
+  if (hash == NULL) {
+    PN532DEBUGPRINT.println(F("The hash algorithm of the signature is not supported"));
+    return false;
+  }
+  byte digest[HASH_MAX_DIGEST_LENGTH];
+  word offset = range.offset;
+  word length = range.length;
+  hash->begin();
+  if (tag != 0x00) {
+    hash->update(&tag, 1);
+    offset++;
+    length--;
+  }
+  bool success = hashRange(filePath, hash, offset, &length);
+  hash->finish(digest);
+
+  byte digestInfo[DIGEST_INFO_MAX_LENGTH];
+  byte digestInfoLength = writeDigestInfo(hashAlgorithm, digest, digestInfo);
+  delete hash;
+  byte *signature = new byte[signatureRange.length];
+  success = success
+    && readBinaryContent(filePath, signature, signatureRange.offset, signatureRange.length)
+    && setRsaModulus(key)
+    && _rsa->verify(signature, signatureRange.length, key->exponent, key->exponentLength, digestInfo, digestInfoLength);
+  delete [] signature;
+  return success;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Forwards the triples of the EF_SOD to the instance running verify_EF_SOD_Signature()
+*/
+/**************************************************************************/
+bool cie_PN532::onSodLayoutTriple(cie_BerTriple *triple) {
+  return _sodChecker->locateSodTriple(triple);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Locates the parts of the SignedData needed to verify it. SignedData ::= SEQUENCE { version, digestAlgorithms,
+          encapContentInfo SEQUENCE { eContentType, [0] { OCTET STRING } }, certificates [0], signerInfos SET }
+
+  @param  triple The triple just read
+	
+  @returns  A boolean value indicating whether parsing should go on or not
+*/
+/**************************************************************************/
+bool cie_PN532::locateSodTriple(cie_BerTriple *triple) {
+  cie_SodLayout *layout = &_sodLayout;
+  byte oid[OID_MAX_LENGTH];
+  bool isObjectIdentifier = triple->classification == 0x00 && triple->type == 0x06 && triple->contentLength <= sizeof(oid);
+  if (isObjectIdentifier && !_berReader->readTripleValue(*triple, oid)) {
+    return false;
+  }
+  if (!isObjectIdentifier) {
+    memset(oid, 0, sizeof(oid));
+  }
+
+  //ContentInfo ::= SEQUENCE { signedData OID, [0] { SignedData } }
+  if (layout->signedDataDepth == 0) {
+    if (isObjectIdentifier && triple->contentLength == sizeof(oid_signedData) && memcmp(oid, oid_signedData, sizeof(oid_signedData)) == 0) {
+      layout->signedDataDepth = triple->depth + 1;
+    }
+    return true;
+  }
+  if (triple->depth <= layout->signedDataDepth) {
+    return true;
+  }
+  byte depth = triple->depth - layout->signedDataDepth;
+  if (depth == 1) {
+    layout->childCount++;
+    layout->sectionCount = 0;
+    if (triple->classification == 0x02 && triple->type == 0x00) {
+      layout->section = SOD_SECTION_CERTIFICATE;
+    } else if (triple->classification == 0x00 && triple->type == 0x11 && layout->childCount > 2) {
+      layout->section = SOD_SECTION_SIGNER_INFO;
+    } else if (triple->classification == 0x00 && triple->type == 0x10 && layout->childCount == 3) {
+      layout->section = SOD_SECTION_CONTENT;
+    } else {
+      layout->section = SOD_SECTION_NONE;
+    }
+    return true;
+  }
+
+  switch (layout->section) {
+    case SOD_SECTION_CONTENT:
+      if (depth == 3 && triple->classification == 0x00 && triple->type == 0x04) {
+        layout->content.offset = triple->contentOffset;
+        layout->content.length = triple->contentLength;
+      }
+      return true;
+
+    case SOD_SECTION_CERTIFICATE:
+      return locateCertificateTriple(triple, depth, oid);
+
+    case SOD_SECTION_SIGNER_INFO:
+      return locateSignerInfoTriple(triple, depth, oid);
+  }
+  return true;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Locates the signed part, the public key, the subjectKeyIdentifier and the signature of the first certificate.
+          Certificate ::= SEQUENCE { tbsCertificate SEQUENCE { ..., subjectPublicKeyInfo SEQUENCE { algorithm, BIT STRING {
+          RSAPublicKey SEQUENCE { modulus, publicExponent } } }, [3] extensions }, signatureAlgorithm, signature BIT STRING }
+
+  @param  triple The triple just read
+  @param  depth Its depth in the SignedData
+  @param  oid The value of the triple if it's an object identifier
+	
+  @returns  A boolean value indicating whether parsing should go on or not
+*/
+/**************************************************************************/
+bool cie_PN532::locateCertificateTriple(cie_BerTriple *triple, const byte depth, const byte *oid) {
+  cie_SodLayout *layout = &_sodLayout;
+  bool isUniversal = triple->classification == 0x00;
+  if (depth == 2) {
+    layout->sectionCount++;
+    return true;
+  }
+  //The document signer is the only certificate in the EF_SOD
+  if (layout->sectionCount != 1) {
+    return true;
+  }
+
+  word tbsCertificateEnd = layout->tbsCertificate.offset + layout->tbsCertificate.length;
+  if (depth == 3 && layout->tbsCertificate.length == 0) {
+    layout->tbsCertificate.offset = triple->offset;
+    layout->tbsCertificate.length = triple->contentOffset + triple->contentLength - triple->offset;
+  } else if (depth == 3 && isUniversal && triple->type == 0x03 && triple->contentLength > 1) {
+    //Skip the unused bits octet
+    layout->certificateSignature.offset = triple->contentOffset + 1;
+    layout->certificateSignature.length = triple->contentLength - 1;
+  } else if (triple->offset >= tbsCertificateEnd) {
+    if (depth == 4 && isUniversal && triple->type == 0x06) {
+      layout->certificateHashAlgorithm = hashAlgorithmOf(oid, triple->contentLength);
+    }
+  } else if (depth == 6 && isUniversal && triple->type == 0x06) {
+    layout->afterPublicKeyOid = triple->contentLength == sizeof(oid_rsaEncryption) && memcmp(oid, oid_rsaEncryption, sizeof(oid_rsaEncryption)) == 0;
+  } else if (depth == 7 && isUniversal && triple->type == 0x02 && layout->afterPublicKeyOid) {
+    cie_SodRange *integer = layout->modulus.length == 0 ? &layout->modulus : &layout->exponent;
+    if (integer->length == 0) {
+      integer->offset = triple->contentOffset;
+      integer->length = triple->contentLength;
+    }
+  } else if (depth == 7 && isUniversal && triple->type == 0x06) {
+    layout->afterKeyIdentifierOid = triple->contentLength == sizeof(oid_subjectKeyIdentifier) && memcmp(oid, oid_subjectKeyIdentifier, sizeof(oid_subjectKeyIdentifier)) == 0;
+  } else if (depth == 8 && isUniversal && triple->type == 0x04 && layout->afterKeyIdentifierOid) {
+    layout->keyIdentifier.offset = triple->contentOffset;
+    layout->keyIdentifier.length = triple->contentLength;
+    layout->afterKeyIdentifierOid = false;
+  }
+  return true;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Locates the digest algorithm, the signed attributes, the messageDigest and the signature of the first SignerInfo.
+          SignerInfo ::= SEQUENCE { version, sid, digestAlgorithm, signedAttrs [0], signatureAlgorithm, signature OCTET STRING }
+
+  @param  triple The triple just read
+  @param  depth Its depth in the SignedData
+  @param  oid The value of the triple if it's an object identifier
+	
+  @returns  A boolean value indicating whether parsing should go on or not
+*/
+/**************************************************************************/
+bool cie_PN532::locateSignerInfoTriple(cie_BerTriple *triple, const byte depth, const byte *oid) {
+  cie_SodLayout *layout = &_sodLayout;
+  bool isUniversal = triple->classification == 0x00;
+  bool isObjectIdentifier = isUniversal && triple->type == 0x06;
+  if (depth == 2) {
+    layout->sectionCount++;
+    //Everything needed has been found
+    return layout->sectionCount == 1;
+  }
+
+  if (depth == 3 && triple->classification == 0x02 && triple->type == 0x00) {
+    layout->signedAttributes.offset = triple->offset;
+    layout->signedAttributes.length = triple->contentOffset + triple->contentLength - triple->offset;
+  } else if (depth == 4 && isObjectIdentifier && layout->signedAttributes.length == 0) {
+    layout->hashAlgorithm = hashAlgorithmOf(oid, triple->contentLength);
+  } else if (depth == 4 && isObjectIdentifier) {
+    //Either rsaEncryption or the RSA signature with the same hash algorithm, e.g. RSASSA-PSS is not supported
+    bool isRsa = triple->contentLength == sizeof(oid_rsaEncryption) && memcmp(oid, oid_rsaEncryption, sizeof(oid_rsaEncryption)) == 0;
+    if (!isRsa && hashAlgorithmOf(oid, triple->contentLength) != layout->hashAlgorithm) {
+      layout->unsupported = true;
+      return false;
+    }
+  } else if (depth == 5 && isObjectIdentifier) {
+    layout->afterMessageDigestOid = triple->contentLength == sizeof(oid_messageDigest) && memcmp(oid, oid_messageDigest, sizeof(oid_messageDigest)) == 0;
+  } else if (depth == 6 && isUniversal && triple->type == 0x04 && layout->afterMessageDigestOid) {
+    layout->messageDigest.offset = triple->contentOffset;
+    layout->messageDigest.length = triple->contentLength;
+    layout->afterMessageDigestOid = false;
+  } else if (depth == 3 && isUniversal && triple->type == 0x04) {
+    layout->signature.offset = triple->contentOffset;
+    layout->signature.length = triple->contentLength;
+    //No need to parse anything else
+    return false;
+  }
+  return true;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Tells the hash algorithm from its object identifier, or from the one of an RSA signature using it
+
+  @param  oid The pointer to the object identifier
+  @param  oidLength The length of the object identifier
+
+  @returns  The hash algorithm, HASH_ALGORITHM_NONE if it's not supported
+*/
+/**************************************************************************/
+byte cie_PN532::hashAlgorithmOf(const byte *oid, const word oidLength) {
+  if ((oidLength == sizeof(oid_sha256) && memcmp(oid, oid_sha256, sizeof(oid_sha256)) == 0)
+      || (oidLength == sizeof(oid_sha256WithRSAEncryption) && memcmp(oid, oid_sha256WithRSAEncryption, sizeof(oid_sha256WithRSAEncryption)) == 0)) {
+    return HASH_ALGORITHM_SHA256;
+  }
+  if ((oidLength == sizeof(oid_sha1) && memcmp(oid, oid_sha1, sizeof(oid_sha1)) == 0)
+      || (oidLength == sizeof(oid_sha1WithRSAEncryption) && memcmp(oid, oid_sha1WithRSAEncryption, sizeof(oid_sha1WithRSAEncryption)) == 0)) {
+    return HASH_ALGORITHM_SHA1;
+  }
+  return HASH_ALGORITHM_NONE;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Creates a hash. Delete it when done
+
+  @param  hashAlgorithm The hash algorithm (either HASH_ALGORITHM_SHA1 or HASH_ALGORITHM_SHA256)
+
+  @returns  The hash, NULL if the algorithm is not supported
+*/
+/**************************************************************************/
+cie_Hash *cie_PN532::createHash(const byte hashAlgorithm) {
+  switch (hashAlgorithm) {
+    case HASH_ALGORITHM_SHA1:
+      return new cie_Sha1();
+    case HASH_ALGORITHM_SHA256:
+      return new cie_Sha256();
+  }
+  return NULL;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Writes the DigestInfo signed by PKCS#1 v1.5 signatures: the DER encoded hash algorithm followed by the digest
+
+  @param  hashAlgorithm The hash algorithm (either HASH_ALGORITHM_SHA1 or HASH_ALGORITHM_SHA256)
+  @param  digest The pointer to the digest
+  @param  digestInfo The pointer to a buffer of DIGEST_INFO_MAX_LENGTH bytes
+
+  @returns  The length of the DigestInfo
+*/
+/**************************************************************************/
+byte cie_PN532::writeDigestInfo(const byte hashAlgorithm, const byte *digest, byte *digestInfo) {
+  const byte sha1Prefix[] = { 0x30, 0x21, 0x30, 0x09, 0x06, 0x05, 0x2B, 0x0E, 0x03, 0x02, 0x1A, 0x05, 0x00, 0x04, 0x14 };
+  const byte sha256Prefix[] = { 0x30, 0x31, 0x30, 0x0D, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x01, 0x05, 0x00, 0x04, 0x20 };
+  if (hashAlgorithm == HASH_ALGORITHM_SHA1) {
+    memcpy(digestInfo, sha1Prefix, sizeof(sha1Prefix));
+    memcpy(digestInfo + sizeof(sha1Prefix), digest, SHA1_DIGEST_LENGTH);
+    return sizeof(sha1Prefix) + SHA1_DIGEST_LENGTH;
+  }
+  memcpy(digestInfo, sha256Prefix, sizeof(sha256Prefix));
+  memcpy(digestInfo + sizeof(sha256Prefix), digest, SHA256_DIGEST_LENGTH);
+  return sizeof(sha256Prefix) + SHA256_DIGEST_LENGTH;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Selects the SDO.Servizi_Int.Kpriv private key for internal authentication
+  
+  @returns  A boolean value indicating whether the operation succeeded or not
+*/
+/**************************************************************************/
+bool cie_PN532::select_SDO_Servizi_Int_Kpriv() {
   cie_EFPath filePath = { CIE_DF, SELECT_BY_SDOID, 0x03 };
   return ensureSdoIsSelected(filePath);
 }
@@ -351,21 +1436,88 @@ bool cie_PN532::sendCommand(byte *command, const word commandLength) {
 */
 /**************************************************************************/
 bool cie_PN532::sendCommand(byte *command, const byte commandLength, byte *responseBuffer, word *responseLength) {
+  if (isDeadlineExceeded()) {
+    PN532DEBUGPRINT.println(F("Deadline exceeded"));
+    _lastError = CIE_ERROR_DEADLINE_EXCEEDED;
+    return false;
+  }
   bool success = true;
-  if (!_nfc->sendCommand(command, commandLength, responseBuffer, responseLength) 
-  || !hasSuccessStatusWord(responseBuffer, *responseLength)) {
+  _apduCount++;
+  //The command and the response may share the same buffer, so the command is read before the exchange
+  if (verbose) {
+    PN532DEBUGPRINT.print(F("Command: "));
+    printHex(command, commandLength);
+  }
+#if CIE_METRICS
+  byte instruction = command[1];
+  unsigned long startedAt = micros();
+#endif
+  bool exchanged = isSecureMessagingActive()
+    ? sendProtectedCommand(command, commandLength, responseBuffer, responseLength)
+    : _nfc->sendCommand(command, commandLength, responseBuffer, responseLength);
+#if CIE_METRICS
+  //The card time is measured by the transport, the rest is the reader's
+  unsigned long exchangeMicros = micros() - startedAt;
+  unsigned long cardMicros = _nfc->getCardMicros();
+  if (cardMicros > exchangeMicros) {
+    cardMicros = exchangeMicros;
+  }
+  _metrics.record(instruction, exchanged, responseBuffer, *responseLength, exchangeMicros - cardMicros, cardMicros);
+#endif
+  if (!exchanged || !hasSuccessStatusWord(responseBuffer, *responseLength)) {
     success = false;
   }
+  //A timeout right at the deadline is reported as such
+  _lastError = success ? CIE_ERROR_NONE : (isDeadlineExceeded() ? CIE_ERROR_DEADLINE_EXCEEDED : CIE_ERROR_COMMAND_FAILED);
+  if (_telemetry != NULL) {
+    _telemetry->recordApdu(success);
+    _tapEndedAt = micros();
+  }
+  _memoryProbe.sample();
   if (verbose) {
     PN532DEBUGPRINT.print(F("Command ("));
     PN532DEBUGPRINT.print(success ? F("success") : F("failure"));
-    PN532DEBUGPRINT.print(F("): "));
-    printHex(command, commandLength);
+    PN532DEBUGPRINT.println(F(")"));
   }
   return success;
 }
 
 
+/**************************************************************************/
+/*!
+  @brief  Sends an APDU command within the secure messaging session: the command is wrapped
+          and the response unwrapped in place, in the frame buffer of the session
+
+  @param  command A pointer to the plain APDU command bytes
+  @param  commandLength Length of the command
+  @param  responseBuffer A pointer to the buffer which will contain the plain response bytes
+  @param  responseLength The length of the desired response, then the length of the response
+
+  @returns  A boolean value indicating whether the response was received and is authentic
+*/
+/**************************************************************************/
+bool cie_PN532::sendProtectedCommand(const byte *command, const byte commandLength, byte *responseBuffer, word *responseLength) {
+  byte *frame = _secureMessaging->getBuffer();
+  memcpy(frame, command, commandLength);
+  word frameLength = _secureMessaging->wrapCommand(commandLength);
+  if (frameLength == 0) {
+    return false;
+  }
+  word protectedLength = SM_BUFFER_LENGTH;
+  if (!_nfc->sendCommand(frame, (byte) frameLength, frame, &protectedLength)
+   || !_secureMessaging->unwrapResponse(&protectedLength)) {
+    return false;
+  }
+  if (protectedLength > *responseLength) {
+    PN532DEBUGPRINT.println(F("The response is longer than expected"));
+    return false;
+  }
+  memcpy(responseBuffer, frame, protectedLength);
+  *responseLength = protectedLength;
+  return true;
+}
+
+
 /**************************************************************************/
 /*!
   @brief  Performs internal authentication
@@ -414,14 +1566,26 @@ bool cie_PN532::internalAuthenticate(byte *responseBuffer, word *responseLength,
 */
 /**************************************************************************/
 bool cie_PN532::verifyInternalAuthenticateResponse(cie_Key *pubKey, byte *cypher, const word cypherLength, const byte *message, const word messageLength) {
-  //To be implemented
-  return false;
+  //Cards seen before reuse their precomputed context
+  bool success = setRsaModulus(pubKey)
+    && _rsa->verify(cypher, cypherLength, pubKey->exponent, pubKey->exponentLength, message, messageLength);
+  _verificationCycles = _rsa->getCycles();
+  if (verbose) {
+    PN532DEBUGPRINT.print(F("RSA verification took "));
+    PN532DEBUGPRINT.print(_verificationCycles);
+    PN532DEBUGPRINT.println(F(" cycles"));
+  }
+  if (!success) {
+    PN532DEBUGPRINT.println(F("The response to the internal authentication is not valid"));
+  }
+  return success;
 }
 
 
 /**************************************************************************/
 /*!
-  @brief  Performs mutual authentication
+  @brief  Performs mutual authentication with the device keys and starts the secure messaging session
+          See 5.2.2 Device authentication with symmetric scheme in http://www.unsads.com/specs/IASECC/IAS_ECC_v1.0.1_UK.pdf
 
   @param  snIccBuffer A pointer to the buffer containing the SN.ICC (card serial number)
   @param  snIccBufferLength The length of the SN.ICC buffer
@@ -432,114 +1596,584 @@ bool cie_PN532::verifyInternalAuthenticateResponse(cie_Key *pubKey, byte *cypher
 */
 /**************************************************************************/
 bool cie_PN532::mutualAuthenticate(byte *snIccBuffer, const byte snIccBufferLength, byte *rndIccBuffer, const byte rndIccBufferLength) {
-
-  /*
-  //Prepare randoms
-  byte *rndIfd = new byte[CHALLENGE_LENGTH];
+  if (snIccBufferLength < SN_LENGTH || rndIccBufferLength < CHALLENGE_LENGTH) {
+    PN532DEBUGPRINT.println(F("The SN.ICC or the RND.ICC is too short"));
+    return false;
+  }
+  byte *snIcc = snIccBuffer + snIccBufferLength - SN_LENGTH;
+  byte rndIfd[CHALLENGE_LENGTH];
+  byte kIfd[K_LENGTH];
   _nfc->generateRandomBytes(rndIfd, 0, CHALLENGE_LENGTH);
-  byte *kIfd = new byte[K_LENGTH];
-  _nfc->generateRandomBytes(kIfd, 0, CHALLENGE_LENGTH);
-
-  delete [] rndIfd;
-  delete [] kIfd;
+  _nfc->generateRandomBytes(kIfd, 0, K_LENGTH);
+
+  //The command is built, encrypted and sent from the frame buffer of the session
+  byte *frame = _secureMessaging->getBuffer();
+  byte *cryptogram = frame + 5;
+  frame[0] = 0x00; //CLA
+  frame[1] = 0x82; //INS: MUTUAL AUTHENTICATE
+  frame[2] = 0x00; //P1: algorithm in the current SE
+  frame[3] = 0x00; //P2: key in the current SE
+  frame[4] = MUTUAL_AUTHENTICATION_LENGTH + SM_MAC_LENGTH; //Lc: E.IFD || M.IFD
+  memcpy(cryptogram, rndIfd, CHALLENGE_LENGTH);
+  memcpy(cryptogram + CHALLENGE_LENGTH, _deviceSerialNumber, SN_LENGTH);
+  memcpy(cryptogram + CHALLENGE_LENGTH + SN_LENGTH, rndIccBuffer, CHALLENGE_LENGTH);
+  memcpy(cryptogram + 2 * CHALLENGE_LENGTH + SN_LENGTH, snIcc, SN_LENGTH);
+  memcpy(cryptogram + 2 * (CHALLENGE_LENGTH + SN_LENGTH), kIfd, K_LENGTH);
+  _secureMessaging->setKeys(_deviceEncKey, _deviceMacKey);
+  _secureMessaging->encrypt(cryptogram, MUTUAL_AUTHENTICATION_LENGTH);
+  _secureMessaging->computeMac(cryptogram, MUTUAL_AUTHENTICATION_LENGTH, cryptogram + MUTUAL_AUTHENTICATION_LENGTH);
+  frame[5 + MUTUAL_AUTHENTICATION_LENGTH + SM_MAC_LENGTH] = MUTUAL_AUTHENTICATION_LENGTH + SM_MAC_LENGTH; //Le: E.ICC || M.ICC
+
+  word responseLength = MUTUAL_AUTHENTICATION_LENGTH + SM_MAC_LENGTH + STATUS_WORD_LENGTH;
+  bool success = sendCommand(frame, 6 + MUTUAL_AUTHENTICATION_LENGTH + SM_MAC_LENGTH, frame, &responseLength)
+    && responseLength == MUTUAL_AUTHENTICATION_LENGTH + SM_MAC_LENGTH + STATUS_WORD_LENGTH;
+  if (success) {
+    byte mac[SM_MAC_LENGTH];
+    _secureMessaging->computeMac(frame, MUTUAL_AUTHENTICATION_LENGTH, mac);
+    success = memcmp(mac, frame + MUTUAL_AUTHENTICATION_LENGTH, SM_MAC_LENGTH) == 0;
+  }
+  if (success) {
+    //R = RND.ICC || SN.ICC || RND.IFD || SN.IFD || K.ICC
+    _secureMessaging->decrypt(frame, MUTUAL_AUTHENTICATION_LENGTH);
+    success = memcmp(frame, rndIccBuffer, CHALLENGE_LENGTH) == 0
+      && memcmp(frame + CHALLENGE_LENGTH, snIcc, SN_LENGTH) == 0
+      && memcmp(frame + CHALLENGE_LENGTH + SN_LENGTH, rndIfd, CHALLENGE_LENGTH) == 0
+      && memcmp(frame + 2 * CHALLENGE_LENGTH + SN_LENGTH, _deviceSerialNumber, SN_LENGTH) == 0;
+  }
+  if (success) {
+    byte skEnc[SK_LENGTH];
+    byte skMac[SK_LENGTH];
+    byte skLength;
+    byte ssc[DES_BLOCK_LENGTH];
+    byte *kIcc = frame + 2 * (CHALLENGE_LENGTH + SN_LENGTH);
+    calculateSk(SK_ENC, kIfd, kIcc, skEnc, &skLength);
+    calculateSk(SK_MAC, kIfd, kIcc, skMac, &skLength);
+    //SSC = the 4 least significant bytes of RND.ICC || the 4 least significant bytes of RND.IFD
+    memcpy(ssc, rndIccBuffer + CHALLENGE_LENGTH - DES_BLOCK_LENGTH / 2, DES_BLOCK_LENGTH / 2);
+    memcpy(ssc + DES_BLOCK_LENGTH / 2, rndIfd + CHALLENGE_LENGTH - DES_BLOCK_LENGTH / 2, DES_BLOCK_LENGTH / 2);
+    _secureMessaging->begin(skEnc, skMac, ssc);
+    memset(skEnc, 0, SK_LENGTH);
+    memset(skMac, 0, SK_LENGTH);
+  } else {
+    _secureMessaging->end();
+    PN532DEBUGPRINT.println(F("The card failed the mutual authentication"));
+  }
+  memset(kIfd, 0, K_LENGTH);
+  memset(frame, 0, SM_BUFFER_LENGTH);
+  return success;
+}
 
-  //TODO: Page 59 - 5.2.2.2 Authentication steps 
-  //http://www.unsads.com/specs/IASECC/IAS_ECC_v1.0.1_UK.pdf
-  PN532DEBUGPRINT.println(F("Not yet implemented"));*/
 
-  return false;
+/**************************************************************************/
+/*!
+  @brief  Sets the static keys shared by the terminal and the cards for the mutual authentication
 
+  @param  encKey A pointer to the SM_KEY_LENGTH bytes K.ENC
+  @param  macKey A pointer to the SM_KEY_LENGTH bytes K.MAC
+  @param  serialNumber A pointer to the SN_LENGTH bytes SN.IFD identifying the terminal
+*/
+/**************************************************************************/
+void cie_PN532::setDeviceKeys(const byte *encKey, const byte *macKey, const byte *serialNumber) {
+  _deviceEncKey = encKey;
+  _deviceMacKey = macKey;
+  _deviceSerialNumber = serialNumber;
 }
 
 
 /**************************************************************************/
 /*!
-  @brief  Establishes a secure messaging context by performing mutual authentication
+  @brief  Establishes a secure messaging context by performing mutual authentication.
+          Until the next card is detected, all the APDUs are then protected
   
   @returns  A boolean value indicating whether the operation succeeded or not
 */
 /**************************************************************************/
 bool cie_PN532::establishSecureMessaging() {
-  /*word snIccLength = EF_SN_ICC_LENGTH;
-  byte *snIcc = new byte[snIccLength];
+  CIE_MEMORY_SCOPE(&_memoryProbe);
+  if (_deviceEncKey == NULL || _deviceMacKey == NULL || _deviceSerialNumber == NULL) {
+    PN532DEBUGPRINT.println(F("Set the device keys to establish secure messaging"));
+    return false;
+  }
+  //A session left by PACE uses AES
+  if (_secureMessaging != NULL && _secureMessaging->getBlockLength() != DES_BLOCK_LENGTH) {
+    delete _secureMessaging;
+    _secureMessaging = NULL;
+  }
+  if (_secureMessaging == NULL) {
+    _secureMessaging = new cie_DesSecureMessaging();
+  }
+  _secureMessaging->end();
 
+  word snIccLength = EF_SN_ICC_LENGTH;
+  byte snIcc[EF_SN_ICC_LENGTH];
   word rndIccLength = CHALLENGE_LENGTH + STATUS_WORD_LENGTH;
-  byte *rndIcc = new byte[rndIccLength];
+  byte rndIcc[CHALLENGE_LENGTH + STATUS_WORD_LENGTH];
 
   //Steps
   //1. Send a READ BINARY command for the SN.ICC Elementary File
-  //2. Retrieval of the card key set for device authentication
-  //3. Send a GET CHALLENGE command and retrieve the RND.ICC
-  //4. Send a MUTUAL AUTHENTICATE command
-  //5. Verify the MAC is correct
-  bool success = true;
-  if (!read_EF_SN_ICC(snIcc, &snIccLength)
-   || !getChallenge(rndIcc, &rndIccLength)
-   || !mutualAuthenticate(snIcc, snIccLength, rndIcc, rndIccLength)
-   //|| !verifyMac(...)
-   ) {
-    success = false;
-  }
+  //2. Send a GET CHALLENGE command and retrieve the RND.ICC
+  //3. Send a MUTUAL AUTHENTICATE command, verify the response and derive the session keys
+  bool success = read_EF_SN_ICC(snIcc, &snIccLength)
+    && getChallenge(rndIcc, &rndIccLength)
+    && mutualAuthenticate(snIcc, snIccLength, rndIcc, rndIccLength);
   if (!success) {
     PN532DEBUGPRINT.println(F("Couldn't establish a secure messaging context"));
   }
+  return success;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Tells whether APDUs are being protected by secure messaging
+
+  @returns  A boolean value indicating whether the secure messaging session is active
+*/
+/**************************************************************************/
+bool cie_PN532::isSecureMessagingActive() {
+  return _secureMessaging != NULL && _secureMessaging->isActive();
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Establishes a secure messaging context with PACE (generic mapping, ECDH on NIST P-256 or brainpoolP256r1,
+          AES-128), using the Card Access Number printed on the card as password. Call it right after detectCard.
+          Until the next card is detected, all the APDUs are then protected and the ICAO application can be read
+  
+  @param  can The pointer to the CAN digits, as ASCII characters
+  @param  canLength The number of digits
+
+  @returns  A boolean value indicating whether the operation succeeded or not
+*/
+/**************************************************************************/
+bool cie_PN532::establishPace(const byte *can, const byte canLength) {
+  CIE_MEMORY_SCOPE(&_memoryProbe);
+  if (canLength == 0 || canLength > PACE_MAX_CAN_LENGTH) {
+    PN532DEBUGPRINT.println(F("The CAN must be 1 to PACE_MAX_CAN_LENGTH digits long"));
+    return false;
+  }
+  //A session left by the mutual authentication uses 3DES
+  if (_secureMessaging != NULL && _secureMessaging->getBlockLength() != AES_BLOCK_LENGTH) {
+    delete _secureMessaging;
+    _secureMessaging = NULL;
+  }
+  if (_secureMessaging == NULL) {
+    _secureMessaging = new cie_AesSecureMessaging();
+  }
+  _secureMessaging->end();
+  cie_AesSecureMessaging *session = (cie_AesSecureMessaging *) _secureMessaging;
+
+  //EF.CardAccess is read from the Master File, which another application may have replaced
+  bool success = _currentDedicatedFile == NULL_DF || selectRootMasterFile();
+  _currentDedicatedFile = NULL_DF;
+  _currentElementaryFile = NULL_EF;
+  byte parameterId = ECC_CURVE_NONE;
+  word cardAccessLength = EF_CARD_ACCESS_MAX_LENGTH;
+  byte *cardAccess = new byte[EF_CARD_ACCESS_MAX_LENGTH];
+  success = success && readCardAccess(cardAccess, &cardAccessLength)
+    && findPaceParameters(cardAccess, cardAccessLength, &parameterId);
+  delete [] cardAccess;
+  //The EF.CardAccess was read by sfi, the next file must be selected again
+  _currentElementaryFile = NULL_EF;
+  cie_Ecc *ecc = new cie_Ecc();
+  success = success && ecc->setCurve(parameterId);
+
+  //Steps
+  //1. Send an MSE:Set AT command choosing the protocol, the CAN and the curve
+  //2. Send a GENERAL AUTHENTICATE command and decrypt the nonce with K.PI
+  //3. Exchange the mapping keys and map the generator: G' = nonce * G + H
+  //4. Exchange the ephemeral keys on G' and derive the session keys from the shared secret
+  //5. Exchange and check the authentication tokens, then start secure messaging
+  if (success) {
+    byte mseCommand[5 + 2 + PACE_OID_LENGTH + 3 + 3] = {
+      0x00, //CLA
+      0x22, //INS: MSE
+      0xC1, //P1: SET for computation and verification
+      0xA4, //P2: authentication template
+      2 + PACE_OID_LENGTH + 3 + 3, //Lc: length of the data (three TLV triples)
+      0x80, PACE_OID_LENGTH //First TLV triple: the protocol, copied below
+    };
+    byte *parameters = mseCommand + 7 + PACE_OID_LENGTH;
+    memcpy(mseCommand + 7, oid_PACE_ECDH_GM_AES_CBC_CMAC_128, PACE_OID_LENGTH);
+    parameters[0] = 0x83; //Second TLV triple: the password
+    parameters[1] = 0x01;
+    parameters[2] = PACE_PASSWORD_CAN;
+    parameters[3] = 0x84; //Third TLV triple: the standardized domain parameters
+    parameters[4] = 0x01;
+    parameters[5] = parameterId;
+    success = sendCommand(mseCommand, sizeof(mseCommand));
+  }
+
+  byte nonce[PACE_NONCE_LENGTH];
+  if (success) {
+    byte kPi[SM_KEY_LENGTH];
+    cie_Aes aes;
+    calculatePaceKey(PACE_KEY_PI, can, canLength, kPi);
+    success = generalAuthenticate(0x00, NULL, 0, 0x80, nonce, PACE_NONCE_LENGTH);
+    aes.setKey(kPi);
+    aes.decryptBlock(nonce);
+    memset(kPi, 0, SM_KEY_LENGTH);
+  }
+
+  byte privateKey[ECC_SCALAR_LENGTH];
+  byte publicKey[ECC_POINT_LENGTH];
+  byte cardPublicKey[ECC_POINT_LENGTH];
+  byte shared[ECC_POINT_LENGTH];
+  success = success && generateKeyPair(ecc, privateKey, publicKey)
+    && generalAuthenticate(0x81, publicKey, ECC_POINT_LENGTH, 0x82, cardPublicKey, ECC_POINT_LENGTH)
+    && ecc->multiply(privateKey, cardPublicKey, shared)
+    && ecc->mapGenerator(nonce, PACE_NONCE_LENGTH, shared);
+  memset(nonce, 0, PACE_NONCE_LENGTH);
+
+  success = success && generateKeyPair(ecc, privateKey, publicKey)
+    && generalAuthenticate(0x83, publicKey, ECC_POINT_LENGTH, 0x84, cardPublicKey, ECC_POINT_LENGTH)
+    && memcmp(publicKey, cardPublicKey, ECC_POINT_LENGTH) != 0
+    && ecc->multiply(privateKey, cardPublicKey, shared);
+  memset(privateKey, 0, ECC_SCALAR_LENGTH);
+  delete ecc;
+
+  byte ksEnc[SM_KEY_LENGTH];
+  byte ksMac[SM_KEY_LENGTH];
+  if (success) {
+    //The session keys come from the x coordinate of the shared point
+    calculatePaceKey(SK_ENC, shared + 1, ECC_COORDINATE_LENGTH, ksEnc);
+    calculatePaceKey(SK_MAC, shared + 1, ECC_COORDINATE_LENGTH, ksMac);
+    session->setKeys(ksEnc, ksMac);
+    byte token[SM_MAC_LENGTH];
+    byte cardToken[SM_MAC_LENGTH];
+    calculateAuthenticationToken(session, cardPublicKey, token);
+    success = generalAuthenticate(0x85, token, SM_MAC_LENGTH, 0x86, cardToken, SM_MAC_LENGTH);
+    calculateAuthenticationToken(session, publicKey, token);
+    success = success && memcmp(token, cardToken, SM_MAC_LENGTH) == 0;
+  }
+  memset(shared, 0, ECC_POINT_LENGTH);
+  if (success) {
+    byte ssc[AES_BLOCK_LENGTH];
+    memset(ssc, 0, AES_BLOCK_LENGTH);
+    session->begin(ksEnc, ksMac, ssc);
+  } else {
+    session->end();
+    PN532DEBUGPRINT.println(F("Couldn't establish a secure messaging context with PACE"));
+  }
+  memset(ksEnc, 0, SM_KEY_LENGTH);
+  memset(ksMac, 0, SM_KEY_LENGTH);
+  return success;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Reads the EF.CardAccess elementary file (sfi 0x1C) from the Master File with plain READ BINARY commands,
+          as PACE requires before any selection
+
+  @param  contentBuffer The pointer to the data buffer
+  @param  contentLength The capacity of the buffer, then the length of the file
+
+  @returns  A boolean value indicating whether the operation succeeded or not
+*/
+/**************************************************************************/
+bool cie_PN532::readCardAccess(byte *contentBuffer, word *contentLength) {
+  word fileLength;
+  if (!readIcaoBinaryPage(0x1C, contentBuffer, READ_FROM_START, BER_HEADER_LENGTH)
+      || !decodeBerLength(contentBuffer, BER_HEADER_LENGTH, &fileLength)) {
+    PN532DEBUGPRINT.println(F("Couldn't read the EF.CardAccess"));
+    return false;
+  }
+  if (fileLength > *contentLength) {
+    PN532DEBUGPRINT.println(F("The buffer is too small for the EF.CardAccess"));
+    return false;
+  }
+  bool success = true;
+  word offset = clamp(fileLength, BER_HEADER_LENGTH);
+  while (success && offset < fileLength) {
+    word contentPageLength = clamp(fileLength - offset, getPageLength());
+    success = readIcaoBinaryPage(0x1C, contentBuffer + offset, offset, contentPageLength);
+    offset += contentPageLength;
+  }
+  *contentLength = fileLength;
+  return success;
+}
 
-  delete [] snIcc;
-  delete [] rndIcc;
 
-  return success;*/
+/**************************************************************************/
+/*!
+  @brief  Looks for the PACEInfo of the generic mapping on a supported curve among the SecurityInfos of the EF.CardAccess:
+          SEQUENCE { OBJECT IDENTIFIER protocol, INTEGER version, INTEGER parameterId }
+
+  @param  cardAccess The pointer to the content of the EF.CardAccess
+  @param  cardAccessLength The length of the content
+  @param  parameterId The pointer to the standardized domain parameters id (either ECC_CURVE_NIST_P256 or ECC_CURVE_BRAINPOOL_P256R1)
+
+  @returns  A boolean value indicating whether the card supports a protocol implemented here
+*/
+/**************************************************************************/
+bool cie_PN532::findPaceParameters(const byte *cardAccess, const word cardAccessLength, byte *parameterId) {
+  //The OID, then two INTEGERs of one octet
+  const word infoLength = 2 + PACE_OID_LENGTH + 3 + 3;
+  for (word offset = 0; offset + infoLength <= cardAccessLength; offset++) {
+    const byte *info = cardAccess + offset;
+    if (info[0] != 0x06 || info[1] != PACE_OID_LENGTH || memcmp(info + 2, oid_PACE_ECDH_GM_AES_CBC_CMAC_128, PACE_OID_LENGTH) != 0) {
+      continue;
+    }
+    info += 2 + PACE_OID_LENGTH;
+    if (info[0] == 0x02 && info[1] == 0x01 && info[2] == PACE_VERSION && info[3] == 0x02 && info[4] == 0x01
+        && (info[5] == ECC_CURVE_NIST_P256 || info[5] == ECC_CURVE_BRAINPOOL_P256R1)) {
+      *parameterId = info[5];
+      return true;
+    }
+  }
+  PN532DEBUGPRINT.println(F("The card doesn't support PACE with the generic mapping on a 256-bit curve"));
   return false;
 }
 
 
 /**************************************************************************/
 /*!
-  @brief  Reads the binary content of an Elementary File given its Dedicated File and EFID or SFI identifier
+  @brief  Sends a step of PACE with the GENERAL AUTHENTICATE command: all the steps but the last are chained (CLA 0x10).
+          The data is wrapped in the dynamic authentication data object (tag 0x7C)
+
+  @param  commandTag The tag of the data object sent, or zeroes to send an empty dynamic authentication data object
+  @param  data The pointer to the value of the data object sent
+  @param  dataLength The length of the value
+  @param  responseTag The tag of the data object expected in the response
+  @param  response The pointer to the buffer which will contain the value of the data object received
+  @param  responseLength The length of the value expected
+
+  @returns  A boolean value indicating whether the card answered with the expected data object
+*/
+/**************************************************************************/
+bool cie_PN532::generalAuthenticate(const byte commandTag, const byte *data, const byte dataLength, const byte responseTag, byte *response, const byte responseLength) {
+  //The authentication tokens are exchanged last
+  bool last = commandTag == 0x85;
+  byte *frame = _secureMessaging->getBuffer();
+  byte dataObjectLength = commandTag == 0x00 ? 0 : 2 + dataLength;
+  frame[0] = last ? 0x00 : 0x10; //CLA: command chaining
+  frame[1] = 0x86; //INS: GENERAL AUTHENTICATE
+  frame[2] = 0x00; //P1: not used
+  frame[3] = 0x00; //P2: not used
+  frame[4] = 2 + dataObjectLength; //Lc
+  frame[5] = 0x7C; //Dynamic authentication data
+  frame[6] = dataObjectLength;
+  if (commandTag != 0x00) {
+    frame[7] = commandTag;
+    frame[8] = dataLength;
+    memcpy(frame + 9, data, dataLength);
+  }
+  frame[7 + dataObjectLength] = 0x00; //Le
+  word frameLength = 4 + responseLength + STATUS_WORD_LENGTH;
+  bool success = sendCommand(frame, 8 + dataObjectLength, frame, &frameLength)
+    && frameLength == 4 + responseLength + STATUS_WORD_LENGTH
+    && frame[0] == 0x7C && frame[1] == 2 + responseLength && frame[2] == responseTag && frame[3] == responseLength;
+  if (success) {
+    memcpy(response, frame + 4, responseLength);
+  } else {
+    PN532DEBUGPRINT.println(F("The card failed a step of PACE"));
+  }
+  memset(frame, 0, SM_BUFFER_LENGTH);
+  return success;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Generates an ephemeral key pair on the current generator
+
+  @param  ecc The engine, with the curve set
+  @param  privateKey The pointer to the ECC_SCALAR_LENGTH bytes private key
+  @param  publicKey The pointer to the ECC_POINT_LENGTH bytes public key
+
+  @returns  A boolean value indicating whether the operation succeeded or not
+*/
+/**************************************************************************/
+bool cie_PN532::generateKeyPair(cie_Ecc *ecc, byte *privateKey, byte *publicKey) {
+  //Random scalars are almost always less than n: a few attempts are plenty
+  for (byte attempt = 0; attempt < PACE_MAX_SCALAR_ATTEMPTS; attempt++) {
+    _nfc->generateRandomBytes(privateKey, 0, ECC_SCALAR_LENGTH);
+    if (ecc->isValidScalar(privateKey)) {
+      return ecc->multiply(privateKey, NULL, publicKey);
+    }
+  }
+  PN532DEBUGPRINT.println(F("Couldn't generate a private key"));
+  return false;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Derives a PACE key: the first SM_KEY_LENGTH bytes of SHA-1(secret || counter), with a 32-bit counter
+
+  @param  counter Either PACE_KEY_PI, SK_ENC or SK_MAC
+  @param  secret The pointer to the secret, the CAN or the x coordinate of the shared point
+  @param  secretLength The length of the secret
+  @param  key The pointer to the SM_KEY_LENGTH bytes key
+*/
+/**************************************************************************/
+void cie_PN532::calculatePaceKey(const byte counter, const byte *secret, const byte secretLength, byte *key) {
+  byte suffix[4] = { 0x00, 0x00, 0x00, counter };
+  byte hash[SHA1_DIGEST_LENGTH];
+  cie_Sha1 sha1;
+  sha1.begin();
+  sha1.update(secret, secretLength);
+  sha1.update(suffix, sizeof(suffix));
+  sha1.finish(hash);
+  memcpy(key, hash, SM_KEY_LENGTH);
+  memset(hash, 0, sizeof(hash));
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Calculates an authentication token, the CMAC of the other party's public key object
+          (7F49 { OID, 86 public point }) truncated to SM_MAC_LENGTH bytes
+
+  @param  session The session, with the keys set
+  @param  publicKey The pointer to the ECC_POINT_LENGTH bytes public key of the other party
+  @param  token The pointer to the SM_MAC_LENGTH bytes token
+*/
+/**************************************************************************/
+void cie_PN532::calculateAuthenticationToken(cie_AesSecureMessaging *session, const byte *publicKey, byte *token) {
+  byte keyObject[3 + 2 + PACE_OID_LENGTH + 2 + ECC_POINT_LENGTH];
+  byte cmac[AES_BLOCK_LENGTH];
+  keyObject[0] = 0x7F;
+  keyObject[1] = 0x49;
+  keyObject[2] = sizeof(keyObject) - 3;
+  keyObject[3] = 0x06;
+  keyObject[4] = PACE_OID_LENGTH;
+  memcpy(keyObject + 5, oid_PACE_ECDH_GM_AES_CBC_CMAC_128, PACE_OID_LENGTH);
+  keyObject[5 + PACE_OID_LENGTH] = 0x86;
+  keyObject[6 + PACE_OID_LENGTH] = ECC_POINT_LENGTH;
+  memcpy(keyObject + 7 + PACE_OID_LENGTH, publicKey, ECC_POINT_LENGTH);
+  session->computeCmac(keyObject, sizeof(keyObject), cmac);
+  memcpy(token, cmac, SM_MAC_LENGTH);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Gets a challenge from the card with the GET CHALLENGE command
 	
   @param contentBuffer Pointer to the response data
-  @param contentLength The length of the response
+  @param contentLength The length of the response buffer, then the length of the RND.ICC if the card sent one
 	
   @returns  A boolean value indicating whether the operation succeeded or not
 */
 /**************************************************************************/
 bool cie_PN532::getChallenge(byte *contentBuffer, word *contentLength) {
-  /*byte getChallengeCommand[] = {
+  byte getChallengeCommand[] = {
     0x00, //CLA
     0x84, //INS: GET CHALLENGE
     0x00, //P1: not used
     0x00, //P2: not used
-    0x08 //Le: Length of the rndIcc
+    CHALLENGE_LENGTH //Le: Length of the rndIcc
   };
-  bool success = sendCommand(getChallengeCommand, sizeof(getChallengeCommand), contentBuffer, contentLength);
+  bool success = sendCommand(getChallengeCommand, sizeof(getChallengeCommand), contentBuffer, contentLength)
+    && *contentLength == CHALLENGE_LENGTH + STATUS_WORD_LENGTH;
   if (!success) {
     PN532DEBUGPRINT.println(F("Couldn't get challenge"));
+    return false;
   }
   *contentLength = CHALLENGE_LENGTH;
-  return success;*/
-  return false;
+  return true;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Reads the binary content of an Elementary File given its Dedicated File and EFID or SFI identifier
+	
+  @param df The containing Dedicated File (either ROOT_MF or CIE_DF)
+  @param filePath a structure indicating the parent Dedicated File (either ROOT_MF or CIE_DF), the selection mode (either SELECT_BY_EFID or SELECT_BY_SFI) and the file identifier (either a sfi or an efid)
+  @param contentBuffer Pointer to the response data
+  @param response The maximum desired length of the response
+  @param lengthStrategy How to determine the length of the file (either FIXED_LENGTH or AUTODETECT_BER_LENGTH or AUTODETECT_ATR_LENGTH)
+	
+  @returns  A boolean value indicating whether the operation succeeded or not
+*/
+/**************************************************************************/
+bool cie_PN532::readElementaryFile(cie_EFPath filePath, byte *contentBuffer, word *contentLength, const byte lengthStrategy) {
+  CIE_MEMORY_SCOPE(&_memoryProbe);
+  //Some arguments passed around but more testable
+  if (!determineLength(filePath, contentLength, lengthStrategy)) {
+    return false;
+  }
+  if (!readBinaryContent(filePath, contentBuffer, READ_FROM_START, *contentLength)) {
+    //Partial results: the pages read before the deadline are in the buffer
+    if (_lastError == CIE_ERROR_DEADLINE_EXCEEDED) {
+      *contentLength = _contentRead;
+    }
+    return false;
+  }
+  return true;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Hashes each page read by readBinaryContent() as it's received, e.g. to check a file against the EF_SOD
+          while reading it. Call hash->begin() before and hash->finish() after the reads
+
+  @param hash The hash to feed, or NULL to stop hashing
+*/
+/**************************************************************************/
+void cie_PN532::setReadHash(cie_Hash *hash) {
+  _readHash = hash;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Computes the digest of an Elementary File without buffering its content: just one page at a time is in memory
+
+  @param filePath a structure indicating the parent Dedicated File (either ROOT_MF or CIE_DF), the selection mode (either SELECT_BY_EFID or SELECT_BY_SFI) and the file identifier (either a sfi or an efid)
+  @param hash The hash to use, e.g. a cie_Sha256
+  @param digest The pointer to a buffer of hash->getDigestLength() bytes
+  @param contentLength The length of the file if lengthStrategy is FIXED_LENGTH. It's set to the length hashed
+  @param lengthStrategy How to determine the length of the file (either FIXED_LENGTH or AUTODETECT_BER_LENGTH or AUTODETECT_ATR_LENGTH)
+
+  @returns  A boolean value indicating whether the operation succeeded or not
+*/
+/**************************************************************************/
+bool cie_PN532::hashElementaryFile(const cie_EFPath filePath, cie_Hash *hash, byte *digest, word *contentLength, const byte lengthStrategy) {
+  CIE_MEMORY_SCOPE(&_memoryProbe);
+  if (!determineLength(filePath, contentLength, lengthStrategy)) {
+    return false;
+  }
+  hash->begin();
+  bool success = hashRange(filePath, hash, READ_FROM_START, contentLength);
+  hash->finish(digest);
+  return success;
 }
 
 
 /**************************************************************************/
 /*!
-  @brief  Reads the binary content of an Elementary File given its Dedicated File and EFID or SFI identifier
-	
-  @param df The containing Dedicated File (either ROOT_MF or CIE_DF)
+  @brief  Feeds part of an Elementary File to a hash, one page at a time. The hash set with setReadHash(), if any, is set back afterwards
+
   @param filePath a structure indicating the parent Dedicated File (either ROOT_MF or CIE_DF), the selection mode (either SELECT_BY_EFID or SELECT_BY_SFI) and the file identifier (either a sfi or an efid)
-  @param contentBuffer Pointer to the response data
-  @param response The maximum desired length of the response
-  @param lengthStrategy How to determine the length of the file (either FIXED_LENGTH or AUTODETECT_BER_LENGTH or AUTODETECT_ATR_LENGTH)
-	
+  @param hash The hash to feed, already begun
+  @param offset The offset of the first byte to hash
+  @param length The number of bytes to hash. It's set to the number of bytes hashed
+
   @returns  A boolean value indicating whether the operation succeeded or not
 */
 /**************************************************************************/
-bool cie_PN532::readElementaryFile(cie_EFPath filePath, byte *contentBuffer, word *contentLength, const byte lengthStrategy) {
-  //Some arguments passed around but more testable
-  if (!determineLength(filePath, contentLength, lengthStrategy) ||
-      !readBinaryContent(filePath, contentBuffer, READ_FROM_START, *contentLength)) {
-    return false;
+bool cie_PN532::hashRange(const cie_EFPath filePath, cie_Hash *hash, const word offset, word *length) {
+  byte page[PAGE_LENGTH];
+  bool success = true;
+  word hashedLength = 0;
+  cie_Hash *readHash = _readHash;
+  setReadHash(hash);
+  while (success && hashedLength < *length) {
+    word contentPageLength = clamp(*length - hashedLength, getPageLength());
+    success = readBinaryContent(filePath, page, offset + hashedLength, contentPageLength);
+    if (success) {
+      hashedLength += contentPageLength;
+    }
   }
-  return true;
+  setReadHash(readHash);
+  *length = hashedLength;
+  return success;
 }
 
 
@@ -632,9 +2266,9 @@ bool cie_PN532::ensureSdoIsSelected(cie_EFPath filePath) {
 
 /**************************************************************************/
 /*!
-  @brief  Selects a dedicated file in the IAS application
+  @brief  Selects a dedicated file in the IAS application, or the ICAO application
   
-  @param df The Dedicated File (either ROOT_MF or CIE_DF)
+  @param df The Dedicated File (either ROOT_MF, CIE_DF or ICAO_DF)
   
   @returns  A boolean value indicating whether the operation succeeded or not
 */
@@ -648,6 +2282,14 @@ bool cie_PN532::ensureDedicatedFileIsSelected (const byte df) {
     _currentElementaryFile = NULL_EF;
   }
 
+  if (df == ICAO_DF) {
+    if (!selectIcaoApplication()) {
+      return false;
+    }
+    _currentDedicatedFile = df;
+    return true;
+  }
+
   if (!selectIasApplication()) {
     return false;
   }
@@ -723,7 +2365,9 @@ bool cie_PN532::determineLength(const cie_EFPath filePath, word *contentLength,
 */
 /**************************************************************************/
 bool cie_PN532::readBinaryContent(const cie_EFPath filePath, byte *contentBuffer, word startingOffset, const word contentLength) {
+  CIE_MEMORY_SCOPE(&_memoryProbe);
   byte fileId;
+  _contentRead = 0;
   switch (filePath.selectionMode) {
     case SELECT_BY_EFID:
       if (!ensureElementaryFileIsSelected(filePath)) {
@@ -746,33 +2390,16 @@ bool cie_PN532::readBinaryContent(const cie_EFPath filePath, byte *contentBuffer
   bool success = false;
   word offset = startingOffset;
   do {
-    word contentPageLength = clamp(contentLength+startingOffset-offset, PAGE_LENGTH);
-    byte preambleOctets = contentPageLength > 0x80 ? 3 : 2; //Discretionary data: three bytes for responses of length > 0x80
-    byte readCommand[] = {
-      0x00, //CLA
-      0xB1, //INS: READ BINARY (ODD INS)
-      0x00, //P1: zeroes
-      fileId, //P2: sfi to select or zeroes (i.e. keep current selected file)
-      0x04, //Lc: data field is made of 4 bytes
-      0x54, 0x02, //Data field: here comes an offset of 2 bytes
-      (byte) (offset >> 8), (byte) (offset & 0b11111111), //the offset
-      (byte) (contentPageLength + preambleOctets) //Le: bytes to be returned in the response
-    };
-    word responseLength = ((byte) contentPageLength) + preambleOctets + STATUS_WORD_LENGTH;
-    byte *responseBuffer = new byte[responseLength];  
-    success = sendCommand(readCommand, sizeof(readCommand), responseBuffer, &responseLength);
-    //Copy data over to the buffer
-    if (success) {
-      //The read binary command with ODD INS incapsulated the response with two or three preamble octets. Don't include them, they're not part of the content.
-      //See page 147 in the Gixel manual http://www.unsads.com/specs/IASECC/IAS_ECC_v1.0.1_UK.pdf
-      for (word i = preambleOctets; i < contentPageLength + preambleOctets; i++) {
-        contentBuffer[offset - startingOffset + i - preambleOctets] = responseBuffer[i];
-      }
+    word contentPageLength = clamp(contentLength+startingOffset-offset, getPageLength());
+    success = readBinaryPage(fileId, contentBuffer + (offset - startingOffset), offset, contentPageLength);
+    if (success && _readHash != NULL) {
+      _readHash->update(contentBuffer + (offset - startingOffset), contentPageLength);
     }
-    delete [] responseBuffer;  
     offset += contentPageLength;
-    
-  } while(success && (offset < contentLength));
+    if (success) {
+      _contentRead = offset - startingOffset;
+    }
+  } while(success && (offset < startingOffset + contentLength));
   if (!success) {
     PN532DEBUGPRINT.println(F("Couldn't fetch the elementary file content"));
   }  
@@ -782,7 +2409,112 @@ bool cie_PN532::readBinaryContent(const cie_EFPath filePath, byte *contentBuffer
 
 /**************************************************************************/
 /*!
-  @brief Reads the key content (BER encoded modulus and exponent) from the indicated Elementary File
+  @brief Reads a single page of binary content with one READ BINARY command
+
+  @param fileId The sfi of the file to read or zeroes to read the currently selected Elementary File
+  @param contentBuffer The pointer to the data buffer which will contain the page
+  @param offset The offset of the page in the file
+  @param contentPageLength The number of bytes to read (up to getPageLength())
+
+  @returns  A boolean value indicating whether the operation succeeded or not
+*/
+/**************************************************************************/
+bool cie_PN532::readBinaryPage(const byte fileId, byte *contentBuffer, const word offset, const word contentPageLength) {
+  if (_currentDedicatedFile == ICAO_DF) {
+    return readIcaoBinaryPage(fileId, contentBuffer, offset, contentPageLength);
+  }
+  byte preambleOctets = contentPageLength > 0x80 ? 3 : 2; //Discretionary data: three bytes for responses of length > 0x80
+  byte readCommand[] = {
+    0x00, //CLA
+    0xB1, //INS: READ BINARY (ODD INS)
+    0x00, //P1: zeroes
+    fileId, //P2: sfi to select or zeroes (i.e. keep current selected file)
+    0x04, //Lc: data field is made of 4 bytes
+    0x54, 0x02, //Data field: here comes an offset of 2 bytes
+    (byte) (offset >> 8), (byte) (offset & 0b11111111), //the offset
+    (byte) (contentPageLength + preambleOctets) //Le: bytes to be returned in the response
+  };
+  word responseLength = ((byte) contentPageLength) + preambleOctets + STATUS_WORD_LENGTH;
+  byte *responseBuffer = new byte[responseLength];  
+  bool success = sendCommand(readCommand, sizeof(readCommand), responseBuffer, &responseLength);
+  //Copy data over to the buffer
+  if (success) {
+    //The read binary command with ODD INS incapsulated the response with two or three preamble octets. Don't include them, they're not part of the content.
+    //See page 147 in the Gixel manual http://www.unsads.com/specs/IASECC/IAS_ECC_v1.0.1_UK.pdf
+    memcpy(contentBuffer, responseBuffer + preambleOctets, contentPageLength);
+  }
+  delete [] responseBuffer;  
+  return success;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Reads a single page of binary content with the READ BINARY command of ISO/IEC 7816-4 (even INS), as the ICAO
+         application wants: a short file identifier in P1 selects the file while reading its first 256 bytes,
+         after that P1-P2 is just the offset in the current file. The response has no preamble
+
+  @param fileId The sfi of the file to read or zeroes to read the currently selected Elementary File
+  @param contentBuffer The pointer to the data buffer which will contain the page
+  @param offset The offset of the page in the file
+  @param contentPageLength The number of bytes to read (up to getPageLength())
+
+  @returns  A boolean value indicating whether the operation succeeded or not
+*/
+/**************************************************************************/
+bool cie_PN532::readIcaoBinaryPage(const byte fileId, byte *contentBuffer, const word offset, const word contentPageLength) {
+  if (fileId != 0x00 && offset > 0xFF && _currentElementaryFile != fileId) {
+    //The offset doesn't fit P2: select the file with a one byte read first
+    byte firstByte;
+    if (!readIcaoBinaryPage(fileId, &firstByte, READ_FROM_START, 1)) {
+      return false;
+    }
+  }
+  bool bySfi = fileId != 0x00 && offset <= 0xFF;
+  byte readCommand[] = {
+    0x00, //CLA
+    0xB0, //INS: READ BINARY
+    bySfi ? (byte) (0b10000000 | fileId) : (byte) (offset >> 8), //P1: sfi or the high bits of the offset
+    (byte) (offset & 0b11111111), //P2: the offset
+    (byte) contentPageLength //Le: bytes to be returned in the response
+  };
+  word responseLength = contentPageLength + STATUS_WORD_LENGTH;
+  byte *responseBuffer = new byte[responseLength];
+  bool success = sendCommand(readCommand, sizeof(readCommand), responseBuffer, &responseLength)
+    && responseLength == contentPageLength + STATUS_WORD_LENGTH;
+  if (success) {
+    memcpy(contentBuffer, responseBuffer, contentPageLength);
+    if (bySfi) {
+      _currentElementaryFile = fileId;
+    }
+  }
+  delete [] responseBuffer;
+  return success;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Gets the number of bytes read by each READ BINARY command: a protected response must still fit in a short APDU
+         with its preamble, and the AES blocks of PACE leave less room than the 3DES ones
+
+  @returns  The page length
+*/
+/**************************************************************************/
+byte cie_PN532::getPageLength() {
+  if (!isSecureMessagingActive()) {
+    return PAGE_LENGTH;
+  }
+  //Up to three preamble octets precede the content
+  word maxPageLength = _secureMessaging->getMaxResponseDataLength() - 3;
+  return (byte) clamp(maxPageLength, PAGE_LENGTH);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Reads the public key (a DER encoded RSAPublicKey) from the indicated Elementary File, decoding each page
+         into the key as it's received. The fingerprint of the modulus is computed along the way
 
   @param filePath a structure indicating the parent Dedicated File (either ROOT_MF or CIE_DF), the selection mode (either SELECT_BY_EFID or SELECT_BY_SFI) and the file identifier (either a sfi or an efid)  
   @param key A pointer to a which object which will be populated with the modulus and exponent
@@ -791,13 +2523,313 @@ bool cie_PN532::readBinaryContent(const cie_EFPath filePath, byte *contentBuffer
 */
 /**************************************************************************/
 bool cie_PN532::readKey(const cie_EFPath filePath, cie_Key *key) {
-  //This is the fasted way but assumes we'll find a 2048-bit key and a 24-bit exponent valued 0x010001
-  //TODO: proper BER parsing by using the cie_BerReader class
-  key->exponentLength = 3;
-  key->exponent = new byte[key->exponentLength] { 0x01, 0x00, 0x01 };
-  key->modulusLength = 257;
-  key->modulus = new byte[key->modulusLength];
-  return readBinaryContent(filePath, key->modulus, 8, key->modulusLength);
+  CIE_MEMORY_SCOPE(&_memoryProbe);
+  //The header of the sequence tells the length of the file: each byte is then read just once
+  byte page[PAGE_LENGTH];
+  word fileLength;
+  cie_KeyDecoder decoder(key);
+  if (!readBinaryContent(filePath, page, READ_FROM_START, BER_HEADER_LENGTH)
+      || !decodeBerLength(page, BER_HEADER_LENGTH, &fileLength)) {
+    PN532DEBUGPRINT.println(F("Couldn't read the public key"));
+    return false;
+  }
+  if (fileLength > KEY_MAX_ENCODED_LENGTH) {
+    PN532DEBUGPRINT.println(F("The public key is too long"));
+    return false;
+  }
+  word offset = clamp(fileLength, BER_HEADER_LENGTH);
+  bool success = decoder.update(page, offset);
+  while (success && offset < fileLength) {
+    word contentPageLength = clamp(fileLength - offset, getPageLength());
+    success = readBinaryContent(filePath, page, offset, contentPageLength)
+      && decoder.update(page, contentPageLength);
+    offset += contentPageLength;
+  }
+  return decoder.finish() && success;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Starts a non-blocking read of an Elementary File. Call poll() repeatedly to advance it, one APDU command at a time
+
+  @param filePath a structure indicating the parent Dedicated File (either ROOT_MF or CIE_DF), the selection mode (either SELECT_BY_EFID or SELECT_BY_SFI) and the file identifier (either a sfi or an efid)
+  @param contentBuffer The pointer to the data buffer, which must stay valid until the read is done
+  @param contentLength The capacity of the buffer, which will be set to the length of the file (for FIXED_LENGTH, it's the number of bytes to read)
+  @param lengthStrategy How to determine the length of the file (either FIXED_LENGTH or AUTODETECT_BER_LENGTH)
+
+  @returns  A boolean value indicating whether the read was started or not
+*/
+/**************************************************************************/
+bool cie_PN532::startRead(const cie_EFPath filePath, byte *contentBuffer, word *contentLength, const byte lengthStrategy) {
+  CIE_MEMORY_SCOPE(&_memoryProbe);
+  byte step = _asyncRead.step;
+  if (step != ASYNC_STEP_IDLE && step != ASYNC_STEP_DONE && step != ASYNC_STEP_ERROR) {
+    PN532DEBUGPRINT.println(F("Another read is in progress, cancel it first"));
+    return false;
+  }
+  if (lengthStrategy != FIXED_LENGTH && lengthStrategy != AUTODETECT_BER_LENGTH) {
+    PN532DEBUGPRINT.println(F("The length strategy must be either AUTODETECT_BER_LENGTH or FIXED_LENGTH"));
+    return false;
+  }
+  if (filePath.selectionMode != SELECT_BY_EFID && filePath.selectionMode != SELECT_BY_SFI) {
+    PN532DEBUGPRINT.println(F("The selection mode must be either SELECT_BY_EFID or SELECT_BY_SFI"));
+    return false;
+  }
+  _asyncRead.filePath = filePath;
+  _asyncRead.contentBuffer = contentBuffer;
+  _asyncRead.contentLength = contentLength;
+  _asyncRead.capacity = *contentLength;
+  _asyncRead.offset = READ_FROM_START;
+  _asyncRead.lengthStrategy = lengthStrategy;
+  _asyncRead.step = nextAsyncStep();
+  return true;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Starts a non-blocking read of the EF_ID_Servizi elementary file
+
+  @param  contentBuffer The pointer to data containing the contents of the file
+  @param  contentLength The length of the file
+
+  @returns  A boolean value indicating whether the read was started or not
+*/
+/**************************************************************************/
+bool cie_PN532::startRead_EF_ID_Servizi(byte *contentBuffer, word *contentLength) {
+  CIE_MEMORY_SCOPE(&_memoryProbe);
+  cie_EFPath filePath = { CIE_DF, SELECT_BY_SFI, 0x01 }; //efid 0x1001
+  *contentLength = clamp(*contentLength, EF_ID_SERVIZI_LENGTH);
+  return startRead(filePath, contentBuffer, contentLength, FIXED_LENGTH);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Starts a non-blocking read of the SN_ICC elementary file
+
+  @param  contentBuffer The pointer to data containing the contents of the file
+  @param  contentLength The length of the file
+
+  @returns  A boolean value indicating whether the read was started or not
+*/
+/**************************************************************************/
+bool cie_PN532::startRead_EF_SN_ICC(byte *contentBuffer, word *contentLength) {
+  CIE_MEMORY_SCOPE(&_memoryProbe);
+  cie_EFPath filePath = { ROOT_MF, SELECT_BY_EFID, 0xD003 };
+  *contentLength = clamp(*contentLength, EF_SN_ICC_LENGTH);
+  return startRead(filePath, contentBuffer, contentLength, FIXED_LENGTH);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Advances the read started with startRead by sending at most one APDU command
+
+  @returns  POLL_IN_PROGRESS if more calls are needed, POLL_DONE when the content is available, POLL_ERROR if the read failed or POLL_IDLE if no read was started
+*/
+/**************************************************************************/
+byte cie_PN532::poll() {
+  CIE_MEMORY_SCOPE(&_memoryProbe);
+  switch (_asyncRead.step) {
+    case ASYNC_STEP_IDLE:
+      return POLL_IDLE;
+
+    case ASYNC_STEP_DONE:
+      return POLL_DONE;
+
+    case ASYNC_STEP_ERROR:
+      return POLL_ERROR;
+  }
+
+  if (!performAsyncStep(_asyncRead.step)) {
+    _asyncRead.step = ASYNC_STEP_ERROR;
+    return POLL_ERROR;
+  }
+  //The IAS application has just been selected, the DF must follow no matter what
+  _asyncRead.step = _asyncRead.step == ASYNC_STEP_SELECT_APPLICATION ? ASYNC_STEP_SELECT_DF : nextAsyncStep();
+  return _asyncRead.step == ASYNC_STEP_DONE ? POLL_DONE : POLL_IN_PROGRESS;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Tells how many bytes of the file have been read so far by the non-blocking read
+
+  @returns  The number of bytes available in the content buffer
+*/
+/**************************************************************************/
+word cie_PN532::readProgress() {
+  return _asyncRead.offset;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Abandons the non-blocking read, if any. The card selection state is kept consistent
+*/
+/**************************************************************************/
+void cie_PN532::cancelRead() {
+  _asyncRead.step = ASYNC_STEP_IDLE;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Determines which APDU command the non-blocking read should send next, skipping the selections already in place
+
+  @returns  The next step of the non-blocking read
+*/
+/**************************************************************************/
+byte cie_PN532::nextAsyncStep() {
+  if (_currentDedicatedFile != _asyncRead.filePath.df) {
+    return ASYNC_STEP_SELECT_APPLICATION;
+  }
+  if (_asyncRead.filePath.selectionMode == SELECT_BY_EFID && _currentElementaryFile != _asyncRead.filePath.id) {
+    return ASYNC_STEP_SELECT_EF;
+  }
+  if (_asyncRead.lengthStrategy == AUTODETECT_BER_LENGTH) {
+    return ASYNC_STEP_DETECT_LENGTH;
+  }
+  if (_asyncRead.offset < *_asyncRead.contentLength) {
+    return ASYNC_STEP_READ;
+  }
+  return ASYNC_STEP_DONE;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Sends the single APDU command needed by a step of the non-blocking read
+
+  @param step The step to perform
+
+  @returns  A boolean value indicating whether the operation succeeded or not
+*/
+/**************************************************************************/
+bool cie_PN532::performAsyncStep(const byte step) {
+  cie_EFPath filePath = _asyncRead.filePath;
+  byte fileId = filePath.selectionMode == SELECT_BY_SFI ? (byte) (filePath.id & 0b11111) : 0x00;
+  switch (step) {
+    case ASYNC_STEP_SELECT_APPLICATION:
+      //We're chaging Dedicated File, the current Elementary File will be deselected to prevent id collision
+      _currentDedicatedFile = NULL_DF;
+      _currentElementaryFile = NULL_EF;
+      return filePath.df == ICAO_DF ? selectIcaoApplication() : selectIasApplication();
+
+    case ASYNC_STEP_SELECT_DF:
+      switch (filePath.df) {
+        case ROOT_MF:
+          if (!selectRootMasterFile()) {
+            return false;
+          }
+        break;
+
+        case CIE_DF:
+          if (!selectCieDedicatedFile()) {
+            return false;
+          }
+        break;
+
+        case ICAO_DF:
+          //Selecting the application was enough
+        break;
+
+        default:
+          PN532DEBUGPRINT.println(F("The DF must be either ROOT_MF or CIE_DF"));
+          return false;
+      }
+      _currentDedicatedFile = filePath.df;
+      return true;
+
+    case ASYNC_STEP_SELECT_EF:
+      //The DF is already selected, so this will just send the SELECT FILE command
+      return ensureElementaryFileIsSelected(filePath);
+
+    case ASYNC_STEP_DETECT_LENGTH:
+      {
+        byte header[BER_HEADER_LENGTH];
+        word contentLength;
+        if (!readBinaryPage(fileId, header, READ_FROM_START, BER_HEADER_LENGTH)
+            || !decodeBerLength(header, BER_HEADER_LENGTH, &contentLength)) {
+          return false;
+        }
+        if (contentLength > _asyncRead.capacity) {
+          PN532DEBUGPRINT.println(F("The buffer is too small for the elementary file content"));
+          return false;
+        }
+        //The header we just read is also the beginning of the content
+        _asyncRead.offset = clamp(contentLength, BER_HEADER_LENGTH);
+        memcpy(_asyncRead.contentBuffer, header, _asyncRead.offset);
+        *_asyncRead.contentLength = contentLength;
+        _asyncRead.lengthStrategy = FIXED_LENGTH;
+      }
+      return true;
+
+    case ASYNC_STEP_READ:
+      {
+        word contentPageLength = clamp(*_asyncRead.contentLength - _asyncRead.offset, getPageLength());
+        if (!readBinaryPage(fileId, _asyncRead.contentBuffer + _asyncRead.offset, _asyncRead.offset, contentPageLength)) {
+          PN532DEBUGPRINT.println(F("Couldn't fetch the elementary file content"));
+          return false;
+        }
+        _asyncRead.offset += contentPageLength;
+      }
+      return true;
+  }
+  return false;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Decodes the overall length (tag octets + length octets + content length) of the first triple in a BER encoded header
+
+  @param header The pointer to the first octets of the file
+  @param headerLength The number of octets available in the header
+  @param contentLength The pointer to the decoded length
+
+  @returns  A boolean value indicating whether the length could be decoded from the header or not
+*/
+/**************************************************************************/
+bool cie_PN532::decodeBerLength(const byte *header, const byte headerLength, word *contentLength) {
+  //Please refer to https://en.wikipedia.org/wiki/X.690#Identifier_octets
+  byte position = 0;
+  while (position < headerLength && header[position] == 0x00) { //End of content can't be a tag
+    position++;
+  }
+  if (position < headerLength && (header[position] & 0b11111) == 0b11111) {
+    //The tag number is encoded in the following octets, where bit 8 of each is 1 if there are more octets
+    do {
+      position++;
+    } while (position < headerLength && (header[position] & 0b10000000) == 0b10000000);
+  }
+  position++;
+  if (position >= headerLength) {
+    PN532DEBUGPRINT.println(F("Couldn't detect length of a BER encoded file"));
+    return false;
+  }
+
+  word length = header[position];
+  if (length == 0b10000000) {
+    PN532DEBUGPRINT.println(F("Indefinite length for BER encoded file not supported"));
+    return false;
+  } else if ((length & 0b10000000) == 0b10000000) {
+    byte lengthOctets = length & 0b1111111;
+    if (lengthOctets > sizeof(word) || position + lengthOctets >= headerLength) {
+      PN532DEBUGPRINT.println(F("Invalid value for a BER encoded file length"));
+      return false;
+    }
+    length = 0;
+    for (byte i = 0; i < lengthOctets; i++) {
+      position++;
+      length <<= 8;
+      length |= header[position];
+    }
+  }
+  *contentLength = position + 1 + length;
+  return true;
 }
 
 
@@ -873,6 +2905,85 @@ bool cie_PN532::selectCieDedicatedFile(void) {
 }
 
 
+/**************************************************************************/
+/*!
+  @brief  Selects the ICAO eMRTD application
+	
+  @returns  A value indicating whether the operation succeeded or not
+*/
+/**************************************************************************/
+bool cie_PN532::selectIcaoApplication(void) {
+  byte command[] = { 
+      0x00, //CLA
+      0xA4, //INS: SELECT FILE
+      0x04, //P1: Select by AID
+      0x0C, //P2: No data in response field
+      0x07, //Lc: Length of AID
+      0xA0, 0x00, 0x00, 0x02, 0x47, 0x10, 0x01 //AID
+  };
+  bool success = sendCommand(command, sizeof(command));
+  if (!success) {
+    PN532DEBUGPRINT.println(F("Couldn't select the ICAO application"));
+  }
+  return success;
+}
+
+
+/**************************************************************************/
+/*!
+    @brief  Checks whether the deadline was exceeded, otherwise limits the time the terminal waits for the card to what's left
+
+    @returns  A value indicating whether the deadline was exceeded or not
+*/
+/**************************************************************************/
+bool cie_PN532::isDeadlineExceeded() {
+  if (_deadline == NO_DEADLINE) {
+    return false;
+  }
+  unsigned long elapsed = millis() - _deadlineStart;
+  if (elapsed >= _deadline) {
+    return true;
+  }
+  unsigned long left = _deadline - elapsed;
+  _nfc->limitTimeout(left > 0xFFFF ? 0xFFFF : (word) left);
+  return false;
+}
+
+
+/**************************************************************************/
+/*!
+    @brief  Checks whether the last detected card is still resting on the reader, when suppressing duplicate taps
+
+    @returns  A value indicating whether the card is still in the field or not
+*/
+/**************************************************************************/
+bool cie_PN532::isRestingCard() {
+  if (_recentCards.getHoldOff() == NO_HOLD_OFF || !_nfc->isCardPresent()) {
+    return false;
+  }
+  _recentCards.touchLast();
+  return true;
+}
+
+
+/**************************************************************************/
+/*!
+    @brief  Gets the UID of the detected card, unless it's a random one (single size, starting with 0x08)
+
+    @param  uidBuffer The pointer to a buffer of at least RECENT_CARD_ID_LENGTH bytes
+
+    @returns  The length of the UID, zero if it's random or unknown
+*/
+/**************************************************************************/
+byte cie_PN532::getStableUid(byte *uidBuffer) {
+  byte uidLength = _nfc->getUid(uidBuffer);
+  if (uidLength == 4 && uidBuffer[0] == 0x08) {
+    return 0;
+  }
+  return uidLength;
+}
+
+
 /**************************************************************************/
 /*!
     @brief  Reads the EF contents by its SFI under the current DF
@@ -952,30 +3063,27 @@ word cie_PN532::clamp(const word value, const byte maxValue) {
 
 */
 /**************************************************************************/
-void calculateSk(const byte valueType, byte *kIfd, byte *kIcc, byte *sk, byte *skLength) {
-  //7.1.4 Secure messaging - Session keys computation 
+void cie_PN532::calculateSk(const byte valueType, byte *kIfd, byte *kIcc, byte *sk, byte *skLength) {
+  //7.1.4 Secure messaging - Session keys computation: the first SK_LENGTH bytes of SHA-256(K.IFD xor K.ICC || counter)
   //http://www.unsads.com/specs/IASECC/IAS_ECC_v1.0.1_UK.pdf
-  byte *hash;
-
-  //Here we could use: https://github.com/Snowda/CryptoC
-  //Sha256.init();
-  for (byte i = 0; i < K_LENGTH + 4; i++) {
-    byte data;
-    if (i < K_LENGTH) {
-      data = kIfd[i] ^ kIcc[i];
-    } else if (i < K_LENGTH-1) {
-      data = 0x00;
-    } else {
-      data = valueType;
-    }
-    //Sha256.write(data);
-  }
-  //hash = Sha256.result();
-
-  for (byte i = 0; i < SK_LENGTH; i++) {
-    sk[i] = hash[i];
+  byte data[K_LENGTH + 4];
+  byte hash[SHA256_DIGEST_LENGTH];
+  for (byte i = 0; i < K_LENGTH; i++) {
+    data[i] = kIfd[i] ^ kIcc[i];
   }
+  data[K_LENGTH] = 0x00;
+  data[K_LENGTH + 1] = 0x00;
+  data[K_LENGTH + 2] = 0x00;
+  data[K_LENGTH + 3] = valueType;
+  cie_Sha256 sha256;
+  sha256.begin();
+  sha256.update(data, sizeof(data));
+  sha256.finish(hash);
+
+  memcpy(sk, hash, SK_LENGTH);
   *skLength = SK_LENGTH;
+  memset(data, 0, sizeof(data));
+  memset(hash, 0, sizeof(hash));
 }
 
 
@@ -988,5 +3096,7 @@ cie_PN532::~cie_PN532()
 {
   delete _atrReader;
   delete _berReader;
+  delete _rsa;
+  delete _secureMessaging;
   delete _nfc;
 }
\ No newline at end of file
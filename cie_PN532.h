@@ -15,6 +15,17 @@
 
 	@section  HISTORY
 
+	v1.11 - Peak stack and heap usage of each public operation
+	v1.10 - Telemetry frames: taps, their latency, APDU failures, cache hits and heap high-water mark
+	v1.9  - Counters and latency histograms of the APDU commands, by instruction
+	v1.8  - Public keys decoded from their RSAPublicKey into fixed size storage
+	v1.7  - PACE with the CAN and DG1/DG11 reads from the ICAO application
+	v1.6  - IAS ECC mutual authentication and secure messaging
+	v1.5  - Document signer and EF_SOD signature verification, cache of verified signers
+	v1.4  - Passive authentication: data group hashes checked against the EF_SOD
+	v1.3  - Hashed reads, streaming file contents into SHA-1 or SHA-256
+	v1.2  - Pool of challenges generated while no card is in the field
+	v1.1  - Non-blocking reads, waitForCard, bit rate negotiation and quick identification
 	v1.0  - Binary reading of unencrypted elementary files
 	
 */
@@ -28,10 +39,25 @@ class cie_BerReader;
 class cie_AtrReader;
 
 #include "cie_EFPath.h"
+#include "cie_AsyncRead.h"
+#include "cie_DataGroup.h"
+#include "cie_SodLayout.h"
+#include "cie_SignerCache.h"
+#include "cie_DesSecureMessaging.h"
+#include "cie_AesSecureMessaging.h"
+#include "cie_Ecc.h"
 #include "cie_AtrReader.h"
 #include "cie_BerReader.h"
 #include "cie_Key.h"
+#include "cie_Memory.h"
+#include "cie_Metrics.h"
+#include "cie_RecentCards.h"
+#include "cie_Rsa.h"
+#include "cie_Sha1.h"
+#include "cie_Sha256.h"
+#include "cie_Telemetry.h"
 #include "cie_Nfc_Adafruit.h"
+#include "cie_Nfc_SPI.h"
 
 // If using the breakout or shield with I2C, define just the pins connected
 // to the IRQ and reset lines.  Use the values below (2, 3) for the shield!
@@ -60,6 +86,22 @@ class cie_AtrReader;
 #define CHALLENGE_LENGTH                      (0x08)
 #define K_LENGTH                              (0x20)
 #define SK_LENGTH                             (0x10)
+//Serial numbers exchanged by the mutual authentication (the least significant bytes of the SN.ICC)
+#define SN_LENGTH                             (0x08)
+//RND.IFD || SN.IFD || RND.ICC || SN.ICC || K.IFD, and the same from the card
+#define MUTUAL_AUTHENTICATION_LENGTH          (0x40)
+//PACE (BSI TR-03110 and ICAO 9303 part 11): nonce, protocol and CAN lengths
+#define PACE_NONCE_LENGTH                     (0x10)
+#define PACE_OID_LENGTH                       (0x0A)
+#define PACE_VERSION                          (0x02)
+#define PACE_MAX_CAN_LENGTH                   (0x10)
+//Password reference of the CAN in MSE:Set AT, and the counter deriving K.PI from it (SK_ENC and SK_MAC derive the session keys)
+#define PACE_PASSWORD_CAN                     (0x02)
+#define PACE_KEY_PI                           (0x03)
+#define PACE_MAX_SCALAR_ATTEMPTS              (0x08)
+#define EF_CARD_ACCESS_MAX_LENGTH             (0x0100)
+//Challenges generated ahead of time, so that isCardValid() doesn't wait for the random number generator
+#define CHALLENGE_POOL_SIZE                   (0x04)
 
 //Elementary File length detection modes
 #define FIXED_LENGTH                          (0x00)
@@ -76,11 +118,54 @@ class cie_AtrReader;
 #define NULL_EF                               (0x00)
 #define ROOT_MF                               (0x01)
 #define CIE_DF                                (0x02)
+//The eMRTD application, reachable after PACE
+#define ICAO_DF                               (0x03)
 
 //Session keys
 #define SK_ENC                                (0x01)
 #define SK_MAC                                (0x02)
 
+//Non-blocking read steps
+#define ASYNC_STEP_IDLE                       (0x00)
+#define ASYNC_STEP_SELECT_APPLICATION         (0x01)
+#define ASYNC_STEP_SELECT_DF                  (0x02)
+#define ASYNC_STEP_SELECT_EF                  (0x03)
+#define ASYNC_STEP_DETECT_LENGTH              (0x04)
+#define ASYNC_STEP_READ                       (0x05)
+#define ASYNC_STEP_DONE                       (0x06)
+#define ASYNC_STEP_ERROR                      (0x07)
+
+//Non-blocking read poll results
+#define POLL_IN_PROGRESS                      (0x00)
+#define POLL_DONE                             (0x01)
+#define POLL_ERROR                            (0x02)
+#define POLL_IDLE                             (0x03)
+
+//Default time between two card detections, in milliseconds
+#define DEFAULT_POLL_PERIOD                   (0x96)
+
+//PN532 exchanges needed by identify() from field entry: activation, SELECT CIE DF, READ BINARY by sfi
+#define IDENTIFY_EXCHANGE_BUDGET              (0x03)
+
+//Error codes returned by getLastError()
+#define CIE_ERROR_NONE                        (0x00)
+#define CIE_ERROR_COMMAND_FAILED              (0x01)
+#define CIE_ERROR_DEADLINE_EXCEEDED           (0x02)
+
+#define NO_DEADLINE                           (0x00)
+
+//Data groups hashed in the EF_SOD and the length of the Elementary Files they protect
+#define DG_ID_SERVIZI                         (0xA1)
+#define DG_SERVIZI_INT_KPUB                   (0xA4)
+#define EF_SERVIZI_INT_KPUB_LENGTH            (0x010E)
+
+//Longest object identifier and DigestInfo (SHA-256) read from the EF_SOD
+#define OID_MAX_LENGTH                        (0x10)
+#define DIGEST_INFO_MAX_LENGTH                (0x33)
+
+//Octets read to detect the length of a BER encoded file in a single APDU
+#define BER_HEADER_LENGTH                     (0x04)
+
 class cie_PN532
 {
  public:
@@ -93,6 +178,23 @@ class cie_PN532
   //PN532 data exchange methods
   virtual void begin(void);
   virtual bool detectCard();
+  bool     waitForCard(const unsigned long timeout, const word pollPeriod);
+  bool     startAutoPoll(const word pollPeriod);
+  void     stopAutoPoll();
+  word     getBitRate();
+  void     setMaxBitRate(const word maxBitRate);
+  bool     identify(byte *contentBuffer, word *contentLength);
+  word     getApduCount();
+  const cie_InsMetrics *getMetrics(const byte insClass);
+  void     clearMetrics();
+  void     setTelemetry(cie_Telemetry *telemetry);
+  void     setMemoryProbe(const bool enabled);
+  cie_MemoryUsage getMemoryUsage();
+  void     setHoldOff(const unsigned long holdOff);
+  bool     isRepeatedTap();
+  void     setDeadline(const unsigned long timeout);
+  void     clearDeadline();
+  byte     getLastError();
 
   
   // Read binary content of unencrypted Elementary Files
@@ -103,24 +205,83 @@ class cie_PN532
   bool     read_EF_Int_Kpub(cie_Key *key);
   bool     read_EF_Servizi_Int_Kpub(cie_Key *key);
   bool     isCardValid(); //Call this to verify it's not a clone
+  unsigned long getVerificationCycles();
+  void     refillChallenges();
 
   // File access
   bool     readElementaryFile(const cie_EFPath filePath, byte *contentBuffer, word *contentLength, const byte lengthStrategy);
   bool     readBinaryContent(const cie_EFPath filePath, byte *contentBuffer, word offset, const word contentLength);
   bool     readKey(const cie_EFPath filePath, cie_Key *key);
+  void     setReadHash(cie_Hash *hash);
+  bool     hashElementaryFile(const cie_EFPath filePath, cie_Hash *hash, byte *digest, word *contentLength, const byte lengthStrategy);
+
+  // Non-blocking file access, advancing one APDU per call to poll()
+  bool     startRead(const cie_EFPath filePath, byte *contentBuffer, word *contentLength, const byte lengthStrategy);
+  bool     startRead_EF_ID_Servizi(byte *contentBuffer, word *contentLength);
+  bool     startRead_EF_SN_ICC(byte *contentBuffer, word *contentLength);
+  byte     poll();
+  word     readProgress();
+  void     cancelRead();
 
   // Utility
   void     printHex(byte *buffer, const word length);
   bool     print_EF_SOD(word *contentLength);
   bool     parse_EF_SOD(cieBerTripleCallbackFunc callback);
+  bool     verify_EF_SOD();
+  bool     verify_EF_SOD(const cie_DataGroup *dataGroups, const byte dataGroupCount);
+  bool     verify_EF_SOD_Signature();
+  void     setTrustAnchor(cie_Key *trustAnchor);
+  word     getSignerCacheHits();
+
+  // Secure messaging
+  void     setDeviceKeys(const byte *encKey, const byte *macKey, const byte *serialNumber);
+  bool     establishSecureMessaging();
+  bool     isSecureMessagingActive();
+
+  // PACE and the ICAO application
+  bool     establishPace(const byte *can, const byte canLength);
+  bool     read_DG1(byte *contentBuffer, word *contentLength);
+  bool     read_DG11(byte *contentBuffer, word *contentLength);
 
  private:
   //fields
   cie_Nfc *_nfc;
   cie_BerReader *_berReader;
   cie_AtrReader *_atrReader;
+  cie_Rsa *_rsa;
+  cie_Hash *_readHash;
   byte _currentDedicatedFile;
   unsigned long _currentElementaryFile;
+  word _bitRate;
+  word _maxBitRate;
+  word _apduCount;
+#if CIE_METRICS
+  cie_Metrics _metrics;
+#endif
+  cie_RecentCards _recentCards;
+  bool _repeatedTap;
+  cie_Telemetry *_telemetry;
+  cie_MemoryProbe _memoryProbe;
+  bool _tapOpen;
+  unsigned long _tapStartedAt;
+  unsigned long _tapEndedAt;
+  unsigned long _deadlineStart;
+  unsigned long _deadline;
+  byte _lastError;
+  word _contentRead;
+  unsigned long _verificationCycles;
+  byte _challenges[CHALLENGE_POOL_SIZE][CHALLENGE_LENGTH];
+  byte _challengeCount;
+  cie_AsyncRead _asyncRead;
+  cie_SodCheck _sodCheck;
+  cie_SodLayout _sodLayout;
+  cie_Key *_trustAnchor;
+  cie_SignerCache _signerCache;
+  cie_SecureMessaging *_secureMessaging;
+  const byte *_deviceEncKey;
+  const byte *_deviceMacKey;
+  const byte *_deviceSerialNumber;
+  static cie_PN532 *_sodChecker;
 
   //PN532 data exchange methods
   virtual bool sendCommand(byte *command, const byte commandLength, byte *response, word *responseLength);
@@ -128,6 +289,10 @@ class cie_PN532
 
   //methods
   void initFields();
+  void takeChallenge(byte *challenge);
+  void startTap();
+  void endTap();
+  bool setRsaModulus(cie_Key *key);
   bool sendCommand(byte *command, const word commandLength);
   bool select_SDO_Servizi_Int_Kpriv();
   bool ensureSelected(const cie_EFPath filePath);
@@ -137,17 +302,45 @@ class cie_PN532
   bool selectIasApplication(void);
   bool selectRootMasterFile(void);
   bool selectCieDedicatedFile(void);
+  bool selectIcaoApplication(void);
   bool determineLength(const cie_EFPath filePath, word *contentLength, const byte lengthStrategy);
+  bool readBinaryPage(const byte fileId, byte *contentBuffer, const word offset, const word contentPageLength);
+  bool readIcaoBinaryPage(const byte fileId, byte *contentBuffer, const word offset, const word contentPageLength);
+  byte getPageLength();
+  bool decodeBerLength(const byte *header, const byte headerLength, word *contentLength);
+  byte nextAsyncStep();
+  bool performAsyncStep(const byte step);
+  bool isRestingCard();
+  bool checkSodTriple(cie_BerTriple *triple);
+  static bool onSodTriple(cie_BerTriple *triple);
+  bool locateSodTriple(cie_BerTriple *triple);
+  bool locateCertificateTriple(cie_BerTriple *triple, const byte depth, const byte *oid);
+  bool locateSignerInfoTriple(cie_BerTriple *triple, const byte depth, const byte *oid);
+  static bool onSodLayoutTriple(cie_BerTriple *triple);
+  bool verifyDocumentSigner(const cie_EFPath filePath, cie_Key *signer);
+  bool verifySignedRange(const cie_EFPath filePath, cie_Key *key, const byte hashAlgorithm, const cie_SodRange range, const byte tag, const cie_SodRange signatureRange);
+  bool hashRange(const cie_EFPath filePath, cie_Hash *hash, const word offset, word *length);
+  static byte hashAlgorithmOf(const byte *oid, const word oidLength);
+  static cie_Hash *createHash(const byte hashAlgorithm);
+  static byte writeDigestInfo(const byte hashAlgorithm, const byte *digest, byte *digestInfo);
+  bool isDeadlineExceeded();
+  byte getStableUid(byte *uidBuffer);
   bool hasSuccessStatusWord(byte *response, const word responseLength);
   word clamp(const word value, const byte maxValue);
   
   //authentication related methods
-  bool establishSecureMessaging();
+  bool sendProtectedCommand(const byte *command, const byte commandLength, byte *responseBuffer, word *responseLength);
   bool getChallenge(byte *contentBuffer, word *contentLength);
   bool mutualAuthenticate(byte *snIccBuffer, const byte snIccBufferLength, byte *rndIccBuffer, const byte rndIccBufferLength);
   bool internalAuthenticate(byte *responseBuffer, word *responseLength, byte *challenge, const byte challengeLength);
   bool verifyInternalAuthenticateResponse(cie_Key *pubKey, byte *cypher, const word cypherLength, const byte *message, const word messageLength);
   void calculateSk(const byte valueType, byte *kIfd, byte *kIcc, byte *sk, byte *skLength);
+  bool readCardAccess(byte *contentBuffer, word *contentLength);
+  bool findPaceParameters(const byte *cardAccess, const word cardAccessLength, byte *parameterId);
+  bool generalAuthenticate(const byte commandTag, const byte *data, const byte dataLength, const byte responseTag, byte *response, const byte responseLength);
+  bool generateKeyPair(cie_Ecc *ecc, byte *privateKey, byte *publicKey);
+  static void calculatePaceKey(const byte counter, const byte *secret, const byte secretLength, byte *key);
+  void calculateAuthenticationToken(cie_AesSecureMessaging *session, const byte *publicKey, byte *token);
 };
 
 
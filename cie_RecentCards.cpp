@@ -0,0 +1,114 @@
+/**************************************************************************/
+/*!
+    @file     cie_RecentCards.cpp
+    @author   Developers Italia
+    @license  BSD (see License)
+
+	Implementation of the cie_RecentCards class: cards are identified by their UID, SN_ICC or ID_Servizi
+	and forgotten once they have not been seen for the hold-off time
+
+	@section  HISTORY
+
+	v1.0  - First implementation of the class
+*/
+/**************************************************************************/
+#include "cie_RecentCards.h"
+
+/**************************************************************************/
+/*!
+  @brief Creates an empty table, with duplicate tap suppression disabled
+*/
+/**************************************************************************/
+cie_RecentCards::cie_RecentCards() :
+_holdOff(NO_HOLD_OFF),
+_last(0)
+{
+  clear();
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Sets how long a card is remembered after it was last seen
+
+  @param holdOff The hold-off time in milliseconds, or NO_HOLD_OFF to disable duplicate tap suppression
+*/
+/**************************************************************************/
+void cie_RecentCards::setHoldOff(const unsigned long holdOff) {
+  _holdOff = holdOff;
+  clear();
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Gets how long a card is remembered after it was last seen
+
+  @returns The hold-off time in milliseconds
+*/
+/**************************************************************************/
+unsigned long cie_RecentCards::getHoldOff() {
+  return _holdOff;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Checks whether a card was seen within the hold-off time and records it as seen now
+
+  @param id The pointer to the card identifier (UID, SN_ICC or ID_Servizi)
+  @param idLength The length of the identifier, longer identifiers are truncated
+
+  @returns A boolean value indicating whether this is a duplicate tap or not
+*/
+/**************************************************************************/
+bool cie_RecentCards::seen(const byte *id, const byte idLength) {
+  unsigned long now = millis();
+  byte length = idLength > RECENT_CARD_ID_LENGTH ? RECENT_CARD_ID_LENGTH : idLength;
+  byte oldest = 0;
+  for (byte i = 0; i < RECENT_CARDS_CAPACITY; i++) {
+    cie_RecentCard *card = &_cards[i];
+    bool expired = card->idLength == 0 || now - card->seenAt >= _holdOff;
+    if (!expired && card->idLength == length && memcmp(card->id, id, length) == 0) {
+      card->seenAt = now;
+      _last = i;
+      return true;
+    }
+    //Expired entries are the first to be replaced, then the least recently seen
+    if (expired) {
+      card->idLength = 0;
+    }
+    if (_cards[oldest].idLength != 0 && (card->idLength == 0 || now - card->seenAt > now - _cards[oldest].seenAt)) {
+      oldest = i;
+    }
+  }
+  memcpy(_cards[oldest].id, id, length);
+  _cards[oldest].idLength = length;
+  _cards[oldest].seenAt = now;
+  _last = oldest;
+  return false;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Records the last seen card as seen now, e.g. when it's still resting on the reader
+*/
+/**************************************************************************/
+void cie_RecentCards::touchLast() {
+  if (_cards[_last].idLength > 0) {
+    _cards[_last].seenAt = millis();
+  }
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Forgets all cards
+*/
+/**************************************************************************/
+void cie_RecentCards::clear() {
+  for (byte i = 0; i < RECENT_CARDS_CAPACITY; i++) {
+    _cards[i].idLength = 0;
+  }
+}
@@ -0,0 +1,45 @@
+/**************************************************************************/
+/*!
+    @file     cie_RecentCards.h
+    @author   Developers Italia
+	@license  BSD (see License)
+
+	Definition of the cie_RecentCards class, a small table of the cards seen lately used to suppress duplicate taps
+
+	@section  HISTORY
+
+	v1.0  - First definition of the class
+
+*/
+/**************************************************************************/
+#ifndef CIE_RECENT_CARDS
+#define CIE_RECENT_CARDS
+#include <Arduino.h>
+
+#define RECENT_CARDS_CAPACITY                 (0x04)
+//Long enough for a 10 bytes UID and for the 12 bytes SN_ICC or ID_Servizi
+#define RECENT_CARD_ID_LENGTH                 (0x0C)
+#define NO_HOLD_OFF                           (0x00)
+
+struct cie_RecentCard {
+    byte id[RECENT_CARD_ID_LENGTH];
+    byte idLength;
+    unsigned long seenAt;
+};
+
+class cie_RecentCards {
+  public:
+    cie_RecentCards();
+    void setHoldOff(const unsigned long holdOff);
+    unsigned long getHoldOff();
+    bool seen(const byte *id, const byte idLength);
+    void touchLast();
+    void clear();
+
+  private:
+    cie_RecentCard _cards[RECENT_CARDS_CAPACITY];
+    unsigned long _holdOff;
+    byte _last;
+};
+
+#endif
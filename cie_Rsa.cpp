@@ -0,0 +1,472 @@
+/**************************************************************************/
+/*!
+    @file     cie_Rsa.cpp
+    @author   Developers Italia
+    @license  BSD (see License)
+
+	Implementation of the cie_Rsa class. Multiplications use the Coarsely Integrated Operand Scanning (CIOS) method
+	described in "Analyzing and Comparing Montgomery Multiplication Algorithms" by Koç, Acar and Kaliski
+
+	@section  HISTORY
+
+	v1.3  - The work area of public key operations is allocated once, cached moduli are compared in place
+	v1.2  - SHA-1 fingerprint of the modulus
+	v1.1  - Cache of precomputed contexts
+	v1.0  - Public key operation and verification of PKCS#1 v1.5 type 1 signatures
+*/
+/**************************************************************************/
+#include "cie_Rsa.h"
+#include "cie_Cycles.h"
+#include "cie_Sha1.h"
+
+#define PN532DEBUGPRINT Serial
+
+/**************************************************************************/
+/*!
+  @brief Creates an instance with an empty cache, call setModulus() before using it
+*/
+/**************************************************************************/
+cie_Rsa::cie_Rsa() :
+_context(NULL),
+_scratch(NULL),
+_uses(0),
+_cycles(0),
+_cacheHits(0)
+{
+  for (byte i = 0; i < RSA_CONTEXT_CACHE_SIZE; i++) {
+    _contexts[i] = NULL;
+  }
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Releases the cached contexts and the work area
+*/
+/**************************************************************************/
+cie_Rsa::~cie_Rsa() {
+  for (byte i = 0; i < RSA_CONTEXT_CACHE_SIZE; i++) {
+    delete _contexts[i];
+  }
+  delete [] _scratch;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Computes the fingerprint of a modulus, leading zeroes excluded, to look it up in the cache:
+         the first four bytes of its SHA-1 digest
+
+  @param modulus The pointer to the big endian modulus
+  @param modulusLength The length of the modulus
+
+  @returns The fingerprint of the modulus
+*/
+/**************************************************************************/
+unsigned long cie_Rsa::fingerprint(const byte *modulus, const word modulusLength) {
+  word offset = 0;
+  while (offset < modulusLength && modulus[offset] == 0x00) {
+    offset++;
+  }
+  byte digest[SHA1_DIGEST_LENGTH];
+  cie_Sha1 sha1;
+  sha1.begin();
+  sha1.update(modulus + offset, modulusLength - offset);
+  sha1.finish(digest);
+  return (unsigned long) digest[0] << 24 | (unsigned long) digest[1] << 16 | (unsigned long) digest[2] << 8 | digest[3];
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Sets the modulus of the public key. The precomputed context of a modulus seen lately is taken from the cache,
+         otherwise it's computed and replaces the least recently used one
+
+  @param modulus The pointer to the big endian modulus, leading zeroes are skipped
+  @param modulusLength The length of the modulus
+  @param fingerprint The fingerprint of the modulus, see fingerprint() and cie_Key::getFingerprint()
+
+  @returns A boolean value indicating whether the modulus is valid (odd and up to RSA_MAX_MODULUS_LENGTH bytes long) or not
+*/
+/**************************************************************************/
+bool cie_Rsa::setModulus(const byte *modulus, const word modulusLength, const unsigned long fingerprint) {
+  unsigned long startedAt = cie_cycles();
+  _context = NULL;
+  word offset = 0;
+  while (offset < modulusLength && modulus[offset] == 0x00) {
+    offset++;
+  }
+  word length = modulusLength - offset;
+  if (length == 0 || length > RSA_MAX_MODULUS_LENGTH || (modulus[modulusLength - 1] & 0x01) == 0) {
+    PN532DEBUGPRINT.println(F("The modulus must be odd and up to 2048 bits long"));
+    return false;
+  }
+
+  byte slot = 0;
+  for (byte i = 0; i < RSA_CONTEXT_CACHE_SIZE; i++) {
+    cie_RsaContext *context = _contexts[i];
+    if (context == NULL) {
+      slot = i;
+      break;
+    }
+    if (context->fingerprint == fingerprint && context->modulusLength == length) {
+      //A matching fingerprint is not a proof, the modulus must be the same too
+      if (hasModulus(context, modulus + offset, length)) {
+        _context = context;
+        context->lastUsed = ++_uses;
+        _cacheHits++;
+        _cycles = cie_cycles() - startedAt;
+        return true;
+      }
+    }
+    if (_contexts[slot] != NULL && context->lastUsed < _contexts[slot]->lastUsed) {
+      slot = i;
+    }
+  }
+
+  if (_contexts[slot] == NULL) {
+    _contexts[slot] = new cie_RsaContext();
+  }
+  _context = _contexts[slot];
+  _context->fingerprint = fingerprint;
+  _context->lastUsed = ++_uses;
+  precompute(_context, modulus + offset, length);
+  _cycles = cie_cycles() - startedAt;
+  return true;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Gets the length of the modulus without leading zeroes, which is the length of signatures
+
+  @returns The length of the modulus in bytes
+*/
+/**************************************************************************/
+word cie_Rsa::getModulusLength() {
+  return _context == NULL ? 0 : _context->modulusLength;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Computes input^exponent mod modulus
+
+  @param input The pointer to the big endian input, which must be less than the modulus
+  @param inputLength The length of the input, up to the modulus length
+  @param exponent The pointer to the big endian public exponent, e.g. { 0x01, 0x00, 0x01 }
+  @param exponentLength The length of the exponent
+  @param output The pointer to a buffer of getModulusLength() bytes, which will contain the big endian result
+
+  @returns A boolean value indicating whether the operation succeeded or not
+*/
+/**************************************************************************/
+bool cie_Rsa::publicOperation(const byte *input, const word inputLength, const byte *exponent, const byte exponentLength, byte *output) {
+  unsigned long startedAt = cie_cycles();
+  if (_context == NULL || inputLength > _context->limbs * sizeof(cie_Limb)) {
+    return false;
+  }
+  //Allocated on the first operation and kept, as large as the largest modulus needs
+  if (_scratch == NULL) {
+    _scratch = new cie_Limb[RSA_SCRATCH_LIMBS];
+  }
+  word limbs = _context->limbs;
+  cie_Limb *x = _scratch;
+  cie_Limb *accumulator = _scratch + limbs;
+  cie_Limb *t = _scratch + 2 * limbs;
+  fromBytes(x, input, inputLength);
+  bool success = isLessThanModulus(x);
+  if (success) {
+    //Left to right square and multiply, in the Montgomery domain: x * R = MontgomeryMultiply(x, R^2)
+    montgomeryMultiply(x, x, _context->rSquared, t);
+    memcpy(accumulator, x, limbs * sizeof(cie_Limb));
+    bool started = false;
+    for (byte i = 0; i < exponentLength; i++) {
+      for (char bit = 7; bit >= 0; bit--) {
+        if (started) {
+          montgomeryMultiply(accumulator, accumulator, accumulator, t);
+          if ((exponent[i] >> bit) & 0x01) {
+            montgomeryMultiply(accumulator, accumulator, x, t);
+          }
+        } else {
+          //The accumulator already holds x for the most significant bit set
+          started = (exponent[i] >> bit) & 0x01;
+        }
+      }
+    }
+    //Multiplying by 1 leaves the Montgomery domain
+    memset(x, 0, limbs * sizeof(cie_Limb));
+    x[0] = 1;
+    montgomeryMultiply(accumulator, accumulator, x, t);
+    toBytes(output, accumulator);
+    success = started;
+  }
+  _cycles += cie_cycles() - startedAt;
+  return success;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Verifies a signature with PKCS#1 v1.5 type 1 padding over a raw message (no DigestInfo), 
+         as returned by the INTERNAL AUTHENTICATE command: 0x00 0x01 0xFF ... 0xFF 0x00 message
+
+  @param signature The pointer to the signature
+  @param signatureLength The length of the signature, which must be the length of the modulus
+  @param exponent The pointer to the big endian public exponent
+  @param exponentLength The length of the exponent
+  @param message The pointer to the message expected in the signature
+  @param messageLength The length of the message
+
+  @returns A boolean value indicating whether the signature is valid or not
+*/
+/**************************************************************************/
+bool cie_Rsa::verify(const byte *signature, const word signatureLength, const byte *exponent, const byte exponentLength, const byte *message, const word messageLength) {
+  word modulusLength = getModulusLength();
+  if (signatureLength != modulusLength || messageLength + RSA_MIN_PADDING_LENGTH > modulusLength) {
+    PN532DEBUGPRINT.println(F("The signature must be as long as the modulus"));
+    return false;
+  }
+  byte *decrypted = new byte[modulusLength];
+  bool success = publicOperation(signature, signatureLength, exponent, exponentLength, decrypted);
+  word paddingEnd = modulusLength - messageLength - 1;
+  //Every byte is checked, to take the same time whatever the mismatch
+  byte mismatch = success ? 0x00 : 0x01;
+  mismatch |= decrypted[0] ^ 0x00;
+  mismatch |= decrypted[1] ^ 0x01;
+  for (word i = 2; i < paddingEnd; i++) {
+    mismatch |= decrypted[i] ^ 0xFF;
+  }
+  mismatch |= decrypted[paddingEnd] ^ 0x00;
+  for (word i = 0; i < messageLength; i++) {
+    mismatch |= decrypted[paddingEnd + 1 + i] ^ message[i];
+  }
+  delete [] decrypted;
+  return mismatch == 0x00;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Gets the CPU cycles taken by the last setModulus() (including the precomputation on cache misses)
+         and the public key operations that followed
+
+  @returns The number of cycles (see cie_Cycles.h for how they're measured on each board)
+*/
+/**************************************************************************/
+unsigned long cie_Rsa::getCycles() {
+  return _cycles;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Counts the calls to setModulus() which found the precomputed context in the cache
+
+  @returns The number of cache hits
+*/
+/**************************************************************************/
+word cie_Rsa::getCacheHits() {
+  return _cacheHits;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Precomputes -modulus^-1 mod 2^RSA_LIMB_BITS and R^2 mod modulus, with R = 2^(RSA_LIMB_BITS * limbs)
+
+  @param context The pointer to the context to fill in
+  @param modulus The pointer to the big endian modulus, without leading zeroes
+  @param modulusLength The length of the modulus
+
+  @returns A boolean value indicating whether the operation succeeded or not
+*/
+/**************************************************************************/
+bool cie_Rsa::precompute(cie_RsaContext *context, const byte *modulus, const word modulusLength) {
+  context->modulusLength = modulusLength;
+  context->limbs = (modulusLength + sizeof(cie_Limb) - 1) / sizeof(cie_Limb);
+  fromBytes(context->modulus, modulus, modulusLength);
+
+  //Newton iteration: each step doubles the number of correct low bits of the inverse, starting from 1 bit
+  cie_Limb inverse = 1;
+  for (byte bits = 1; bits < RSA_LIMB_BITS; bits *= 2) {
+    inverse = (cie_Limb) (inverse * (cie_Limb) (2 - (cie_Limb) (context->modulus[0] * inverse)));
+  }
+  context->inverse = (cie_Limb) (0 - inverse);
+
+  //R^2 mod modulus by doubling the highest power of two less than the modulus
+  cie_Limb *rSquared = context->rSquared;
+  word bits = context->limbs * RSA_LIMB_BITS;
+  word highestBit = (modulusLength - 1) * 8;
+  for (byte top = modulus[0]; top > 1; top >>= 1) {
+    highestBit++;
+  }
+  memset(rSquared, 0, context->limbs * sizeof(cie_Limb));
+  rSquared[highestBit / RSA_LIMB_BITS] = ((cie_Limb) 1) << (highestBit % RSA_LIMB_BITS);
+  for (word bit = highestBit; bit < 2 * bits; bit++) {
+    doubleModulo(rSquared);
+  }
+  return true;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Computes a * b * R^-1 mod modulus with R = 2^(RSA_LIMB_BITS * limbs)
+
+  @param result The pointer to the result, which can be the same as a or b
+  @param a The pointer to the first factor
+  @param b The pointer to the second factor
+  @param t The pointer to a scratch buffer of limbs + 2 limbs
+*/
+/**************************************************************************/
+void cie_Rsa::montgomeryMultiply(cie_Limb *result, const cie_Limb *a, const cie_Limb *b, cie_Limb *t) {
+  word s = _context->limbs;
+  const cie_Limb *modulus = _context->modulus;
+  cie_Limb inverse = _context->inverse;
+  memset(t, 0, (s + 2) * sizeof(cie_Limb));
+  for (word i = 0; i < s; i++) {
+    //t += a * b[i]
+    cie_DoubleLimb carry = 0;
+    for (word j = 0; j < s; j++) {
+      carry += (cie_DoubleLimb) a[j] * b[i] + t[j];
+      t[j] = (cie_Limb) carry;
+      carry >>= RSA_LIMB_BITS;
+    }
+    carry += t[s];
+    t[s] = (cie_Limb) carry;
+    t[s + 1] = (cie_Limb) (carry >> RSA_LIMB_BITS);
+
+    //t = (t + m * modulus) / 2^RSA_LIMB_BITS, with m chosen so that the lowest limb becomes zero
+    cie_Limb m = (cie_Limb) (t[0] * inverse);
+    carry = (cie_DoubleLimb) m * modulus[0] + t[0];
+    carry >>= RSA_LIMB_BITS;
+    for (word j = 1; j < s; j++) {
+      carry += (cie_DoubleLimb) m * modulus[j] + t[j];
+      t[j - 1] = (cie_Limb) carry;
+      carry >>= RSA_LIMB_BITS;
+    }
+    carry += t[s];
+    t[s - 1] = (cie_Limb) carry;
+    t[s] = (cie_Limb) (t[s + 1] + (cie_Limb) (carry >> RSA_LIMB_BITS));
+  }
+  memcpy(result, t, s * sizeof(cie_Limb));
+  if (t[s] != 0 || !isLessThanModulus(result)) {
+    subtractModulus(result);
+  }
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Doubles a number less than the modulus, modulo the modulus
+
+  @param x The pointer to the number
+*/
+/**************************************************************************/
+void cie_Rsa::doubleModulo(cie_Limb *x) {
+  cie_Limb carry = 0;
+  for (word j = 0; j < _context->limbs; j++) {
+    cie_Limb next = x[j] >> (RSA_LIMB_BITS - 1);
+    x[j] = (cie_Limb) (x[j] << 1) | carry;
+    carry = next;
+  }
+  if (carry != 0 || !isLessThanModulus(x)) {
+    subtractModulus(x);
+  }
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Compares a number with the modulus
+
+  @param x The pointer to the number
+
+  @returns A boolean value indicating whether the number is less than the modulus or not
+*/
+/**************************************************************************/
+bool cie_Rsa::isLessThanModulus(const cie_Limb *x) {
+  const cie_Limb *modulus = _context->modulus;
+  for (word j = _context->limbs; j > 0; j--) {
+    if (x[j - 1] != modulus[j - 1]) {
+      return x[j - 1] < modulus[j - 1];
+    }
+  }
+  return false;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Subtracts the modulus from a number, modulo R
+
+  @param x The pointer to the number
+*/
+/**************************************************************************/
+void cie_Rsa::subtractModulus(cie_Limb *x) {
+  const cie_Limb *modulus = _context->modulus;
+  cie_Limb borrow = 0;
+  for (word j = 0; j < _context->limbs; j++) {
+    cie_Limb difference = (cie_Limb) (x[j] - modulus[j] - borrow);
+    borrow = (x[j] < modulus[j] || (x[j] == modulus[j] && borrow)) ? 1 : 0;
+    x[j] = difference;
+  }
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Converts a big endian number to little endian limbs, padding with zeroes
+
+  @param x The pointer to the limbs
+  @param bytes The pointer to the big endian number
+  @param length The length of the number, up to limbs * sizeof(cie_Limb)
+*/
+/**************************************************************************/
+void cie_Rsa::fromBytes(cie_Limb *x, const byte *bytes, const word length) {
+  memset(x, 0, _context->limbs * sizeof(cie_Limb));
+  for (word i = 0; i < length; i++) {
+    word position = length - 1 - i;
+    x[position / sizeof(cie_Limb)] |= ((cie_Limb) bytes[i]) << (8 * (position % sizeof(cie_Limb)));
+  }
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Compares the modulus of a context with a big endian modulus of the same length, limb by limb
+
+  @param context The pointer to the context
+  @param modulus The pointer to the big endian modulus, without leading zeroes
+  @param modulusLength The length of the modulus, which must be the one of the context
+
+  @returns A boolean value indicating whether the moduli are the same or not
+*/
+/**************************************************************************/
+bool cie_Rsa::hasModulus(const cie_RsaContext *context, const byte *modulus, const word modulusLength) {
+  for (word i = 0; i < modulusLength; i++) {
+    word position = modulusLength - 1 - i;
+    if ((byte) (context->modulus[position / sizeof(cie_Limb)] >> (8 * (position % sizeof(cie_Limb)))) != modulus[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Converts little endian limbs to a big endian number as long as the modulus
+
+  @param bytes The pointer to a buffer of getModulusLength() bytes
+  @param x The pointer to the limbs
+*/
+/**************************************************************************/
+void cie_Rsa::toBytes(byte *bytes, const cie_Limb *x) {
+  word modulusLength = _context->modulusLength;
+  for (word i = 0; i < modulusLength; i++) {
+    word position = modulusLength - 1 - i;
+    bytes[i] = (byte) (x[position / sizeof(cie_Limb)] >> (8 * (position % sizeof(cie_Limb))));
+  }
+}
@@ -0,0 +1,100 @@
+/**************************************************************************/
+/*!
+    @file     cie_Rsa.h
+    @author   Developers Italia
+	@license  BSD (see License)
+
+	Definition of the cie_Rsa class performing RSA public key operations with Montgomery multiplication.
+	Limbs are as wide as the CPU registers: 8 bits on AVR, 64 bits on hosts supporting 128 bits products
+	and 32 bits elsewhere (ARM, ESP32 and the like). Define CIE_RSA_LIMB_BITS (8, 32 or 64) to force a width,
+	e.g. to test the AVR kernel on a host
+
+	@section  HISTORY
+
+	v1.2  - No allocation per public key operation
+	v1.1  - Cache of precomputed Montgomery contexts, keyed by modulus fingerprint
+	v1.0  - Public key operation and verification of PKCS#1 v1.5 type 1 signatures
+
+*/
+/**************************************************************************/
+#ifndef CIE_RSA
+#define CIE_RSA
+#include <Arduino.h>
+
+#if !defined(CIE_RSA_LIMB_BITS)
+  #if defined(__AVR__)
+    #define CIE_RSA_LIMB_BITS                 (8)
+  #elif defined(__SIZEOF_INT128__)
+    #define CIE_RSA_LIMB_BITS                 (64)
+  #else
+    #define CIE_RSA_LIMB_BITS                 (32)
+  #endif
+#endif
+
+#if CIE_RSA_LIMB_BITS == 8
+  typedef uint8_t cie_Limb;
+  typedef uint16_t cie_DoubleLimb;
+#elif CIE_RSA_LIMB_BITS == 64
+  typedef uint64_t cie_Limb;
+  typedef unsigned __int128 cie_DoubleLimb;
+#else
+  typedef uint32_t cie_Limb;
+  typedef uint64_t cie_DoubleLimb;
+#endif
+
+#define RSA_LIMB_BITS                         (sizeof(cie_Limb) * 8)
+#define RSA_MAX_MODULUS_LENGTH                (0x0100)
+#define RSA_MAX_LIMBS                         (RSA_MAX_MODULUS_LENGTH / sizeof(cie_Limb))
+//Each context takes two moduli worth of RAM
+#if CIE_RSA_LIMB_BITS == 8
+  #define RSA_CONTEXT_CACHE_SIZE              (0x01)
+#else
+  #define RSA_CONTEXT_CACHE_SIZE              (0x04)
+#endif
+//Work area of a public key operation: the base, the accumulator and the product of a Montgomery multiplication
+#define RSA_SCRATCH_LIMBS                     (3 * RSA_MAX_LIMBS + 2)
+//PKCS#1 v1.5 type 1 padding: 0x00 0x01, at least 8 0xFF octets, 0x00
+#define RSA_MIN_PADDING_LENGTH                (0x0B)
+
+//Per-modulus precomputation: -modulus^-1 mod 2^RSA_LIMB_BITS and R^2 mod modulus
+struct cie_RsaContext {
+    unsigned long fingerprint;
+    unsigned long lastUsed;
+    word modulusLength;
+    word limbs;
+    cie_Limb inverse;
+    cie_Limb modulus[RSA_MAX_LIMBS];
+    cie_Limb rSquared[RSA_MAX_LIMBS];
+};
+
+class cie_Rsa {
+  public:
+    cie_Rsa();
+    ~cie_Rsa();
+    static unsigned long fingerprint(const byte *modulus, const word modulusLength);
+    bool setModulus(const byte *modulus, const word modulusLength, const unsigned long fingerprint);
+    word getModulusLength();
+    bool publicOperation(const byte *input, const word inputLength, const byte *exponent, const byte exponentLength, byte *output);
+    bool verify(const byte *signature, const word signatureLength, const byte *exponent, const byte exponentLength, const byte *message, const word messageLength);
+    unsigned long getCycles();
+    word getCacheHits();
+
+  private:
+    bool precompute(cie_RsaContext *context, const byte *modulus, const word modulusLength);
+    bool hasModulus(const cie_RsaContext *context, const byte *modulus, const word modulusLength);
+    void montgomeryMultiply(cie_Limb *result, const cie_Limb *a, const cie_Limb *b, cie_Limb *t);
+    void doubleModulo(cie_Limb *x);
+    bool isLessThanModulus(const cie_Limb *x);
+    void subtractModulus(cie_Limb *x);
+    void fromBytes(cie_Limb *x, const byte *bytes, const word length);
+    void toBytes(byte *bytes, const cie_Limb *x);
+
+    cie_RsaContext *_contexts[RSA_CONTEXT_CACHE_SIZE];
+    cie_RsaContext *_context;
+    cie_Limb *_scratch;
+    unsigned long _uses;
+    unsigned long _cycles;
+    word _cacheHits;
+};
+
+#endif
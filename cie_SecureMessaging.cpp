@@ -0,0 +1,464 @@
+/**************************************************************************/
+/*!
+    @file     cie_SecureMessaging.cpp
+    @author   Developers Italia
+    @license  BSD (see License)
+
+	Implementation of the cie_SecureMessaging class, common to all the ciphers
+	See 7.1 Secure messaging in http://www.unsads.com/specs/IASECC/IAS_ECC_v1.0.1_UK.pdf
+
+	@section  HISTORY
+
+	v1.2  - Unprotected status words are accepted only for errors
+	v1.1  - Block length, initialization vector and MAC left to subclasses
+	v1.0  - First implementation of the class
+*/
+/**************************************************************************/
+#include "cie_SecureMessaging.h"
+#define PN532DEBUGPRINT Serial
+
+/**************************************************************************/
+/*!
+  @brief Creates an inactive session
+*/
+/**************************************************************************/
+cie_SecureMessaging::cie_SecureMessaging() :
+_macBlockLength(0),
+_active(false)
+{
+  memset(_ssc, 0, SM_MAX_BLOCK_LENGTH);
+  memset(_macState, 0, SM_MAX_BLOCK_LENGTH);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Starts the session: from now on commands are wrapped and responses unwrapped
+
+  @param encKey The pointer to the SM_KEY_LENGTH bytes SK.ENC
+  @param macKey The pointer to the SM_KEY_LENGTH bytes SK.MAC
+  @param ssc The pointer to the initial send sequence counter, as long as a block
+*/
+/**************************************************************************/
+void cie_SecureMessaging::begin(const byte *encKey, const byte *macKey, const byte *ssc) {
+  setKeys(encKey, macKey);
+  memcpy(_ssc, ssc, getBlockLength());
+  _active = true;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Ends the session and wipes the keys
+*/
+/**************************************************************************/
+void cie_SecureMessaging::end() {
+  _active = false;
+  clearKeys();
+  memset(_ssc, 0, SM_MAX_BLOCK_LENGTH);
+  memset(_macState, 0, SM_MAX_BLOCK_LENGTH);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Tells whether the session is active
+
+  @returns A boolean value indicating whether APDUs are being protected
+*/
+/**************************************************************************/
+bool cie_SecureMessaging::isActive() {
+  return _active;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Gets the frame buffer where APDUs are wrapped and unwrapped
+
+  @returns The pointer to the SM_BUFFER_LENGTH bytes buffer
+*/
+/**************************************************************************/
+byte *cie_SecureMessaging::getBuffer() {
+  return _buffer;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Protects the command APDU found at the start of the buffer, in place: the data field
+         becomes a cryptogram and a MAC over the header and the data objects is appended
+
+  @param commandLength The length of the plain command (a short APDU)
+
+  @returns The length of the protected command or 0 if it can't be protected
+*/
+/**************************************************************************/
+word cie_SecureMessaging::wrapCommand(const word commandLength) {
+  if (!_active || commandLength < 4) {
+    return 0;
+  }
+  word dataLength = 0;
+  bool hasLe = commandLength == 5;
+  byte le = hasLe ? _buffer[4] : 0x00;
+  if (commandLength > 5) {
+    dataLength = _buffer[4];
+    hasLe = commandLength == 6 + dataLength;
+    if (!hasLe && commandLength != 5 + dataLength) {
+      PN532DEBUGPRINT.println(F("The command to protect is not a valid short APDU"));
+      return 0;
+    }
+    le = hasLe ? _buffer[5 + dataLength] : 0x00;
+  }
+  //Odd instructions carry BER-TLV data, which needs no padding indicator
+  bool odd = (_buffer[1] & 0x01) == 0x01;
+  byte blockLength = getBlockLength();
+  word cryptogramLength = dataLength > 0 ? (dataLength / blockLength + 1) * blockLength : 0;
+  word valueLength = cryptogramLength + (odd ? 0 : 1);
+  byte lengthOctets = valueLength < 0x80 ? 1 : (valueLength < 0x100 ? 2 : 3);
+  word protectedLength = 5 + (dataLength > 0 ? 1 + lengthOctets + valueLength : 0) + (hasLe ? 3 : 0) + 2 + SM_MAC_LENGTH + 1;
+  if (protectedLength > SM_MAX_COMMAND_LENGTH) {
+    PN532DEBUGPRINT.println(F("The protected command doesn't fit in a short APDU"));
+    return 0;
+  }
+
+  //The counter also gives the initialization vector of the cryptogram
+  incrementSsc();
+  word offset = 5;
+  if (dataLength > 0) {
+    //Move the data where the cryptogram goes, then encrypt it there
+    word cryptogramOffset = offset + 1 + lengthOctets + (odd ? 0 : 1);
+    memmove(_buffer + cryptogramOffset, _buffer + offset, dataLength);
+    pad(_buffer + cryptogramOffset, dataLength);
+    encrypt(_buffer + cryptogramOffset, cryptogramLength);
+    _buffer[offset++] = odd ? SM_DO_CRYPTOGRAM_ODD : SM_DO_CRYPTOGRAM;
+    if (lengthOctets == 3) {
+      _buffer[offset++] = 0x82;
+      _buffer[offset++] = (byte) (valueLength >> 8);
+    } else if (lengthOctets == 2) {
+      _buffer[offset++] = 0x81;
+    }
+    _buffer[offset++] = (byte) valueLength;
+    if (!odd) {
+      _buffer[offset++] = SM_PADDING_INDICATOR;
+    }
+    offset += cryptogramLength;
+  }
+  if (hasLe) {
+    _buffer[offset++] = SM_DO_LE;
+    _buffer[offset++] = 0x01;
+    _buffer[offset++] = le;
+  }
+  _buffer[0] |= SM_CLA;
+
+  //MAC over the send sequence counter, the padded header and the data objects
+  beginMac();
+  updateMac(_buffer, 4);
+  padMac();
+  updateMac(_buffer + 5, offset - 5);
+  finishMac(_buffer + offset + 2);
+  _buffer[offset++] = SM_DO_MAC;
+  _buffer[offset++] = SM_MAC_LENGTH;
+  offset += SM_MAC_LENGTH;
+
+  _buffer[4] = (byte) (offset - 5); //Lc
+  _buffer[offset++] = 0x00; //Le
+  return offset;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Checks the MAC of the response APDU found at the start of the buffer and decrypts it in place,
+         leaving the plain data followed by the status word. A MAC mismatch ends the session
+
+  @param responseLength The length of the protected response, then the length of the plain one
+
+  @returns A boolean value indicating whether the response is authentic, or an unprotected error status word (the session is over)
+*/
+/**************************************************************************/
+bool cie_SecureMessaging::unwrapResponse(word *responseLength) {
+  word length = *responseLength;
+  if (!_active || length < SM_STATUS_WORD_LENGTH) {
+    return false;
+  }
+  if (length == SM_STATUS_WORD_LENGTH) {
+    //Errors come unprotected, and the card has closed the session. Anything else must be authenticated
+    byte sw1 = _buffer[0];
+    end();
+    if ((sw1 == 0x90 && _buffer[1] == 0x00) || sw1 == 0x61 || sw1 == 0x62 || sw1 == 0x63) {
+      PN532DEBUGPRINT.println(F("The response is not protected, yet it's not an error"));
+      return false;
+    }
+    return true;
+  }
+  incrementSsc();
+
+  word dataObjectsLength = length - SM_STATUS_WORD_LENGTH;
+  word offset = 0;
+  byte cryptogramTag = 0x00;
+  word cryptogramOffset = 0;
+  word cryptogramLength = 0;
+  word statusOffset = dataObjectsLength;
+  word macOffset = 0;
+  bool hasMac = false;
+  while (offset + 2 <= dataObjectsLength && !hasMac) {
+    byte tag = _buffer[offset];
+    word valueOffset = offset + 2;
+    word valueLength = _buffer[offset + 1];
+    if (valueLength == 0x81) {
+      valueOffset++;
+      valueLength = _buffer[offset + 2];
+    } else if (valueLength == 0x82) {
+      valueOffset += 2;
+      valueLength = ((word) _buffer[offset + 2] << 8) | _buffer[offset + 3];
+    }
+    if (valueOffset + valueLength > dataObjectsLength) {
+      break;
+    }
+    switch (tag) {
+      case SM_DO_CRYPTOGRAM:
+      case SM_DO_CRYPTOGRAM_ODD:
+        cryptogramTag = tag;
+        cryptogramOffset = valueOffset;
+        cryptogramLength = valueLength;
+      break;
+
+      case SM_DO_STATUS_WORD:
+        if (valueLength == SM_STATUS_WORD_LENGTH) {
+          statusOffset = valueOffset;
+        }
+      break;
+
+      case SM_DO_MAC:
+        hasMac = valueLength == SM_MAC_LENGTH;
+        macOffset = offset;
+      break;
+    }
+    offset = valueOffset + valueLength;
+  }
+  if (!hasMac) {
+    PN532DEBUGPRINT.println(F("The response has no MAC"));
+    end();
+    return false;
+  }
+
+  byte mac[SM_MAC_LENGTH];
+  beginMac();
+  updateMac(_buffer, macOffset);
+  finishMac(mac);
+  byte difference = 0;
+  for (byte i = 0; i < SM_MAC_LENGTH; i++) {
+    difference |= mac[i] ^ _buffer[macOffset + 2 + i];
+  }
+  if (difference != 0) {
+    PN532DEBUGPRINT.println(F("The MAC of the response is not valid"));
+    end();
+    return false;
+  }
+
+  byte sw1 = _buffer[statusOffset];
+  byte sw2 = _buffer[statusOffset + 1];
+  word plainLength = 0;
+  if (cryptogramTag == SM_DO_CRYPTOGRAM) {
+    //Skip the padding indicator
+    cryptogramOffset++;
+    cryptogramLength--;
+  }
+  if (cryptogramLength > 0) {
+    if (cryptogramLength % getBlockLength() != 0) {
+      PN532DEBUGPRINT.println(F("The cryptogram is not made of whole blocks"));
+      return false;
+    }
+    decrypt(_buffer + cryptogramOffset, cryptogramLength);
+    plainLength = cryptogramLength;
+    while (plainLength > 0 && _buffer[cryptogramOffset + plainLength - 1] == 0x00) {
+      plainLength--;
+    }
+    if (plainLength == 0 || _buffer[cryptogramOffset + plainLength - 1] != SM_PADDING_START) {
+      PN532DEBUGPRINT.println(F("The cryptogram is not padded"));
+      return false;
+    }
+    plainLength--;
+    memmove(_buffer, _buffer + cryptogramOffset, plainLength);
+  }
+  _buffer[plainLength] = sw1;
+  _buffer[plainLength + 1] = sw2;
+  *responseLength = plainLength + SM_STATUS_WORD_LENGTH;
+  return true;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Gets the longest plain response data which still fits in a short response once protected,
+         e.g. to size the pages of READ BINARY
+
+  @returns The length in bytes
+*/
+/**************************************************************************/
+word cie_SecureMessaging::getMaxResponseDataLength() {
+  byte blockLength = getBlockLength();
+  //Padding takes at least one byte
+  return (SM_MAX_RESPONSE_LENGTH - SM_RESPONSE_OVERHEAD) / blockLength * blockLength - 1;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Encrypts whole blocks in place in CBC mode, with the initialization vector of the current counter
+
+  @param buffer The pointer to the data
+  @param length The length of the data, a multiple of the block length
+*/
+/**************************************************************************/
+void cie_SecureMessaging::encrypt(byte *buffer, const word length) {
+  byte blockLength = getBlockLength();
+  byte iv[SM_MAX_BLOCK_LENGTH];
+  initialVector(iv);
+  for (word offset = 0; offset < length; offset += blockLength) {
+    const byte *previous = offset > 0 ? buffer + offset - blockLength : iv;
+    for (byte i = 0; i < blockLength; i++) {
+      buffer[offset + i] ^= previous[i];
+    }
+    encryptBlock(buffer + offset);
+  }
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Decrypts whole blocks in place in CBC mode, with the initialization vector of the current counter
+
+  @param buffer The pointer to the data
+  @param length The length of the data, a multiple of the block length
+*/
+/**************************************************************************/
+void cie_SecureMessaging::decrypt(byte *buffer, const word length) {
+  byte blockLength = getBlockLength();
+  byte iv[SM_MAX_BLOCK_LENGTH];
+  initialVector(iv);
+  //Backwards, so that each block still finds the previous cryptogram
+  for (word offset = length; offset >= blockLength; offset -= blockLength) {
+    byte *block = buffer + offset - blockLength;
+    decryptBlock(block);
+    const byte *previous = offset > blockLength ? block - blockLength : iv;
+    for (byte i = 0; i < blockLength; i++) {
+      block[i] ^= previous[i];
+    }
+  }
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Computes the MAC of the data, padded with ISO/IEC 9797-1 padding method 2
+
+  @param data The pointer to the data
+  @param length The length of the data
+  @param mac The pointer to the SM_MAC_LENGTH bytes MAC
+*/
+/**************************************************************************/
+void cie_SecureMessaging::computeMac(const byte *data, const word length, byte *mac) {
+  memset(_macState, 0, SM_MAX_BLOCK_LENGTH);
+  _macBlockLength = 0;
+  updateMac(data, length);
+  finishMac(mac);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Pads the data to whole blocks (ISO/IEC 9797-1 padding method 2)
+
+  @param buffer The pointer to the data, with room for the padding
+  @param length The length of the data
+
+  @returns The length of the padded data
+*/
+/**************************************************************************/
+word cie_SecureMessaging::pad(byte *buffer, const word length) {
+  byte blockLength = getBlockLength();
+  word paddedLength = (length / blockLength + 1) * blockLength;
+  buffer[length] = SM_PADDING_START;
+  memset(buffer + length + 1, 0, paddedLength - length - 1);
+  return paddedLength;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Increments the send sequence counter, before each command and each response
+*/
+/**************************************************************************/
+void cie_SecureMessaging::incrementSsc() {
+  for (int8_t i = getBlockLength() - 1; i >= 0; i--) {
+    if (++_ssc[i] != 0x00) {
+      break;
+    }
+  }
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Starts a MAC chained to the send sequence counter
+*/
+/**************************************************************************/
+void cie_SecureMessaging::beginMac() {
+  memset(_macState, 0, SM_MAX_BLOCK_LENGTH);
+  _macBlockLength = 0;
+  updateMac(_ssc, getBlockLength());
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Feeds data to the MAC. A full block is processed only when more data follows,
+         since the last block is processed differently
+
+  @param data The pointer to the data
+  @param length The length of the data
+*/
+/**************************************************************************/
+void cie_SecureMessaging::updateMac(const byte *data, const word length) {
+  byte blockLength = getBlockLength();
+  for (word i = 0; i < length; i++) {
+    if (_macBlockLength == blockLength) {
+      macBlock(_macState);
+      _macBlockLength = 0;
+    }
+    _macState[_macBlockLength++] ^= data[i];
+  }
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Pads the data fed to the MAC so far to a whole block
+*/
+/**************************************************************************/
+void cie_SecureMessaging::padMac() {
+  byte padding = SM_PADDING_START;
+  updateMac(&padding, 1);
+  padding = 0x00;
+  while (_macBlockLength < getBlockLength()) {
+    updateMac(&padding, 1);
+  }
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Pads the data and computes the MAC
+
+  @param mac The pointer to the SM_MAC_LENGTH bytes MAC
+*/
+/**************************************************************************/
+void cie_SecureMessaging::finishMac(byte *mac) {
+  padMac();
+  macLastBlock(_macState);
+  memcpy(mac, _macState, SM_MAC_LENGTH);
+  memset(_macState, 0, SM_MAX_BLOCK_LENGTH);
+  _macBlockLength = 0;
+}
@@ -0,0 +1,90 @@
+/**************************************************************************/
+/*!
+    @file     cie_SecureMessaging.h
+    @author   Developers Italia
+	@license  BSD (see License)
+
+	Definition of the cie_SecureMessaging abstract class, a secure messaging session (ISO/IEC 7816-4):
+	APDUs are wrapped and unwrapped in place, in the frame buffer owned by the session.
+	Subclasses provide the block cipher and the MAC: 3DES and retail MAC after the IAS ECC mutual
+	authentication, AES and CMAC after PACE
+
+	@section  HISTORY
+
+	v1.1  - Abstract class, ciphers moved to subclasses
+	v1.0  - First definition of the class
+
+*/
+/**************************************************************************/
+#ifndef CIE_SECURE_MESSAGING
+#define CIE_SECURE_MESSAGING
+#include <Arduino.h>
+
+#define SM_KEY_LENGTH                         (0x10)
+#define SM_MAC_LENGTH                         (0x08)
+#define SM_MAX_BLOCK_LENGTH                   (0x10)
+//A short response: 256 bytes of data objects and the status word
+#define SM_MAX_RESPONSE_LENGTH                (0x0100)
+#define SM_BUFFER_LENGTH                      (SM_MAX_RESPONSE_LENGTH + SM_STATUS_WORD_LENGTH)
+//A protected command must still fit in a single short APDU
+#define SM_MAX_COMMAND_LENGTH                 (0xFF)
+//Data objects around the cryptogram of a response: 87 81 L 01, 99 02 SW1 SW2, 8E 08 MAC
+#define SM_RESPONSE_OVERHEAD                  (0x12)
+
+//Class byte of a command with secure messaging and authenticated header
+#define SM_CLA                                (0x0C)
+
+//Secure messaging data objects (ISO/IEC 7816-4)
+#define SM_DO_CRYPTOGRAM                      (0x87)
+#define SM_DO_CRYPTOGRAM_ODD                  (0x85)
+#define SM_DO_LE                              (0x97)
+#define SM_DO_STATUS_WORD                     (0x99)
+#define SM_DO_MAC                             (0x8E)
+#define SM_PADDING_INDICATOR                  (0x01)
+#define SM_PADDING_START                      (0x80)
+#define SM_STATUS_WORD_LENGTH                 (0x02)
+
+class cie_SecureMessaging {
+  public:
+    cie_SecureMessaging();
+    virtual ~cie_SecureMessaging() {}
+    virtual void setKeys(const byte *encKey, const byte *macKey) = 0;
+    virtual byte getBlockLength() = 0;
+    void begin(const byte *encKey, const byte *macKey, const byte *ssc);
+    void end();
+    bool isActive();
+    byte *getBuffer();
+    word wrapCommand(const word commandLength);
+    bool unwrapResponse(word *responseLength);
+    word getMaxResponseDataLength();
+
+    //Primitives, also used by the authentications before the session starts
+    void encrypt(byte *buffer, const word length);
+    void decrypt(byte *buffer, const word length);
+    void computeMac(const byte *data, const word length, byte *mac);
+    word pad(byte *buffer, const word length);
+
+  protected:
+    virtual void encryptBlock(byte *block) = 0;
+    virtual void decryptBlock(byte *block) = 0;
+    virtual void macBlock(byte *block) = 0;
+    virtual void macLastBlock(byte *block) = 0;
+    virtual void initialVector(byte *iv) = 0;
+    virtual void clearKeys() = 0;
+
+    byte _ssc[SM_MAX_BLOCK_LENGTH];
+
+  private:
+    void incrementSsc();
+    void beginMac();
+    void updateMac(const byte *data, const word length);
+    void padMac();
+    void finishMac(byte *mac);
+
+    byte _macState[SM_MAX_BLOCK_LENGTH];
+    byte _macBlockLength;
+    bool _active;
+    byte _buffer[SM_BUFFER_LENGTH];
+};
+
+#endif
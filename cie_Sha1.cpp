@@ -0,0 +1,108 @@
+/**************************************************************************/
+/*!
+    @file     cie_Sha1.cpp
+    @author   Developers Italia
+    @license  BSD (see License)
+
+	Implementation of the cie_Sha1 class
+
+	@section  HISTORY
+
+	v1.0  - First implementation of the class
+*/
+/**************************************************************************/
+#include "cie_Sha1.h"
+
+/**************************************************************************/
+/*!
+  @brief Gets the length of the digest
+
+  @returns SHA1_DIGEST_LENGTH
+*/
+/**************************************************************************/
+byte cie_Sha1::getDigestLength() {
+  return SHA1_DIGEST_LENGTH;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Sets the initial hash value
+*/
+/**************************************************************************/
+void cie_Sha1::initState() {
+  _state[0] = 0x67452301;
+  _state[1] = 0xEFCDAB89;
+  _state[2] = 0x98BADCFE;
+  _state[3] = 0x10325476;
+  _state[4] = 0xC3D2E1F0;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Compresses a block of HASH_BLOCK_LENGTH bytes into the state
+
+  @param block The pointer to the block
+*/
+/**************************************************************************/
+void cie_Sha1::compress(const byte *block) {
+#if CIE_HASH_COMPACT
+  uint32_t w[16];
+  #define SHA1_SCHEDULE(i) (i < 16 ? w[i] : (w[i & 15] = HASH_ROTATE_LEFT(w[(i + 13) & 15] ^ w[(i + 8) & 15] ^ w[(i + 2) & 15] ^ w[i & 15], 1)))
+#else
+  uint32_t w[80];
+  #define SHA1_SCHEDULE(i) (w[i])
+#endif
+  for (byte i = 0; i < 16; i++) {
+    w[i] = readWord(block + 4 * i);
+  }
+#if !CIE_HASH_COMPACT
+  for (byte i = 16; i < 80; i++) {
+    w[i] = HASH_ROTATE_LEFT(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+  }
+#endif
+  uint32_t a = _state[0];
+  uint32_t b = _state[1];
+  uint32_t c = _state[2];
+  uint32_t d = _state[3];
+  uint32_t e = _state[4];
+  for (byte i = 0; i < 80; i++) {
+    uint32_t f;
+    if (i < 20) {
+      f = ((b & c) | (~b & d)) + 0x5A827999;
+    } else if (i < 40) {
+      f = (b ^ c ^ d) + 0x6ED9EBA1;
+    } else if (i < 60) {
+      f = ((b & c) | (b & d) | (c & d)) + 0x8F1BBCDC;
+    } else {
+      f = (b ^ c ^ d) + 0xCA62C1D6;
+    }
+    uint32_t t = HASH_ROTATE_LEFT(a, 5) + f + e + SHA1_SCHEDULE(i);
+    e = d;
+    d = c;
+    c = HASH_ROTATE_LEFT(b, 30);
+    b = a;
+    a = t;
+  }
+  #undef SHA1_SCHEDULE
+  _state[0] += a;
+  _state[1] += b;
+  _state[2] += c;
+  _state[3] += d;
+  _state[4] += e;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Writes the state as the digest
+
+  @param digest The pointer to a buffer of SHA1_DIGEST_LENGTH bytes
+*/
+/**************************************************************************/
+void cie_Sha1::writeDigest(byte *digest) {
+  for (byte i = 0; i < 5; i++) {
+    writeWord(digest + 4 * i, _state[i]);
+  }
+}
@@ -0,0 +1,34 @@
+/**************************************************************************/
+/*!
+    @file     cie_Sha1.h
+    @author   Developers Italia
+	@license  BSD (see License)
+
+	Definition of the cie_Sha1 class, the SHA-1 hash (FIPS 180-4) used by the RSA PKCS#1 - SHA1 security environment
+
+	@section  HISTORY
+
+	v1.0  - First definition of the class
+
+*/
+/**************************************************************************/
+#ifndef CIE_SHA1
+#define CIE_SHA1
+#include "cie_Hash.h"
+
+#define SHA1_DIGEST_LENGTH                    (0x14)
+
+class cie_Sha1 : public cie_Hash {
+  public:
+    byte getDigestLength();
+
+  protected:
+    void initState();
+    void compress(const byte *block);
+    void writeDigest(byte *digest);
+
+  private:
+    uint32_t _state[5];
+};
+
+#endif
@@ -0,0 +1,128 @@
+/**************************************************************************/
+/*!
+    @file     cie_Sha256.cpp
+    @author   Developers Italia
+    @license  BSD (see License)
+
+	Implementation of the cie_Sha256 class
+
+	@section  HISTORY
+
+	v1.0  - First implementation of the class
+*/
+/**************************************************************************/
+#include "cie_Sha256.h"
+
+//Round constants: the first 32 bits of the fractional parts of the cube roots of the first 64 primes
+static const uint32_t SHA256_K[64] HASH_CONSTANTS = {
+  0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+  0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+  0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+  0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+  0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+  0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+  0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+  0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2
+};
+
+#define SHA256_SIGMA0(x) (HASH_ROTATE_RIGHT(x, 7) ^ HASH_ROTATE_RIGHT(x, 18) ^ ((x) >> 3))
+#define SHA256_SIGMA1(x) (HASH_ROTATE_RIGHT(x, 17) ^ HASH_ROTATE_RIGHT(x, 19) ^ ((x) >> 10))
+
+/**************************************************************************/
+/*!
+  @brief Gets the length of the digest
+
+  @returns SHA256_DIGEST_LENGTH
+*/
+/**************************************************************************/
+byte cie_Sha256::getDigestLength() {
+  return SHA256_DIGEST_LENGTH;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Sets the initial hash value
+*/
+/**************************************************************************/
+void cie_Sha256::initState() {
+  _state[0] = 0x6A09E667;
+  _state[1] = 0xBB67AE85;
+  _state[2] = 0x3C6EF372;
+  _state[3] = 0xA54FF53A;
+  _state[4] = 0x510E527F;
+  _state[5] = 0x9B05688C;
+  _state[6] = 0x1F83D9AB;
+  _state[7] = 0x5BE0CD19;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Compresses a block of HASH_BLOCK_LENGTH bytes into the state
+
+  @param block The pointer to the block
+*/
+/**************************************************************************/
+void cie_Sha256::compress(const byte *block) {
+#if CIE_HASH_COMPACT
+  uint32_t w[16];
+  #define SHA256_SCHEDULE(i) (i < 16 ? w[i] : (w[i & 15] += SHA256_SIGMA1(w[(i + 14) & 15]) + w[(i + 9) & 15] + SHA256_SIGMA0(w[(i + 1) & 15])))
+#else
+  uint32_t w[64];
+  #define SHA256_SCHEDULE(i) (w[i])
+#endif
+  for (byte i = 0; i < 16; i++) {
+    w[i] = readWord(block + 4 * i);
+  }
+#if !CIE_HASH_COMPACT
+  for (byte i = 16; i < 64; i++) {
+    w[i] = SHA256_SIGMA1(w[i - 2]) + w[i - 7] + SHA256_SIGMA0(w[i - 15]) + w[i - 16];
+  }
+#endif
+  uint32_t a = _state[0];
+  uint32_t b = _state[1];
+  uint32_t c = _state[2];
+  uint32_t d = _state[3];
+  uint32_t e = _state[4];
+  uint32_t f = _state[5];
+  uint32_t g = _state[6];
+  uint32_t h = _state[7];
+  for (byte i = 0; i < 64; i++) {
+    uint32_t t1 = h + (HASH_ROTATE_RIGHT(e, 6) ^ HASH_ROTATE_RIGHT(e, 11) ^ HASH_ROTATE_RIGHT(e, 25))
+      + ((e & f) ^ (~e & g)) + HASH_CONSTANT(SHA256_K, i) + SHA256_SCHEDULE(i);
+    uint32_t t2 = (HASH_ROTATE_RIGHT(a, 2) ^ HASH_ROTATE_RIGHT(a, 13) ^ HASH_ROTATE_RIGHT(a, 22))
+      + ((a & b) ^ (a & c) ^ (b & c));
+    h = g;
+    g = f;
+    f = e;
+    e = d + t1;
+    d = c;
+    c = b;
+    b = a;
+    a = t1 + t2;
+  }
+  #undef SHA256_SCHEDULE
+  _state[0] += a;
+  _state[1] += b;
+  _state[2] += c;
+  _state[3] += d;
+  _state[4] += e;
+  _state[5] += f;
+  _state[6] += g;
+  _state[7] += h;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Writes the state as the digest
+
+  @param digest The pointer to a buffer of SHA256_DIGEST_LENGTH bytes
+*/
+/**************************************************************************/
+void cie_Sha256::writeDigest(byte *digest) {
+  for (byte i = 0; i < 8; i++) {
+    writeWord(digest + 4 * i, _state[i]);
+  }
+}
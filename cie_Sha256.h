@@ -0,0 +1,34 @@
+/**************************************************************************/
+/*!
+    @file     cie_Sha256.h
+    @author   Developers Italia
+	@license  BSD (see License)
+
+	Definition of the cie_Sha256 class, the SHA-256 hash (FIPS 180-4) used by the LDS security object (EF_SOD)
+
+	@section  HISTORY
+
+	v1.0  - First definition of the class
+
+*/
+/**************************************************************************/
+#ifndef CIE_SHA256
+#define CIE_SHA256
+#include "cie_Hash.h"
+
+#define SHA256_DIGEST_LENGTH                  (0x20)
+
+class cie_Sha256 : public cie_Hash {
+  public:
+    byte getDigestLength();
+
+  protected:
+    void initState();
+    void compress(const byte *block);
+    void writeDigest(byte *digest);
+
+  private:
+    uint32_t _state[8];
+};
+
+#endif
@@ -0,0 +1,105 @@
+/**************************************************************************/
+/*!
+    @file     cie_SignerCache.cpp
+    @author   Developers Italia
+    @license  BSD (see License)
+
+	Implementation of the cie_SignerCache class. An entry matches only if the digest of the public key matches too:
+	a forged certificate reusing the subjectKeyIdentifier of a verified one is a miss
+
+	@section  HISTORY
+
+	v1.0  - First implementation of the class
+*/
+/**************************************************************************/
+#include "cie_SignerCache.h"
+
+/**************************************************************************/
+/*!
+  @brief Creates an empty cache
+*/
+/**************************************************************************/
+cie_SignerCache::cie_SignerCache() :
+_uses(0),
+_hits(0)
+{
+  clear();
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Checks whether a document signer certificate was already verified
+
+  @param keyIdentifier The pointer to the subjectKeyIdentifier of the certificate
+  @param keyIdentifierLength The length of the subjectKeyIdentifier
+  @param keyDigest The pointer to the SHA-256 digest of the public key in the certificate
+
+  @returns A boolean value indicating whether the certificate was verified or not
+*/
+/**************************************************************************/
+bool cie_SignerCache::contains(const byte *keyIdentifier, const byte keyIdentifierLength, const byte *keyDigest) {
+  for (byte i = 0; i < SIGNER_CACHE_CAPACITY; i++) {
+    cie_VerifiedSigner *signer = &_signers[i];
+    if (signer->keyIdentifierLength == keyIdentifierLength
+        && memcmp(signer->keyIdentifier, keyIdentifier, keyIdentifierLength) == 0
+        && memcmp(signer->keyDigest, keyDigest, SHA256_DIGEST_LENGTH) == 0) {
+      signer->lastUsed = ++_uses;
+      _hits++;
+      return true;
+    }
+  }
+  return false;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Records a verified document signer certificate, replacing the least recently used one when full
+
+  @param keyIdentifier The pointer to the subjectKeyIdentifier of the certificate
+  @param keyIdentifierLength The length of the subjectKeyIdentifier (up to SIGNER_KEY_IDENTIFIER_LENGTH bytes)
+  @param keyDigest The pointer to the SHA-256 digest of the public key in the certificate
+*/
+/**************************************************************************/
+void cie_SignerCache::add(const byte *keyIdentifier, const byte keyIdentifierLength, const byte *keyDigest) {
+  if (keyIdentifierLength == 0 || keyIdentifierLength > SIGNER_KEY_IDENTIFIER_LENGTH) {
+    return;
+  }
+  byte oldest = 0;
+  for (byte i = 1; i < SIGNER_CACHE_CAPACITY; i++) {
+    if (_signers[i].lastUsed < _signers[oldest].lastUsed) {
+      oldest = i;
+    }
+  }
+  cie_VerifiedSigner *signer = &_signers[oldest];
+  memcpy(signer->keyIdentifier, keyIdentifier, keyIdentifierLength);
+  signer->keyIdentifierLength = keyIdentifierLength;
+  memcpy(signer->keyDigest, keyDigest, SHA256_DIGEST_LENGTH);
+  signer->lastUsed = ++_uses;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Counts the certificates found in the cache, that is the verifications saved
+
+  @returns The number of cache hits
+*/
+/**************************************************************************/
+word cie_SignerCache::getHits() {
+  return _hits;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Forgets all certificates, e.g. after changing the trust anchor
+*/
+/**************************************************************************/
+void cie_SignerCache::clear() {
+  for (byte i = 0; i < SIGNER_CACHE_CAPACITY; i++) {
+    _signers[i].keyIdentifierLength = 0;
+    _signers[i].lastUsed = 0;
+  }
+}
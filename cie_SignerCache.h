@@ -0,0 +1,50 @@
+/**************************************************************************/
+/*!
+    @file     cie_SignerCache.h
+    @author   Developers Italia
+	@license  BSD (see License)
+
+	Definition of the cie_SignerCache class, a small table of the document signer certificates already verified
+	against the trust anchor, keyed by their subjectKeyIdentifier
+
+	@section  HISTORY
+
+	v1.0  - First definition of the class
+
+*/
+/**************************************************************************/
+#ifndef CIE_SIGNER_CACHE
+#define CIE_SIGNER_CACHE
+#include <Arduino.h>
+#include "cie_Sha256.h"
+
+//Cards of the same issuance batch share one document signer, a few entries are enough
+#if defined(__AVR__)
+  #define SIGNER_CACHE_CAPACITY               (0x02)
+#else
+  #define SIGNER_CACHE_CAPACITY               (0x04)
+#endif
+#define SIGNER_KEY_IDENTIFIER_LENGTH          (0x14)
+
+struct cie_VerifiedSigner {
+    byte keyIdentifier[SIGNER_KEY_IDENTIFIER_LENGTH];
+    byte keyIdentifierLength;
+    byte keyDigest[SHA256_DIGEST_LENGTH];
+    unsigned long lastUsed;
+};
+
+class cie_SignerCache {
+  public:
+    cie_SignerCache();
+    bool contains(const byte *keyIdentifier, const byte keyIdentifierLength, const byte *keyDigest);
+    void add(const byte *keyIdentifier, const byte keyIdentifierLength, const byte *keyDigest);
+    word getHits();
+    void clear();
+
+  private:
+    cie_VerifiedSigner _signers[SIGNER_CACHE_CAPACITY];
+    unsigned long _uses;
+    word _hits;
+};
+
+#endif
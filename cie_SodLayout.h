@@ -0,0 +1,57 @@
+/**************************************************************************/
+/*!
+    @file     cie_SodLayout.h
+    @author   Developers Italia
+	@license  BSD (see License)
+
+	Definition of the cie_SodLayout structure locating the document signer certificate and the SignerInfo in the EF_SOD.
+	Nothing is copied while parsing: each part is an offset and a length in the file, read or hashed when it's needed
+
+	@section  HISTORY
+
+	v1.0  - First definition of the structure
+
+*/
+/**************************************************************************/
+#ifndef CIE_SOD_LAYOUT
+#define CIE_SOD_LAYOUT
+#include <Arduino.h>
+
+//Parts of the SignedData being parsed
+#define SOD_SECTION_NONE                      (0x00)
+#define SOD_SECTION_CONTENT                   (0x01)
+#define SOD_SECTION_CERTIFICATE               (0x02)
+#define SOD_SECTION_SIGNER_INFO               (0x03)
+
+struct cie_SodRange {
+    word offset;
+    word length;
+};
+
+struct cie_SodLayout {
+    //Document signer certificate
+    cie_SodRange tbsCertificate;
+    cie_SodRange modulus;
+    cie_SodRange exponent;
+    cie_SodRange keyIdentifier;
+    byte certificateHashAlgorithm;
+    cie_SodRange certificateSignature;
+    //SignerInfo
+    cie_SodRange content;
+    byte hashAlgorithm;
+    cie_SodRange signedAttributes;
+    cie_SodRange messageDigest;
+    cie_SodRange signature;
+
+    //Parsing state
+    byte signedDataDepth;
+    byte section;
+    byte sectionCount;
+    byte childCount;
+    bool afterPublicKeyOid;
+    bool afterKeyIdentifierOid;
+    bool afterMessageDigestOid;
+    bool unsupported;
+};
+
+#endif
@@ -0,0 +1,299 @@
+/**************************************************************************/
+/*!
+    @file     cie_Telemetry.cpp
+    @author   Developers Italia
+    @license  BSD (see License)
+
+	Implementation of the cie_Telemetry class: counters are updated as taps and APDU commands happen,
+	the percentiles are taken once per period by sorting the latest tap latencies
+
+	@section  HISTORY
+
+	v1.0  - First implementation of the class
+*/
+/**************************************************************************/
+#include "cie_Telemetry.h"
+#include "cie_Memory.h"
+
+/**************************************************************************/
+/*!
+  @brief Creates the telemetry of a reader with the default period of a minute, writing frames nowhere
+*/
+/**************************************************************************/
+cie_Telemetry::cie_Telemetry() :
+_output(NULL),
+_callback(NULL),
+_period(TELEMETRY_DEFAULT_PERIOD),
+_periodStartedAt(0),
+_sequence(0)
+{
+  clear();
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Sets how often update() emits a frame
+
+  @param period The period in milliseconds
+*/
+/**************************************************************************/
+void cie_Telemetry::setPeriod(const unsigned long period) {
+  _period = period;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Sets where the frames are written, e.g. &Serial
+
+  @param output The output, or NULL to write the frames nowhere
+*/
+/**************************************************************************/
+void cie_Telemetry::setOutput(Print *output) {
+  _output = output;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Sets a function receiving each frame, e.g. to send it over the network
+
+  @param callback The function, or NULL
+*/
+/**************************************************************************/
+void cie_Telemetry::setCallback(cieTelemetryCallbackFunc callback) {
+  _callback = callback;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Emits a frame when the period is over. Call this in your loop
+
+  @returns  A boolean value indicating whether a frame was emitted or not
+*/
+/**************************************************************************/
+bool cie_Telemetry::update() {
+  if (millis() - _periodStartedAt < _period) {
+    return false;
+  }
+  emit();
+  return true;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Emits the frame of the period so far and starts a new period
+*/
+/**************************************************************************/
+void cie_Telemetry::emit() {
+  byte frame[TELEMETRY_FRAME_LENGTH];
+  buildFrame(frame);
+  if (_output != NULL) {
+    _output->write(frame, TELEMETRY_FRAME_LENGTH);
+  }
+  if (_callback != NULL) {
+    _callback(frame, TELEMETRY_FRAME_LENGTH);
+  }
+  _sequence++;
+  clear();
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Writes the frame of the period so far, without starting a new period
+
+  @param frame The pointer to a buffer of TELEMETRY_FRAME_LENGTH bytes
+*/
+/**************************************************************************/
+void cie_Telemetry::buildFrame(byte *frame) {
+  unsigned long period = millis() - _periodStartedAt;
+  byte count = _taps < TELEMETRY_TAP_SAMPLES ? _taps : TELEMETRY_TAP_SAMPLES;
+  //Insertion sort: a few dozen samples once per period
+  word samples[TELEMETRY_TAP_SAMPLES];
+  for (byte i = 0; i < count; i++) {
+    word sample = _tapSamples[i];
+    byte j = i;
+    for (; j > 0 && samples[j-1] > sample; j--) {
+      samples[j] = samples[j-1];
+    }
+    samples[j] = sample;
+  }
+  unsigned long tapsPerMinute = period == 0 ? 0 : (unsigned long) _taps * 60000UL / period;
+
+  byte offset = 0;
+  frame[offset++] = TELEMETRY_FRAME_MAGIC;
+  frame[offset++] = TELEMETRY_FRAME_VERSION;
+  frame[offset++] = TELEMETRY_FRAME_LENGTH;
+  frame[offset++] = _sequence;
+  offset = writeLong(frame, offset, period);
+  offset = writeWord(frame, offset, _taps);
+  offset = writeWord(frame, offset, tapsPerMinute > 0xFFFF ? 0xFFFF : tapsPerMinute);
+  offset = writeWord(frame, offset, percentile(samples, count, 50));
+  offset = writeWord(frame, offset, percentile(samples, count, 95));
+  offset = writeWord(frame, offset, percentile(samples, count, 99));
+  offset = writeWord(frame, offset, _apdus);
+  offset = writeWord(frame, offset, ratio(_failedApdus, _apdus));
+  for (byte cache = 0; cache < TELEMETRY_CACHE_COUNT; cache++) {
+    offset = writeWord(frame, offset, ratio(_cacheHits[cache], _cacheLookups[cache]));
+  }
+  offset = writeLong(frame, offset, _heapHighWater);
+  byte checksum = 0;
+  for (byte i = 0; i < offset; i++) {
+    checksum += frame[i];
+  }
+  frame[offset] = (byte) -checksum;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Counts a tap and keeps its latency for the percentiles
+
+  @param micros The time from the detection of the card to its last APDU command, in microseconds
+*/
+/**************************************************************************/
+void cie_Telemetry::recordTap(const unsigned long micros) {
+  unsigned long millis = micros / 1000;
+  _tapSamples[_nextTapSample] = millis > 0xFFFF ? 0xFFFF : millis;
+  _nextTapSample = (_nextTapSample + 1) % TELEMETRY_TAP_SAMPLES;
+  if (_taps != 0xFFFF) {
+    _taps++;
+  }
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Counts an APDU command and checks the heap in use, which is highest while talking to the card
+
+  @param success Whether the command succeeded
+*/
+/**************************************************************************/
+void cie_Telemetry::recordApdu(const bool success) {
+  if (_apdus == 0xFFFF) {
+    return;
+  }
+  _apdus++;
+  if (!success) {
+    _failedApdus++;
+  }
+  unsigned long heapUsed = cie_heapUsed();
+  if (heapUsed > _heapHighWater) {
+    _heapHighWater = heapUsed;
+  }
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Counts a lookup in one of the caches of the reader
+
+  @param cache The cache, e.g. TELEMETRY_CACHE_SIGNER
+  @param hit Whether the lookup found what it was looking for
+*/
+/**************************************************************************/
+void cie_Telemetry::recordCacheLookup(const byte cache, const bool hit) {
+  if (cache >= TELEMETRY_CACHE_COUNT || _cacheLookups[cache] == 0xFFFF) {
+    return;
+  }
+  _cacheLookups[cache]++;
+  if (hit) {
+    _cacheHits[cache]++;
+  }
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Starts a new period with all counters at zero
+*/
+/**************************************************************************/
+void cie_Telemetry::clear() {
+  _periodStartedAt = millis();
+  _taps = 0;
+  _nextTapSample = 0;
+  _apdus = 0;
+  _failedApdus = 0;
+  memset(_cacheLookups, 0, sizeof(_cacheLookups));
+  memset(_cacheHits, 0, sizeof(_cacheHits));
+  _heapHighWater = cie_heapUsed();
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Takes a percentile of the tap latencies by the nearest rank method
+
+  @param sortedSamples The pointer to the latencies in ascending order
+  @param count The number of latencies
+  @param percent The percentile, from 1 to 100
+
+  @returns  The latency in milliseconds, 0 without any tap
+*/
+/**************************************************************************/
+word cie_Telemetry::percentile(const word *sortedSamples, const byte count, const byte percent) {
+  if (count == 0) {
+    return 0;
+  }
+  word rank = ((word) count * percent + 99) / 100;
+  return sortedSamples[rank - 1];
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Calculates a ratio per mille
+
+  @param part The part counted
+  @param total The total counted
+
+  @returns  The ratio per mille, or TELEMETRY_NO_RATIO if the total is 0
+*/
+/**************************************************************************/
+word cie_Telemetry::ratio(const unsigned long part, const unsigned long total) {
+  if (total == 0) {
+    return TELEMETRY_NO_RATIO;
+  }
+  return (word) (part * 1000 / total);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Writes a 16 bits field, least significant byte first
+
+  @param frame The pointer to the frame
+  @param offset The offset of the field
+  @param value The value of the field
+
+  @returns  The offset of the next field
+*/
+/**************************************************************************/
+byte cie_Telemetry::writeWord(byte *frame, const byte offset, const word value) {
+  frame[offset] = value & 0xFF;
+  frame[offset + 1] = value >> 8;
+  return offset + 2;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Writes a 32 bits field, least significant byte first
+
+  @param frame The pointer to the frame
+  @param offset The offset of the field
+  @param value The value of the field
+
+  @returns  The offset of the next field
+*/
+/**************************************************************************/
+byte cie_Telemetry::writeLong(byte *frame, const byte offset, const unsigned long value) {
+  for (byte i = 0; i < 4; i++) {
+    frame[offset + i] = (value >> (8 * i)) & 0xFF;
+  }
+  return offset + 4;
+}
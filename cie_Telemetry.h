@@ -0,0 +1,100 @@
+/**************************************************************************/
+/*!
+    @file     cie_Telemetry.h
+    @author   Developers Italia
+	@license  BSD (see License)
+
+	Definition of the cie_Telemetry class, which sums up the taps of each period in a fixed layout
+	binary frame, written to a Print (e.g. Serial) and/or passed to a callback.
+	Multi-byte fields are little endian, ratios are per mille (TELEMETRY_NO_RATIO when nothing was counted)
+	and times are in milliseconds. A tap lasts from the detection of the card to its last APDU command
+
+	  offset  length  field
+	  0x00    1       TELEMETRY_FRAME_MAGIC
+	  0x01    1       TELEMETRY_FRAME_VERSION
+	  0x02    1       TELEMETRY_FRAME_LENGTH, so that later versions may append fields
+	  0x03    1       sequence number, wrapping around
+	  0x04    4       length of the period
+	  0x08    2       taps
+	  0x0A    2       taps per minute
+	  0x0C    2       tap latency, 50th percentile
+	  0x0E    2       tap latency, 95th percentile
+	  0x10    2       tap latency, 99th percentile
+	  0x12    2       APDU commands
+	  0x14    2       APDU commands failed, per mille
+	  0x16    2       document signer cache hits, per mille
+	  0x18    2       challenge pool hits, per mille
+	  0x1A    2       RSA context cache hits, per mille
+	  0x1C    4       heap high-water mark in bytes (0 if unknown on the board)
+	  0x20    1       checksum: the sum of all the bytes of the frame is 0
+
+	@section  HISTORY
+
+	v1.0  - First definition of the class
+
+*/
+/**************************************************************************/
+#ifndef CIE_TELEMETRY
+#define CIE_TELEMETRY
+#include <Arduino.h>
+
+#define TELEMETRY_FRAME_MAGIC                 (0xC1)
+#define TELEMETRY_FRAME_VERSION               (0x01)
+#define TELEMETRY_FRAME_LENGTH                (0x21)
+
+//Caches whose hit ratio is reported
+#define TELEMETRY_CACHE_SIGNER                (0x00)
+#define TELEMETRY_CACHE_CHALLENGE_POOL        (0x01)
+#define TELEMETRY_CACHE_RSA_CONTEXT           (0x02)
+#define TELEMETRY_CACHE_COUNT                 (0x03)
+
+#define TELEMETRY_NO_RATIO                    (0xFFFF)
+#define TELEMETRY_DEFAULT_PERIOD              (0xEA60)
+
+//Latest tap latencies the percentiles are taken from
+#if defined(__AVR__)
+  #define TELEMETRY_TAP_SAMPLES               (0x10)
+#else
+  #define TELEMETRY_TAP_SAMPLES               (0x40)
+#endif
+
+typedef void (*cieTelemetryCallbackFunc)(const byte *frame, const byte frameLength);
+
+class cie_Telemetry {
+  public:
+    cie_Telemetry();
+    void setPeriod(const unsigned long period);
+    void setOutput(Print *output);
+    void setCallback(cieTelemetryCallbackFunc callback);
+    bool update();
+    void emit();
+    void buildFrame(byte *frame);
+
+    //Called by cie_PN532
+    void recordTap(const unsigned long micros);
+    void recordApdu(const bool success);
+    void recordCacheLookup(const byte cache, const bool hit);
+
+  private:
+    void clear();
+    word percentile(const word *sortedSamples, const byte count, const byte percent);
+    static word ratio(const unsigned long part, const unsigned long total);
+    static byte writeWord(byte *frame, const byte offset, const word value);
+    static byte writeLong(byte *frame, const byte offset, const unsigned long value);
+
+    Print *_output;
+    cieTelemetryCallbackFunc _callback;
+    unsigned long _period;
+    unsigned long _periodStartedAt;
+    byte _sequence;
+    word _taps;
+    word _tapSamples[TELEMETRY_TAP_SAMPLES];
+    byte _nextTapSample;
+    word _apdus;
+    word _failedApdus;
+    word _cacheLookups[TELEMETRY_CACHE_COUNT];
+    word _cacheHits[TELEMETRY_CACHE_COUNT];
+    unsigned long _heapHighWater;
+};
+
+#endif
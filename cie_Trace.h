@@ -0,0 +1,52 @@
+/**************************************************************************/
+/*!
+    @file     cie_Trace.h
+    @author   Developers Italia
+    @license  BSD (see License)
+
+	The binary trace format written by cie_Nfc_Recorder and played back by cie_Nfc_Replayer.
+	A header (the magic "CIET" and the version), then one record per call to the transport:
+	the record type, the microseconds since the previous record and the outcome of the call.
+	Lengths, times and bit rates are unsigned LEB128 varints (7 bits per byte, least significant first)
+
+	  TRACE_DETECT       result (1 byte)
+	  TRACE_EXCHANGE     command length, command, result (1 byte), duration, response length, response
+	  TRACE_RANDOM       length, bytes
+	  TRACE_REDACTED     length (random bytes left out of the trace)
+	  TRACE_BIT_RATE     bit rate in kbps
+	  TRACE_UID          length, uid
+	  TRACE_PRESENCE     result (1 byte)
+	  TRACE_AUTO_POLL    result (1 byte)
+
+	@section  HISTORY
+
+	v1.1  - Random bytes can be left out of the trace
+	v1.0  - First definition
+*/
+/**************************************************************************/
+#ifndef CIE_TRACE
+#define CIE_TRACE
+
+#include <Arduino.h>
+
+#define TRACE_MAGIC                           ("CIET")
+#define TRACE_MAGIC_LENGTH                    (0x04)
+#define TRACE_VERSION                         (0x02)
+//Traces of older versions are a subset of this one
+#define TRACE_OLDEST_VERSION                  (0x01)
+#define TRACE_HEADER_LENGTH                   (TRACE_MAGIC_LENGTH + 1)
+
+//Record types
+#define TRACE_DETECT                          (0x01)
+#define TRACE_EXCHANGE                        (0x02)
+#define TRACE_RANDOM                          (0x03)
+#define TRACE_BIT_RATE                        (0x04)
+#define TRACE_UID                             (0x05)
+#define TRACE_PRESENCE                        (0x06)
+#define TRACE_AUTO_POLL                       (0x07)
+#define TRACE_REDACTED                        (0x08)
+
+//An unsigned long takes up to 5 bytes as a varint
+#define TRACE_MAX_VARINT_LENGTH               (0x05)
+
+#endif
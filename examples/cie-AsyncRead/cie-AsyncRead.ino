@@ -0,0 +1,81 @@
+/**************************************************************************/
+/*!
+  @file     CIE-AsyncRead.ino
+  @author   Developers italia
+  @license  BSD (see license)
+  This example will wait for a CIE card and read its ID_Servizi without
+  blocking the loop, so that a LED keeps blinking during the read.
+
+
+This is an example sketch for the Adafruit PN532 NFC/RFID breakout boards
+This library works with the Adafruit NFC breakout
+  ----> https://www.adafruit.com/products/364
+
+Check out the links above for our tutorials and wiring diagrams
+
+*/
+/**************************************************************************/
+#include <Wire.h>
+#include <SPI.h>
+#include <cie_PN532.h>
+
+// SPI communication is the only supported one at the moment
+#define PN532_SCK  (2)
+#define PN532_MOSI (3)
+#define PN532_SS   (4)
+#define PN532_MISO (5)
+
+#define BLINK_LED  (13)
+
+cie_PN532 cie(PN532_SCK, PN532_MISO, PN532_MOSI, PN532_SS);
+word bufferLength;
+byte buffer[EF_ID_SERVIZI_LENGTH];
+bool reading;
+unsigned long startedAt;
+
+void setup(void) {
+  #ifndef ESP8266
+    while (!Serial); // for Leonardo/Micro/Zero
+  #endif
+  Serial.begin(115200);
+  cie.begin();
+  //Uncomment this to output the APDU commands sent to the terminal
+  //cie.verbose = true;
+  pinMode(BLINK_LED, OUTPUT);
+  reading = false;
+}
+
+
+void loop(void) {
+  //This keeps running at its own pace, even while a card is being read
+  digitalWrite(BLINK_LED, (millis() / 50) % 2 ? HIGH : LOW);
+
+  if (!reading) {
+    if (!cie.detectCard()) {
+      return;
+    }
+    bufferLength = EF_ID_SERVIZI_LENGTH;
+    startedAt = millis();
+    reading = cie.startRead_EF_ID_Servizi(buffer, &bufferLength);
+    return;
+  }
+
+  //Each call sends at most one APDU command to the card
+  switch (cie.poll()) {
+    case POLL_IN_PROGRESS:
+      return;
+
+    case POLL_DONE:
+      Serial.print(F("EF.ID_Servizi: "));
+      cie.printHex(buffer, bufferLength);
+      Serial.print(F("Reading the ID_Servizi took "));
+      Serial.print(millis()-startedAt);
+      Serial.println(F("ms"));
+      break;
+
+    default:
+      Serial.println(F("Error reading EF.ID_SERVIZI"));
+      break;
+  }
+  reading = false;
+}
@@ -0,0 +1,174 @@
+/**************************************************************************/
+/*!
+  @file     CIE-Benchmark.ino
+  @author   Developers italia
+  @license  BSD (see license)
+  This example measures how much CPU time each tap takes, that is the
+  time not spent idling while the PN532 exchanges data with the card.
+
+  Run it twice: first with PN532_IRQ_LINE set to NO_IRQ (the PN532 status
+  is polled over SPI), then with the IRQ line connected to an interrupt
+  capable pin. The idle time is what the sketch could spend doing
+  something else (or sleeping).
+  Uncomment PN532_HARDWARE_SPI to compare the bit-banged SPI with the
+  hardware SPI peripheral (on the Arduino Uno: SCK 13, MISO 12, MOSI 11).
+  The tap latency is the time between the last detection that found no
+  card and the first APDU response. Comment PN532_AUTO_POLL to compare the
+  autonomous polling of the PN532 with InListPassiveTarget called every
+  POLL_PERIOD milliseconds by the sketch: the autonomous polling period of
+  the PN532 itself is not part of the measured latency.
+  Uncomment PN532_QUICK_IDENTIFY to measure the tap-to-ID latency of
+  identify() instead, which must stay within IDENTIFY_EXCHANGE_BUDGET
+  exchanges with the PN532.
+  Uncomment PN532_VERIFY to also check each card is not a clone, printing
+  the CPU cycles taken by the RSA verification of its signature.
+
+
+This is an example sketch for the Adafruit PN532 NFC/RFID breakout boards
+This library works with the Adafruit NFC breakout
+  ----> https://www.adafruit.com/products/364
+
+Check out the links above for our tutorials and wiring diagrams
+
+*/
+/**************************************************************************/
+#include <Wire.h>
+#include <SPI.h>
+#include <cie_PN532.h>
+
+// The IRQ line needs an interrupt capable pin (2 or 3 on the Arduino Uno),
+// so SCK moves from pin 2 to pin 6 in this example
+#define PN532_SCK  (6)
+#define PN532_MOSI (3)
+#define PN532_SS   (4)
+#define PN532_MISO (5)
+#define PN532_IRQ_LINE (PN532_IRQ) // Set this to NO_IRQ to measure the polling transport
+//#define PN532_HARDWARE_SPI
+#define PN532_AUTO_POLL
+//#define PN532_QUICK_IDENTIFY
+//#define PN532_VERIFY
+#define POLL_PERIOD (150)
+
+#define TAPS       (10)
+
+#ifdef PN532_HARDWARE_SPI
+cie_Nfc_SPI *nfc = new cie_Nfc_SPI(PN532_SS, PN532_IRQ_LINE);
+#else
+cie_Nfc_SPI *nfc = new cie_Nfc_SPI(PN532_SCK, PN532_MISO, PN532_MOSI, PN532_SS, PN532_IRQ_LINE);
+#endif
+cie_PN532 cie(nfc);
+unsigned long idleMicros;
+unsigned long totalMicros;
+unsigned long busyMicros;
+unsigned long latencyMillis;
+unsigned long missedAt;
+bool fieldWasEmpty;
+byte taps;
+
+void idle() {
+  //Here the sketch could do anything else. We just account for the time we've been given
+  unsigned long startedAt = micros();
+  delayMicroseconds(100);
+  idleMicros += micros() - startedAt;
+}
+
+void setup(void) {
+  #ifndef ESP8266
+    while (!Serial); // for Leonardo/Micro/Zero
+  #endif
+  Serial.begin(115200);
+  cie.begin();
+  nfc->setIdleCallback(idle);
+  taps = 0;
+  totalMicros = 0;
+  busyMicros = 0;
+  latencyMillis = 0;
+  #ifdef PN532_AUTO_POLL
+    cie.startAutoPoll(POLL_PERIOD);
+  #endif
+  fieldWasEmpty = false;
+}
+
+
+void loop(void) {
+  #ifdef PN532_QUICK_IDENTIFY
+    word idLength = EF_ID_SERVIZI_LENGTH;
+    byte id[EF_ID_SERVIZI_LENGTH];
+    bool detected = cie.identify(id, &idLength);
+  #else
+    bool detected = cie.detectCard();
+  #endif
+  if (!detected) {
+    missedAt = millis();
+    fieldWasEmpty = true;
+    #ifndef PN532_AUTO_POLL
+      delay(POLL_PERIOD);
+    #endif
+    return;
+  }
+  if (!fieldWasEmpty) {
+    //Still the same tap, the card hasn't left the field yet
+    delay(POLL_PERIOD);
+    return;
+  }
+  fieldWasEmpty = false;
+
+  #ifdef PN532_QUICK_IDENTIFY
+    //The ID has already been read
+    bool success = true;
+  #else
+    //The first APDU is the SN_ICC read, which also tells one card from another
+    word snLength = EF_SN_ICC_LENGTH;
+    byte sn[EF_SN_ICC_LENGTH];
+    bool success = cie.read_EF_SN_ICC(sn, &snLength);
+  #endif
+  unsigned long latency = millis() - missedAt;
+  word apdus = cie.getApduCount();
+
+  word bufferLength = EF_ID_SERVIZI_LENGTH;
+  byte buffer[EF_ID_SERVIZI_LENGTH];
+  idleMicros = 0;
+  unsigned long startedAt = micros();
+  success = success && cie.read_EF_ID_Servizi(buffer, &bufferLength);
+  unsigned long elapsed = micros() - startedAt;
+  if (!success) {
+    Serial.println(F("Error reading EF.SN_ICC or EF.ID_SERVIZI"));
+    return;
+  }
+
+  taps++;
+  totalMicros += elapsed;
+  busyMicros += elapsed - idleMicros;
+  latencyMillis += latency;
+  Serial.print(F("Tap "));
+  Serial.print(taps);
+  Serial.print(F(": "));
+  Serial.print(latency);
+  Serial.print(F(" ms tap latency ("));
+  Serial.print(apdus);
+  Serial.print(F(" APDUs), "));
+  Serial.print(elapsed);
+  Serial.print(F(" us total, "));
+  Serial.print(elapsed - idleMicros);
+  Serial.println(F(" us of CPU time"));
+  #ifdef PN532_VERIFY
+    bool valid = cie.isCardValid();
+    Serial.print(valid ? F("Valid card, ") : F("Invalid card, "));
+    Serial.print(cie.getVerificationCycles());
+    Serial.println(F(" cycles to verify its signature"));
+  #endif
+
+  if (taps == TAPS) {
+    Serial.print(F("Average per tap: "));
+    Serial.print(latencyMillis / TAPS);
+    Serial.print(F(" ms tap latency, "));
+    Serial.print(totalMicros / TAPS);
+    Serial.print(F(" us total, "));
+    Serial.print(busyMicros / TAPS);
+    Serial.println(F(" us of CPU time"));
+    taps = 0;
+    totalMicros = 0;
+    busyMicros = 0;
+    latencyMillis = 0;
+  }
+}
@@ -0,0 +1,62 @@
+/**************************************************************************/
+/*!
+  @file     CIE-HashBenchmark.ino
+  @author   Developers italia
+  @license  BSD (see license)
+  This example measures how many CPU cycles per byte SHA-1 and SHA-256
+  take on this board, i.e. what hashed reads (hashElementaryFile) add to
+  the time spent on each page. No card is needed.
+
+  On the Arduino Uno the cycles come from micros() and have a 4us (64
+  cycles) resolution, so a large buffer is hashed a few times. On AVR the
+  compact implementations are used: define CIE_HASH_COMPACT to 0 or 1
+  in cie_Hash.h to compare both of them on other boards.
+  The sketch also builds on Linux hosts, see extras/host.
+
+*/
+/**************************************************************************/
+#include <cie_Cycles.h>
+#include <cie_Sha1.h>
+#include <cie_Sha256.h>
+
+//A page of READ BINARY
+#define BENCHMARK_LENGTH (0xE4)
+#define BENCHMARK_ROUNDS (16)
+
+byte data[BENCHMARK_LENGTH];
+
+void benchmark(const __FlashStringHelper *name, cie_Hash *hash) {
+  byte digest[HASH_MAX_DIGEST_LENGTH];
+  unsigned long startedAt = cie_cycles();
+  hash->begin();
+  for (byte i = 0; i < BENCHMARK_ROUNDS; i++) {
+    hash->update(data, BENCHMARK_LENGTH);
+  }
+  hash->finish(digest);
+  unsigned long cycles = cie_cycles() - startedAt;
+  Serial.print(name);
+  Serial.print(F(": "));
+  Serial.print(cycles / ((unsigned long) BENCHMARK_LENGTH * BENCHMARK_ROUNDS));
+  Serial.println(F(" cycles/byte"));
+}
+
+void setup(void) {
+  #ifndef ESP8266
+    while (!Serial); // for Leonardo/Micro/Zero
+  #endif
+  Serial.begin(115200);
+  for (word i = 0; i < BENCHMARK_LENGTH; i++) {
+    data[i] = (byte) i;
+  }
+  Serial.print(F("Compact implementations: "));
+  Serial.println(CIE_HASH_COMPACT ? F("yes") : F("no"));
+}
+
+
+void loop(void) {
+  cie_Sha1 sha1;
+  cie_Sha256 sha256;
+  benchmark(F("SHA-1"), &sha1);
+  benchmark(F("SHA-256"), &sha256);
+  delay(5000);
+}
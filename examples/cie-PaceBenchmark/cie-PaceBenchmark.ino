@@ -0,0 +1,77 @@
+/**************************************************************************/
+/*!
+  @file     CIE-PaceBenchmark.ino
+  @author   Developers italia
+  @license  BSD (see license)
+  This example measures how many CPU cycles the elliptic curve operations
+  of PACE (establishPace) take on this board, on both the curves a card
+  may choose. No card is needed.
+
+  The terminal side of PACE takes two multiplications of the generator
+  (the mapping key and the ephemeral key, on the mapped generator), two
+  multiplications of a point received from the card and the mapping of
+  the generator: the estimate adds them up, hashes and AES are negligible.
+  Define CIE_RSA_LIMB_BITS (8, 32 or 64) to compare the limb widths: on
+  8-bit boards PACE takes more than ten seconds, 32-bit boards are recommended.
+  The sketch also builds on Linux hosts, see extras/host.
+
+*/
+/**************************************************************************/
+#include <cie_Cycles.h>
+#include <cie_Ecc.h>
+
+//The nonce of PACE is one AES block
+#define BENCHMARK_NONCE_LENGTH (0x10)
+
+byte scalar[ECC_SCALAR_LENGTH];
+byte nonce[BENCHMARK_NONCE_LENGTH];
+
+unsigned long report(const __FlashStringHelper *name, cie_Ecc *ecc) {
+  Serial.print(F("  "));
+  Serial.print(name);
+  Serial.print(F(": "));
+  Serial.print(ecc->getCycles());
+  Serial.println(F(" cycles"));
+  return ecc->getCycles();
+}
+
+void benchmark(const __FlashStringHelper *name, const byte curve) {
+  cie_Ecc ecc;
+  byte point[ECC_POINT_LENGTH];
+  byte product[ECC_POINT_LENGTH];
+  unsigned long total = 0;
+  ecc.setCurve(curve);
+  Serial.println(name);
+  ecc.multiply(scalar, NULL, point);
+  total += 2 * report(F("Generator multiplication"), &ecc);
+  ecc.multiply(scalar, point, product);
+  total += 2 * report(F("Point multiplication"), &ecc);
+  ecc.mapGenerator(nonce, BENCHMARK_NONCE_LENGTH, product);
+  total += report(F("Generator mapping"), &ecc);
+  Serial.print(F("  PACE estimate: "));
+  Serial.print(total);
+  Serial.println(F(" cycles"));
+}
+
+void setup(void) {
+  #ifndef ESP8266
+    while (!Serial); // for Leonardo/Micro/Zero
+  #endif
+  Serial.begin(115200);
+  //Any scalar less than the order of both curves
+  for (byte i = 0; i < ECC_SCALAR_LENGTH; i++) {
+    scalar[i] = 0x5A ^ i;
+  }
+  for (byte i = 0; i < BENCHMARK_NONCE_LENGTH; i++) {
+    nonce[i] = 0xC0 + i;
+  }
+  Serial.print(F("Limb bits: "));
+  Serial.println(RSA_LIMB_BITS);
+}
+
+
+void loop(void) {
+  benchmark(F("NIST P-256"), ECC_CURVE_NIST_P256);
+  benchmark(F("brainpoolP256r1"), ECC_CURVE_BRAINPOOL_P256R1);
+  delay(5000);
+}
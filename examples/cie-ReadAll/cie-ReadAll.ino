@@ -43,6 +43,8 @@ void setup(void) {
   cie.begin();
   //Uncomment this to output the APDU commands sent to the terminal
   //cie.verbose = true;
+  //Measure the peak stack and heap usage of each read
+  cie.setMemoryProbe(true);
 }
 
 
@@ -124,6 +126,12 @@ void readKey(readKeyFunc func, const char *name) {
 }
 
 void printFreeMemory() {
+  cie_MemoryUsage usage = cie.getMemoryUsage();
+  Serial.print(F("The read took up to "));
+  Serial.print(usage.stack);
+  Serial.print(usage.stackOverflowed ? F(" bytes of stack (or more) and ") : F(" bytes of stack and "));
+  Serial.print(usage.heap);
+  Serial.println(F(" bytes of heap"));
   Serial.print(F("We have "));
   Serial.print(freeRam());
   Serial.println(F(" bytes of memory left"));
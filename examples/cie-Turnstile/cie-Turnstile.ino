@@ -52,6 +52,8 @@ void setup(void) {
   cie.begin();  
   //Uncomment this to output the APDU commands sent to the terminal
   //cie.verbose = true;
+  //The same card won't open the turnstile twice within 10 seconds, even if it rests on the reader
+  cie.setHoldOff(10000);
 
   matrix.begin(0x70);
   count = 0;
@@ -69,19 +71,15 @@ void setup(void) {
 
 void loop(void) {
   
-  bool cardDetected = cie.detectCard();
-  if (!cardDetected) {
-    //No card present, we wait for one
-    delay(100);
-    return;
-  }
-
-  //Good! A card is present, let's read the ID!
+  //Detection and reading of the ID in just three exchanges with the PN532
   word bufferLength = EF_ID_SERVIZI_LENGTH;
   byte buffer[EF_ID_SERVIZI_LENGTH];
-  if (!cie.read_EF_ID_Servizi(buffer, &bufferLength)) {
-    Serial.print(F("Error reading EF.ID_SERVIZI"));
-    blinkRedLed();
+  if (!cie.identify(buffer, &bufferLength)) {
+    if (cie.getApduCount() > 0 && !cie.isRepeatedTap()) {
+      Serial.print(F("Error reading EF.ID_SERVIZI"));
+      blinkRedLed();
+    }
+    //No card present (or the same one again), we wait for a new one
     delay(100);
     return;
   }
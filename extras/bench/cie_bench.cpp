@@ -0,0 +1,143 @@
+/**************************************************************************/
+/*!
+    @file     cie_bench.cpp
+    @author   Developers Italia
+    @license  BSD (see License)
+
+	Measures each high-level operation of cie_PN532 on the host, against a card living in
+	the same process: APDU commands, bytes moved (commands and responses) and time per operation,
+	split between the reader (the library) and the card (the emulator and its latency model).
+	Every operation starts from a fresh tap, so the selections it needs are part of its cost.
+	Usage: cie_bench [iterations [frameMicros byteMicros]], where the latency of the card defaults to none
+
+	@section  HISTORY
+
+	v1.1  - Against cie_Nfc_Emulator, with its latency model
+	v1.0  - read_EF_* wrappers, parse_EF_SOD and isCardValid
+*/
+/**************************************************************************/
+#include <Arduino.h>
+#include <cie_PN532.h>
+#include <cie_Nfc_Emulator.h>
+#include <chrono>
+#include "cie_SodFixture.h"
+
+#define BENCH_DEFAULT_ITERATIONS              (1000)
+
+typedef bool (*cieBenchOperationFunc)(cie_PN532 *cie);
+
+static bool benchReadSnIcc(cie_PN532 *cie) {
+  byte buffer[EF_SN_ICC_LENGTH];
+  word length = sizeof(buffer);
+  return cie->read_EF_SN_ICC(buffer, &length);
+}
+
+static bool benchReadIdServizi(cie_PN532 *cie) {
+  byte buffer[EF_ID_SERVIZI_LENGTH];
+  word length = sizeof(buffer);
+  return cie->read_EF_ID_Servizi(buffer, &length);
+}
+
+static bool benchReadDh(cie_PN532 *cie) {
+  byte buffer[0x200];
+  word length = sizeof(buffer);
+  return cie->read_EF_DH(buffer, &length);
+}
+
+static bool benchReadAtr(cie_PN532 *cie) {
+  byte buffer[0x100];
+  word length = sizeof(buffer);
+  return cie->read_EF_ATR(buffer, &length);
+}
+
+static bool benchReadIntKpub(cie_PN532 *cie) {
+  cie_Key key;
+  return cie->read_EF_Int_Kpub(&key);
+}
+
+static bool benchReadServiziIntKpub(cie_PN532 *cie) {
+  cie_Key key;
+  return cie->read_EF_Servizi_Int_Kpub(&key);
+}
+
+static bool countTriple(cie_BerTriple *triple) {
+  return true;
+}
+
+static bool benchParseSod(cie_PN532 *cie) {
+  return cie->parse_EF_SOD(countTriple);
+}
+
+static bool benchIsCardValid(cie_PN532 *cie) {
+  return cie->isCardValid();
+}
+
+struct cie_BenchOperation {
+  const char *name;
+  cieBenchOperationFunc run;
+};
+
+static const cie_BenchOperation operations[] = {
+  { "read_EF_SN_ICC", benchReadSnIcc },
+  { "read_EF_ID_Servizi", benchReadIdServizi },
+  { "read_EF_DH", benchReadDh },
+  { "read_EF_ATR", benchReadAtr },
+  { "read_EF_Int_Kpub", benchReadIntKpub },
+  { "read_EF_Servizi_Int_Kpub", benchReadServiziIntKpub },
+  { "parse_EF_SOD", benchParseSod },
+  { "isCardValid", benchIsCardValid }
+};
+
+
+/**************************************************************************/
+/*!
+  @brief  Runs each operation the given number of times, each one on a fresh tap, and prints
+          the APDU commands, the bytes and the nanoseconds per operation
+
+  @returns  Zero when every operation succeeded every time
+*/
+/**************************************************************************/
+int main(int argc, char **argv) {
+  long iterations = argc > 1 ? atol(argv[1]) : BENCH_DEFAULT_ITERATIONS;
+  if (iterations <= 0 || argc == 3) {
+    fprintf(stderr, "Usage: %s [iterations [frameMicros byteMicros]]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  //The card belongs to cie_PN532, which deletes it
+  cie_Nfc_Emulator *card = new cie_Nfc_Emulator();
+  card->addFile(CIE_DF, 0x1006, 0x06, testSod, TEST_SOD_LENGTH);
+  if (argc > 3) {
+    card->setLatency(atol(argv[2]), atol(argv[3]));
+  }
+  cie_PN532 cie(card);
+  cie.begin();
+
+  int failures = 0;
+  printf("%-26s %10s %10s %12s %12s\n", "operation", "APDUs/op", "bytes/op", "ns/op", "card ns/op");
+  for (const cie_BenchOperation &operation : operations) {
+    unsigned long apdus = 0;
+    unsigned long bytes = 0;
+    unsigned long long cardNanos = 0;
+    std::chrono::steady_clock::duration elapsed(0);
+    bool success = true;
+    for (long i = 0; i < iterations && success; i++) {
+      cie.detectCard();
+      card->resetCounters();
+      std::chrono::steady_clock::time_point startedAt = std::chrono::steady_clock::now();
+      success = operation.run(&cie);
+      elapsed += std::chrono::steady_clock::now() - startedAt;
+      apdus += card->getCommandCount();
+      bytes += card->getBytesExchanged();
+      cardNanos += card->getCardNanos();
+    }
+    if (!success) {
+      printf("%-26s failed\n", operation.name);
+      failures++;
+      continue;
+    }
+    long long nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() - cardNanos;
+    printf("%-26s %10.1f %10.1f %12lld %12llu\n", operation.name, (double) apdus / iterations, (double) bytes / iterations,
+      nanos / iterations, cardNanos / iterations);
+  }
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,615 @@
+/**************************************************************************/
+/*!
+    @file     cie_Nfc_Emulator.cpp
+    @author   Developers Italia
+    @license  BSD (see License)
+
+	A CIE emulated in software, placed in the field of a cie_Nfc transport
+
+	@section  HISTORY
+
+	v1.1  - Time taken by the card to answer the last command
+	v1.0  - File system, READ BINARY, MSE SET, INTERNAL AUTHENTICATE and the latency model
+*/
+/**************************************************************************/
+#include "cie_Nfc_Emulator.h"
+#include <time.h>
+
+#define PN532DEBUGPRINT Serial
+
+//A 2048-bit test key (not a CIE one) with public exponent 65537, whose private exponent is short enough for cie_Rsa
+static const byte testKeyModulus[] = {
+  0xA5, 0x7E, 0xDA, 0x22, 0xEB, 0x82, 0xAD, 0x5E, 0xE4, 0x87, 0xF8, 0x39, 0x1A, 0x7C, 0xB5, 0xEB,
+  0x2E, 0xBB, 0x80, 0xFD, 0x2E, 0x9E, 0xC4, 0xFB, 0x7E, 0x1D, 0xA9, 0xF5, 0x8F, 0x20, 0xD6, 0x56,
+  0x59, 0xD5, 0xB4, 0xFF, 0x24, 0x94, 0xFC, 0xD0, 0x33, 0x05, 0x26, 0xF8, 0x40, 0x24, 0x16, 0x45,
+  0xA6, 0xFE, 0xFF, 0x9A, 0x17, 0xB0, 0x32, 0xC5, 0x8B, 0xA7, 0x42, 0x62, 0x22, 0xA8, 0xD6, 0x91,
+  0x7A, 0xCA, 0x59, 0xD3, 0x9B, 0xCB, 0x16, 0xFA, 0x6B, 0x7E, 0x45, 0xF6, 0xDD, 0x65, 0x7C, 0xC4,
+  0xD7, 0xBF, 0x95, 0x2E, 0x43, 0xAE, 0x0E, 0xDF, 0xDA, 0xE5, 0xD7, 0x02, 0xA9, 0x52, 0xD6, 0x54,
+  0x23, 0xBF, 0x06, 0xC9, 0xA7, 0x00, 0x09, 0x4E, 0x5D, 0x37, 0x84, 0x58, 0x1A, 0x14, 0xA2, 0x54,
+  0xD8, 0xE0, 0xB2, 0x50, 0xEF, 0x95, 0x82, 0xA3, 0x95, 0x96, 0x62, 0x3C, 0xE8, 0xC7, 0x55, 0x91,
+  0x86, 0xC1, 0xDC, 0xA5, 0x8C, 0x94, 0xB1, 0x21, 0x5C, 0x85, 0x1E, 0xB1, 0x5F, 0x8F, 0x25, 0xD4,
+  0x6A, 0xDC, 0x09, 0x54, 0xCD, 0xD5, 0xD0, 0xFD, 0xD3, 0xD6, 0xEA, 0xC8, 0x8C, 0xF1, 0x00, 0x1C,
+  0x5C, 0xD3, 0x28, 0x23, 0xF8, 0x4F, 0xD0, 0x66, 0xAD, 0xF0, 0x87, 0x57, 0x8D, 0x97, 0xF8, 0x1E,
+  0x29, 0xF1, 0x13, 0x25, 0x9D, 0x4B, 0x6C, 0x25, 0xED, 0xA5, 0xE7, 0x37, 0x23, 0x3B, 0x52, 0x90,
+  0xB9, 0xEF, 0x20, 0x84, 0xB5, 0xB1, 0x25, 0xA7, 0x32, 0xF4, 0x86, 0x42, 0x63, 0x41, 0xBA, 0x11,
+  0x88, 0x61, 0x89, 0x3D, 0xCF, 0x2A, 0x3F, 0x7B, 0x9B, 0x14, 0xD7, 0x12, 0x35, 0x7D, 0xA4, 0xCC,
+  0xFE, 0x1C, 0x2E, 0x96, 0x4C, 0x00, 0xE8, 0x81, 0x00, 0x88, 0x21, 0xD9, 0xA7, 0xB6, 0x44, 0x2F,
+  0xB9, 0xC8, 0x45, 0xE0, 0x4B, 0xA6, 0x25, 0x41, 0x03, 0x1F, 0x09, 0x32, 0x73, 0x08, 0x76, 0x1D
+};
+static const byte testKeyPrivateExponent[] = {
+  0x5E, 0xD0, 0x4E, 0x29, 0x08, 0xC4, 0x7F, 0xE4, 0x88, 0x5E, 0xB3, 0x2C, 0xAE, 0xAA, 0xC4, 0x39,
+  0x4E, 0x8C, 0xC8, 0xAE, 0xEF, 0x5C, 0x06, 0xD4, 0x0E, 0xC2, 0x45, 0x47, 0xBF, 0x63, 0x10, 0xBE,
+  0x68, 0x0E, 0xB2, 0x4E, 0x25, 0x51, 0xE0, 0xDA, 0xBC, 0x60, 0x37, 0x48, 0xAD, 0x76, 0xA9, 0xF6,
+  0x93, 0x0B, 0x84, 0xBA, 0x18, 0xD8, 0x2E, 0xE8, 0xFE, 0x6E, 0xD4, 0xEE, 0xB9, 0x97, 0x56, 0xAC,
+  0x02, 0x57, 0xEB, 0xC9, 0x50, 0x23, 0x0A, 0x5C, 0x6D, 0xE3, 0xEA, 0x31, 0x84, 0xA5, 0xF5, 0x80,
+  0x26, 0x1A, 0xF2, 0x07, 0x8F, 0x69, 0x7E, 0x71, 0x6C, 0x4C, 0xEC, 0x37, 0x44, 0xCA, 0xDB, 0x55,
+  0x59, 0x25, 0x6D, 0x68, 0xC4, 0xEF, 0x40, 0x65, 0xA5, 0x02, 0x29, 0x7A, 0xFA, 0xCB, 0x82, 0x35,
+  0x1A, 0x0B, 0xA1, 0x72, 0xBD, 0x25, 0x95, 0xB2, 0xCD, 0x56, 0x05, 0x9C, 0xDF, 0xBF, 0xFE, 0x9A,
+  0x73, 0x7C, 0x7A, 0x33, 0x96, 0xE8, 0x5C, 0xDD, 0x82, 0x1F, 0x58, 0xC5, 0x9F, 0xD3, 0x13, 0xF7,
+  0x99, 0x8C, 0x2A, 0x6B, 0x4C, 0xAF, 0x0C, 0xC6, 0xC8, 0xD6, 0x1F, 0x39, 0xE2, 0x34, 0x79, 0xAF,
+  0x36, 0x23, 0xD0, 0x0D, 0x4C, 0xE7, 0xEF, 0xA5, 0xB3, 0x1C, 0x66, 0xC9, 0x67, 0x1B, 0xA3, 0x18,
+  0x6C, 0xDE, 0x5E, 0x22, 0xC7, 0xE8, 0x1A, 0x8E, 0x3B, 0x8F, 0x60, 0xC1, 0x75, 0x06, 0xEA, 0x2C,
+  0x58, 0xC3, 0x70, 0x0D, 0x47, 0x24, 0x7C, 0xEB, 0xE8, 0x6C, 0x78, 0x7E, 0x36, 0xF9, 0x39, 0x01,
+  0x67, 0x6A, 0x00, 0x7A, 0xE6, 0xB2, 0xE2, 0x87, 0x6C, 0xC4, 0xC6, 0xB1, 0x93, 0xDA, 0x27, 0xBD,
+  0xE5, 0x7F, 0x14, 0xD9, 0x85, 0xF8, 0x79, 0xBE, 0x1F, 0x97, 0x73, 0x5F, 0xDD, 0xBB, 0x94, 0x20,
+  0xB6, 0x2C, 0xA6, 0xDF, 0x0C, 0x36, 0xF5, 0x73, 0x16, 0x3E, 0xF9, 0x87, 0x87, 0xF2, 0x61
+};static const byte testKeyPublicExponent[] = { 0x01, 0x00, 0x01 };
+
+//IAS ECC application and CIE DF, as selected by their AID
+static const byte iasAid[] = { 0xA0, 0x00, 0x00, 0x00, 0x30, 0x80, 0x00, 0x00, 0x00, 0x09, 0x81, 0x60, 0x01 };
+static const byte cieAid[] = { 0xA0, 0x00, 0x00, 0x00, 0x00, 0x39 };
+
+static unsigned long long monotonicNanos() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Create a card in the field, with the files of a CIE and no latency
+*/
+/**************************************************************************/
+cie_Nfc_Emulator::cie_Nfc_Emulator() :
+_fileCount(0),
+_currentDedicatedFile(NULL_DF),
+_currentElementaryFile(NULL),
+_keySelected(false),
+_present(true),
+_frameMicros(0),
+_byteMicros(0),
+_commandCount(0),
+_bytesExchanged(0),
+_cardNanos(0),
+_lastCardNanos(0)
+{
+  memset(_uid, 0, CARD_EMULATOR_UID_LENGTH);
+  createFiles();
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Does nothing, the card needs no initialization
+*/
+/**************************************************************************/
+void cie_Nfc_Emulator::begin() {
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Activates the card, if it's in the field: nothing is selected anymore and it gets a new random UID
+
+  @returns  A boolean value indicating whether the card is in the field or not
+*/
+/**************************************************************************/
+bool cie_Nfc_Emulator::detectCard() {
+  if (!_present) {
+    return false;
+  }
+  _currentDedicatedFile = NULL_DF;
+  _currentElementaryFile = NULL;
+  _keySelected = false;
+  //Random UIDs are single size and start with 0x08
+  _uid[0] = 0x08;
+  generateRandomBytes(_uid, 1, CARD_EMULATOR_UID_LENGTH - 1);
+  return true;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Answers an APDU command, taking as long as the latency model says
+
+  @param  command A pointer to the APDU command bytes
+  @param  commandLength Length of the command
+  @param  response A pointer to the buffer which will contain the response bytes
+  @param  responseLength The length of the response buffer, then the length of the response
+
+  @returns  A boolean value indicating whether the card answered or not
+*/
+/**************************************************************************/
+bool cie_Nfc_Emulator::sendCommand(byte *command, byte commandLength, byte *response, word *responseLength) {
+  if (!_present || commandLength < 4) {
+    return false;
+  }
+  unsigned long long startedAt = monotonicNanos();
+  //Answers are written to a buffer large enough for any of them, the caller may expect a shorter one
+  byte answerBuffer[CARD_EMULATOR_KEY_LENGTH + STATUS_WORD_LENGTH];
+  word length = answer(command, commandLength, answerBuffer);
+  _commandCount++;
+  _bytesExchanged += commandLength + length;
+  if (_frameMicros > 0 || _byteMicros > 0) {
+    delayMicroseconds(_frameMicros + _byteMicros * (commandLength + length));
+  }
+  _lastCardNanos = monotonicNanos() - startedAt;
+  _cardNanos += _lastCardNanos;
+  if (length > *responseLength) {
+    PN532DEBUGPRINT.println(F("The response doesn't fit the response buffer"));
+    return false;
+  }
+  memcpy(response, answerBuffer, length);
+  *responseLength = length;
+  return true;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Populates a buffer with random bytes
+
+  @param  buffer The pointer to a byte array
+  @param  offset The starting offset in the buffer
+  @param  length The number of random bytes to generate
+*/
+/**************************************************************************/
+void cie_Nfc_Emulator::generateRandomBytes(byte *buffer, const word offset, const byte length) {
+  for (word i = offset; i < offset + length; i++) {
+    buffer[i] = (byte) random(0x100);
+  }
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Gets the UID of the activated card, a random one like the CIE's
+
+  @param  uidBuffer The pointer to a buffer of at least CARD_EMULATOR_UID_LENGTH bytes
+
+  @returns  The length of the UID, zero if the card is not in the field
+*/
+/**************************************************************************/
+byte cie_Nfc_Emulator::getUid(byte *uidBuffer) {
+  if (!_present) {
+    return 0;
+  }
+  memcpy(uidBuffer, _uid, CARD_EMULATOR_UID_LENGTH);
+  return CARD_EMULATOR_UID_LENGTH;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Tells whether the card is still in the field
+
+  @returns  A boolean value indicating whether the card is in the field or not
+*/
+/**************************************************************************/
+bool cie_Nfc_Emulator::isCardPresent() {
+  return _present;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Adds an elementary file, or replaces the content of the one with the same EFID. The content is not copied
+
+  @param  df The parent Dedicated File (either ROOT_MF or CIE_DF)
+  @param  efid The file identifier
+  @param  sfi The short file identifier, or zeroes if the file can't be read by SFI
+  @param  content The pointer to the content, which must outlive the emulator
+  @param  length The length of the content
+
+  @returns  A boolean value indicating whether the file was added or not
+*/
+/**************************************************************************/
+bool cie_Nfc_Emulator::addFile(const byte df, const word efid, const byte sfi, const byte *content, const word length) {
+  for (byte i = 0; i < _fileCount; i++) {
+    if (_files[i].df == df && _files[i].efid == efid) {
+      _files[i].sfi = sfi;
+      _files[i].content = content;
+      _files[i].length = length;
+      return true;
+    }
+  }
+  if (_fileCount == CARD_EMULATOR_MAX_FILES) {
+    PN532DEBUGPRINT.println(F("Too many files in the emulated card"));
+    return false;
+  }
+  cie_EmulatedFile file = { df, efid, sfi, content, length };
+  _files[_fileCount++] = file;
+  return true;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Places the card in the field or takes it away
+
+  @param  present Whether the card should be detected or not
+*/
+/**************************************************************************/
+void cie_Nfc_Emulator::setCardPresent(const bool present) {
+  _present = present;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Sets how long each exchange takes: a fixed time per frame plus a time per byte, commands and responses alike
+         (e.g. CARD_EMULATOR_FRAME_MICROS_106 and CARD_EMULATOR_BYTE_MICROS_106)
+
+  @param  frameMicros The time per exchange in microseconds
+  @param  byteMicros The time per byte in microseconds
+*/
+/**************************************************************************/
+void cie_Nfc_Emulator::setLatency(const unsigned long frameMicros, const unsigned long byteMicros) {
+  _frameMicros = frameMicros;
+  _byteMicros = byteMicros;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Counts the APDU commands answered since the creation or the last resetCounters()
+
+  @returns  The number of APDU commands
+*/
+/**************************************************************************/
+unsigned long cie_Nfc_Emulator::getCommandCount() {
+  return _commandCount;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Counts the bytes of the APDU commands and of their responses since the last resetCounters()
+
+  @returns  The number of bytes
+*/
+/**************************************************************************/
+unsigned long cie_Nfc_Emulator::getBytesExchanged() {
+  return _bytesExchanged;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Gets the time spent by the card answering the last command
+
+  @returns  The time in microseconds
+*/
+/**************************************************************************/
+unsigned long cie_Nfc_Emulator::getCardMicros() {
+  return _lastCardNanos / 1000;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Gets the time spent by the card since the last resetCounters(): answering, the RSA private key operation
+         above all, and waiting as the latency model says. The rest of the time is the reader's
+
+  @returns  The time in nanoseconds
+*/
+/**************************************************************************/
+unsigned long long cie_Nfc_Emulator::getCardNanos() {
+  return _cardNanos;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Starts counting APDU commands, bytes and time from zero
+*/
+/**************************************************************************/
+void cie_Nfc_Emulator::resetCounters() {
+  _commandCount = 0;
+  _bytesExchanged = 0;
+  _cardNanos = 0;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Answers an APDU command
+
+  @param  command A pointer to the APDU command bytes
+  @param  commandLength Length of the command
+  @param  response A pointer to a buffer of CARD_EMULATOR_KEY_LENGTH + STATUS_WORD_LENGTH bytes
+
+  @returns  The length of the response, status word included
+*/
+/**************************************************************************/
+word cie_Nfc_Emulator::answer(const byte *command, const byte commandLength, byte *response) {
+  if (command[0] != 0x00) {
+    //Class not supported: no secure messaging here
+    return status(0x6E00, response, 0);
+  }
+  switch (command[1]) {
+    case 0xA4:
+      return select(command, commandLength, response);
+
+    case 0xB1:
+      return readBinary(command, commandLength, response);
+
+    case 0x22:
+      return setSecurityEnvironment(command, commandLength, response);
+
+    case 0x88:
+      return internalAuthenticate(command, commandLength, response);
+
+    default:
+      //Instruction not supported
+      return status(0x6D00, response, 0);
+  }
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Answers SELECT FILE: the IAS application or the CIE DF by AID, the MF, or an elementary file by EFID
+
+  @returns  The length of the response
+*/
+/**************************************************************************/
+word cie_Nfc_Emulator::select(const byte *command, const byte commandLength, byte *response) {
+  if (commandLength < 5 || commandLength < 5 + command[4]) {
+    return status(0x6700, response, 0);
+  }
+  const byte *data = command + 5;
+  byte dataLength = command[4];
+  switch (command[2]) {
+    case 0x04: //By AID
+      if (dataLength == sizeof(iasAid) && memcmp(data, iasAid, sizeof(iasAid)) == 0) {
+        //The IAS application is the MF
+        _currentDedicatedFile = ROOT_MF;
+      } else if (dataLength == sizeof(cieAid) && memcmp(data, cieAid, sizeof(cieAid)) == 0) {
+        _currentDedicatedFile = CIE_DF;
+      } else {
+        return status(0x6A82, response, 0);
+      }
+    break;
+
+    case 0x00: //The MF by its identifier
+      if (dataLength != 2 || data[0] != 0x3F || data[1] != 0x00) {
+        return status(0x6A82, response, 0);
+      }
+      _currentDedicatedFile = ROOT_MF;
+    break;
+
+    case 0x02: { //An EF by its EFID, under the current DF
+      const cie_EmulatedFile *file = dataLength == 2 ? findFile(data[0] << 8 | data[1], 0x00) : NULL;
+      if (file == NULL) {
+        return status(0x6A82, response, 0);
+      }
+      _currentElementaryFile = file;
+      return status(0x9000, response, 0);
+    }
+
+    default:
+      return status(0x6A86, response, 0);
+  }
+  _currentElementaryFile = NULL;
+  _keySelected = false;
+  return status(0x9000, response, 0);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Answers READ BINARY with ODD INS: the offset comes in a 0x54 data object and the content in a 0x53 one.
+         A short file identifier in P2 selects the file, zeroes read the current one
+
+  @returns  The length of the response
+*/
+/**************************************************************************/
+word cie_Nfc_Emulator::readBinary(const byte *command, const byte commandLength, byte *response) {
+  if (commandLength != 10 || command[4] != 0x04 || command[5] != 0x54 || command[6] != 0x02) {
+    return status(0x6700, response, 0);
+  }
+  byte sfi = command[3] & 0b11111;
+  if (sfi != 0x00) {
+    const cie_EmulatedFile *file = findFile(0x0000, sfi);
+    if (file == NULL) {
+      return status(0x6A82, response, 0);
+    }
+    _currentElementaryFile = file;
+  }
+  if (_currentElementaryFile == NULL) {
+    //Command not allowed, no current EF
+    return status(0x6986, response, 0);
+  }
+  word offset = command[7] << 8 | command[8];
+  if (offset >= _currentElementaryFile->length) {
+    return status(0x6B00, response, 0);
+  }
+  //Le counts the preamble octets of the 0x53 data object too
+  byte le = command[9];
+  byte preambleOctets = le > 0x82 ? 3 : 2;
+  word contentLength = le > preambleOctets ? le - preambleOctets : 0;
+  //The end of the file comes first: fewer bytes and a warning
+  word statusWord = 0x9000;
+  if (offset + contentLength > _currentElementaryFile->length) {
+    contentLength = _currentElementaryFile->length - offset;
+    statusWord = 0x6282;
+  }
+  word length = 0;
+  response[length++] = 0x53;
+  if (preambleOctets == 3) {
+    response[length++] = 0x81;
+  }
+  response[length++] = contentLength;
+  memcpy(response + length, _currentElementaryFile->content + offset, contentLength);
+  return status(statusWord, response, length + contentLength);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Answers MSE SET with an AT template: the key for INTERNAL AUTHENTICATE is selected by its SDO ID (0x84 data object)
+         in the CIE DF
+
+  @returns  The length of the response
+*/
+/**************************************************************************/
+word cie_Nfc_Emulator::setSecurityEnvironment(const byte *command, const byte commandLength, byte *response) {
+  if (commandLength < 5 || commandLength < 5 + command[4]) {
+    return status(0x6700, response, 0);
+  }
+  if (command[2] != 0x41 || command[3] != 0xA4) {
+    return status(0x6A86, response, 0);
+  }
+  _keySelected = false;
+  const byte *data = command + 5;
+  byte dataLength = command[4];
+  word offset = 0;
+  while (offset + 2 <= dataLength && offset + 2 + data[offset + 1] <= dataLength) {
+    //The SDO ID is OR'ed with 0b10000000 when it's in the current DF
+    if (data[offset] == 0x84 && data[offset + 1] == 0x01 && _currentDedicatedFile == CIE_DF && (data[offset + 2] & 0b1111111) == CARD_EMULATOR_SDO_ID) {
+      _keySelected = true;
+    }
+    offset += 2 + data[offset + 1];
+  }
+  //Referenced data not found
+  return status(_keySelected ? 0x9000 : 0x6A88, response, 0);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Answers INTERNAL AUTHENTICATE: the challenge is signed with the test key, PKCS#1 v1.5 type 1 padding and no DigestInfo
+
+  @returns  The length of the response
+*/
+/**************************************************************************/
+word cie_Nfc_Emulator::internalAuthenticate(const byte *command, const byte commandLength, byte *response) {
+  if (commandLength < 5 || commandLength < 5 + command[4]) {
+    return status(0x6700, response, 0);
+  }
+  if (!_keySelected) {
+    //Conditions of use not satisfied
+    return status(0x6985, response, 0);
+  }
+  byte challengeLength = command[4];
+  if (challengeLength == 0 || challengeLength + RSA_MIN_PADDING_LENGTH > CARD_EMULATOR_KEY_LENGTH) {
+    return status(0x6700, response, 0);
+  }
+  byte padded[CARD_EMULATOR_KEY_LENGTH];
+  word paddingEnd = CARD_EMULATOR_KEY_LENGTH - challengeLength - 1;
+  padded[0] = 0x00;
+  padded[1] = 0x01;
+  memset(padded + 2, 0xFF, paddingEnd - 2);
+  padded[paddingEnd] = 0x00;
+  memcpy(padded + paddingEnd + 1, command + 5, challengeLength);
+  //The private key operation is the public one with the private exponent
+  bool success = _rsa.setModulus(testKeyModulus, sizeof(testKeyModulus), cie_Rsa::fingerprint(testKeyModulus, sizeof(testKeyModulus)))
+    && _rsa.publicOperation(padded, sizeof(padded), testKeyPrivateExponent, sizeof(testKeyPrivateExponent), response);
+  if (!success) {
+    return status(0x6F00, response, 0);
+  }
+  return status(0x9000, response, CARD_EMULATOR_KEY_LENGTH);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Appends a status word to the response data
+
+  @param  statusWord The status word
+  @param  response The pointer to the response
+  @param  dataLength The length of the data before the status word
+
+  @returns  The length of the response
+*/
+/**************************************************************************/
+word cie_Nfc_Emulator::status(const word statusWord, byte *response, const word dataLength) {
+  response[dataLength] = statusWord >> 8;
+  response[dataLength + 1] = statusWord & 0xFF;
+  return dataLength + STATUS_WORD_LENGTH;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Finds an elementary file under the current DF
+
+  @param  efid The file identifier, when sfi is zeroes
+  @param  sfi The short file identifier, or zeroes to look for the EFID
+
+  @returns  The file, or NULL if there's no such file
+*/
+/**************************************************************************/
+const cie_EmulatedFile *cie_Nfc_Emulator::findFile(const word efid, const byte sfi) {
+  for (byte i = 0; i < _fileCount; i++) {
+    const cie_EmulatedFile *file = &_files[i];
+    if (file->df == _currentDedicatedFile && (sfi == 0x00 ? file->efid == efid : file->sfi == sfi)) {
+      return file;
+    }
+  }
+  return NULL;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Creates the files of a CIE. The EF.SOD is left out, tests add their own with addFile()
+*/
+/**************************************************************************/
+void cie_Nfc_Emulator::createFiles() {
+  for (byte i = 0; i < EF_SN_ICC_LENGTH; i++) {
+    _snIcc[i] = 0x10 + i;
+  }
+  for (byte i = 0; i < EF_ID_SERVIZI_LENGTH; i++) {
+    _idServizi[i] = 0x30 + i;
+  }
+  //EF.DH: a SEQUENCE of two INTEGERs, longer than a page
+  word length = 0;
+  _dh[length++] = 0x30;
+  _dh[length++] = 0x82;
+  _dh[length++] = (CARD_EMULATOR_DH_LENGTH - 4) >> 8;
+  _dh[length++] = (CARD_EMULATOR_DH_LENGTH - 4) & 0xFF;
+  for (byte integer = 0; integer < 2; integer++) {
+    byte integerLength = (CARD_EMULATOR_DH_LENGTH - 4) / 2 - 3;
+    _dh[length++] = 0x02;
+    _dh[length++] = 0x81;
+    _dh[length++] = integerLength;
+    for (byte i = 0; i < integerLength; i++) {
+      _dh[length++] = (byte) (0x41 + i * 3);
+    }
+  }
+  //EF.ATR: made up historical bytes, then the ending sequence looked for by cie_AtrReader
+  for (byte i = 0; i < CARD_EMULATOR_ATR_LENGTH - 4; i++) {
+    _atr[i] = (byte) (0x40 + i);
+  }
+  memcpy(_atr + CARD_EMULATOR_ATR_LENGTH - 4, "\x82\x02\x90\x00", 4);
+  //RSAPublicKey: SEQUENCE { INTEGER modulus (with a zero octet in front), INTEGER exponent }
+  const byte header[] = { 0x30, 0x82, 0x01, 0x0A, 0x02, 0x82, 0x01, 0x01, 0x00 };
+  length = 0;
+  memcpy(_publicKey, header, sizeof(header));
+  length += sizeof(header);
+  memcpy(_publicKey + length, testKeyModulus, sizeof(testKeyModulus));
+  length += sizeof(testKeyModulus);
+  _publicKey[length++] = 0x02;
+  _publicKey[length++] = sizeof(testKeyPublicExponent);
+  memcpy(_publicKey + length, testKeyPublicExponent, sizeof(testKeyPublicExponent));
+
+  addFile(ROOT_MF, 0xD003, 0x00, _snIcc, sizeof(_snIcc));
+  addFile(ROOT_MF, 0xD004, 0x1B, _dh, sizeof(_dh));
+  addFile(ROOT_MF, 0x2F01, 0x1D, _atr, sizeof(_atr));
+  addFile(CIE_DF, 0x1001, 0x01, _idServizi, sizeof(_idServizi));
+  addFile(CIE_DF, 0x1004, 0x04, _publicKey, sizeof(_publicKey));
+  addFile(CIE_DF, 0x1005, 0x05, _publicKey, sizeof(_publicKey));
+}
@@ -0,0 +1,97 @@
+/**************************************************************************/
+/*!
+    @file     cie_Nfc_Emulator.h
+    @author   Developers Italia
+    @license  BSD (see License)
+
+	A CIE emulated in software, placed in the field of a cie_Nfc transport: the IAS ECC application
+	with its MF and CIE DF, elementary files addressable by EFID and SFI, READ BINARY with ODD INS,
+	MSE SET and INTERNAL AUTHENTICATE with a test key. Each exchange may take as long as a real one
+
+	@section  HISTORY
+
+	v1.1  - Time taken by the card to answer the last command
+	v1.0  - File system, READ BINARY, MSE SET, INTERNAL AUTHENTICATE and the latency model
+*/
+/**************************************************************************/
+#ifndef CIE_NFC_EMULATOR
+#define CIE_NFC_EMULATOR
+
+#include <Arduino.h>
+#include <cie_Nfc.h>
+#include <cie_PN532.h>
+#include <cie_Rsa.h>
+
+#define CARD_EMULATOR_MAX_FILES               (0x10)
+#define CARD_EMULATOR_UID_LENGTH              (0x04)
+#define CARD_EMULATOR_KEY_LENGTH              (0x0100)
+#define CARD_EMULATOR_ATR_LENGTH              (0x28)
+#define CARD_EMULATOR_DH_LENGTH               (0x0110)
+//The SDO of the key used by INTERNAL AUTHENTICATE, as selected by select_SDO_Servizi_Int_Kpriv()
+#define CARD_EMULATOR_SDO_ID                  (0x03)
+
+//Latency model of a PN532 and a CIE at 106 kbps: a byte takes 9 bit times, a frame the PN532 round trip and the card processing time
+#define CARD_EMULATOR_FRAME_MICROS_106        (0x0BB8)
+#define CARD_EMULATOR_BYTE_MICROS_106         (0x55)
+
+struct cie_EmulatedFile {
+  byte df;
+  word efid;
+  byte sfi;
+  const byte *content;
+  word length;
+};
+
+class cie_Nfc_Emulator : public cie_Nfc {
+  public:
+    cie_Nfc_Emulator();
+
+    void begin();
+    bool detectCard();
+    bool sendCommand(byte *command, byte commandLength, byte *response, word *responseLength);
+    void generateRandomBytes(byte *buffer, const word offset, const byte length);
+    byte getUid(byte *uidBuffer);
+    bool isCardPresent();
+    unsigned long getCardMicros();
+
+    bool addFile(const byte df, const word efid, const byte sfi, const byte *content, const word length);
+    void setCardPresent(const bool present);
+    void setLatency(const unsigned long frameMicros, const unsigned long byteMicros);
+    unsigned long getCommandCount();
+    unsigned long getBytesExchanged();
+    unsigned long long getCardNanos();
+    void resetCounters();
+
+  private:
+    word answer(const byte *command, const byte commandLength, byte *response);
+    word select(const byte *command, const byte commandLength, byte *response);
+    word readBinary(const byte *command, const byte commandLength, byte *response);
+    word setSecurityEnvironment(const byte *command, const byte commandLength, byte *response);
+    word internalAuthenticate(const byte *command, const byte commandLength, byte *response);
+    word status(const word statusWord, byte *response, const word dataLength);
+    const cie_EmulatedFile *findFile(const word efid, const byte sfi);
+    void createFiles();
+
+    cie_EmulatedFile _files[CARD_EMULATOR_MAX_FILES];
+    byte _fileCount;
+    byte _currentDedicatedFile;
+    const cie_EmulatedFile *_currentElementaryFile;
+    bool _keySelected;
+    bool _present;
+    byte _uid[CARD_EMULATOR_UID_LENGTH];
+    unsigned long _frameMicros;
+    unsigned long _byteMicros;
+    unsigned long _commandCount;
+    unsigned long _bytesExchanged;
+    unsigned long long _cardNanos;
+    unsigned long _lastCardNanos;
+    cie_Rsa _rsa;
+
+    byte _snIcc[EF_SN_ICC_LENGTH];
+    byte _idServizi[EF_ID_SERVIZI_LENGTH];
+    byte _dh[CARD_EMULATOR_DH_LENGTH];
+    byte _atr[CARD_EMULATOR_ATR_LENGTH];
+    byte _publicKey[EF_SERVIZI_INT_KPUB_LENGTH];
+};
+
+#endif
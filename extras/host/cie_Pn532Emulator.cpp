@@ -0,0 +1,453 @@
+/**************************************************************************/
+/*!
+    @file     cie_Pn532Emulator.cpp
+    @author   Developers Italia
+    @license  BSD (see License)
+
+	A PN532 stand-in on the master side of a pseudo-terminal, speaking the HSU frame
+	protocol and forwarding APDU commands to a card implemented as a cie_Nfc
+
+	@section  HISTORY
+
+	v1.0  - GetFirmwareVersion, SAMConfiguration, RFConfiguration, InListPassiveTarget, InDataExchange
+*/
+/**************************************************************************/
+#include "cie_Pn532Emulator.h"
+#include <cie_Nfc_Frame.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+/**************************************************************************/
+/*!
+  @brief Create with the card which will be placed in the emulated RF field
+
+  @param  card The card, which receives the APDU commands of every InDataExchange
+*/
+/**************************************************************************/
+cie_Pn532Emulator::cie_Pn532Emulator (cie_Nfc *card) :
+_card(card),
+_master(-1),
+_running(false),
+_cardPresent(true),
+_autoPollPending(false),
+_maxBitRate(FRAME_BIT_RATE_848),
+_leaveOnRefusedBitRate(false),
+_framesReceived(0),
+_bufferLength(0),
+_frameEnd(0)
+{
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Opens the pseudo-terminal and starts serving frames in a background thread
+
+  @returns  A boolean value indicating whether the emulator started or not
+*/
+/**************************************************************************/
+bool cie_Pn532Emulator::start() {
+  _master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (_master < 0 || grantpt(_master) != 0 || unlockpt(_master) != 0) {
+    return false;
+  }
+  struct termios options;
+  if (tcgetattr(_master, &options) == 0) {
+    cfmakeraw(&options);
+    tcsetattr(_master, TCSANOW, &options);
+  }
+  _running = true;
+  if (pthread_create(&_thread, NULL, run, this) != 0) {
+    _running = false;
+    return false;
+  }
+  return true;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Stops serving frames and closes the pseudo-terminal
+*/
+/**************************************************************************/
+void cie_Pn532Emulator::stop() {
+  if (_running) {
+    _running = false;
+    pthread_join(_thread, NULL);
+  }
+  if (_master >= 0) {
+    close(_master);
+    _master = -1;
+  }
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Opens the slave side of the pseudo-terminal, where cie_Nfc_HSU should connect
+
+  @returns  The slave file descriptor, or -1 on errors
+*/
+/**************************************************************************/
+int cie_Pn532Emulator::openSlave() {
+  return open(devicePath(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Gets the path of the slave side of the pseudo-terminal
+
+  @returns  The device path (e.g. /dev/pts/3)
+*/
+/**************************************************************************/
+const char *cie_Pn532Emulator::devicePath() {
+  return ptsname(_master);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Places the card in the RF field or takes it away
+
+  @param  present Whether the card should be detected or not
+*/
+/**************************************************************************/
+void cie_Pn532Emulator::setCardPresent(const bool present) {
+  _cardPresent = present;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Sets the fastest bit rate the emulated card accepts in a PPS request
+
+  @param  bitRate The bit rate code (0x00 106 kbps to 0x03 848 kbps)
+*/
+/**************************************************************************/
+void cie_Pn532Emulator::setMaxBitRate(const byte bitRate) {
+  _maxBitRate = bitRate;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Makes the card leave the field as soon as it refuses a PPS request, e.g. pulled away while negotiating
+
+  @param  leave Whether the card leaves the field or not
+*/
+/**************************************************************************/
+void cie_Pn532Emulator::setLeaveOnRefusedBitRate(const bool leave) {
+  _leaveOnRefusedBitRate = leave;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Counts the command frames received so far
+
+  @returns  The number of command frames
+*/
+/**************************************************************************/
+word cie_Pn532Emulator::framesReceived() {
+  return _framesReceived;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Thread entry point
+*/
+/**************************************************************************/
+void *cie_Pn532Emulator::run(void *emulator) {
+  ((cie_Pn532Emulator *) emulator)->serve();
+  return NULL;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Reads bytes from the pseudo-terminal and answers each complete frame
+*/
+/**************************************************************************/
+void cie_Pn532Emulator::serve() {
+  while (_running) {
+    struct pollfd descriptor = { _master, POLLIN, 0 };
+    if (_autoPollPending && _cardPresent) {
+      //Type 0x20 (passive 106 kbps ISO/IEC14443-4A), then the same target data as InListPassiveTarget
+      _autoPollPending = false;
+      answerTarget(FRAME_IN_AUTO_POLL, 0x20);
+    }
+    if (poll(&descriptor, 1, 10) <= 0 || (descriptor.revents & POLLIN) == 0) {
+      continue;
+    }
+    ssize_t count = read(_master, _buffer + _bufferLength, EMULATOR_BUFFER_LENGTH - _bufferLength);
+    if (count <= 0) {
+      continue;
+    }
+    _bufferLength += count;
+    word consumed;
+    while ((consumed = consume(_buffer, _bufferLength)) > 0) {
+      memmove(_buffer, _buffer + consumed, _bufferLength - consumed);
+      _bufferLength -= consumed;
+    }
+    if (_bufferLength == EMULATOR_BUFFER_LENGTH) {
+      //Garbage, start over
+      _bufferLength = 0;
+    }
+  }
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Parses the first frame in the buffer, answering it if it's a command frame
+
+  @param  buffer The received bytes
+  @param  length The number of received bytes
+
+  @returns  The number of bytes consumed, or zero if the frame is not complete yet
+*/
+/**************************************************************************/
+word cie_Pn532Emulator::consume(const byte *buffer, const word length) {
+  //Skip the wake up preamble and look for the 0x00 0xFF start codes
+  word start = 0;
+  while (start + 1 < length && !(buffer[start] == FRAME_START_CODE_1 && buffer[start + 1] == FRAME_START_CODE_2)) {
+    start++;
+  }
+  if (start + 4 > length) {
+    return start;
+  }
+  word position = start + 2;
+  word frameLength;
+  if (buffer[position] == FRAME_EXTENDED_LENGTH && buffer[position + 1] == FRAME_EXTENDED_LENGTH) {
+    if (position + 5 > length) {
+      return start;
+    }
+    frameLength = ((word) buffer[position + 2] << 8) | buffer[position + 3];
+    position += 5;
+  } else if (buffer[position] == 0x00 && buffer[position + 1] == 0xFF) {
+    //ACK frame: the host aborted a command, nothing to answer
+    _autoPollPending = false;
+    return position + 2;
+  } else {
+    if ((byte) (buffer[position] + buffer[position + 1]) != 0x00) {
+      return start + 2;
+    }
+    frameLength = buffer[position];
+    position += 2;
+  }
+  if (position + frameLength + 2 > length) {
+    return start;
+  }
+  byte checksum = 0;
+  for (word i = 0; i < frameLength + 1; i++) {
+    checksum += buffer[position + i];
+  }
+  if (checksum == 0x00 && buffer[position] == FRAME_HOST_TO_PN532) {
+    _framesReceived++;
+    byte ack[FRAME_ACK_LENGTH] = { 0x00, 0x00, 0xFF, 0x00, 0xFF, 0x00 };
+    writeBytes(ack, FRAME_ACK_LENGTH);
+    _frameEnd = position + frameLength + 2;
+    handleCommand(buffer + position + 1, frameLength - 1);
+    _frameEnd = 0;
+  }
+  return position + frameLength + 2;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Answers a command with a response frame
+
+  @param  data The command code and its parameters
+  @param  length The length of the command
+*/
+/**************************************************************************/
+void cie_Pn532Emulator::handleCommand(const byte *data, const word length) {
+  byte response[EMULATOR_MAX_RESPONSE_LENGTH];
+  word responseLength = 2;
+  response[0] = FRAME_PN532_TO_HOST;
+  response[1] = data[0] + 1;
+  switch (data[0]) {
+    case FRAME_GET_FIRMWARE_VERSION:
+      {
+        byte version[] = { 0x32, 0x01, 0x06, 0x07 };
+        memcpy(response + responseLength, version, sizeof(version));
+        responseLength += sizeof(version);
+      }
+    break;
+
+    case FRAME_IN_LIST_PASSIVE_TARGET:
+      answerTarget(FRAME_IN_LIST_PASSIVE_TARGET, 0x00);
+    return;
+
+    case FRAME_IN_AUTO_POLL:
+      //Answered by serve() as soon as the card enters the field
+      _autoPollPending = true;
+    return;
+
+    case FRAME_IN_DATA_EXCHANGE:
+      {
+        word apduLength = EMULATOR_MAX_RESPONSE_LENGTH - responseLength - 1;
+        bool success = _cardPresent && length >= 2 && _card->sendCommand((byte *) data + 2, length - 2, response + responseLength + 1, &apduLength);
+        //Status byte: 0x00 success, 0x01 timeout
+        response[responseLength++] = success ? 0x00 : 0x01;
+        if (success) {
+          responseLength += apduLength;
+        }
+      }
+    break;
+
+    case FRAME_DIAGNOSE:
+      //Card presence test: 0x00 the card answered, 0x01 timeout
+      response[responseLength++] = _cardPresent && length >= 2 && data[1] == FRAME_DIAGNOSE_CARD_PRESENCE ? 0x00 : 0x01;
+    break;
+
+    case FRAME_IN_PSL: {
+      //Status byte: 0x00 success, 0x01 timeout when the card doesn't answer the PPS
+      bool accepted = _cardPresent && length >= 4 && data[2] <= _maxBitRate && data[3] <= _maxBitRate;
+      response[responseLength++] = accepted ? 0x00 : 0x01;
+      if (!accepted && _leaveOnRefusedBitRate) {
+        _cardPresent = false;
+      }
+    }
+    break;
+
+    default:
+      //SAMConfiguration, RFConfiguration and the like have empty responses
+    break;
+  }
+  writeFrame(response, responseLength);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Answers InListPassiveTarget or InAutoPoll with the target data of the card, if it's in the field
+
+  @param  command The command being answered
+  @param  type The target type preceding the target data (InAutoPoll only)
+*/
+/**************************************************************************/
+void cie_Pn532Emulator::answerTarget(const byte command, const byte type) {
+  byte response[EMULATOR_MAX_RESPONSE_LENGTH];
+  word responseLength = 2;
+  response[0] = FRAME_PN532_TO_HOST;
+  response[1] = command + 1;
+  if (!_cardPresent || !_card->detectCard()) {
+    response[responseLength++] = 0x00; //NbTg
+  } else {
+    //Tg, SENS_RES, SEL_RES (ISO/IEC 14443-4 compliant), a random 4 bytes UID and an ATS (212 and 424 kbps in TA(1))
+    byte target[] = { 0x01, 0x00, 0x04, 0x20, 0x04, 0x08, (byte) random(256), (byte) random(256), (byte) random(256), 0x05, 0x78, 0x33, 0x70, 0x02 };
+    response[responseLength++] = 0x01; //NbTg
+    if (command == FRAME_IN_AUTO_POLL) {
+      response[responseLength++] = type;
+      response[responseLength++] = sizeof(target);
+    }
+    memcpy(response + responseLength, target, sizeof(target));
+    responseLength += sizeof(target);
+  }
+  writeFrame(response, responseLength);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Checks whether the host sent an ACK frame to abort the command being answered.
+         The bytes received meanwhile are appended to the buffer, to be consumed afterwards
+
+  @returns  A boolean value indicating whether the command was aborted or not
+*/
+/**************************************************************************/
+bool cie_Pn532Emulator::isAborted() {
+  struct pollfd descriptor = { _master, POLLIN, 0 };
+  if (poll(&descriptor, 1, 0) > 0 && (descriptor.revents & POLLIN) != 0) {
+    ssize_t count = read(_master, _buffer + _bufferLength, EMULATOR_BUFFER_LENGTH - _bufferLength);
+    if (count > 0) {
+      _bufferLength += count;
+    }
+  }
+  byte ack[] = { FRAME_START_CODE_1, FRAME_START_CODE_2, 0x00, 0xFF, FRAME_POSTAMBLE };
+  for (word i = _frameEnd; i + sizeof(ack) <= _bufferLength; i++) {
+    if (memcmp(_buffer + i, ack, sizeof(ack)) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Writes a normal or extended information frame to the pseudo-terminal
+
+  @param  data The TFI, the response code and the response data
+  @param  length The length of the data
+*/
+/**************************************************************************/
+void cie_Pn532Emulator::writeFrame(const byte *data, const word length) {
+  if (isAborted()) {
+    //Like the PN532, don't answer a command the host gave up on
+    return;
+  }
+  byte frame[EMULATOR_MAX_RESPONSE_LENGTH + 10];
+  word position = 0;
+  frame[position++] = FRAME_PREAMBLE;
+  frame[position++] = FRAME_START_CODE_1;
+  frame[position++] = FRAME_START_CODE_2;
+  if (length > 0xFF) {
+    frame[position++] = FRAME_EXTENDED_LENGTH;
+    frame[position++] = FRAME_EXTENDED_LENGTH;
+    frame[position++] = (byte) (length >> 8);
+    frame[position++] = (byte) (length & 0xFF);
+    frame[position++] = (byte) (~((length >> 8) + (length & 0xFF)) + 1);
+  } else {
+    frame[position++] = (byte) length;
+    frame[position++] = (byte) (~length + 1);
+  }
+  byte checksum = 0;
+  for (word i = 0; i < length; i++) {
+    frame[position++] = data[i];
+    checksum += data[i];
+  }
+  frame[position++] = (byte) (~checksum + 1);
+  frame[position++] = FRAME_POSTAMBLE;
+  writeBytes(frame, position);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Writes bytes to the pseudo-terminal
+
+  @param  buffer The bytes to write
+  @param  length The number of bytes
+*/
+/**************************************************************************/
+void cie_Pn532Emulator::writeBytes(const byte *buffer, const word length) {
+  word written = 0;
+  while (written < length) {
+    ssize_t count = write(_master, buffer + written, length - written);
+    if (count > 0) {
+      written += count;
+    } else if (count < 0 && errno != EAGAIN && errno != EINTR) {
+      return;
+    }
+  }
+}
+
+
+/**************************************************************************/
+/*!
+    @brief Frees resources
+*/
+/**************************************************************************/
+cie_Pn532Emulator::~cie_Pn532Emulator()
+{
+  stop();
+}
@@ -0,0 +1,68 @@
+/**************************************************************************/
+/*!
+    @file     cie_Pn532Emulator.h
+    @author   Developers Italia
+    @license  BSD (see License)
+
+	A PN532 stand-in on the master side of a pseudo-terminal, speaking the HSU frame
+	protocol and forwarding APDU commands to a card implemented as a cie_Nfc
+
+	@section  HISTORY
+
+	v1.5  - The card can leave the field when it refuses a PPS
+	v1.4  - No response to aborted commands
+	v1.3  - Diagnose card presence test
+	v1.2  - InPSL, with a configurable fastest bit rate
+	v1.1  - InAutoPoll, answered as soon as the card enters the field
+	v1.0  - GetFirmwareVersion, SAMConfiguration, RFConfiguration, InListPassiveTarget, InDataExchange
+*/
+/**************************************************************************/
+#ifndef CIE_PN532_EMULATOR
+#define CIE_PN532_EMULATOR
+
+#include <Arduino.h>
+#include <pthread.h>
+#include <cie_Nfc.h>
+
+#define EMULATOR_BUFFER_LENGTH                (0x0200)
+#define EMULATOR_MAX_RESPONSE_LENGTH          (0x0106)
+
+class cie_Pn532Emulator {
+  public:
+    cie_Pn532Emulator(cie_Nfc *card);
+    ~cie_Pn532Emulator();
+
+    bool start();
+    void stop();
+    int openSlave();
+    const char *devicePath();
+    void setCardPresent(const bool present);
+    void setMaxBitRate(const byte bitRate);
+    void setLeaveOnRefusedBitRate(const bool leave);
+    word framesReceived();
+
+  private:
+    static void *run(void *emulator);
+    void serve();
+    word consume(const byte *buffer, const word length);
+    void handleCommand(const byte *data, const word length);
+    void answerTarget(const byte command, const byte type);
+    void writeFrame(const byte *data, const word length);
+    bool isAborted();
+    void writeBytes(const byte *buffer, const word length);
+
+    cie_Nfc *_card;
+    int _master;
+    pthread_t _thread;
+    volatile bool _running;
+    volatile bool _cardPresent;
+    volatile bool _autoPollPending;
+    volatile byte _maxBitRate;
+    volatile bool _leaveOnRefusedBitRate;
+    volatile word _framesReceived;
+    byte _buffer[EMULATOR_BUFFER_LENGTH];
+    word _bufferLength;
+    word _frameEnd;
+};
+
+#endif
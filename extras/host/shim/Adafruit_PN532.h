@@ -0,0 +1,31 @@
+/**************************************************************************/
+/*!
+    @file     Adafruit_PN532.h
+    @author   Developers Italia
+    @license  BSD (see License)
+
+	The part of the Adafruit PN532 library used by cie_Nfc_Adafruit, with no board attached:
+	no firmware version is reported and no card is ever found
+
+	@section  HISTORY
+
+	v1.0  - First definition
+*/
+/**************************************************************************/
+#ifndef ADAFRUIT_PN532_H
+#define ADAFRUIT_PN532_H
+
+#include "Arduino.h"
+
+class Adafruit_PN532 {
+  public:
+    Adafruit_PN532(uint8_t clk, uint8_t miso, uint8_t mosi, uint8_t ss) {}
+
+    void begin() {}
+    uint32_t getFirmwareVersion() { return 0; }
+    bool SAMConfig() { return false; }
+    bool inListPassiveTarget() { return false; }
+    bool inDataExchange(uint8_t *send, uint8_t sendLength, uint8_t *response, uint16_t *responseLength) { return false; }
+};
+
+#endif
@@ -0,0 +1,158 @@
+/**************************************************************************/
+/*!
+    @file     Arduino.cpp
+    @author   Developers Italia
+    @license  BSD (see License)
+
+	The bits of the Arduino core the library uses, on Linux hosts
+
+	@section  HISTORY
+
+	v1.0  - First definition
+*/
+/**************************************************************************/
+#include "Arduino.h"
+#include <time.h>
+#include <unistd.h>
+
+HardwareSerial Serial;
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  size_t written = 0;
+  while (size-- > 0 && write(*buffer++) == 1) {
+    written++;
+  }
+  return written;
+}
+
+size_t Print::print(const char *s) {
+  return write((const uint8_t *) s, strlen(s));
+}
+
+size_t Print::print(const __FlashStringHelper *s) {
+  return print(reinterpret_cast<const char *>(s));
+}
+
+size_t Print::print(char c) {
+  return write((uint8_t) c);
+}
+
+size_t Print::print(unsigned char value, int base) {
+  return print((unsigned long) value, base);
+}
+
+size_t Print::print(int value, int base) {
+  return print((long) value, base);
+}
+
+size_t Print::print(unsigned int value, int base) {
+  return print((unsigned long) value, base);
+}
+
+size_t Print::print(long value, int base) {
+  if (base != DEC) {
+    return print((unsigned long) value, base);
+  }
+  char text[24];
+  snprintf(text, sizeof(text), "%ld", value);
+  return print(text);
+}
+
+size_t Print::print(unsigned long value, int base) {
+  char text[24];
+  snprintf(text, sizeof(text), base == HEX ? "%lX" : "%lu", value);
+  return print(text);
+}
+
+size_t Print::print(double value, int digits) {
+  char text[48];
+  snprintf(text, sizeof(text), "%.*f", digits, value);
+  return print(text);
+}
+
+size_t Print::println() {
+  return print("\n");
+}
+
+HardwareSerial::HardwareSerial() {
+  setvbuf(stdout, NULL, _IOLBF, BUFSIZ);
+}
+
+void HardwareSerial::begin(unsigned long baudRate) {
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+  return fputc(c, stdout) == EOF ? 0 : 1;
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size) {
+  return fwrite(buffer, 1, size, stdout);
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Gets the microseconds elapsed on the monotonic clock since the first call
+*/
+/**************************************************************************/
+static unsigned long long elapsedMicros() {
+  static unsigned long long startedAt = 0;
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  unsigned long long nowMicros = now.tv_sec * 1000000ULL + now.tv_nsec / 1000;
+  if (startedAt == 0) {
+    startedAt = nowMicros;
+  }
+  return nowMicros - startedAt;
+}
+
+unsigned long millis() {
+  return (unsigned long) (elapsedMicros() / 1000);
+}
+
+unsigned long micros() {
+  return (unsigned long) elapsedMicros();
+}
+
+void delay(unsigned long ms) {
+  usleep(ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+  usleep(us);
+}
+
+void yield() {
+}
+
+long random(long max) {
+  return max > 0 ? rand() % max : 0;
+}
+
+long random(long min, long max) {
+  return max > min ? min + rand() % (max - min) : min;
+}
+
+void randomSeed(unsigned long seed) {
+  srand(seed);
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+}
+
+int digitalRead(uint8_t pin) {
+  return LOW;
+}
+
+int analogRead(uint8_t pin) {
+  return rand() & 0x3FF;
+}
+
+void attachInterrupt(uint8_t interrupt, void (*isr)(void), int mode) {
+}
+
+void detachInterrupt(uint8_t interrupt) {
+}
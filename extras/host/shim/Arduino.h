@@ -0,0 +1,104 @@
+/**************************************************************************/
+/*!
+    @file     Arduino.h
+    @author   Developers Italia
+    @license  BSD (see License)
+
+	The bits of the Arduino core the library uses, so that it builds and runs on Linux hosts:
+	types, flash strings, Serial over the standard output, time, pins and random numbers
+
+	@section  HISTORY
+
+	v1.0  - First definition
+*/
+/**************************************************************************/
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef uint8_t byte;
+typedef uint16_t word;
+typedef bool boolean;
+
+//Flash strings are plain strings on the host
+class __FlashStringHelper;
+#define F(s)                                  (reinterpret_cast<const __FlashStringHelper *>(s))
+#define PROGMEM
+#define pgm_read_byte(address)                (*(const uint8_t *) (address))
+#define pgm_read_word(address)                (*(const uint16_t *) (address))
+#define pgm_read_dword(address)               (*(const uint32_t *) (address))
+
+#define DEC                                   (10)
+#define HEX                                   (16)
+
+#define LOW                                   (0x00)
+#define HIGH                                  (0x01)
+#define INPUT                                 (0x00)
+#define OUTPUT                                (0x01)
+#define INPUT_PULLUP                          (0x02)
+#define FALLING                               (0x02)
+#define digitalPinToInterrupt(pin)            (pin)
+
+class Print {
+  public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size);
+
+    size_t print(const char *s);
+    size_t print(const __FlashStringHelper *s);
+    size_t print(char c);
+    size_t print(unsigned char value, int base = DEC);
+    size_t print(int value, int base = DEC);
+    size_t print(unsigned int value, int base = DEC);
+    size_t print(long value, int base = DEC);
+    size_t print(unsigned long value, int base = DEC);
+    size_t print(double value, int digits = 2);
+
+    size_t println();
+    template <typename T> size_t println(T value) {
+      size_t length = print(value);
+      return length + println();
+    }
+    template <typename T> size_t println(T value, int format) {
+      size_t length = print(value, format);
+      return length + println();
+    }
+};
+
+//The standard output, line buffered so that nothing is lost when a sketch is killed
+class HardwareSerial : public Print {
+  public:
+    HardwareSerial();
+    void begin(unsigned long baudRate);
+    size_t write(uint8_t c);
+    size_t write(const uint8_t *buffer, size_t size);
+    operator bool() { return true; }
+};
+
+extern HardwareSerial Serial;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+//Pins do nothing: analog inputs read noise
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+void attachInterrupt(uint8_t interrupt, void (*isr)(void), int mode);
+void detachInterrupt(uint8_t interrupt);
+
+#endif
@@ -0,0 +1,89 @@
+/**************************************************************************/
+/*!
+    @file     ArduinoUnit.cpp
+    @author   Developers Italia
+    @license  BSD (see License)
+
+	The part of ArduinoUnit the tests use, on Linux hosts
+
+	@section  HISTORY
+
+	v1.0  - First definition
+*/
+/**************************************************************************/
+#include "ArduinoUnit.h"
+
+Test *Test::_first = NULL;
+Test *Test::_last = NULL;
+
+/**************************************************************************/
+/*!
+  @brief Registers a test, tests run in the order they're defined
+
+  @param  name The name of the test
+  @param  body The function with the assertions
+*/
+/**************************************************************************/
+Test::Test(const char *name, Body body) :
+_name(name),
+_body(body),
+_failed(false),
+_next(NULL)
+{
+  if (_last == NULL) {
+    _first = this;
+  } else {
+    _last->_next = this;
+  }
+  _last = this;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Marks the test as failed, reporting the assertion which didn't hold
+
+  @param  file The source file of the assertion
+  @param  line The line of the assertion
+  @param  assertion The assertion
+*/
+/**************************************************************************/
+void Test::fail(const char *file, const int line, const char *assertion) {
+  _failed = true;
+  Serial.print(F("Assertion failed: ("));
+  Serial.print(assertion);
+  Serial.print(F("), file "));
+  Serial.print(file);
+  Serial.print(F(", line "));
+  Serial.print(line);
+  Serial.println(F("."));
+}
+
+
+/**************************************************************************/
+/*!
+  @brief Runs every test, prints the summary and exits: the exit status tells whether they all passed
+*/
+/**************************************************************************/
+void Test::run() {
+  int count = 0;
+  int failures = 0;
+  for (Test *test = _first; test != NULL; test = test->_next) {
+    test->_body(*test);
+    count++;
+    if (test->_failed) {
+      failures++;
+    }
+    Serial.print(F("Test "));
+    Serial.print(test->_name);
+    Serial.println(test->_failed ? F(" failed.") : F(" passed."));
+  }
+  Serial.print(F("Test summary: "));
+  Serial.print(count - failures);
+  Serial.print(F(" passed, "));
+  Serial.print(failures);
+  Serial.print(F(" failed, and 0 skipped, out of "));
+  Serial.print(count);
+  Serial.println(F(" test(s)."));
+  exit(failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
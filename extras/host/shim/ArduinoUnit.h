@@ -0,0 +1,60 @@
+/**************************************************************************/
+/*!
+    @file     ArduinoUnit.h
+    @author   Developers Italia
+    @license  BSD (see License)
+
+	The part of ArduinoUnit the tests use: test() and the assertions. On the host Test::run()
+	runs every test once, then exits with a non zero status if any of them failed
+
+	@section  HISTORY
+
+	v1.0  - First definition
+*/
+/**************************************************************************/
+#ifndef ARDUINO_UNIT_H
+#define ARDUINO_UNIT_H
+
+#include "Arduino.h"
+
+class Test {
+  public:
+    typedef void (*Body)(Test &test);
+
+    Test(const char *name, Body body);
+    void fail(const char *file, const int line, const char *assertion);
+
+    static void run();
+
+  private:
+    const char *_name;
+    Body _body;
+    bool _failed;
+    Test *_next;
+
+    static Test *_first;
+    static Test *_last;
+};
+
+#define test(name) \
+  static void test_##name##_body(Test &test_); \
+  static Test test_##name##_instance(#name, test_##name##_body); \
+  static void test_##name##_body(Test &test_)
+
+#define assertOp(a, op, b) do { \
+    if (!((a) op (b))) { \
+      test_.fail(__FILE__, __LINE__, #a " " #op " " #b); \
+      return; \
+    } \
+  } while (0)
+
+#define assertEqual(a, b)                     assertOp(a, ==, b)
+#define assertNotEqual(a, b)                  assertOp(a, !=, b)
+#define assertLess(a, b)                      assertOp(a, <, b)
+#define assertLessOrEqual(a, b)               assertOp(a, <=, b)
+#define assertMore(a, b)                      assertOp(a, >, b)
+#define assertMoreOrEqual(a, b)               assertOp(a, >=, b)
+#define assertTrue(a)                         assertOp((bool) (a), ==, true)
+#define assertFalse(a)                        assertOp((bool) (a), ==, false)
+
+#endif
@@ -0,0 +1,16 @@
+/**************************************************************************/
+/*!
+    @file     SPI.cpp
+    @author   Developers Italia
+    @license  BSD (see License)
+
+	An SPI peripheral with nothing attached
+
+	@section  HISTORY
+
+	v1.0  - First definition
+*/
+/**************************************************************************/
+#include "SPI.h"
+
+SPIClass SPI;
@@ -0,0 +1,41 @@
+/**************************************************************************/
+/*!
+    @file     SPI.h
+    @author   Developers Italia
+    @license  BSD (see License)
+
+	An SPI peripheral with nothing attached, so that the SPI transport builds on Linux hosts
+
+	@section  HISTORY
+
+	v1.0  - First definition
+*/
+/**************************************************************************/
+#ifndef SPI_H
+#define SPI_H
+
+#include "Arduino.h"
+
+#define LSBFIRST                              (0x00)
+#define MSBFIRST                              (0x01)
+#define SPI_MODE0                             (0x00)
+
+class SPISettings {
+  public:
+    SPISettings() {}
+    SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode) {}
+};
+
+class SPIClass {
+  public:
+    void begin() {}
+    void end() {}
+    void beginTransaction(SPISettings settings) {}
+    void endTransaction() {}
+    uint8_t transfer(uint8_t data) { return 0x00; }
+    void transfer(void *buffer, size_t count) { memset(buffer, 0, count); }
+};
+
+extern SPIClass SPI;
+
+#endif
@@ -0,0 +1,19 @@
+/**************************************************************************/
+/*!
+    @file     Wire.h
+    @author   Developers Italia
+    @license  BSD (see License)
+
+	Nothing uses I2C on the host, but sketches include this
+
+	@section  HISTORY
+
+	v1.0  - First definition
+*/
+/**************************************************************************/
+#ifndef WIRE_H
+#define WIRE_H
+
+#include "Arduino.h"
+
+#endif
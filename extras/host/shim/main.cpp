@@ -0,0 +1,22 @@
+/**************************************************************************/
+/*!
+    @file     main.cpp
+    @author   Developers Italia
+    @license  BSD (see License)
+
+	What the Arduino core does with a sketch: setup() once, then loop() forever
+
+	@section  HISTORY
+
+	v1.0  - First definition
+*/
+/**************************************************************************/
+void setup(void);
+void loop(void);
+
+int main() {
+  setup();
+  for (;;) {
+    loop();
+  }
+}
@@ -0,0 +1,328 @@
+/**************************************************************************/
+/*!
+  @file     CIE-BudgetTest.ino
+  @author   Developers italia
+  @license  BSD (see license)
+  Regression tests of the cost of each public operation against a CIE
+  emulated in software: APDU commands, bytes moved (commands and responses),
+  heap allocations, peak stack and peak heap must stay within the budgets
+  below. Lower a budget when a change saves something, never raise it without
+  a reason. Stack budgets leave room for other compilers and flags.
+  This runs on Linux hosts only.
+
+*/
+/**************************************************************************/
+#include <ArduinoUnit.h>
+#include <cie_PN532.h>
+#include <cie_Nfc_Emulator.h>
+#include "cie_AllocationCounter.h"
+#include "cie_SodFixture.h"
+
+typedef bool (*cieBudgetOperationFunc)(cie_PN532 *cie);
+
+struct cie_Cost {
+  unsigned long apdus;
+  unsigned long bytes;
+  unsigned long allocations;
+  unsigned long stack;
+  unsigned long heap;
+};
+
+//Runs the operation on a fresh tap and returns false if it failed. The card belongs to cie_PN532
+bool measure(const char *name, cie_Nfc_Emulator *card, cieBudgetOperationFunc run, cie_Cost *cost) {
+  cie_PN532 cie(card);
+  cie.begin();
+  cie.detectCard();
+  card->resetCounters();
+  cie.setMemoryProbe(true);
+  resetAllocationCount();
+  bool success = run(&cie);
+  cost->allocations = getAllocationCount();
+  cost->apdus = card->getCommandCount();
+  cost->bytes = card->getBytesExchanged();
+  cie_MemoryUsage usage = cie.getMemoryUsage();
+  cost->stack = usage.stackOverflowed ? (unsigned long) -1 : usage.stack;
+  cost->heap = usage.heap;
+  Serial.print(name);
+  Serial.print(F(": "));
+  Serial.print(cost->apdus);
+  Serial.print(F(" APDUs, "));
+  Serial.print(cost->bytes);
+  Serial.print(F(" bytes, "));
+  Serial.print(cost->allocations);
+  Serial.print(F(" allocations, "));
+  Serial.print(cost->stack);
+  Serial.print(F(" bytes of stack, "));
+  Serial.print(cost->heap);
+  Serial.println(F(" bytes of heap"));
+  return success;
+}
+
+bool measure(const char *name, cieBudgetOperationFunc run, cie_Cost *cost) {
+  return measure(name, new cie_Nfc_Emulator(), run, cost);
+}
+
+bool runIdentify(cie_PN532 *cie) {
+  byte buffer[EF_ID_SERVIZI_LENGTH];
+  word length = sizeof(buffer);
+  return cie->identify(buffer, &length);
+}
+
+bool runReadSnIcc(cie_PN532 *cie) {
+  byte buffer[EF_SN_ICC_LENGTH];
+  word length = sizeof(buffer);
+  return cie->read_EF_SN_ICC(buffer, &length);
+}
+
+bool runReadIdServizi(cie_PN532 *cie) {
+  byte buffer[EF_ID_SERVIZI_LENGTH];
+  word length = sizeof(buffer);
+  return cie->read_EF_ID_Servizi(buffer, &length);
+}
+
+bool runReadDh(cie_PN532 *cie) {
+  byte buffer[0x200];
+  word length = sizeof(buffer);
+  return cie->read_EF_DH(buffer, &length);
+}
+
+bool runReadAtr(cie_PN532 *cie) {
+  byte buffer[0x100];
+  word length = sizeof(buffer);
+  return cie->read_EF_ATR(buffer, &length);
+}
+
+bool runReadIntKpub(cie_PN532 *cie) {
+  cie_Key key;
+  return cie->read_EF_Int_Kpub(&key);
+}
+
+bool runReadServiziIntKpub(cie_PN532 *cie) {
+  cie_Key key;
+  return cie->read_EF_Servizi_Int_Kpub(&key);
+}
+
+bool runStartRead(cie_PN532 *cie) {
+  byte buffer[EF_ID_SERVIZI_LENGTH];
+  word length = sizeof(buffer);
+  if (!cie->startRead_EF_ID_Servizi(buffer, &length)) {
+    return false;
+  }
+  byte result;
+  while ((result = cie->poll()) == POLL_IN_PROGRESS);
+  return result == POLL_DONE;
+}
+
+bool runHashElementaryFile(cie_PN532 *cie) {
+  cie_Sha256 sha256;
+  byte digest[SHA256_DIGEST_LENGTH];
+  word length = EF_SERVIZI_INT_KPUB_LENGTH;
+  cie_EFPath filePath = { CIE_DF, SELECT_BY_SFI, 0x05 };
+  return cie->hashElementaryFile(filePath, &sha256, digest, &length, FIXED_LENGTH);
+}
+
+bool countTriple(cie_BerTriple *triple) {
+  return true;
+}
+
+bool runParseSod(cie_PN532 *cie) {
+  return cie->parse_EF_SOD(countTriple);
+}
+
+bool runVerifySod(cie_PN532 *cie) {
+  return cie->verify_EF_SOD();
+}
+
+bool runVerifySodSignature(cie_PN532 *cie) {
+  cie_Key csca;
+  csca.set(testTrustAnchorModulus, sizeof(testTrustAnchorModulus), testTrustAnchorExponent, sizeof(testTrustAnchorExponent));
+  cie->setTrustAnchor(&csca);
+  return cie->verify_EF_SOD_Signature();
+}
+
+bool runIsCardValid(cie_PN532 *cie) {
+  return cie->isCardValid();
+}
+
+//A card with the EF_SOD of the fixture, and optionally the EF_Servizi_Int_Kpub it lists
+cie_Nfc_Emulator *cardWithSod(bool sodKey) {
+  cie_Nfc_Emulator *card = new cie_Nfc_Emulator();
+  card->addFile(CIE_DF, 0x1006, 0x06, testSod, TEST_SOD_LENGTH);
+  if (sodKey) {
+    card->addFile(CIE_DF, 0x1005, 0x05, testKpub, sizeof(testKpub));
+  }
+  return card;
+}
+
+//Uses about 2 KB of stack and 4 KB of heap, as the operation of a cie_MemoryProbe
+__attribute__((noinline)) void useMemory(cie_MemoryProbe *probe) {
+  volatile byte buffer[0x0800];
+  for (word i = 0; i < sizeof(buffer); i++) {
+    buffer[i] = (byte) i;
+  }
+  byte *allocated = new byte[0x1000];
+  allocated[0] = buffer[0];
+  probe->sample();
+  delete [] allocated;
+}
+
+__attribute__((noinline)) void measureMemory(cie_MemoryProbe *probe) {
+  CIE_MEMORY_SCOPE(probe);
+  useMemory(probe);
+}
+
+test(memory_probe_must_see_the_peak_stack_and_heap_of_an_operation) {
+  cie_MemoryProbe probe;
+  measureMemory(&probe);
+  cie_MemoryUsage disabled = probe.getUsage();
+  probe.setEnabled(true);
+  measureMemory(&probe);
+  cie_MemoryUsage usage = probe.getUsage();
+
+  assertEqual(0, disabled.stack);
+  assertEqual(0, disabled.heap);
+  assertMoreOrEqual(usage.stack, 0x0800);
+  assertLess(usage.stack, STACK_PAINT_LENGTH);
+  assertEqual(false, usage.stackOverflowed);
+  assertMoreOrEqual(usage.heap, 0x1000);
+}
+
+test(identify_must_stay_within_its_budget) {
+  cie_Cost cost;
+  assertEqual(true, measure("identify", runIdentify, &cost));
+  assertLessOrEqual(cost.apdus, 2);
+  assertLessOrEqual(cost.bytes, 39);
+  assertLessOrEqual(cost.allocations, 2);
+  assertLessOrEqual(cost.stack, 4608);
+  assertLessOrEqual(cost.heap, 256);
+}
+
+test(read_EF_SN_ICC_must_stay_within_its_budget) {
+  cie_Cost cost;
+  assertEqual(true, measure("read_EF_SN_ICC", runReadSnIcc, &cost));
+  assertLessOrEqual(cost.apdus, 4);
+  assertLessOrEqual(cost.bytes, 64);
+  assertLessOrEqual(cost.allocations, 4);
+  assertLessOrEqual(cost.stack, 1536);
+  assertLessOrEqual(cost.heap, 256);
+}
+
+test(read_EF_ID_Servizi_must_stay_within_its_budget) {
+  cie_Cost cost;
+  assertEqual(true, measure("read_EF_ID_Servizi", runReadIdServizi, &cost));
+  assertLessOrEqual(cost.apdus, 3);
+  assertLessOrEqual(cost.bytes, 59);
+  assertLessOrEqual(cost.allocations, 3);
+  assertLessOrEqual(cost.stack, 1536);
+  assertLessOrEqual(cost.heap, 256);
+}
+
+test(read_EF_DH_must_stay_within_its_budget) {
+  cie_Cost cost;
+  assertEqual(true, measure("read_EF_DH", runReadDh, &cost));
+  assertLessOrEqual(cost.apdus, 6);
+  assertLessOrEqual(cost.bytes, 357);
+  assertLessOrEqual(cost.allocations, 7);
+  assertLessOrEqual(cost.stack, 2048);
+  assertLessOrEqual(cost.heap, 512);
+}
+
+test(read_EF_ATR_must_stay_within_its_budget) {
+  cie_Cost cost;
+  assertEqual(true, measure("read_EF_ATR", runReadAtr, &cost));
+  assertLessOrEqual(cost.apdus, 5);
+  assertLessOrEqual(cost.bytes, 119);
+  assertLessOrEqual(cost.allocations, 5);
+  assertLessOrEqual(cost.stack, 1536);
+  assertLessOrEqual(cost.heap, 256);
+}
+
+test(read_EF_Int_Kpub_must_stay_within_its_budget) {
+  cie_Cost cost;
+  assertEqual(true, measure("read_EF_Int_Kpub", runReadIntKpub, &cost));
+  assertLessOrEqual(cost.apdus, 5);
+  assertLessOrEqual(cost.bytes, 346);
+  assertLessOrEqual(cost.allocations, 5);
+  assertLessOrEqual(cost.stack, 1536);
+  assertLessOrEqual(cost.heap, 256);
+}
+
+test(read_EF_Servizi_Int_Kpub_must_stay_within_its_budget) {
+  cie_Cost cost;
+  assertEqual(true, measure("read_EF_Servizi_Int_Kpub", runReadServiziIntKpub, &cost));
+  assertLessOrEqual(cost.apdus, 5);
+  assertLessOrEqual(cost.bytes, 346);
+  assertLessOrEqual(cost.allocations, 5);
+  assertLessOrEqual(cost.stack, 1536);
+  assertLessOrEqual(cost.heap, 256);
+}
+
+test(startRead_must_stay_within_its_budget) {
+  cie_Cost cost;
+  assertEqual(true, measure("startRead_EF_ID_Servizi", runStartRead, &cost));
+  assertLessOrEqual(cost.apdus, 3);
+  assertLessOrEqual(cost.bytes, 59);
+  assertLessOrEqual(cost.allocations, 3);
+  assertLessOrEqual(cost.stack, 1024);
+  assertLessOrEqual(cost.heap, 256);
+}
+
+test(hashElementaryFile_must_stay_within_its_budget) {
+  cie_Cost cost;
+  assertEqual(true, measure("hashElementaryFile", runHashElementaryFile, &cost));
+  assertLessOrEqual(cost.apdus, 4);
+  assertLessOrEqual(cost.bytes, 332);
+  assertLessOrEqual(cost.allocations, 4);
+  assertLessOrEqual(cost.stack, 1536);
+  assertLessOrEqual(cost.heap, 256);
+}
+
+test(parse_EF_SOD_must_stay_within_its_budget) {
+  cie_Cost cost;
+  assertEqual(true, measure("parse_EF_SOD", cardWithSod(false), runParseSod, &cost));
+  assertLessOrEqual(cost.apdus, 7);
+  assertLessOrEqual(cost.bytes, 1023);
+  assertLessOrEqual(cost.allocations, 8);
+  assertLessOrEqual(cost.stack, 1536);
+  assertLessOrEqual(cost.heap, 768);
+}
+
+test(verify_EF_SOD_must_stay_within_its_budget) {
+  cie_Cost cost;
+  assertEqual(true, measure("verify_EF_SOD", cardWithSod(true), runVerifySod, &cost));
+  assertLessOrEqual(cost.apdus, 8);
+  assertLessOrEqual(cost.bytes, 637);
+  assertLessOrEqual(cost.allocations, 10);
+  assertLessOrEqual(cost.stack, 4608);
+  assertLessOrEqual(cost.heap, 256);
+}
+
+test(verify_EF_SOD_Signature_must_stay_within_its_budget) {
+  cie_Cost cost;
+  assertEqual(true, measure("verify_EF_SOD_Signature", cardWithSod(false), runVerifySodSignature, &cost));
+  assertLessOrEqual(cost.apdus, 21);
+  assertLessOrEqual(cost.bytes, 2807);
+  assertLessOrEqual(cost.allocations, 32);
+  assertLessOrEqual(cost.stack, 5632);
+  assertLessOrEqual(cost.heap, 3072);
+}
+
+test(isCardValid_must_stay_within_its_budget) {
+  cie_Cost cost;
+  assertEqual(true, measure("isCardValid", runIsCardValid, &cost));
+  assertLessOrEqual(cost.apdus, 7);
+  assertLessOrEqual(cost.bytes, 631);
+  assertLessOrEqual(cost.allocations, 14);
+  assertLessOrEqual(cost.stack, 2560);
+  //The work area of the RSA operations is kept for the next card
+  assertLessOrEqual(cost.heap, 1024);
+}
+
+void setup() {
+  Serial.begin(9600);
+  while(!Serial); // for the Arduino Leonardo/Micro only
+}
+
+void loop() {
+  Test::run();
+}
@@ -0,0 +1,55 @@
+/**************************************************************************/
+/*!
+    @file     cie_AllocationCounter.cpp
+    @author   Developers Italia
+    @license  BSD (see License)
+
+	Replaces the global operator new and delete to count the heap allocations
+
+	@section  HISTORY
+
+	v1.0  - Counts operator new and new[]
+*/
+/**************************************************************************/
+#include "cie_AllocationCounter.h"
+#include <cstdlib>
+#include <new>
+
+static unsigned long allocationCount = 0;
+
+unsigned long getAllocationCount() {
+  return allocationCount;
+}
+
+void resetAllocationCount() {
+  allocationCount = 0;
+}
+
+void *operator new(std::size_t size) {
+  allocationCount++;
+  void *pointer = malloc(size == 0 ? 1 : size);
+  if (pointer == NULL) {
+    throw std::bad_alloc();
+  }
+  return pointer;
+}
+
+void *operator new[](std::size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void *pointer) noexcept {
+  free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept {
+  free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t size) noexcept {
+  free(pointer);
+}
+
+void operator delete[](void *pointer, std::size_t size) noexcept {
+  free(pointer);
+}
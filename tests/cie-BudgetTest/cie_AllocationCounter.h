@@ -0,0 +1,17 @@
+/**************************************************************************/
+/*!
+  @file     cie_AllocationCounter.h
+  @author   Developers italia
+  @license  BSD (see license)
+  Counts the heap allocations of the process by replacing the global
+  operator new. Hosts only.
+
+*/
+/**************************************************************************/
+#ifndef CIE_ALLOCATION_COUNTER
+#define CIE_ALLOCATION_COUNTER
+
+unsigned long getAllocationCount();
+void resetAllocationCount();
+
+#endif
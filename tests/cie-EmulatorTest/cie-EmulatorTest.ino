@@ -0,0 +1,382 @@
+/**************************************************************************/
+/*!
+  @file     CIE-EmulatorTest.ino
+  @author   Developers italia
+  @license  BSD (see license)
+  End-to-end tests of the reader paths against a CIE emulated in software.
+  This runs on Linux hosts only.
+
+*/
+/**************************************************************************/
+#include <ArduinoUnit.h>
+#include <cie_PN532.h>
+#include <cie_Nfc_Emulator.h>
+#include <cie_Nfc_Recorder.h>
+#include <cie_Nfc_Replayer.h>
+
+//A trace kept in memory
+class cie_TraceBuffer : public Print {
+  public:
+    cie_TraceBuffer() : length(0) {}
+    using Print::write;
+    size_t write(uint8_t octet) {
+      if (length == sizeof(buffer)) {
+        return 0;
+      }
+      buffer[length++] = octet;
+      return 1;
+    }
+    byte buffer[0x1000];
+    unsigned long length;
+};
+
+//The last telemetry frame received
+byte telemetryFrame[TELEMETRY_FRAME_LENGTH];
+byte telemetryFrames = 0;
+
+void receiveTelemetry(const byte *frame, const byte frameLength) {
+  memcpy(telemetryFrame, frame, frameLength);
+  telemetryFrames++;
+}
+
+word frameWord(const byte offset) {
+  return telemetryFrame[offset] | (telemetryFrame[offset + 1] << 8);
+}
+
+//The emulated card, with a pattern instead of random bytes so that they can be found in a trace
+#define RANDOM_PATTERN                        (0x5A)
+
+class cie_Nfc_PatternRandom : public cie_Nfc_Emulator {
+  public:
+    void generateRandomBytes(byte *buffer, const word offset, const byte length) {
+      memset(buffer + offset, RANDOM_PATTERN, length);
+    }
+};
+
+//Counts the runs of at least CHALLENGE_LENGTH bytes of the random pattern
+byte countPatternRuns(const byte *buffer, const unsigned long length) {
+  byte runs = 0;
+  word runLength = 0;
+  for (unsigned long i = 0; i < length; i++) {
+    runLength = buffer[i] == RANDOM_PATTERN ? runLength + 1 : 0;
+    if (runLength == CHALLENGE_LENGTH) {
+      runs++;
+    }
+  }
+  return runs;
+}
+
+//Records a session reading the EF_SN_ICC and the EF_ID_Servizi, then checking the card is not a clone
+void recordSession(cie_TraceBuffer *trace, word *commandCount, const bool recordRandomBytes) {
+  cie_Nfc_Emulator *card = new cie_Nfc_Emulator();
+  cie_Nfc_Recorder *recorder = new cie_Nfc_Recorder(card, trace);
+  recorder->setRecordRandomBytes(recordRandomBytes);
+  cie_PN532 cie(recorder);
+  byte buffer[EF_ID_SERVIZI_LENGTH];
+  word length;
+  cie.begin();
+  cie.detectCard();
+  length = EF_SN_ICC_LENGTH;
+  cie.read_EF_SN_ICC(buffer, &length);
+  length = EF_ID_SERVIZI_LENGTH;
+  cie.read_EF_ID_Servizi(buffer, &length);
+  cie.isCardValid();
+  *commandCount = card->getCommandCount();
+}
+
+test(every_reader_path_must_read_the_emulated_files) {
+  cie_Nfc_Emulator *card = new cie_Nfc_Emulator();
+  cie_PN532 cie(card);
+  byte buffer[0x200];
+  cie_Key key;
+
+  assertEqual(true, cie.detectCard());
+  word snLength = EF_SN_ICC_LENGTH;
+  bool snRead = cie.read_EF_SN_ICC(buffer, &snLength);
+  byte sn0 = buffer[0];
+  word idLength = EF_ID_SERVIZI_LENGTH;
+  bool idRead = cie.read_EF_ID_Servizi(buffer, &idLength);
+  byte id0 = buffer[0];
+  word dhLength = sizeof(buffer);
+  bool dhRead = cie.read_EF_DH(buffer, &dhLength);
+  word atrLength = sizeof(buffer);
+  bool atrRead = cie.read_EF_ATR(buffer, &atrLength);
+  bool keyRead = cie.read_EF_Servizi_Int_Kpub(&key);
+
+  assertEqual(true, snRead);
+  assertEqual(0x10, sn0);
+  assertEqual(true, idRead);
+  assertEqual(0x30, id0);
+  assertEqual(true, dhRead);
+  assertEqual(CARD_EMULATOR_DH_LENGTH, dhLength);
+  assertEqual(true, atrRead);
+  assertEqual(CARD_EMULATOR_ATR_LENGTH, atrLength);
+  assertEqual(true, keyRead);
+  assertEqual(CARD_EMULATOR_KEY_LENGTH + 1, key.modulusLength);
+  assertEqual(3, key.exponentLength);
+}
+
+test(internal_authentication_must_sign_fresh_challenges_with_the_test_key) {
+  cie_Nfc_Emulator *card = new cie_Nfc_Emulator();
+  cie_PN532 cie(card);
+  cie.begin();
+
+  cie.detectCard();
+  bool valid = cie.isCardValid();
+  bool validAgain = cie.isCardValid();
+  //A clone with someone else's public key
+  cie_Key key;
+  cie.read_EF_Int_Kpub(&key);
+  byte otherKey[EF_SERVIZI_INT_KPUB_LENGTH];
+  word length = EF_SERVIZI_INT_KPUB_LENGTH;
+  cie_EFPath filePath = { CIE_DF, SELECT_BY_SFI, 0x05 };
+  cie.readElementaryFile(filePath, otherKey, &length, FIXED_LENGTH);
+  otherKey[0x80] ^= 0x01;
+  card->addFile(CIE_DF, 0x1005, 0x05, otherKey, sizeof(otherKey));
+  cie.detectCard();
+  bool cloneValid = cie.isCardValid();
+
+  assertEqual(true, valid);
+  assertEqual(true, validAgain);
+  assertEqual(false, cloneValid);
+}
+
+test(commands_must_fail_without_the_card_or_the_file) {
+  cie_Nfc_Emulator *card = new cie_Nfc_Emulator();
+  cie_PN532 cie(card);
+  byte buffer[EF_SN_ICC_LENGTH];
+
+  cie.detectCard();
+  //No EF.SOD unless a test adds one
+  word sodLength = sizeof(buffer);
+  cie_EFPath sodPath = { CIE_DF, SELECT_BY_SFI, 0x06 };
+  bool sodRead = cie.readElementaryFile(sodPath, buffer, &sodLength, FIXED_LENGTH);
+  card->setCardPresent(false);
+  bool detected = cie.detectCard();
+  word snLength = EF_SN_ICC_LENGTH;
+  bool snRead = cie.read_EF_SN_ICC(buffer, &snLength);
+
+  assertEqual(false, sodRead);
+  assertEqual(false, detected);
+  assertEqual(false, snRead);
+}
+
+test(exchanges_must_take_as_long_as_the_latency_model_says) {
+  cie_Nfc_Emulator *card = new cie_Nfc_Emulator();
+  cie_PN532 cie(card);
+  byte buffer[EF_ID_SERVIZI_LENGTH];
+  word length = EF_ID_SERVIZI_LENGTH;
+
+  card->setLatency(2000, 20);
+  cie.detectCard();
+  unsigned long startedAt = micros();
+  bool read = cie.read_EF_ID_Servizi(buffer, &length);
+  unsigned long elapsed = micros() - startedAt;
+  unsigned long modelled = card->getCommandCount() * 2000 + card->getBytesExchanged() * 20;
+
+  assertEqual(true, read);
+  assertEqual(3, card->getCommandCount());
+  assertTrue(elapsed >= modelled);
+}
+
+test(metrics_must_count_commands_by_instruction_with_their_status_and_latency) {
+  cie_Nfc_Emulator *card = new cie_Nfc_Emulator();
+  cie_PN532 cie(card);
+  byte buffer[EF_ID_SERVIZI_LENGTH];
+  word length = EF_ID_SERVIZI_LENGTH;
+
+  card->setLatency(2000, 20);
+  cie.detectCard();
+  bool read = cie.read_EF_ID_Servizi(buffer, &length);
+  //No EF.SOD: the READ BINARY fails
+  length = EF_ID_SERVIZI_LENGTH;
+  cie_EFPath sodPath = { CIE_DF, SELECT_BY_SFI, 0x06 };
+  bool sodRead = cie.readElementaryFile(sodPath, buffer, &length, FIXED_LENGTH);
+  const cie_InsMetrics *select = cie.getMetrics(METRICS_INS_SELECT);
+  const cie_InsMetrics *readBinary = cie.getMetrics(METRICS_INS_READ_BINARY);
+
+  assertEqual(true, read);
+  assertEqual(false, sodRead);
+  assertEqual(2, select->count);
+  assertEqual(2, select->statusWords[METRICS_SW_SUCCESS]);
+  assertEqual(2, readBinary->count);
+  assertEqual(1, readBinary->statusWords[METRICS_SW_SUCCESS]);
+  assertEqual(1, readBinary->statusWords[METRICS_SW_ERROR]);
+  assertEqual(0, cie.getMetrics(METRICS_INS_INTERNAL_AUTHENTICATE)->count);
+  //Each exchange takes at least 2 ms on the card, which the histogram puts at 2048 microseconds or more
+  assertTrue(select->cardMicros >= 4000);
+  assertEqual(0, readBinary->cardHistogram[cie_Metrics::bucket(1999)]);
+  assertEqual(2, readBinary->cardHistogram[cie_Metrics::bucket(2000)] + readBinary->cardHistogram[cie_Metrics::bucket(2000) + 1]);
+  assertTrue(cie.getMetrics(METRICS_INS_COUNT) == NULL);
+  cie.clearMetrics();
+  assertEqual(0, select->count);
+}
+
+test(telemetry_must_sum_up_the_taps_in_a_frame) {
+  cie_Nfc_Emulator *card = new cie_Nfc_Emulator();
+  cie_PN532 cie(card);
+  cie_Telemetry telemetry;
+  byte buffer[EF_ID_SERVIZI_LENGTH];
+  word length;
+  cie_EFPath sodPath = { CIE_DF, SELECT_BY_SFI, 0x06 };
+
+  cie.begin();
+  cie.setTelemetry(&telemetry);
+  telemetry.setCallback(receiveTelemetry);
+  card->setLatency(1000, 0);
+  for (byte i = 0; i < 3; i++) {
+    cie.detectCard();
+    length = EF_ID_SERVIZI_LENGTH;
+    cie.read_EF_ID_Servizi(buffer, &length);
+    cie.isCardValid();
+  }
+  //No EF.SOD: a failed READ BINARY
+  length = EF_ID_SERVIZI_LENGTH;
+  cie.readElementaryFile(sodPath, buffer, &length, FIXED_LENGTH);
+  card->setCardPresent(false);
+  cie.detectCard();
+  bool early = telemetry.update();
+  telemetry.emit();
+  byte checksum = 0;
+  for (byte i = 0; i < TELEMETRY_FRAME_LENGTH; i++) {
+    checksum += telemetryFrame[i];
+  }
+
+  assertEqual(false, early);
+  assertEqual(1, telemetryFrames);
+  assertEqual(TELEMETRY_FRAME_MAGIC, telemetryFrame[0]);
+  assertEqual(TELEMETRY_FRAME_VERSION, telemetryFrame[1]);
+  assertEqual(TELEMETRY_FRAME_LENGTH, telemetryFrame[2]);
+  assertEqual(0, telemetryFrame[3]);
+  assertEqual(0, checksum);
+  assertEqual(3, frameWord(0x08));
+  //Each tap takes at least 10 exchanges of 1 ms
+  assertMoreOrEqual(frameWord(0x0C), 10);
+  assertMoreOrEqual(frameWord(0x0E), frameWord(0x0C));
+  assertMoreOrEqual(frameWord(0x10), frameWord(0x0E));
+  assertEqual(card->getCommandCount(), frameWord(0x12));
+  assertEqual(1000 / card->getCommandCount(), frameWord(0x14));
+  assertEqual(TELEMETRY_NO_RATIO, frameWord(0x16));
+  assertEqual(1000, frameWord(0x18));
+  assertEqual(666, frameWord(0x1A));
+  assertMore(telemetryFrame[0x1C] | (telemetryFrame[0x1D] << 8), 0);
+  //The next period starts from zero
+  telemetry.emit();
+  assertEqual(1, telemetryFrame[3]);
+  assertEqual(0, frameWord(0x08));
+  assertEqual(TELEMETRY_NO_RATIO, frameWord(0x14));
+}
+
+test(a_recorded_session_must_replay_with_the_same_outcome) {
+  cie_TraceBuffer trace;
+  word recordedCommands;
+  recordSession(&trace, &recordedCommands, true);
+  cie_Nfc_Replayer *replayer = new cie_Nfc_Replayer(trace.buffer, trace.length);
+  cie_PN532 cie(replayer);
+  byte sn[EF_SN_ICC_LENGTH];
+  word snLength = EF_SN_ICC_LENGTH;
+  byte id[EF_ID_SERVIZI_LENGTH];
+  word idLength = EF_ID_SERVIZI_LENGTH;
+
+  cie.begin();
+  bool detected = cie.detectCard();
+  bool snRead = cie.read_EF_SN_ICC(sn, &snLength);
+  bool idRead = cie.read_EF_ID_Servizi(id, &idLength);
+  //The challenges are the recorded ones, so the recorded signature is valid
+  bool valid = cie.isCardValid();
+
+  assertEqual(true, replayer->isValid());
+  assertEqual(true, detected);
+  assertEqual(true, snRead);
+  assertEqual(0x10, sn[0]);
+  assertEqual(true, idRead);
+  assertEqual(0x30, id[0]);
+  assertEqual(true, valid);
+  assertEqual(recordedCommands, replayer->getExchangeCount());
+  assertEqual(false, replayer->hasDiverged());
+  assertEqual(true, replayer->isFinished());
+  assertEqual(false, cie.detectCard());
+}
+
+test(a_trace_must_leave_out_the_random_bytes_unless_asked_for) {
+  cie_TraceBuffer trace;
+  cie_TraceBuffer secretTrace;
+  cie_Nfc_Recorder *recorder = new cie_Nfc_Recorder(new cie_Nfc_PatternRandom(), &trace);
+  cie_Nfc_Recorder *secretRecorder = new cie_Nfc_Recorder(new cie_Nfc_PatternRandom(), &secretTrace);
+  secretRecorder->setRecordRandomBytes(true);
+  cie_PN532 cie(recorder);
+  cie_PN532 secret(secretRecorder);
+  cie.begin();
+  cie.detectCard();
+  cie.isCardValid();
+  secret.begin();
+  secret.detectCard();
+  secret.isCardValid();
+  cie_Nfc_Replayer *replayer = new cie_Nfc_Replayer(trace.buffer, trace.length);
+  cie_PN532 replayed(replayer);
+
+  replayed.begin();
+  replayed.detectCard();
+  //The challenge isn't the recorded one
+  bool valid = replayed.isCardValid();
+
+  //The challenge is in the INTERNAL AUTHENTICATE command anyway, and in the random bytes if they're recorded
+  assertEqual(1, countPatternRuns(trace.buffer, trace.length));
+  assertEqual(2, countPatternRuns(secretTrace.buffer, secretTrace.length));
+  assertEqual(false, valid);
+  assertEqual(true, replayer->hasDiverged());
+}
+
+test(a_replay_must_diverge_unless_lenient_when_commands_are_not_sent_anymore) {
+  cie_TraceBuffer trace;
+  word recordedCommands;
+  recordSession(&trace, &recordedCommands, false);
+  byte id[EF_ID_SERVIZI_LENGTH];
+  word idLength = EF_ID_SERVIZI_LENGTH;
+
+  //The EF_SN_ICC is not read anymore
+  cie_Nfc_Replayer *strictReplayer = new cie_Nfc_Replayer(trace.buffer, trace.length);
+  cie_PN532 strict(strictReplayer);
+  strict.begin();
+  strict.detectCard();
+  bool strictRead = strict.read_EF_ID_Servizi(id, &idLength);
+  cie_Nfc_Replayer *lenientReplayer = new cie_Nfc_Replayer(trace.buffer, trace.length);
+  lenientReplayer->setLenient(true);
+  cie_PN532 lenient(lenientReplayer);
+  lenient.begin();
+  lenient.detectCard();
+  idLength = EF_ID_SERVIZI_LENGTH;
+  bool lenientRead = lenient.read_EF_ID_Servizi(id, &idLength);
+
+  assertEqual(false, strictRead);
+  assertEqual(true, strictReplayer->hasDiverged());
+  assertEqual(true, lenientRead);
+  assertEqual(0x30, id[0]);
+  assertEqual(false, lenientReplayer->hasDiverged());
+  //SELECT MF, SELECT EF, READ BINARY and SELECT of the IAS application once more
+  assertEqual(4, lenientReplayer->getSkippedExchangeCount());
+}
+
+test(a_replay_must_diverge_on_a_recorded_uid_longer_than_a_card_id) {
+  //Header, then a TRACE_UID record of 0x20 octets
+  byte trace[TRACE_HEADER_LENGTH + 3 + 0x20] = { 'C', 'I', 'E', 'T', TRACE_VERSION, TRACE_UID, 0x00, 0x20 };
+  memset(trace + TRACE_HEADER_LENGTH + 3, 0x41, 0x20);
+  cie_Nfc_Replayer replayer(trace, sizeof(trace));
+  byte uid[RECENT_CARD_ID_LENGTH + 1];
+  uid[RECENT_CARD_ID_LENGTH] = 0x00;
+
+  byte uidLength = replayer.getUid(uid);
+
+  assertEqual(0, uidLength);
+  assertEqual(0x00, uid[RECENT_CARD_ID_LENGTH]);
+  assertEqual(true, replayer.hasDiverged());
+}
+
+void setup(void) {
+  Serial.begin(115200);
+}
+
+
+void loop(void) {
+  Test::run();
+}
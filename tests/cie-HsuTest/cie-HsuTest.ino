@@ -0,0 +1,279 @@
+/**************************************************************************/
+/*!
+  @file     CIE-HsuTest.ino
+  @author   Developers italia
+  @license  BSD (see license)
+  Tests for the cie_Nfc_HSU transport against a PN532 emulated on a
+  pseudo-terminal. This runs on Linux hosts only.
+
+*/
+/**************************************************************************/
+#include <ArduinoUnit.h>
+#include <cie_PN532.h>
+#include <cie_Nfc_HSU.h>
+#include "cie_HsuFixture.h"
+
+//A card taking a while to answer each command
+class cie_Nfc_SlowEcho : public cie_Nfc_Echo {
+  public:
+    bool sendCommand(byte *command, byte commandLength, byte *response, word *responseLength) {
+      delay(40);
+      return cie_Nfc_Echo::sendCommand(command, commandLength, response, responseLength);
+    }
+};
+
+test(hsu_transport_must_read_an_elementary_file_through_the_emulated_pn532) {
+  cie_Nfc_Echo card;
+  cie_HsuFixture hsu(&card);
+  cie_PN532 &cie = hsu.cie;
+  assertEqual(true, hsu.started);
+
+  word bufferLength = EF_ID_SERVIZI_LENGTH;
+  byte buffer[EF_ID_SERVIZI_LENGTH];
+  bool detected = cie.detectCard();
+  bool success = cie.read_EF_ID_Servizi(buffer, &bufferLength);
+
+  assertEqual(true, detected);
+  assertEqual(true, success);
+  assertEqual(EF_ID_SERVIZI_LENGTH, bufferLength);
+  assertEqual(0x0B, buffer[EF_ID_SERVIZI_LENGTH-1]);
+}
+
+test(hsu_transport_must_not_detect_a_card_outside_the_field) {
+  cie_Nfc_Echo card;
+  cie_HsuFixture hsu(&card);
+  cie_Pn532Emulator &emulator = hsu.emulator;
+  cie_PN532 &cie = hsu.cie;
+  assertEqual(true, hsu.started);
+  emulator.setCardPresent(false);
+
+  bool detected = cie.detectCard();
+
+  assertEqual(false, detected);
+}
+
+test(hsu_transport_must_fail_detection_instead_of_halting_without_a_pn532) {
+  cie_Nfc_HSU *nfc = new cie_Nfc_HSU("/nonexistent/ttyPN532");
+  cie_PN532 cie(nfc);
+
+  //begin() must return, so that the caller can give up or retry
+  cie.begin();
+  bool detected = cie.detectCard();
+
+  assertEqual(false, detected);
+}
+
+test(wait_for_card_must_use_auto_poll_and_leave_the_pn532_ready_for_apdus) {
+  cie_Nfc_Echo card;
+  cie_HsuFixture hsu(&card);
+  cie_Pn532Emulator &emulator = hsu.emulator;
+  cie_PN532 &cie = hsu.cie;
+  assertEqual(true, hsu.started);
+  emulator.setCardPresent(false);
+
+  //Nobody taps: the pending InAutoPoll must be aborted when giving up
+  bool timedOut = !cie.waitForCard(300, DEFAULT_POLL_PERIOD);
+  emulator.setCardPresent(true);
+  bool detected = cie.waitForCard(1000, DEFAULT_POLL_PERIOD);
+  word bufferLength = EF_SN_ICC_LENGTH;
+  byte buffer[EF_SN_ICC_LENGTH];
+  bool success = cie.read_EF_SN_ICC(buffer, &bufferLength);
+
+  assertEqual(true, timedOut);
+  assertEqual(true, detected);
+  assertEqual(true, success);
+}
+
+test(detect_card_must_negotiate_the_fastest_bit_rate_and_fall_back_when_refused) {
+  cie_Nfc_Echo card;
+  cie_HsuFixture hsu(&card);
+  cie_Pn532Emulator &emulator = hsu.emulator;
+  cie_PN532 &cie = hsu.cie;
+  assertEqual(true, hsu.started);
+
+  //The card advertises 212 and 424 kbps
+  bool detected = cie.detectCard();
+  word fastest = cie.getBitRate();
+  emulator.setMaxBitRate(0x01);
+  bool redetected = cie.detectCard();
+  word fallback = cie.getBitRate();
+  cie.setMaxBitRate(BIT_RATE_106);
+  cie.detectCard();
+  word limited = cie.getBitRate();
+  word bufferLength = EF_SN_ICC_LENGTH;
+  byte buffer[EF_SN_ICC_LENGTH];
+  bool success = cie.read_EF_SN_ICC(buffer, &bufferLength);
+
+  assertEqual(true, detected);
+  assertEqual(BIT_RATE_424, fastest);
+  assertEqual(true, redetected);
+  assertEqual(BIT_RATE_212, fallback);
+  assertEqual(BIT_RATE_106, limited);
+  assertEqual(true, success);
+}
+
+test(detect_card_must_fail_when_the_card_is_lost_while_negotiating_the_bit_rate) {
+  cie_Nfc_Echo card;
+  cie_HsuFixture hsu(&card);
+  cie_Pn532Emulator &emulator = hsu.emulator;
+  cie_PN532 &cie = hsu.cie;
+  assertEqual(true, hsu.started);
+
+  //The card refuses 424 kbps and leaves the field before it can be activated again
+  emulator.setMaxBitRate(0x01);
+  emulator.setLeaveOnRefusedBitRate(true);
+  bool detected = cie.detectCard();
+  word bitRate = cie.getBitRate();
+
+  assertEqual(false, detected);
+  assertEqual(BIT_RATE_NONE, bitRate);
+}
+
+test(identify_must_stay_within_its_exchange_budget) {
+  cie_Nfc_Echo card;
+  cie_HsuFixture hsu(&card);
+  cie_Pn532Emulator &emulator = hsu.emulator;
+  cie_PN532 &cie = hsu.cie;
+  assertEqual(true, hsu.started);
+
+  word framesBefore = emulator.framesReceived();
+  word bufferLength = EF_ID_SERVIZI_LENGTH;
+  byte buffer[EF_ID_SERVIZI_LENGTH];
+  bool success = cie.identify(buffer, &bufferLength);
+  word frames = emulator.framesReceived() - framesBefore;
+
+  assertEqual(true, success);
+  assertEqual(EF_ID_SERVIZI_LENGTH, bufferLength);
+  assertEqual(IDENTIFY_EXCHANGE_BUDGET, frames);
+  assertEqual(2, cie.getApduCount());
+}
+
+test(identify_must_suppress_duplicate_taps_within_the_hold_off_time) {
+  cie_Nfc_Echo card;
+  cie_HsuFixture hsu(&card);
+  cie_Pn532Emulator &emulator = hsu.emulator;
+  cie_PN532 &cie = hsu.cie;
+  assertEqual(true, hsu.started);
+  cie.setHoldOff(10000);
+
+  word bufferLength = EF_ID_SERVIZI_LENGTH;
+  byte buffer[EF_ID_SERVIZI_LENGTH];
+  bool first = cie.identify(buffer, &bufferLength);
+  //The card rests on the reader: just a presence check
+  word framesBefore = emulator.framesReceived();
+  bool resting = cie.identify(buffer, &bufferLength);
+  word restingFrames = emulator.framesReceived() - framesBefore;
+  bool restingRepeated = cie.isRepeatedTap();
+  //The card leaves and comes back: the emulated UID is random, so the ID tells it's the same card
+  emulator.setCardPresent(false);
+  bool gone = cie.identify(buffer, &bufferLength);
+  bool goneRepeated = cie.isRepeatedTap();
+  emulator.setCardPresent(true);
+  bool again = cie.identify(buffer, &bufferLength);
+  bool againRepeated = cie.isRepeatedTap();
+
+  assertEqual(true, first);
+  assertEqual(false, resting);
+  assertEqual(1, restingFrames);
+  assertEqual(true, restingRepeated);
+  assertEqual(false, gone);
+  assertEqual(false, goneRepeated);
+  assertEqual(false, again);
+  assertEqual(true, againRepeated);
+}
+
+test(reads_must_stop_at_the_deadline_with_partial_results) {
+  cie_Nfc_SlowEcho card;
+  cie_HsuFixture hsu(&card);
+  cie_PN532 &cie = hsu.cie;
+  assertEqual(true, hsu.started);
+  cie.detectCard();
+
+  //SELECT IAS, SELECT CIE DF and then 4 pages: way more than the deadline allows
+  cie_EFPath filePath = { CIE_DF, SELECT_BY_SFI, 0x06 };
+  word bufferLength = 4 * PAGE_LENGTH;
+  byte *buffer = new byte[bufferLength];
+  cie.setDeadline(200);
+  unsigned long startedAt = millis();
+  bool success = cie.readElementaryFile(filePath, buffer, &bufferLength, FIXED_LENGTH);
+  unsigned long elapsed = millis() - startedAt;
+  byte error = cie.getLastError();
+  cie.clearDeadline();
+  word idLength = EF_ID_SERVIZI_LENGTH;
+  byte id[EF_ID_SERVIZI_LENGTH];
+  bool successAfterwards = cie.read_EF_ID_Servizi(id, &idLength);
+  delete [] buffer;
+
+  assertEqual(false, success);
+  assertEqual(CIE_ERROR_DEADLINE_EXCEEDED, error);
+  assertTrue(bufferLength > 0);
+  assertTrue(bufferLength < 4 * PAGE_LENGTH);
+  assertEqual(0, bufferLength % PAGE_LENGTH);
+  assertTrue(elapsed < 300);
+  assertEqual(true, successAfterwards);
+}
+
+test(hashed_reads_must_match_the_digest_of_the_buffered_content) {
+  cie_Nfc_Echo card;
+  cie_HsuFixture hsu(&card);
+  cie_PN532 &cie = hsu.cie;
+  assertEqual(true, hsu.started);
+  cie.detectCard();
+
+  //Three pages, the last one partial
+  cie_EFPath filePath = { CIE_DF, SELECT_BY_SFI, 0x06 };
+  word bufferLength = 2 * PAGE_LENGTH + 0x10;
+  byte *buffer = new byte[bufferLength];
+  bool read = cie.readElementaryFile(filePath, buffer, &bufferLength, FIXED_LENGTH);
+  cie_Sha256 sha256;
+  byte expected[SHA256_DIGEST_LENGTH];
+  sha256.begin();
+  sha256.update(buffer, bufferLength);
+  sha256.finish(expected);
+  word hashedLength = bufferLength;
+  byte digest[SHA256_DIGEST_LENGTH];
+  bool hashed = cie.hashElementaryFile(filePath, &sha256, digest, &hashedLength, FIXED_LENGTH);
+  delete [] buffer;
+
+  assertEqual(true, read);
+  assertEqual(true, hashed);
+  assertEqual(bufferLength, hashedLength);
+  assertEqual(0, memcmp(expected, digest, SHA256_DIGEST_LENGTH));
+}
+
+test(hashing_a_file_must_keep_the_read_hash_of_the_caller) {
+  cie_Nfc_Echo card;
+  cie_HsuFixture hsu(&card);
+  cie_PN532 &cie = hsu.cie;
+  assertEqual(true, hsu.started);
+  cie.detectCard();
+
+  cie_EFPath filePath = { CIE_DF, SELECT_BY_SFI, 0x06 };
+  cie_Sha256 readHash;
+  readHash.begin();
+  cie.setReadHash(&readHash);
+  cie_Sha256 fileHash;
+  byte fileDigest[SHA256_DIGEST_LENGTH];
+  word hashedLength = PAGE_LENGTH;
+  bool hashed = cie.hashElementaryFile(filePath, &fileHash, fileDigest, &hashedLength, FIXED_LENGTH);
+  //Only this read must reach the hash of the caller
+  byte buffer[PAGE_LENGTH];
+  word bufferLength = PAGE_LENGTH;
+  bool read = cie.readElementaryFile(filePath, buffer, &bufferLength, FIXED_LENGTH);
+  cie.setReadHash(NULL);
+  byte readDigest[SHA256_DIGEST_LENGTH];
+  readHash.finish(readDigest);
+
+  assertEqual(true, hashed);
+  assertEqual(true, read);
+  assertEqual(0, memcmp(fileDigest, readDigest, SHA256_DIGEST_LENGTH));
+}
+
+void setup(void) {
+  Serial.begin(115200);
+}
+
+
+void loop(void) {
+  Test::run();
+}
@@ -0,0 +1,65 @@
+/**************************************************************************/
+/*!
+  @file     cie_HsuFixture.h
+  @author   Developers italia
+  @license  BSD (see license)
+  A cie_PN532 talking to a card through the cie_Nfc_HSU transport and a
+  PN532 emulated on a pseudo-terminal, stopped when it goes out of scope.
+  Linux hosts only.
+
+*/
+/**************************************************************************/
+#ifndef CIE_HSU_FIXTURE
+#define CIE_HSU_FIXTURE
+
+#include <unistd.h>
+#include <cie_PN532.h>
+#include <cie_Nfc_HSU.h>
+#include <cie_Pn532Emulator.h>
+
+//A card which accepts every command and returns its own offset as content
+class cie_Nfc_Echo : public cie_Nfc {
+  public:
+    void begin() {}
+    bool detectCard() { return true; }
+    bool sendCommand(byte *command, byte commandLength, byte *response, word *responseLength) {
+      word length = 0;
+      if (command[1] == 0xB1) {
+        //READ BINARY with ODD INS: preamble octets, then the content
+        byte pageLength = command[9];
+        for (; length < pageLength; length++) {
+          response[length] = length < 2 ? 0x53 : (byte) (command[8] + length - 2);
+        }
+      }
+      response[length++] = 0x90;
+      response[length++] = 0x00;
+      *responseLength = length;
+      return true;
+    }
+    void generateRandomBytes(byte *buffer, const word offset, const byte length) {}
+};
+
+//The emulated PN532 in front of the card and the reader attached to it, begun
+class cie_HsuFixture {
+  public:
+    cie_HsuFixture(cie_Nfc *card) :
+    emulator(card),
+    started(emulator.start()),
+    fd(started ? emulator.openSlave() : -1),
+    cie(new cie_Nfc_HSU(fd))
+    {
+      cie.begin();
+    }
+    ~cie_HsuFixture() {
+      emulator.stop();
+      if (fd >= 0) {
+        close(fd);
+      }
+    }
+    cie_Pn532Emulator emulator;
+    bool started;
+    int fd;
+    cie_PN532 cie;
+};
+
+#endif
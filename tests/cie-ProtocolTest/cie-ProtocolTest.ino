@@ -0,0 +1,757 @@
+/**************************************************************************/
+/*!
+  @file     CIE-ProtocolTest.ino
+  @author   Developers italia
+  @license  BSD (see license)
+  Tests of the protocols of the card: passive authentication, verification
+  of the Document Signer, IAS ECC secure messaging and PACE, against cards
+  emulated behind a PN532 on a pseudo-terminal (see cie-HsuTest).
+  This runs on Linux hosts only.
+
+*/
+/**************************************************************************/
+#include <ArduinoUnit.h>
+#include <cie_PN532.h>
+#include "cie_HsuFixture.h"
+#include "cie_SodFixture.h"
+
+//A card serving the EF_ID_Servizi, the EF_Servizi_Int_Kpub and a signed EF_SOD listing their SHA-256 hashes
+class cie_Nfc_Files : public cie_Nfc_Echo {
+  public:
+    cie_Nfc_Files() {
+      for (byte i = 0; i < EF_ID_SERVIZI_LENGTH; i++) {
+        idServizi[i] = 0x30 + i;
+      }
+      memcpy(kpub, testKpub, sizeof(kpub));
+      setSod(testSod, TEST_SOD_LENGTH);
+      memset(readsBySfi, 0, sizeof(readsBySfi));
+    }
+    bool sendCommand(byte *command, byte commandLength, byte *response, word *responseLength) {
+      word length = 0;
+      if (command[1] == 0xB1) {
+        byte sfi = command[3] & 0b11111;
+        const byte *file = sfi == 0x01 ? idServizi : (sfi == 0x05 ? kpub : sod);
+        word fileLength = sfi == 0x01 ? sizeof(idServizi) : (sfi == 0x05 ? sizeof(kpub) : sodLength);
+        word offset = command[7] << 8 | command[8];
+        byte preambleOctets = command[9] > 0x82 ? 3 : 2;
+        byte pageLength = command[9] - preambleOctets;
+        readsBySfi[sfi]++;
+        if (offset + pageLength > fileLength) {
+          //Wrong length
+          response[0] = 0x67;
+          response[1] = 0x00;
+          *responseLength = 2;
+          return true;
+        }
+        response[length++] = 0x53;
+        if (preambleOctets == 3) {
+          response[length++] = 0x81;
+        }
+        response[length++] = pageLength;
+        memcpy(response + length, file + offset, pageLength);
+        length += pageLength;
+      }
+      response[length++] = 0x90;
+      response[length++] = 0x00;
+      *responseLength = length;
+      return true;
+    }
+    void setSod(const byte *content, const word length) {
+      memcpy(sod, content, length);
+      sodLength = length;
+    }
+    byte idServizi[EF_ID_SERVIZI_LENGTH];
+    byte kpub[EF_SERVIZI_INT_KPUB_LENGTH];
+    byte sod[TEST_SOD_KPUB_FIRST_LENGTH];
+    word sodLength;
+    word readsBySfi[0x20];
+};
+
+//Static keys and serial number of the terminal for the mutual authentication
+static const byte testDeviceEncKey[SM_KEY_LENGTH] = {
+  0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF, 0xFE, 0xDC, 0xBA, 0x98, 0x76, 0x54, 0x32, 0x10
+};
+static const byte testDeviceMacKey[SM_KEY_LENGTH] = {
+  0x10, 0x32, 0x54, 0x76, 0x98, 0xBA, 0xDC, 0xFE, 0xEF, 0xCD, 0xAB, 0x89, 0x67, 0x45, 0x23, 0x01
+};
+static const byte testDeviceSerialNumber[SN_LENGTH] = { 0x49, 0x46, 0x44, 0x30, 0x30, 0x30, 0x30, 0x31 };
+
+//The same files behind the IAS ECC mutual authentication, then protected by secure messaging
+class cie_Nfc_SecureFiles : public cie_Nfc_Files {
+  public:
+    cie_Nfc_SecureFiles() : active(false), tamperNextResponse(false), protectedCommands(0) {
+      for (byte i = 0; i < CHALLENGE_LENGTH; i++) {
+        rndIcc[i] = 0xA0 + i;
+      }
+    }
+    bool sendCommand(byte *command, byte commandLength, byte *response, word *responseLength) {
+      if (command[1] == 0x84) {
+        memcpy(response, rndIcc, CHALLENGE_LENGTH);
+        response[CHALLENGE_LENGTH] = 0x90;
+        response[CHALLENGE_LENGTH + 1] = 0x00;
+        *responseLength = CHALLENGE_LENGTH + 2;
+        return true;
+      }
+      if (command[1] == 0x82) {
+        return mutualAuthenticate(command, response, responseLength);
+      }
+      if ((command[0] & SM_CLA) != SM_CLA) {
+        return cie_Nfc_Files::sendCommand(command, commandLength, response, responseLength);
+      }
+      if (!active) {
+        return status(0x6988, response, responseLength);
+      }
+      protectedCommands++;
+      return unwrapCommand(command, commandLength, response, responseLength);
+    }
+    bool active;
+    bool tamperNextResponse;
+    word protectedCommands;
+
+  private:
+    bool status(const word statusWord, byte *response, word *responseLength) {
+      response[0] = statusWord >> 8;
+      response[1] = statusWord & 0xFF;
+      *responseLength = 2;
+      return true;
+    }
+    void incrementSsc() {
+      for (int i = DES_BLOCK_LENGTH - 1; i >= 0 && ++ssc[i] == 0; i--);
+    }
+    void deriveKey(const byte *kIfd, const byte *kIcc, const byte counter, byte *key) {
+      byte data[K_LENGTH + 4] = { 0 };
+      byte digest[SHA256_DIGEST_LENGTH];
+      for (byte i = 0; i < K_LENGTH; i++) {
+        data[i] = kIfd[i] ^ kIcc[i];
+      }
+      data[K_LENGTH + 3] = counter;
+      cie_Sha256 sha256;
+      sha256.begin();
+      sha256.update(data, sizeof(data));
+      sha256.finish(digest);
+      memcpy(key, digest, SM_KEY_LENGTH);
+    }
+    bool mutualAuthenticate(byte *command, byte *response, word *responseLength) {
+      byte *e = command + 5;
+      byte mac[SM_MAC_LENGTH];
+      session.setKeys(testDeviceEncKey, testDeviceMacKey);
+      session.computeMac(e, MUTUAL_AUTHENTICATION_LENGTH, mac);
+      if (memcmp(mac, e + MUTUAL_AUTHENTICATION_LENGTH, SM_MAC_LENGTH) != 0) {
+        return status(0x6300, response, responseLength);
+      }
+      session.decrypt(e, MUTUAL_AUTHENTICATION_LENGTH);
+      //The SN.ICC is read from the same file as the EF_SOD by this card
+      const byte *snIcc = sod + EF_SN_ICC_LENGTH - SN_LENGTH;
+      if (memcmp(e + 16, rndIcc, CHALLENGE_LENGTH) != 0 || memcmp(e + 24, snIcc, SN_LENGTH) != 0) {
+        return status(0x6300, response, responseLength);
+      }
+      byte kIcc[K_LENGTH];
+      for (byte i = 0; i < K_LENGTH; i++) {
+        kIcc[i] = 0x5A ^ i;
+      }
+      memcpy(response, rndIcc, CHALLENGE_LENGTH);
+      memcpy(response + 8, snIcc, SN_LENGTH);
+      memcpy(response + 16, e, CHALLENGE_LENGTH + SN_LENGTH);
+      memcpy(response + 32, kIcc, K_LENGTH);
+      session.encrypt(response, MUTUAL_AUTHENTICATION_LENGTH);
+      session.computeMac(response, MUTUAL_AUTHENTICATION_LENGTH, response + MUTUAL_AUTHENTICATION_LENGTH);
+      response[MUTUAL_AUTHENTICATION_LENGTH + SM_MAC_LENGTH] = 0x90;
+      response[MUTUAL_AUTHENTICATION_LENGTH + SM_MAC_LENGTH + 1] = 0x00;
+      *responseLength = MUTUAL_AUTHENTICATION_LENGTH + SM_MAC_LENGTH + 2;
+
+      byte skEnc[SM_KEY_LENGTH];
+      byte skMac[SM_KEY_LENGTH];
+      deriveKey(e + 32, kIcc, SK_ENC, skEnc);
+      deriveKey(e + 32, kIcc, SK_MAC, skMac);
+      session.setKeys(skEnc, skMac);
+      memcpy(ssc, rndIcc + 4, 4);
+      memcpy(ssc + 4, e + 4, 4);
+      active = true;
+      return true;
+    }
+    bool unwrapCommand(byte *command, byte commandLength, byte *response, word *responseLength) {
+      //SSC || padded header || data objects, MACed all at once
+      byte macInput[DES_BLOCK_LENGTH + 8 + 0x100];
+      byte mac[SM_MAC_LENGTH];
+      byte plain[0x100];
+      word dataObjectsLength = command[4] - 2 - SM_MAC_LENGTH;
+      incrementSsc();
+      memcpy(macInput, ssc, DES_BLOCK_LENGTH);
+      memcpy(macInput + DES_BLOCK_LENGTH, command, 4);
+      memcpy(macInput + DES_BLOCK_LENGTH + 4, "\x80\x00\x00\x00", 4);
+      memcpy(macInput + DES_BLOCK_LENGTH + 8, command + 5, dataObjectsLength);
+      session.computeMac(macInput, DES_BLOCK_LENGTH + 8 + dataObjectsLength, mac);
+      if (memcmp(mac, command + 5 + dataObjectsLength + 2, SM_MAC_LENGTH) != 0) {
+        active = false;
+        return status(0x6988, response, responseLength);
+      }
+      byte plainLength = 4;
+      memcpy(plain, command, 4);
+      plain[0] &= ~SM_CLA;
+      word offset = 5;
+      if (command[offset] == SM_DO_CRYPTOGRAM || command[offset] == SM_DO_CRYPTOGRAM_ODD) {
+        byte skip = command[offset] == SM_DO_CRYPTOGRAM ? 1 : 0;
+        word cryptogramLength = command[offset + 1] - skip;
+        byte *cryptogram = command + offset + 2 + skip;
+        session.decrypt(cryptogram, cryptogramLength);
+        while (cryptogram[cryptogramLength - 1] == 0x00) {
+          cryptogramLength--;
+        }
+        cryptogramLength--;
+        plain[plainLength++] = cryptogramLength;
+        memcpy(plain + plainLength, cryptogram, cryptogramLength);
+        plainLength += cryptogramLength;
+        offset += 2 + command[offset + 1];
+      }
+      if (command[offset] == SM_DO_LE) {
+        plain[plainLength++] = command[offset + 2];
+      }
+
+      word length = 0x100;
+      cie_Nfc_Files::sendCommand(plain, plainLength, plain, &length);
+      //Wrap the response: cryptogram, status word and MAC
+      word dataLength = length - 2;
+      word position = 0;
+      if (dataLength > 0) {
+        word cryptogramLength = (dataLength / 8 + 1) * 8;
+        response[position++] = SM_DO_CRYPTOGRAM;
+        if (cryptogramLength + 1 > 0x7F) {
+          response[position++] = 0x81;
+        }
+        response[position++] = cryptogramLength + 1;
+        response[position++] = SM_PADDING_INDICATOR;
+        memcpy(response + position, plain, dataLength);
+        session.pad(response + position, dataLength);
+        session.encrypt(response + position, cryptogramLength);
+        position += cryptogramLength;
+      }
+      response[position++] = SM_DO_STATUS_WORD;
+      response[position++] = 0x02;
+      response[position++] = plain[dataLength];
+      response[position++] = plain[dataLength + 1];
+      incrementSsc();
+      memcpy(macInput, ssc, DES_BLOCK_LENGTH);
+      memcpy(macInput + DES_BLOCK_LENGTH, response, position);
+      response[position++] = SM_DO_MAC;
+      response[position++] = SM_MAC_LENGTH;
+      session.computeMac(macInput, DES_BLOCK_LENGTH + position - 2, response + position);
+      if (tamperNextResponse) {
+        response[position] ^= 0x01;
+        tamperNextResponse = false;
+      }
+      position += SM_MAC_LENGTH;
+      response[position++] = plain[dataLength];
+      response[position++] = plain[dataLength + 1];
+      *responseLength = position;
+      return true;
+    }
+
+    cie_DesSecureMessaging session;
+    byte rndIcc[CHALLENGE_LENGTH];
+    byte ssc[DES_BLOCK_LENGTH];
+};
+
+//The CAN printed on the PACE test card
+static const byte testCan[] = { '1', '2', '3', '4', '5', '6' };
+
+//A card of the ICAO application serving the DG1 and a DG11 longer than 256 bytes behind PACE (generic mapping, AES-128)
+class cie_Nfc_PaceFiles : public cie_Nfc_Echo {
+  public:
+    cie_Nfc_PaceFiles(const byte curve) : curve(curve), protectedCommands(0) {
+      const byte access[] = {
+        0x31, 0x14, 0x30, 0x12, 0x06, PACE_OID_LENGTH, 0x04, 0x00, 0x7F, 0x00, 0x07, 0x02, 0x02, 0x04, 0x02, 0x02,
+        0x02, 0x01, PACE_VERSION, 0x02, 0x01, curve
+      };
+      memcpy(cardAccess, access, sizeof(cardAccess));
+      dg1[0] = 0x61;
+      dg1[1] = sizeof(dg1) - 2;
+      dg1[2] = 0x5F;
+      dg1[3] = 0x1F;
+      dg1[4] = sizeof(dg1) - 5;
+      for (byte i = 5; i < sizeof(dg1); i++) {
+        dg1[i] = 'A' + i % 26;
+      }
+      dg11[0] = 0x6B;
+      dg11[1] = 0x82;
+      dg11[2] = (sizeof(dg11) - 4) >> 8;
+      dg11[3] = (sizeof(dg11) - 4) & 0xFF;
+      for (word i = 4; i < sizeof(dg11); i++) {
+        dg11[i] = (byte) (i * 13);
+      }
+      detectCard();
+    }
+    bool detectCard() {
+      active = false;
+      currentSfi = 0x00;
+      memset(ssc, 0, AES_BLOCK_LENGTH);
+      return true;
+    }
+    bool sendCommand(byte *command, byte commandLength, byte *response, word *responseLength) {
+      if ((command[0] & SM_CLA) == SM_CLA) {
+        if (!active) {
+          return status(0x6988, response, responseLength);
+        }
+        protectedCommands++;
+        return unwrapCommand(command, response, responseLength);
+      }
+      if (command[1] == 0x22) {
+        //MSE:Set AT, the curve must be the one of the EF.CardAccess
+        bool supported = command[5 + 2 + PACE_OID_LENGTH + 5] == curve;
+        ecc.setCurve(curve);
+        return status(supported ? 0x9000 : 0x6A80, response, responseLength);
+      }
+      if (command[1] == 0x86) {
+        return generalAuthenticate(command, response, responseLength);
+      }
+      if (command[1] == 0xB0 && active) {
+        //An ICAO card refuses plain commands during secure messaging
+        active = false;
+        return status(0x6987, response, responseLength);
+      }
+      return execute(command, response, responseLength);
+    }
+    byte curve;
+    byte cardAccess[0x16];
+    byte dg1[0x5F];
+    byte dg11[0x0258];
+    word protectedCommands;
+
+  private:
+    bool status(const word statusWord, byte *response, word *responseLength) {
+      response[0] = statusWord >> 8;
+      response[1] = statusWord & 0xFF;
+      *responseLength = 2;
+      return true;
+    }
+    void deriveKey(const byte *secret, const byte secretLength, const byte counter, byte *key) {
+      byte suffix[4] = { 0x00, 0x00, 0x00, counter };
+      byte digest[SHA1_DIGEST_LENGTH];
+      cie_Sha1 sha1;
+      sha1.begin();
+      sha1.update(secret, secretLength);
+      sha1.update(suffix, sizeof(suffix));
+      sha1.finish(digest);
+      memcpy(key, digest, SM_KEY_LENGTH);
+    }
+    void authenticationToken(const byte *publicKey, byte *token) {
+      byte keyObject[3 + 2 + PACE_OID_LENGTH + 2 + ECC_POINT_LENGTH] = { 0x7F, 0x49, sizeof(keyObject) - 3, 0x06, PACE_OID_LENGTH };
+      byte cmac[AES_BLOCK_LENGTH];
+      memcpy(keyObject + 5, cardAccess + 6, PACE_OID_LENGTH);
+      keyObject[5 + PACE_OID_LENGTH] = 0x86;
+      keyObject[6 + PACE_OID_LENGTH] = ECC_POINT_LENGTH;
+      memcpy(keyObject + 7 + PACE_OID_LENGTH, publicKey, ECC_POINT_LENGTH);
+      session.computeCmac(keyObject, sizeof(keyObject), cmac);
+      memcpy(token, cmac, SM_MAC_LENGTH);
+    }
+    bool respond(const byte tag, const byte *data, const byte dataLength, byte *response, word *responseLength) {
+      response[0] = 0x7C;
+      response[1] = 2 + dataLength;
+      response[2] = tag;
+      response[3] = dataLength;
+      memcpy(response + 4, data, dataLength);
+      response[4 + dataLength] = 0x90;
+      response[5 + dataLength] = 0x00;
+      *responseLength = 6 + dataLength;
+      return true;
+    }
+    bool generalAuthenticate(byte *command, byte *response, word *responseLength) {
+      byte tag = command[6] == 0x00 ? 0x00 : command[7];
+      byte *data = command + 9;
+      byte point[ECC_POINT_LENGTH];
+      byte scalar[ECC_SCALAR_LENGTH];
+      if (tag == 0x00) {
+        //Encrypted nonce
+        byte kPi[SM_KEY_LENGTH];
+        byte encryptedNonce[PACE_NONCE_LENGTH];
+        for (byte i = 0; i < PACE_NONCE_LENGTH; i++) {
+          nonce[i] = 0xC0 + i;
+        }
+        memcpy(encryptedNonce, nonce, PACE_NONCE_LENGTH);
+        deriveKey(testCan, sizeof(testCan), PACE_KEY_PI, kPi);
+        cie_Aes aes;
+        aes.setKey(kPi);
+        aes.encryptBlock(encryptedNonce);
+        return respond(0x80, encryptedNonce, PACE_NONCE_LENGTH, response, responseLength);
+      }
+      if (tag == 0x81) {
+        //Mapping: G' = nonce * G + mapping key * terminal mapping key
+        memset(scalar, 0x11, ECC_SCALAR_LENGTH);
+        byte shared[ECC_POINT_LENGTH];
+        if (!ecc.multiply(scalar, data, shared) || !ecc.multiply(scalar, NULL, point)) {
+          return status(0x6A80, response, responseLength);
+        }
+        ecc.mapGenerator(nonce, PACE_NONCE_LENGTH, shared);
+        return respond(0x82, point, ECC_POINT_LENGTH, response, responseLength);
+      }
+      if (tag == 0x83) {
+        //Key agreement on G'
+        memset(scalar, 0x22, ECC_SCALAR_LENGTH);
+        byte shared[ECC_POINT_LENGTH];
+        if (!ecc.multiply(scalar, data, shared) || !ecc.multiply(scalar, NULL, publicKey)) {
+          return status(0x6A80, response, responseLength);
+        }
+        memcpy(terminalPublicKey, data, ECC_POINT_LENGTH);
+        deriveKey(shared + 1, ECC_COORDINATE_LENGTH, SK_ENC, ksEnc);
+        deriveKey(shared + 1, ECC_COORDINATE_LENGTH, SK_MAC, ksMac);
+        session.setKeys(ksEnc, ksMac);
+        enc.setKey(ksEnc);
+        return respond(0x84, publicKey, ECC_POINT_LENGTH, response, responseLength);
+      }
+      //Mutual authentication with the tokens
+      byte token[SM_MAC_LENGTH];
+      authenticationToken(publicKey, token);
+      if (memcmp(token, data, SM_MAC_LENGTH) != 0) {
+        return status(0x6300, response, responseLength);
+      }
+      authenticationToken(terminalPublicKey, token);
+      memset(ssc, 0, AES_BLOCK_LENGTH);
+      active = true;
+      return respond(0x86, token, SM_MAC_LENGTH, response, responseLength);
+    }
+    bool execute(byte *command, byte *response, word *responseLength) {
+      if (command[1] == 0xA4) {
+        return status(0x9000, response, responseLength);
+      }
+      if (command[1] != 0xB0) {
+        return status(0x6D00, response, responseLength);
+      }
+      word offset = command[3];
+      if ((command[2] & 0x80) == 0x80) {
+        currentSfi = command[2] & 0x1F;
+      } else {
+        offset |= command[2] << 8;
+      }
+      const byte *file = currentSfi == 0x1C ? cardAccess : (currentSfi == 0x01 ? dg1 : dg11);
+      word fileLength = currentSfi == 0x1C ? sizeof(cardAccess) : (currentSfi == 0x01 ? sizeof(dg1) : sizeof(dg11));
+      word length = command[4] == 0x00 ? 0x100 : command[4];
+      if (currentSfi != 0x1C && !active) {
+        //Security status not satisfied
+        return status(0x6982, response, responseLength);
+      }
+      if (offset + length > fileLength) {
+        return status(0x6700, response, responseLength);
+      }
+      memcpy(response, file + offset, length);
+      response[length] = 0x90;
+      response[length + 1] = 0x00;
+      *responseLength = length + 2;
+      return true;
+    }
+    void incrementSsc() {
+      for (int i = AES_BLOCK_LENGTH - 1; i >= 0 && ++ssc[i] == 0; i--);
+    }
+    void cbc(byte *buffer, const word length, const bool encrypt) {
+      byte iv[AES_BLOCK_LENGTH];
+      byte previous[AES_BLOCK_LENGTH];
+      memcpy(iv, ssc, AES_BLOCK_LENGTH);
+      enc.encryptBlock(iv);
+      for (word offset = 0; offset < length; offset += AES_BLOCK_LENGTH) {
+        byte *block = buffer + offset;
+        memcpy(previous, block, AES_BLOCK_LENGTH);
+        for (byte i = 0; encrypt && i < AES_BLOCK_LENGTH; i++) {
+          block[i] ^= iv[i];
+        }
+        encrypt ? enc.encryptBlock(block) : enc.decryptBlock(block);
+        for (byte i = 0; !encrypt && i < AES_BLOCK_LENGTH; i++) {
+          block[i] ^= iv[i];
+        }
+        memcpy(iv, encrypt ? block : previous, AES_BLOCK_LENGTH);
+      }
+    }
+    //CMAC of SSC || data, padded, truncated to SM_MAC_LENGTH bytes
+    void mac(const byte *data, const word length, byte *result) {
+      byte input[AES_BLOCK_LENGTH + 0x110];
+      byte cmac[AES_BLOCK_LENGTH];
+      memcpy(input, ssc, AES_BLOCK_LENGTH);
+      memcpy(input + AES_BLOCK_LENGTH, data, length);
+      word paddedLength = session.pad(input, AES_BLOCK_LENGTH + length);
+      session.computeCmac(input, paddedLength, cmac);
+      memcpy(result, cmac, SM_MAC_LENGTH);
+    }
+    bool unwrapCommand(byte *command, byte *response, word *responseLength) {
+      byte input[AES_BLOCK_LENGTH + 0x100];
+      byte expected[SM_MAC_LENGTH];
+      word dataObjectsLength = command[4] - 2 - SM_MAC_LENGTH;
+      incrementSsc();
+      memcpy(input, command, 4);
+      memset(input + 4, 0, AES_BLOCK_LENGTH - 4);
+      input[4] = SM_PADDING_START;
+      memcpy(input + AES_BLOCK_LENGTH, command + 5, dataObjectsLength);
+      mac(input, AES_BLOCK_LENGTH + dataObjectsLength, expected);
+      if (memcmp(expected, command + 5 + dataObjectsLength + 2, SM_MAC_LENGTH) != 0) {
+        active = false;
+        return status(0x6988, response, responseLength);
+      }
+      byte plain[0x110];
+      byte plainLength = 4;
+      memcpy(plain, command, 4);
+      plain[0] &= ~SM_CLA;
+      word offset = 5;
+      if (command[offset] == SM_DO_CRYPTOGRAM) {
+        byte lengthOctets = command[offset + 1] == 0x81 ? 2 : 1;
+        word cryptogramLength = command[offset + lengthOctets] - 1;
+        byte *cryptogram = command + offset + 1 + lengthOctets + 1;
+        cbc(cryptogram, cryptogramLength, false);
+        while (cryptogram[cryptogramLength - 1] == 0x00) {
+          cryptogramLength--;
+        }
+        cryptogramLength--;
+        plain[plainLength++] = cryptogramLength;
+        memcpy(plain + plainLength, cryptogram, cryptogramLength);
+        plainLength += cryptogramLength;
+        offset = cryptogram - command + command[offset + lengthOctets] - 1;
+      }
+      if (command[offset] == SM_DO_LE) {
+        plain[plainLength++] = command[offset + 2];
+      }
+
+      word length;
+      execute(plain, plain, &length);
+      //Wrap the response: cryptogram, status word and MAC
+      word dataLength = length - 2;
+      byte sw1 = plain[dataLength];
+      byte sw2 = plain[dataLength + 1];
+      word position = 0;
+      incrementSsc();
+      if (dataLength > 0) {
+        word cryptogramLength = (dataLength / AES_BLOCK_LENGTH + 1) * AES_BLOCK_LENGTH;
+        response[position++] = SM_DO_CRYPTOGRAM;
+        if (cryptogramLength + 1 > 0x7F) {
+          response[position++] = 0x81;
+        }
+        response[position++] = cryptogramLength + 1;
+        response[position++] = SM_PADDING_INDICATOR;
+        memcpy(response + position, plain, dataLength);
+        session.pad(response + position, dataLength);
+        cbc(response + position, cryptogramLength, true);
+        position += cryptogramLength;
+      }
+      response[position++] = SM_DO_STATUS_WORD;
+      response[position++] = 0x02;
+      response[position++] = sw1;
+      response[position++] = sw2;
+      mac(response, position, response + position + 2);
+      response[position++] = SM_DO_MAC;
+      response[position++] = SM_MAC_LENGTH;
+      position += SM_MAC_LENGTH;
+      response[position++] = sw1;
+      response[position++] = sw2;
+      *responseLength = position;
+      return true;
+    }
+
+    cie_Ecc ecc;
+    cie_Aes enc;
+    cie_AesSecureMessaging session;
+    bool active;
+    byte currentSfi;
+    byte nonce[PACE_NONCE_LENGTH];
+    byte publicKey[ECC_POINT_LENGTH];
+    byte terminalPublicKey[ECC_POINT_LENGTH];
+    byte ksEnc[SM_KEY_LENGTH];
+    byte ksMac[SM_KEY_LENGTH];
+    byte ssc[AES_BLOCK_LENGTH];
+};
+
+test(identify_must_end_the_secure_messaging_of_the_previous_card) {
+  cie_Nfc_SecureFiles card;
+  cie_HsuFixture hsu(&card);
+  cie_Pn532Emulator &emulator = hsu.emulator;
+  cie_PN532 &cie = hsu.cie;
+  assertEqual(true, hsu.started);
+  cie.detectCard();
+  cie.setDeviceKeys(testDeviceEncKey, testDeviceMacKey, testDeviceSerialNumber);
+  bool established = cie.establishSecureMessaging();
+
+  //The next card knows nothing of the session
+  card.active = false;
+  word framesBefore = emulator.framesReceived();
+  word bufferLength = EF_ID_SERVIZI_LENGTH;
+  byte buffer[EF_ID_SERVIZI_LENGTH];
+  bool success = cie.identify(buffer, &bufferLength);
+  word frames = emulator.framesReceived() - framesBefore;
+
+  assertEqual(true, established);
+  assertEqual(true, success);
+  assertEqual(false, cie.isSecureMessagingActive());
+  assertEqual(IDENTIFY_EXCHANGE_BUDGET, frames);
+}
+
+test(passive_authentication_must_check_the_data_groups_and_stop_at_the_first_mismatch) {
+  cie_Nfc_Files card;
+  cie_HsuFixture hsu(&card);
+  cie_PN532 &cie = hsu.cie;
+  assertEqual(true, hsu.started);
+  cie.detectCard();
+
+  bool valid = cie.verify_EF_SOD();
+  word sodReads = card.readsBySfi[0x06];
+  //A cloned card with altered data
+  card.idServizi[0] ^= 0x01;
+  memset(card.readsBySfi, 0, sizeof(card.readsBySfi));
+  bool tamperedValid = cie.verify_EF_SOD();
+
+  assertEqual(true, valid);
+  //The read-ahead window takes the whole EF_SOD in a couple of READ BINARY
+  assertTrue(sodReads <= 3);
+  assertEqual(false, tamperedValid);
+  assertEqual(1, card.readsBySfi[0x01]);
+  assertEqual(0, card.readsBySfi[0x05]);
+}
+
+test(passive_authentication_must_measure_the_key_without_disturbing_the_parse_of_the_EF_SOD) {
+  cie_Nfc_Files card;
+  cie_HsuFixture hsu(&card);
+  cie_PN532 &cie = hsu.cie;
+  assertEqual(true, hsu.started);
+  cie.detectCard();
+
+  bool valid = cie.verify_EF_SOD();
+  //The EF_Servizi_Int_Kpub is checked first: the parse of the EF_SOD must go on where it was, past its length
+  card.setSod(testSodKpubFirst, TEST_SOD_KPUB_FIRST_LENGTH);
+  memset(card.readsBySfi, 0, sizeof(card.readsBySfi));
+  bool kpubFirstValid = cie.verify_EF_SOD();
+
+  assertEqual(true, valid);
+  assertEqual(true, kpubFirstValid);
+  assertEqual(1, card.readsBySfi[0x01]);
+}
+
+test(passive_authentication_must_fail_when_a_data_group_is_not_in_the_EF_SOD) {
+  cie_Nfc_Files card;
+  cie_HsuFixture hsu(&card);
+  cie_PN532 &cie = hsu.cie;
+  assertEqual(true, hsu.started);
+  cie.detectCard();
+
+  //The EF_SOD of the card lists no data group 0x7F
+  const cie_DataGroup dataGroups[] = {
+    { DG_ID_SERVIZI, { CIE_DF, SELECT_BY_SFI, 0x01 }, EF_ID_SERVIZI_LENGTH, FIXED_LENGTH },
+    { 0x7F, { CIE_DF, SELECT_BY_SFI, 0x05 }, 0, AUTODETECT_BER_LENGTH }
+  };
+  bool valid = cie.verify_EF_SOD(dataGroups, sizeof(dataGroups) / sizeof(cie_DataGroup));
+
+  assertEqual(false, valid);
+  assertEqual(1, card.readsBySfi[0x01]);
+}
+
+test(document_signer_must_be_verified_once_per_batch) {
+  cie_Nfc_Files card;
+  cie_HsuFixture hsu(&card);
+  cie_PN532 &cie = hsu.cie;
+  assertEqual(true, hsu.started);
+  cie.detectCard();
+  cie_Key csca;
+  csca.set(testTrustAnchorModulus, sizeof(testTrustAnchorModulus), testTrustAnchorExponent, sizeof(testTrustAnchorExponent));
+
+  bool untrusted = cie.verify_EF_SOD_Signature();
+  cie.setTrustAnchor(&csca);
+  bool first = cie.verify_EF_SOD_Signature();
+  word firstHits = cie.getSignerCacheHits();
+  //Another card of the same batch
+  bool second = cie.verify_EF_SOD_Signature();
+  word secondHits = cie.getSignerCacheHits();
+  //A tampered LDSSecurityObject
+  card.sod[100] ^= 0x01;
+  bool tampered = cie.verify_EF_SOD_Signature();
+  //A forged signature over the signed attributes
+  card.sod[100] ^= 0x01;
+  card.sod[TEST_SOD_LENGTH - 1] ^= 0x01;
+  bool forged = cie.verify_EF_SOD_Signature();
+
+  assertEqual(false, untrusted);
+  assertEqual(true, first);
+  assertEqual(0, firstHits);
+  assertEqual(true, second);
+  assertEqual(1, secondHits);
+  assertEqual(false, tampered);
+  assertEqual(false, forged);
+}
+
+test(secure_messaging_must_protect_reads_after_the_mutual_authentication) {
+  cie_Nfc_SecureFiles card;
+  cie_HsuFixture hsu(&card);
+  cie_PN532 &cie = hsu.cie;
+  assertEqual(true, hsu.started);
+  cie.detectCard();
+
+  //A terminal with the wrong keys
+  byte wrongKey[SM_KEY_LENGTH] = { 0 };
+  cie.setDeviceKeys(wrongKey, testDeviceMacKey, testDeviceSerialNumber);
+  bool impostor = cie.establishSecureMessaging();
+  bool impostorActive = cie.isSecureMessagingActive();
+
+  cie.setDeviceKeys(testDeviceEncKey, testDeviceMacKey, testDeviceSerialNumber);
+  bool established = cie.establishSecureMessaging();
+  word idLength = EF_ID_SERVIZI_LENGTH;
+  byte id[EF_ID_SERVIZI_LENGTH];
+  bool idRead = cie.read_EF_ID_Servizi(id, &idLength);
+  //Two pages, the first one as long as a protected response can be
+  byte kpub[EF_SERVIZI_INT_KPUB_LENGTH];
+  cie_EFPath kpubPath = { CIE_DF, SELECT_BY_SFI, 0x05 };
+  bool kpubRead = cie.readBinaryContent(kpubPath, kpub, READ_FROM_START, EF_SERVIZI_INT_KPUB_LENGTH);
+  word protectedCommands = card.protectedCommands;
+  //A forged response ends the session
+  card.tamperNextResponse = true;
+  bool forged = cie.read_EF_ID_Servizi(id, &idLength);
+  bool activeAfterForgery = cie.isSecureMessagingActive();
+
+  assertEqual(false, impostor);
+  assertEqual(false, impostorActive);
+  assertEqual(true, established);
+  assertEqual(true, idRead);
+  assertEqual(0, memcmp(id, card.idServizi, EF_ID_SERVIZI_LENGTH));
+  assertEqual(true, kpubRead);
+  assertEqual(0, memcmp(kpub, card.kpub, EF_SERVIZI_INT_KPUB_LENGTH));
+  //Two SELECT and three READ BINARY
+  assertEqual(5, protectedCommands);
+  assertEqual(false, forged);
+  assertEqual(false, activeAfterForgery);
+}
+
+test(pace_must_protect_the_icao_data_groups_on_both_curves) {
+  const byte curves[] = { ECC_CURVE_NIST_P256, ECC_CURVE_BRAINPOOL_P256R1 };
+  for (byte c = 0; c < sizeof(curves); c++) {
+    cie_Nfc_PaceFiles card(curves[c]);
+    cie_HsuFixture hsu(&card);
+    cie_PN532 &cie = hsu.cie;
+    assertEqual(true, hsu.started);
+    cie.detectCard();
+
+    word dg1Length = sizeof(card.dg1);
+    byte dg1[sizeof(card.dg1)];
+    bool unprotectedRead = cie.read_DG1(dg1, &dg1Length);
+    const byte wrongCan[] = { '6', '5', '4', '3', '2', '1' };
+    bool impostor = cie.establishPace(wrongCan, sizeof(wrongCan));
+    bool impostorActive = cie.isSecureMessagingActive();
+
+    cie.detectCard();
+    bool established = cie.establishPace(testCan, sizeof(testCan));
+    dg1Length = sizeof(card.dg1);
+    bool dg1Read = cie.read_DG1(dg1, &dg1Length);
+    //Past the first 256 bytes the offset takes P1 too
+    word dg11Length = sizeof(card.dg11);
+    byte dg11[sizeof(card.dg11)];
+    bool dg11Read = cie.read_DG11(dg11, &dg11Length);
+
+    assertEqual(false, unprotectedRead);
+    assertEqual(false, impostor);
+    assertEqual(false, impostorActive);
+    assertEqual(true, established);
+    assertEqual(true, dg1Read);
+    assertEqual(sizeof(card.dg1), dg1Length);
+    assertEqual(0, memcmp(dg1, card.dg1, sizeof(card.dg1)));
+    assertEqual(true, dg11Read);
+    assertEqual(sizeof(card.dg11), dg11Length);
+    assertEqual(0, memcmp(dg11, card.dg11, sizeof(card.dg11)));
+  }
+}
+
+void setup(void) {
+  Serial.begin(115200);
+}
+
+
+void loop(void) {
+  Test::run();
+}
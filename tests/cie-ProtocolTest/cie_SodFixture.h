@@ -0,0 +1,258 @@
+/**************************************************************************/
+/*!
+  @file     cie_SodFixture.h
+  @author   Developers italia
+  @license  BSD (see license)
+  An EF_SOD signed by a test document signer, whose certificate is signed
+  by a test CSCA. The LDSSecurityObject lists the SHA-256 hashes of an
+  EF_ID_Servizi with octets 0x30, 0x31, ... and of the EF_Servizi_Int_Kpub
+  testKpub, in this order.
+  Made with openssl req, x509 and cms -sign -econtent_type 2.23.136.1.1.1
+
+*/
+/**************************************************************************/
+#ifndef CIE_SOD_FIXTURE
+#define CIE_SOD_FIXTURE
+
+#define TEST_SOD_LENGTH (1476)
+#define TEST_SOD_KPUB_FIRST_LENGTH (1726)
+
+//A 2048 bits RSA public key, SEQUENCE { modulus INTEGER, publicExponent INTEGER }
+const byte testKpub[EF_SERVIZI_INT_KPUB_LENGTH] = {
+  0x30, 0x82, 0x01, 0x0A, 0x02, 0x82, 0x01, 0x01, 0x00, 0xD8, 0x60, 0x49, 0xBA, 0x27, 0x24, 0xC9, 0x43,
+  0x87, 0x6B, 0xF0, 0x57, 0xBA, 0x07, 0x4E, 0x7E, 0x65, 0x50, 0xBD, 0x79, 0x7F, 0xF2, 0x74, 0xCF, 0xD6,
+  0x92, 0x0A, 0xF5, 0xEE, 0x46, 0xAF, 0xC1, 0xC8, 0x7D, 0xA9, 0x85, 0x34, 0x63, 0x79, 0x5C, 0x1E, 0x1F,
+  0xD0, 0x93, 0x24, 0xB0, 0x13, 0x07, 0x8F, 0xCC, 0xFC, 0x1C, 0x52, 0x5A, 0x77, 0xD6, 0x06, 0x09, 0x01,
+  0x15, 0xDB, 0xCA, 0x2B, 0x98, 0x05, 0x9C, 0x63, 0x5F, 0x18, 0x18, 0xE5, 0xD9, 0x18, 0xA4, 0xD4, 0xB5,
+  0x1C, 0x7D, 0x37, 0x37, 0x44, 0xB7, 0x9D, 0x75, 0x86, 0xE7, 0x7B, 0x3E, 0x18, 0xEE, 0x4B, 0xF6, 0x23,
+  0x2A, 0x9A, 0xFB, 0xA6, 0x75, 0x9E, 0x30, 0x84, 0x98, 0x2E, 0x36, 0x8D, 0x51, 0x5A, 0x98, 0xD2, 0x62,
+  0x86, 0x2B, 0x78, 0xBF, 0x54, 0x2F, 0x39, 0x11, 0x0D, 0x65, 0xC1, 0x4B, 0x15, 0xCC, 0xDB, 0xB5, 0x09,
+  0xE3, 0xFA, 0xC5, 0x9E, 0x89, 0x5B, 0x6B, 0x2C, 0xA1, 0x89, 0x44, 0xD1, 0x69, 0x1F, 0xA1, 0x65, 0x31,
+  0xB3, 0x4C, 0x0F, 0x77, 0xED, 0x68, 0x0C, 0x53, 0x5B, 0x6C, 0x3D, 0x28, 0xFB, 0x02, 0xE0, 0xD0, 0xE5,
+  0x40, 0xC7, 0x28, 0x9E, 0xFD, 0x64, 0xFD, 0x2E, 0x01, 0xC0, 0x60, 0xF3, 0xF0, 0xEB, 0xB0, 0x8D, 0xDF,
+  0xD6, 0xEF, 0x04, 0x9E, 0xD1, 0x76, 0xFE, 0x2B, 0x4F, 0x5B, 0x7F, 0x40, 0x77, 0xFF, 0x90, 0x64, 0x98,
+  0xBF, 0x4B, 0xFE, 0x79, 0x16, 0x63, 0x4B, 0x13, 0x8F, 0xB8, 0xC1, 0x0A, 0x51, 0x5E, 0x99, 0xAF, 0xB0,
+  0x4A, 0x9D, 0xCF, 0xB1, 0x1D, 0xAD, 0xE3, 0x81, 0xC7, 0x76, 0x12, 0x9A, 0x8D, 0x53, 0xF7, 0x4D, 0xAC,
+  0x94, 0x7C, 0x82, 0x82, 0xFD, 0xCC, 0x8A, 0xF1, 0xF3, 0xEB, 0x8C, 0xD7, 0x35, 0x4D, 0xA2, 0x58, 0xD6,
+  0x31, 0x77, 0x9B, 0x6A, 0x85, 0xEA, 0xC3, 0xC7, 0xCA, 0x73, 0x02, 0x03, 0x01, 0x00, 0x01
+};
+
+const byte testSod[TEST_SOD_LENGTH] = {
+  0x77, 0x82, 0x05, 0xC0, 0x30, 0x82, 0x05, 0xBC, 0x06, 0x09, 0x2A, 0x86, 0x48, 0x86, 0xF7, 0x0D, 0x01,
+  0x07, 0x02, 0xA0, 0x82, 0x05, 0xAD, 0x30, 0x82, 0x05, 0xA9, 0x02, 0x01, 0x03, 0x31, 0x0D, 0x30, 0x0B,
+  0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x01, 0x30, 0x72, 0x06, 0x06, 0x67, 0x81,
+  0x08, 0x01, 0x01, 0x01, 0xA0, 0x68, 0x04, 0x66, 0x30, 0x64, 0x02, 0x01, 0x00, 0x30, 0x0D, 0x06, 0x09,
+  0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x01, 0x05, 0x00, 0x30, 0x50, 0x30, 0x26, 0x02, 0x02,
+  0x00, 0xA1, 0x04, 0x20, 0x9A, 0x7E, 0x76, 0x20, 0x1A, 0x17, 0xFB, 0x10, 0xB2, 0xA5, 0x44, 0xB1, 0x47,
+  0x31, 0x3D, 0xE5, 0x7F, 0x74, 0x17, 0xDE, 0x28, 0xBF, 0xE2, 0x1F, 0x97, 0x7A, 0x98, 0xC3, 0xB8, 0x31,
+  0xA2, 0xBA, 0x30, 0x26, 0x02, 0x02, 0x00, 0xA4, 0x04, 0x20, 0x4F, 0xEF, 0x32, 0xBF, 0x60, 0x27, 0x98,
+  0x2F, 0xFC, 0xE5, 0x95, 0xFF, 0xF1, 0xA9, 0x38, 0x3D, 0x2E, 0x3F, 0x3B, 0xA5, 0xA9, 0x20, 0xC1, 0x79,
+  0x49, 0x39, 0x5A, 0xAC, 0x3B, 0x74, 0x1C, 0x4A, 0xA0, 0x82, 0x03, 0x42, 0x30, 0x82, 0x03, 0x3E, 0x30,
+  0x82, 0x02, 0x26, 0xA0, 0x03, 0x02, 0x01, 0x02, 0x02, 0x14, 0x51, 0xD0, 0x56, 0x91, 0xE6, 0xC7, 0xDA,
+  0x34, 0xE2, 0x38, 0x73, 0x32, 0x3B, 0x26, 0x95, 0xD8, 0xE6, 0xEE, 0xED, 0x61, 0x30, 0x0D, 0x06, 0x09,
+  0x2A, 0x86, 0x48, 0x86, 0xF7, 0x0D, 0x01, 0x01, 0x0B, 0x05, 0x00, 0x30, 0x30, 0x31, 0x0B, 0x30, 0x09,
+  0x06, 0x03, 0x55, 0x04, 0x06, 0x13, 0x02, 0x49, 0x54, 0x31, 0x0D, 0x30, 0x0B, 0x06, 0x03, 0x55, 0x04,
+  0x0A, 0x0C, 0x04, 0x54, 0x65, 0x73, 0x74, 0x31, 0x12, 0x30, 0x10, 0x06, 0x03, 0x55, 0x04, 0x03, 0x0C,
+  0x09, 0x54, 0x65, 0x73, 0x74, 0x20, 0x43, 0x53, 0x43, 0x41, 0x30, 0x1E, 0x17, 0x0D, 0x32, 0x36, 0x31,
+  0x30, 0x31, 0x39, 0x30, 0x39, 0x30, 0x38, 0x35, 0x34, 0x5A, 0x17, 0x0D, 0x33, 0x36, 0x31, 0x30, 0x31,
+  0x36, 0x30, 0x39, 0x30, 0x38, 0x35, 0x34, 0x5A, 0x30, 0x2E, 0x31, 0x0B, 0x30, 0x09, 0x06, 0x03, 0x55,
+  0x04, 0x06, 0x13, 0x02, 0x49, 0x54, 0x31, 0x0D, 0x30, 0x0B, 0x06, 0x03, 0x55, 0x04, 0x0A, 0x0C, 0x04,
+  0x54, 0x65, 0x73, 0x74, 0x31, 0x10, 0x30, 0x0E, 0x06, 0x03, 0x55, 0x04, 0x03, 0x0C, 0x07, 0x54, 0x65,
+  0x73, 0x74, 0x20, 0x44, 0x53, 0x30, 0x82, 0x01, 0x22, 0x30, 0x0D, 0x06, 0x09, 0x2A, 0x86, 0x48, 0x86,
+  0xF7, 0x0D, 0x01, 0x01, 0x01, 0x05, 0x00, 0x03, 0x82, 0x01, 0x0F, 0x00, 0x30, 0x82, 0x01, 0x0A, 0x02,
+  0x82, 0x01, 0x01, 0x00, 0x90, 0xE7, 0x47, 0x4C, 0xA3, 0xBA, 0xC5, 0x62, 0x69, 0xB3, 0x0A, 0x48, 0x73,
+  0x0C, 0x9C, 0xE7, 0xCD, 0xD5, 0x71, 0xF8, 0xAF, 0x50, 0x4F, 0x47, 0xAA, 0x0E, 0x88, 0x71, 0xED, 0xA9,
+  0xE5, 0x53, 0x00, 0xD5, 0x8A, 0x72, 0x3F, 0x45, 0x46, 0xB7, 0x5D, 0x18, 0xDA, 0x36, 0x71, 0x6B, 0x96,
+  0x62, 0xF0, 0x8D, 0xFB, 0xAE, 0xE8, 0xA0, 0x0C, 0x5D, 0x11, 0x95, 0xA5, 0xDF, 0x30, 0xB7, 0x0E, 0x79,
+  0x56, 0xD9, 0x0D, 0x86, 0x48, 0x6F, 0x34, 0x11, 0xAF, 0x25, 0xEF, 0x64, 0x2B, 0xC6, 0x0D, 0x60, 0xC2,
+  0x6F, 0x5F, 0xD6, 0x56, 0xDE, 0x6F, 0x9E, 0xEA, 0xC6, 0xF7, 0x9A, 0x27, 0x88, 0xB2, 0x03, 0xA6, 0xE7,
+  0x6C, 0x5A, 0x00, 0x9C, 0x02, 0x0F, 0x7E, 0xEF, 0x61, 0xB5, 0xC1, 0xD5, 0x54, 0xEA, 0xCE, 0xE1, 0x7F,
+  0x6C, 0x90, 0x86, 0x45, 0xB5, 0x17, 0x25, 0xA3, 0xB8, 0xD2, 0xE1, 0xE1, 0x4B, 0x0E, 0xBB, 0x5E, 0x55,
+  0x93, 0x1F, 0x55, 0xBF, 0x89, 0x73, 0x48, 0x2B, 0x3E, 0x7B, 0x45, 0x48, 0x1E, 0xD8, 0x33, 0xA4, 0x98,
+  0xC9, 0xFB, 0x41, 0xD3, 0x79, 0x2D, 0xD2, 0x13, 0xE1, 0xED, 0xE6, 0x16, 0x74, 0xEB, 0xD9, 0xF4, 0xF7,
+  0xEF, 0xED, 0xA1, 0x16, 0x49, 0x3E, 0x16, 0x7D, 0x0A, 0x9A, 0xB4, 0x89, 0x29, 0x67, 0xE1, 0xBF, 0x7D,
+  0xED, 0x35, 0x6E, 0xC6, 0xA3, 0x04, 0xD8, 0xA2, 0x8E, 0x32, 0x72, 0x15, 0x3A, 0xD3, 0x82, 0xFB, 0x72,
+  0x75, 0x7F, 0xCD, 0xB1, 0x52, 0x22, 0xF1, 0xB5, 0xFE, 0x96, 0xD5, 0x7A, 0x92, 0x2F, 0x91, 0x5C, 0x6D,
+  0x70, 0xB3, 0xB0, 0xEA, 0x8A, 0x48, 0x0E, 0x9B, 0xF3, 0x55, 0x00, 0x41, 0x61, 0x66, 0x6E, 0x4A, 0xF0,
+  0x1E, 0xB0, 0xB4, 0x58, 0xF9, 0x61, 0x16, 0x97, 0x5C, 0xE6, 0xF3, 0xF2, 0x38, 0xE4, 0x98, 0x04, 0x8D,
+  0x1E, 0x8A, 0x3C, 0x01, 0xDB, 0x02, 0x03, 0x01, 0x00, 0x01, 0xA3, 0x52, 0x30, 0x50, 0x30, 0x1D, 0x06,
+  0x03, 0x55, 0x1D, 0x0E, 0x04, 0x16, 0x04, 0x14, 0x6A, 0x44, 0x78, 0x92, 0xA5, 0xAD, 0x23, 0x67, 0xC0,
+  0x99, 0x06, 0x40, 0xA0, 0xFA, 0x2A, 0x77, 0x24, 0xD6, 0xB7, 0x32, 0x30, 0x1F, 0x06, 0x03, 0x55, 0x1D,
+  0x23, 0x04, 0x18, 0x30, 0x16, 0x80, 0x14, 0xFE, 0x7B, 0xA3, 0xF0, 0x76, 0x85, 0x48, 0x91, 0x89, 0xA1,
+  0xB5, 0x44, 0x83, 0x72, 0xBE, 0xA6, 0xBB, 0xD8, 0x92, 0x06, 0x30, 0x0E, 0x06, 0x03, 0x55, 0x1D, 0x0F,
+  0x01, 0x01, 0xFF, 0x04, 0x04, 0x03, 0x02, 0x07, 0x80, 0x30, 0x0D, 0x06, 0x09, 0x2A, 0x86, 0x48, 0x86,
+  0xF7, 0x0D, 0x01, 0x01, 0x0B, 0x05, 0x00, 0x03, 0x82, 0x01, 0x01, 0x00, 0x89, 0xD0, 0x36, 0xBB, 0xCC,
+  0xC4, 0xF4, 0x51, 0xCF, 0x06, 0x51, 0x60, 0xA6, 0xBF, 0x9C, 0x97, 0xD1, 0x58, 0xBF, 0x01, 0xE5, 0xEE,
+  0xC9, 0x0C, 0xEB, 0x7E, 0x60, 0xAD, 0xC7, 0xD6, 0xA9, 0x1C, 0xEA, 0x69, 0x5B, 0x15, 0xAF, 0x77, 0x82,
+  0xA0, 0x09, 0x7D, 0x8D, 0xF2, 0xF4, 0x76, 0x46, 0x17, 0x8A, 0x48, 0xBA, 0x70, 0xDB, 0x6C, 0x66, 0x9D,
+  0x78, 0x02, 0x3C, 0xA3, 0xA1, 0x5C, 0x19, 0x74, 0xBE, 0x94, 0x46, 0x71, 0xB8, 0x64, 0x77, 0xD9, 0x98,
+  0x63, 0xE5, 0xA2, 0x9B, 0x95, 0x85, 0x39, 0xBA, 0x81, 0x67, 0xC6, 0x89, 0x8F, 0x06, 0xEE, 0xD0, 0xA7,
+  0x14, 0xB9, 0x43, 0x96, 0x63, 0xD0, 0x3F, 0xE9, 0x61, 0x26, 0xA8, 0x13, 0xF0, 0x64, 0xF7, 0xE3, 0x70,
+  0x60, 0x74, 0xBB, 0x73, 0x67, 0x15, 0xF7, 0x41, 0xAA, 0x4B, 0x4B, 0x97, 0x77, 0xCF, 0xCA, 0x10, 0xCA,
+  0x43, 0xA6, 0x4C, 0x6D, 0xA0, 0xAD, 0xD9, 0x07, 0xD6, 0xAE, 0x6E, 0x45, 0x40, 0xE7, 0x34, 0x01, 0x89,
+  0xFB, 0x49, 0x22, 0xE9, 0xD1, 0x25, 0x36, 0xD9, 0x67, 0x79, 0x53, 0x73, 0xF0, 0xFD, 0x6E, 0x5A, 0xA1,
+  0x96, 0x38, 0x66, 0x12, 0x9B, 0xE7, 0x06, 0xBC, 0x69, 0x5E, 0x0B, 0xA2, 0x5A, 0x82, 0xFF, 0xE7, 0x14,
+  0x85, 0xE7, 0x72, 0x87, 0x1F, 0xF4, 0x83, 0x76, 0x94, 0x0A, 0xA3, 0x05, 0xDE, 0xE6, 0x15, 0xD1, 0xA4,
+  0xC6, 0x04, 0x73, 0xAC, 0x16, 0x4C, 0x27, 0xE5, 0x5B, 0xFD, 0xD8, 0x4C, 0xE9, 0xCA, 0x22, 0xF8, 0x70,
+  0x2F, 0xB7, 0x02, 0x26, 0xD7, 0xCE, 0x39, 0xAD, 0x4D, 0x01, 0xDF, 0x48, 0x42, 0xDF, 0xE1, 0xB4, 0xED,
+  0x3D, 0x32, 0xFC, 0xE1, 0xED, 0xA8, 0x06, 0xFB, 0xC5, 0x5E, 0x52, 0x12, 0x2E, 0x50, 0x12, 0xB9, 0x88,
+  0x1E, 0x73, 0x9F, 0x0F, 0xA5, 0x76, 0xA3, 0x68, 0xB0, 0xFA, 0x91, 0x53, 0x58, 0x31, 0x82, 0x01, 0xD9,
+  0x30, 0x82, 0x01, 0xD5, 0x02, 0x01, 0x01, 0x30, 0x48, 0x30, 0x30, 0x31, 0x0B, 0x30, 0x09, 0x06, 0x03,
+  0x55, 0x04, 0x06, 0x13, 0x02, 0x49, 0x54, 0x31, 0x0D, 0x30, 0x0B, 0x06, 0x03, 0x55, 0x04, 0x0A, 0x0C,
+  0x04, 0x54, 0x65, 0x73, 0x74, 0x31, 0x12, 0x30, 0x10, 0x06, 0x03, 0x55, 0x04, 0x03, 0x0C, 0x09, 0x54,
+  0x65, 0x73, 0x74, 0x20, 0x43, 0x53, 0x43, 0x41, 0x02, 0x14, 0x51, 0xD0, 0x56, 0x91, 0xE6, 0xC7, 0xDA,
+  0x34, 0xE2, 0x38, 0x73, 0x32, 0x3B, 0x26, 0x95, 0xD8, 0xE6, 0xEE, 0xED, 0x61, 0x30, 0x0B, 0x06, 0x09,
+  0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x01, 0xA0, 0x66, 0x30, 0x15, 0x06, 0x09, 0x2A, 0x86,
+  0x48, 0x86, 0xF7, 0x0D, 0x01, 0x09, 0x03, 0x31, 0x08, 0x06, 0x06, 0x67, 0x81, 0x08, 0x01, 0x01, 0x01,
+  0x30, 0x1C, 0x06, 0x09, 0x2A, 0x86, 0x48, 0x86, 0xF7, 0x0D, 0x01, 0x09, 0x05, 0x31, 0x0F, 0x17, 0x0D,
+  0x32, 0x36, 0x31, 0x30, 0x31, 0x39, 0x31, 0x30, 0x31, 0x33, 0x34, 0x31, 0x5A, 0x30, 0x2F, 0x06, 0x09,
+  0x2A, 0x86, 0x48, 0x86, 0xF7, 0x0D, 0x01, 0x09, 0x04, 0x31, 0x22, 0x04, 0x20, 0x46, 0x32, 0xA4, 0x9D,
+  0x9A, 0x23, 0xCD, 0x2D, 0x8B, 0xF3, 0xFE, 0x34, 0xC0, 0x9D, 0xB6, 0x7A, 0x2F, 0xF4, 0xE2, 0x2F, 0x5D,
+  0x0D, 0xC6, 0x1D, 0x54, 0xA6, 0xD3, 0x48, 0x4C, 0x7C, 0x26, 0xBA, 0x30, 0x0D, 0x06, 0x09, 0x2A, 0x86,
+  0x48, 0x86, 0xF7, 0x0D, 0x01, 0x01, 0x01, 0x05, 0x00, 0x04, 0x82, 0x01, 0x00, 0x23, 0x30, 0xDE, 0xB6,
+  0x03, 0xB2, 0x1C, 0x2B, 0x34, 0x2D, 0x1D, 0x69, 0x2D, 0x1A, 0x7D, 0x26, 0x2A, 0x90, 0xC8, 0xEA, 0x0A,
+  0xED, 0x1C, 0x39, 0x7C, 0x77, 0x88, 0x74, 0x6E, 0x01, 0x1A, 0x03, 0xBA, 0x15, 0x14, 0xF3, 0xB7, 0x87,
+  0x92, 0xAB, 0x8D, 0x76, 0x84, 0x5F, 0x94, 0x8C, 0x1C, 0xAA, 0xCD, 0xFC, 0x99, 0xE8, 0xEF, 0xF3, 0xF4,
+  0xB9, 0x70, 0xAD, 0xAB, 0x9A, 0x03, 0x71, 0x5F, 0xEC, 0xB2, 0xAF, 0x71, 0x17, 0x14, 0x90, 0x5B, 0x68,
+  0x8E, 0x60, 0xA2, 0x2B, 0x86, 0x82, 0x97, 0xE7, 0x52, 0xDB, 0xE8, 0x94, 0x3C, 0x5F, 0x56, 0x30, 0x61,
+  0xAF, 0x9E, 0x2E, 0x85, 0xD9, 0x7E, 0x23, 0xB9, 0x59, 0xE2, 0x84, 0x24, 0x39, 0x9B, 0x58, 0xC3, 0xA2,
+  0xAB, 0xB7, 0x07, 0x3E, 0xF6, 0xDA, 0xC6, 0x98, 0x6E, 0xBB, 0x07, 0xB9, 0x3F, 0x56, 0x03, 0x18, 0xD9,
+  0xEF, 0xA5, 0x46, 0xE7, 0x2F, 0x7E, 0x42, 0x61, 0xBA, 0x02, 0x3E, 0xA8, 0x25, 0xFB, 0x64, 0xD1, 0xFB,
+  0x5A, 0x92, 0x9D, 0xFC, 0x9B, 0x9D, 0xC2, 0xD9, 0x4E, 0xED, 0xA4, 0x37, 0x1A, 0x24, 0xC6, 0x88, 0x74,
+  0xFD, 0x04, 0xA3, 0x7A, 0x98, 0xD3, 0xAF, 0x85, 0x14, 0xD5, 0xBE, 0x25, 0x82, 0xCE, 0x30, 0xF1, 0xEB,
+  0x56, 0x72, 0xB7, 0xE8, 0xCD, 0x7F, 0x46, 0x29, 0xB5, 0xA6, 0x8F, 0xFC, 0x9F, 0x67, 0x92, 0xF3, 0xFA,
+  0x96, 0xCC, 0x6C, 0x7C, 0xED, 0x4F, 0x28, 0x33, 0x2E, 0x96, 0x44, 0x88, 0x65, 0x4C, 0xEA, 0xB5, 0x8E,
+  0x3F, 0x11, 0x78, 0x1B, 0xD0, 0x5C, 0x92, 0x9F, 0x0D, 0x39, 0xC0, 0x79, 0xDC, 0x88, 0x27, 0x83, 0x34,
+  0x66, 0x9C, 0x96, 0x3D, 0x94, 0x85, 0x97, 0x1E, 0xFF, 0x4A, 0x69, 0x96, 0x59, 0x38, 0x65, 0x9B, 0xE9,
+  0x4F, 0xF3, 0x5F, 0x4F, 0xE3, 0xB2, 0x95, 0xC9, 0xB9, 0x3B, 0x72, 0x45, 0xEC, 0x74
+};
+
+//An EF_SOD by the same signer listing the EF_Servizi_Int_Kpub first, then data groups 0x01 to 0x06 (16 times their
+//number), then the EF_ID_Servizi past the length of the EF_Servizi_Int_Kpub
+const byte testSodKpubFirst[TEST_SOD_KPUB_FIRST_LENGTH] = {
+  0x77, 0x82, 0x06, 0xBA, 0x30, 0x82, 0x06, 0xB6, 0x06, 0x09, 0x2A, 0x86, 0x48, 0x86, 0xF7, 0x0D, 0x01,
+  0x07, 0x02, 0xA0, 0x82, 0x06, 0xA7, 0x30, 0x82, 0x06, 0xA3, 0x02, 0x01, 0x03, 0x31, 0x0D, 0x30, 0x0B,
+  0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x01, 0x30, 0x82, 0x01, 0x6A, 0x06, 0x06,
+  0x67, 0x81, 0x08, 0x01, 0x01, 0x01, 0xA0, 0x82, 0x01, 0x5E, 0x04, 0x82, 0x01, 0x5A, 0x30, 0x82, 0x01,
+  0x56, 0x02, 0x01, 0x00, 0x30, 0x0D, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x01,
+  0x05, 0x00, 0x30, 0x82, 0x01, 0x40, 0x30, 0x26, 0x02, 0x02, 0x00, 0xA4, 0x04, 0x20, 0x4F, 0xEF, 0x32,
+  0xBF, 0x60, 0x27, 0x98, 0x2F, 0xFC, 0xE5, 0x95, 0xFF, 0xF1, 0xA9, 0x38, 0x3D, 0x2E, 0x3F, 0x3B, 0xA5,
+  0xA9, 0x20, 0xC1, 0x79, 0x49, 0x39, 0x5A, 0xAC, 0x3B, 0x74, 0x1C, 0x4A, 0x30, 0x26, 0x02, 0x02, 0x00,
+  0x01, 0x04, 0x20, 0xCC, 0x8C, 0xD4, 0x1C, 0xEF, 0x90, 0x7C, 0x4D, 0x21, 0x60, 0x69, 0x12, 0x2C, 0x4B,
+  0x89, 0x93, 0x62, 0x11, 0x36, 0x1F, 0x90, 0x50, 0xA7, 0x17, 0xA1, 0xE3, 0x7A, 0xD1, 0x86, 0x2E, 0x95,
+  0x2F, 0x30, 0x26, 0x02, 0x02, 0x00, 0x02, 0x04, 0x20, 0x29, 0x2A, 0xFD, 0xE3, 0xB6, 0x4E, 0x66, 0x36,
+  0xD6, 0x8F, 0x11, 0x20, 0xD9, 0x24, 0x2F, 0x1F, 0x85, 0xE3, 0x8E, 0xF7, 0xBF, 0x30, 0x6E, 0x44, 0x07,
+  0xC2, 0x30, 0x3E, 0xB6, 0x37, 0x91, 0xEF, 0x30, 0x26, 0x02, 0x02, 0x00, 0x03, 0x04, 0x20, 0x63, 0x99,
+  0xF6, 0xD8, 0x63, 0xB0, 0x8F, 0x46, 0x52, 0xB3, 0x42, 0xC2, 0xE1, 0x35, 0x0B, 0x4C, 0x01, 0xE2, 0x91,
+  0x33, 0x2D, 0x9D, 0x84, 0xD8, 0x4B, 0x57, 0x5B, 0xF7, 0x27, 0x28, 0x97, 0xD2, 0x30, 0x26, 0x02, 0x02,
+  0x00, 0x04, 0x04, 0x20, 0x99, 0x55, 0x8A, 0x88, 0x1F, 0x0B, 0x22, 0x9E, 0x74, 0x33, 0x5D, 0x16, 0x4E,
+  0xEE, 0xF7, 0x15, 0x2B, 0x71, 0x16, 0xEC, 0xC8, 0xBB, 0xE8, 0xE2, 0x9C, 0x9B, 0x67, 0x3B, 0x8E, 0xE9,
+  0xD6, 0x69, 0x30, 0x26, 0x02, 0x02, 0x00, 0x05, 0x04, 0x20, 0xF9, 0x8A, 0x59, 0x4C, 0x16, 0x78, 0x4D,
+  0xBE, 0x52, 0xB1, 0x4C, 0xF7, 0x5C, 0x8B, 0xA4, 0xC4, 0x1C, 0x51, 0xEB, 0x5F, 0x62, 0x12, 0xD8, 0x66,
+  0xF6, 0x83, 0x49, 0x9C, 0x2D, 0x0B, 0xC5, 0x93, 0x30, 0x26, 0x02, 0x02, 0x00, 0x06, 0x04, 0x20, 0x34,
+  0x46, 0x76, 0xF2, 0x77, 0xE8, 0xE4, 0x9A, 0x34, 0xAC, 0x18, 0x10, 0x37, 0x30, 0xD1, 0x62, 0x7B, 0x62,
+  0x1A, 0x68, 0xC8, 0x7F, 0x0F, 0x05, 0x56, 0xA7, 0x64, 0x0F, 0x03, 0xE4, 0xA4, 0x4A, 0x30, 0x26, 0x02,
+  0x02, 0x00, 0xA1, 0x04, 0x20, 0x9A, 0x7E, 0x76, 0x20, 0x1A, 0x17, 0xFB, 0x10, 0xB2, 0xA5, 0x44, 0xB1,
+  0x47, 0x31, 0x3D, 0xE5, 0x7F, 0x74, 0x17, 0xDE, 0x28, 0xBF, 0xE2, 0x1F, 0x97, 0x7A, 0x98, 0xC3, 0xB8,
+  0x31, 0xA2, 0xBA, 0xA0, 0x82, 0x03, 0x42, 0x30, 0x82, 0x03, 0x3E, 0x30, 0x82, 0x02, 0x26, 0xA0, 0x03,
+  0x02, 0x01, 0x02, 0x02, 0x14, 0x51, 0xD0, 0x56, 0x91, 0xE6, 0xC7, 0xDA, 0x34, 0xE2, 0x38, 0x73, 0x32,
+  0x3B, 0x26, 0x95, 0xD8, 0xE6, 0xEE, 0xED, 0x61, 0x30, 0x0D, 0x06, 0x09, 0x2A, 0x86, 0x48, 0x86, 0xF7,
+  0x0D, 0x01, 0x01, 0x0B, 0x05, 0x00, 0x30, 0x30, 0x31, 0x0B, 0x30, 0x09, 0x06, 0x03, 0x55, 0x04, 0x06,
+  0x13, 0x02, 0x49, 0x54, 0x31, 0x0D, 0x30, 0x0B, 0x06, 0x03, 0x55, 0x04, 0x0A, 0x0C, 0x04, 0x54, 0x65,
+  0x73, 0x74, 0x31, 0x12, 0x30, 0x10, 0x06, 0x03, 0x55, 0x04, 0x03, 0x0C, 0x09, 0x54, 0x65, 0x73, 0x74,
+  0x20, 0x43, 0x53, 0x43, 0x41, 0x30, 0x1E, 0x17, 0x0D, 0x32, 0x36, 0x31, 0x30, 0x31, 0x39, 0x30, 0x39,
+  0x30, 0x38, 0x35, 0x34, 0x5A, 0x17, 0x0D, 0x33, 0x36, 0x31, 0x30, 0x31, 0x36, 0x30, 0x39, 0x30, 0x38,
+  0x35, 0x34, 0x5A, 0x30, 0x2E, 0x31, 0x0B, 0x30, 0x09, 0x06, 0x03, 0x55, 0x04, 0x06, 0x13, 0x02, 0x49,
+  0x54, 0x31, 0x0D, 0x30, 0x0B, 0x06, 0x03, 0x55, 0x04, 0x0A, 0x0C, 0x04, 0x54, 0x65, 0x73, 0x74, 0x31,
+  0x10, 0x30, 0x0E, 0x06, 0x03, 0x55, 0x04, 0x03, 0x0C, 0x07, 0x54, 0x65, 0x73, 0x74, 0x20, 0x44, 0x53,
+  0x30, 0x82, 0x01, 0x22, 0x30, 0x0D, 0x06, 0x09, 0x2A, 0x86, 0x48, 0x86, 0xF7, 0x0D, 0x01, 0x01, 0x01,
+  0x05, 0x00, 0x03, 0x82, 0x01, 0x0F, 0x00, 0x30, 0x82, 0x01, 0x0A, 0x02, 0x82, 0x01, 0x01, 0x00, 0x90,
+  0xE7, 0x47, 0x4C, 0xA3, 0xBA, 0xC5, 0x62, 0x69, 0xB3, 0x0A, 0x48, 0x73, 0x0C, 0x9C, 0xE7, 0xCD, 0xD5,
+  0x71, 0xF8, 0xAF, 0x50, 0x4F, 0x47, 0xAA, 0x0E, 0x88, 0x71, 0xED, 0xA9, 0xE5, 0x53, 0x00, 0xD5, 0x8A,
+  0x72, 0x3F, 0x45, 0x46, 0xB7, 0x5D, 0x18, 0xDA, 0x36, 0x71, 0x6B, 0x96, 0x62, 0xF0, 0x8D, 0xFB, 0xAE,
+  0xE8, 0xA0, 0x0C, 0x5D, 0x11, 0x95, 0xA5, 0xDF, 0x30, 0xB7, 0x0E, 0x79, 0x56, 0xD9, 0x0D, 0x86, 0x48,
+  0x6F, 0x34, 0x11, 0xAF, 0x25, 0xEF, 0x64, 0x2B, 0xC6, 0x0D, 0x60, 0xC2, 0x6F, 0x5F, 0xD6, 0x56, 0xDE,
+  0x6F, 0x9E, 0xEA, 0xC6, 0xF7, 0x9A, 0x27, 0x88, 0xB2, 0x03, 0xA6, 0xE7, 0x6C, 0x5A, 0x00, 0x9C, 0x02,
+  0x0F, 0x7E, 0xEF, 0x61, 0xB5, 0xC1, 0xD5, 0x54, 0xEA, 0xCE, 0xE1, 0x7F, 0x6C, 0x90, 0x86, 0x45, 0xB5,
+  0x17, 0x25, 0xA3, 0xB8, 0xD2, 0xE1, 0xE1, 0x4B, 0x0E, 0xBB, 0x5E, 0x55, 0x93, 0x1F, 0x55, 0xBF, 0x89,
+  0x73, 0x48, 0x2B, 0x3E, 0x7B, 0x45, 0x48, 0x1E, 0xD8, 0x33, 0xA4, 0x98, 0xC9, 0xFB, 0x41, 0xD3, 0x79,
+  0x2D, 0xD2, 0x13, 0xE1, 0xED, 0xE6, 0x16, 0x74, 0xEB, 0xD9, 0xF4, 0xF7, 0xEF, 0xED, 0xA1, 0x16, 0x49,
+  0x3E, 0x16, 0x7D, 0x0A, 0x9A, 0xB4, 0x89, 0x29, 0x67, 0xE1, 0xBF, 0x7D, 0xED, 0x35, 0x6E, 0xC6, 0xA3,
+  0x04, 0xD8, 0xA2, 0x8E, 0x32, 0x72, 0x15, 0x3A, 0xD3, 0x82, 0xFB, 0x72, 0x75, 0x7F, 0xCD, 0xB1, 0x52,
+  0x22, 0xF1, 0xB5, 0xFE, 0x96, 0xD5, 0x7A, 0x92, 0x2F, 0x91, 0x5C, 0x6D, 0x70, 0xB3, 0xB0, 0xEA, 0x8A,
+  0x48, 0x0E, 0x9B, 0xF3, 0x55, 0x00, 0x41, 0x61, 0x66, 0x6E, 0x4A, 0xF0, 0x1E, 0xB0, 0xB4, 0x58, 0xF9,
+  0x61, 0x16, 0x97, 0x5C, 0xE6, 0xF3, 0xF2, 0x38, 0xE4, 0x98, 0x04, 0x8D, 0x1E, 0x8A, 0x3C, 0x01, 0xDB,
+  0x02, 0x03, 0x01, 0x00, 0x01, 0xA3, 0x52, 0x30, 0x50, 0x30, 0x1D, 0x06, 0x03, 0x55, 0x1D, 0x0E, 0x04,
+  0x16, 0x04, 0x14, 0x6A, 0x44, 0x78, 0x92, 0xA5, 0xAD, 0x23, 0x67, 0xC0, 0x99, 0x06, 0x40, 0xA0, 0xFA,
+  0x2A, 0x77, 0x24, 0xD6, 0xB7, 0x32, 0x30, 0x1F, 0x06, 0x03, 0x55, 0x1D, 0x23, 0x04, 0x18, 0x30, 0x16,
+  0x80, 0x14, 0xFE, 0x7B, 0xA3, 0xF0, 0x76, 0x85, 0x48, 0x91, 0x89, 0xA1, 0xB5, 0x44, 0x83, 0x72, 0xBE,
+  0xA6, 0xBB, 0xD8, 0x92, 0x06, 0x30, 0x0E, 0x06, 0x03, 0x55, 0x1D, 0x0F, 0x01, 0x01, 0xFF, 0x04, 0x04,
+  0x03, 0x02, 0x07, 0x80, 0x30, 0x0D, 0x06, 0x09, 0x2A, 0x86, 0x48, 0x86, 0xF7, 0x0D, 0x01, 0x01, 0x0B,
+  0x05, 0x00, 0x03, 0x82, 0x01, 0x01, 0x00, 0x89, 0xD0, 0x36, 0xBB, 0xCC, 0xC4, 0xF4, 0x51, 0xCF, 0x06,
+  0x51, 0x60, 0xA6, 0xBF, 0x9C, 0x97, 0xD1, 0x58, 0xBF, 0x01, 0xE5, 0xEE, 0xC9, 0x0C, 0xEB, 0x7E, 0x60,
+  0xAD, 0xC7, 0xD6, 0xA9, 0x1C, 0xEA, 0x69, 0x5B, 0x15, 0xAF, 0x77, 0x82, 0xA0, 0x09, 0x7D, 0x8D, 0xF2,
+  0xF4, 0x76, 0x46, 0x17, 0x8A, 0x48, 0xBA, 0x70, 0xDB, 0x6C, 0x66, 0x9D, 0x78, 0x02, 0x3C, 0xA3, 0xA1,
+  0x5C, 0x19, 0x74, 0xBE, 0x94, 0x46, 0x71, 0xB8, 0x64, 0x77, 0xD9, 0x98, 0x63, 0xE5, 0xA2, 0x9B, 0x95,
+  0x85, 0x39, 0xBA, 0x81, 0x67, 0xC6, 0x89, 0x8F, 0x06, 0xEE, 0xD0, 0xA7, 0x14, 0xB9, 0x43, 0x96, 0x63,
+  0xD0, 0x3F, 0xE9, 0x61, 0x26, 0xA8, 0x13, 0xF0, 0x64, 0xF7, 0xE3, 0x70, 0x60, 0x74, 0xBB, 0x73, 0x67,
+  0x15, 0xF7, 0x41, 0xAA, 0x4B, 0x4B, 0x97, 0x77, 0xCF, 0xCA, 0x10, 0xCA, 0x43, 0xA6, 0x4C, 0x6D, 0xA0,
+  0xAD, 0xD9, 0x07, 0xD6, 0xAE, 0x6E, 0x45, 0x40, 0xE7, 0x34, 0x01, 0x89, 0xFB, 0x49, 0x22, 0xE9, 0xD1,
+  0x25, 0x36, 0xD9, 0x67, 0x79, 0x53, 0x73, 0xF0, 0xFD, 0x6E, 0x5A, 0xA1, 0x96, 0x38, 0x66, 0x12, 0x9B,
+  0xE7, 0x06, 0xBC, 0x69, 0x5E, 0x0B, 0xA2, 0x5A, 0x82, 0xFF, 0xE7, 0x14, 0x85, 0xE7, 0x72, 0x87, 0x1F,
+  0xF4, 0x83, 0x76, 0x94, 0x0A, 0xA3, 0x05, 0xDE, 0xE6, 0x15, 0xD1, 0xA4, 0xC6, 0x04, 0x73, 0xAC, 0x16,
+  0x4C, 0x27, 0xE5, 0x5B, 0xFD, 0xD8, 0x4C, 0xE9, 0xCA, 0x22, 0xF8, 0x70, 0x2F, 0xB7, 0x02, 0x26, 0xD7,
+  0xCE, 0x39, 0xAD, 0x4D, 0x01, 0xDF, 0x48, 0x42, 0xDF, 0xE1, 0xB4, 0xED, 0x3D, 0x32, 0xFC, 0xE1, 0xED,
+  0xA8, 0x06, 0xFB, 0xC5, 0x5E, 0x52, 0x12, 0x2E, 0x50, 0x12, 0xB9, 0x88, 0x1E, 0x73, 0x9F, 0x0F, 0xA5,
+  0x76, 0xA3, 0x68, 0xB0, 0xFA, 0x91, 0x53, 0x58, 0x31, 0x82, 0x01, 0xD9, 0x30, 0x82, 0x01, 0xD5, 0x02,
+  0x01, 0x01, 0x30, 0x48, 0x30, 0x30, 0x31, 0x0B, 0x30, 0x09, 0x06, 0x03, 0x55, 0x04, 0x06, 0x13, 0x02,
+  0x49, 0x54, 0x31, 0x0D, 0x30, 0x0B, 0x06, 0x03, 0x55, 0x04, 0x0A, 0x0C, 0x04, 0x54, 0x65, 0x73, 0x74,
+  0x31, 0x12, 0x30, 0x10, 0x06, 0x03, 0x55, 0x04, 0x03, 0x0C, 0x09, 0x54, 0x65, 0x73, 0x74, 0x20, 0x43,
+  0x53, 0x43, 0x41, 0x02, 0x14, 0x51, 0xD0, 0x56, 0x91, 0xE6, 0xC7, 0xDA, 0x34, 0xE2, 0x38, 0x73, 0x32,
+  0x3B, 0x26, 0x95, 0xD8, 0xE6, 0xEE, 0xED, 0x61, 0x30, 0x0B, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65,
+  0x03, 0x04, 0x02, 0x01, 0xA0, 0x66, 0x30, 0x15, 0x06, 0x09, 0x2A, 0x86, 0x48, 0x86, 0xF7, 0x0D, 0x01,
+  0x09, 0x03, 0x31, 0x08, 0x06, 0x06, 0x67, 0x81, 0x08, 0x01, 0x01, 0x01, 0x30, 0x1C, 0x06, 0x09, 0x2A,
+  0x86, 0x48, 0x86, 0xF7, 0x0D, 0x01, 0x09, 0x05, 0x31, 0x0F, 0x17, 0x0D, 0x32, 0x36, 0x31, 0x30, 0x31,
+  0x39, 0x31, 0x30, 0x33, 0x31, 0x35, 0x33, 0x5A, 0x30, 0x2F, 0x06, 0x09, 0x2A, 0x86, 0x48, 0x86, 0xF7,
+  0x0D, 0x01, 0x09, 0x04, 0x31, 0x22, 0x04, 0x20, 0x9F, 0x31, 0x6A, 0x1C, 0xF5, 0x63, 0xA4, 0x39, 0xBD,
+  0xBA, 0xC8, 0xEA, 0xD3, 0xC8, 0xA4, 0xB1, 0xC3, 0x42, 0x15, 0x36, 0xC2, 0x0E, 0x7B, 0xED, 0xA1, 0x9A,
+  0x19, 0x95, 0x35, 0x34, 0xCC, 0x17, 0x30, 0x0D, 0x06, 0x09, 0x2A, 0x86, 0x48, 0x86, 0xF7, 0x0D, 0x01,
+  0x01, 0x01, 0x05, 0x00, 0x04, 0x82, 0x01, 0x00, 0x5E, 0x21, 0xE4, 0xF8, 0x29, 0x7F, 0x4A, 0x56, 0xA2,
+  0x2A, 0xF3, 0xE3, 0xE1, 0xFD, 0x1C, 0x7C, 0xC7, 0xA8, 0x65, 0xB6, 0xF6, 0xFB, 0xA4, 0x03, 0xD1, 0xDA,
+  0x98, 0xC0, 0xDE, 0xBE, 0xF4, 0x4B, 0xF6, 0xE9, 0xA4, 0xB8, 0xD5, 0x1F, 0xFC, 0x09, 0x8D, 0xD3, 0x13,
+  0xB6, 0x12, 0x4F, 0xEE, 0x9B, 0xD0, 0x2E, 0x74, 0x41, 0xFD, 0xAB, 0x59, 0xDD, 0xFD, 0xA3, 0xC8, 0xD1,
+  0xB6, 0xC1, 0x14, 0x42, 0xA3, 0x09, 0xC5, 0x5E, 0xD5, 0x13, 0x2C, 0x01, 0xE2, 0xB5, 0x6B, 0xD4, 0x01,
+  0xA9, 0x58, 0x61, 0x26, 0x1C, 0x87, 0xA3, 0x81, 0xC3, 0xB7, 0x5E, 0x6D, 0xEE, 0x52, 0xEC, 0x88, 0x19,
+  0xF0, 0x78, 0xB1, 0xF8, 0xAA, 0x89, 0xDB, 0x7D, 0xE1, 0xBB, 0xB0, 0xAC, 0x16, 0x33, 0x46, 0x71, 0x52,
+  0x04, 0x7F, 0xAB, 0x8B, 0x73, 0x30, 0xF6, 0x98, 0xEE, 0x6D, 0xA6, 0xE3, 0x5B, 0x62, 0x94, 0xF2, 0x14,
+  0x96, 0xCD, 0x24, 0xC4, 0x1B, 0x30, 0x01, 0x12, 0x70, 0x27, 0x08, 0xFA, 0x43, 0x9A, 0xE5, 0xEE, 0xFA,
+  0xCC, 0x7C, 0x80, 0xDE, 0xA0, 0x15, 0x36, 0xBB, 0x24, 0x79, 0x1D, 0xA6, 0x2A, 0xA2, 0xAA, 0x37, 0x41,
+  0xC2, 0x7B, 0x63, 0xF2, 0x88, 0xEC, 0x36, 0x2D, 0x2C, 0x96, 0x3E, 0xF1, 0x62, 0x3C, 0x49, 0x0E, 0xAC,
+  0x6E, 0xC0, 0x89, 0x60, 0x80, 0x2E, 0x06, 0x68, 0x10, 0xEC, 0x96, 0x86, 0x50, 0x50, 0xA1, 0x6F, 0xF3,
+  0xF9, 0xA5, 0x5A, 0xBF, 0x2B, 0xC1, 0xA2, 0x55, 0x82, 0x24, 0x59, 0x12, 0x30, 0x55, 0xE4, 0x65, 0x61,
+  0x4D, 0x75, 0xD3, 0x49, 0x13, 0x57, 0x2F, 0x1D, 0x04, 0x63, 0xE2, 0xF4, 0x38, 0xFB, 0x86, 0xE5, 0xCD,
+  0x32, 0x30, 0x9E, 0xD2, 0x5A, 0x8C, 0x65, 0x5E, 0xFF, 0xC2, 0xDB, 0x4C, 0x01, 0x0F, 0xC4, 0x3E, 0x99,
+  0xBE, 0x37, 0x4E, 0x50, 0x06, 0xD9, 0xFA, 0x95, 0x92
+};
+
+const byte testTrustAnchorModulus[] = {
+  0xCC, 0x63, 0xF4, 0x38, 0xD0, 0x08, 0xE0, 0xB7, 0x56, 0xE6, 0xBB, 0xFE, 0x89, 0xC2, 0x9F, 0xAF, 0x72,
+  0xB5, 0xFC, 0x55, 0x76, 0x72, 0xBE, 0xF8, 0xE8, 0x49, 0x36, 0x9B, 0xF9, 0x4E, 0xD6, 0xF7, 0x95, 0xFC,
+  0x99, 0xB9, 0x45, 0xAF, 0x7B, 0xF3, 0x01, 0x31, 0x0C, 0x98, 0xB3, 0x17, 0x0B, 0x87, 0x6A, 0xC3, 0x2A,
+  0xB4, 0x15, 0xC7, 0x7D, 0x85, 0x14, 0x5A, 0x3E, 0xE1, 0x76, 0x9E, 0x49, 0x4C, 0x4F, 0x5C, 0x7E, 0xBB,
+  0xFA, 0xDB, 0xE5, 0x6F, 0x47, 0x67, 0x9B, 0xA8, 0x3C, 0x97, 0xCA, 0x2A, 0xAC, 0x66, 0xA2, 0xDE, 0x6A,
+  0x5B, 0xB5, 0x15, 0xB3, 0x23, 0x3F, 0x98, 0xB3, 0x14, 0xB7, 0xCE, 0x21, 0xD4, 0x1B, 0xCB, 0xC2, 0x98,
+  0xF8, 0x23, 0x5F, 0x7A, 0x46, 0x95, 0x50, 0x16, 0x42, 0xDF, 0x52, 0x6A, 0x0A, 0x89, 0xCF, 0xD4, 0x80,
+  0xAA, 0x13, 0xF8, 0x61, 0xE2, 0xF3, 0x7F, 0x51, 0x23, 0x36, 0x43, 0x5C, 0x9A, 0xD6, 0x7D, 0x13, 0x89,
+  0xCB, 0x6F, 0xA9, 0xA2, 0x85, 0x83, 0x44, 0x61, 0xC2, 0x6E, 0x32, 0xC4, 0x65, 0x64, 0xED, 0xA9, 0x29,
+  0xB0, 0x8C, 0x73, 0x26, 0xCC, 0xD2, 0xF9, 0xEA, 0xE5, 0x56, 0xCC, 0xE6, 0xA5, 0xD1, 0x61, 0xCC, 0x22,
+  0xA1, 0xBD, 0xEA, 0xE3, 0xD0, 0x86, 0x81, 0x88, 0x99, 0x3A, 0xEA, 0xB1, 0xC7, 0xC9, 0x36, 0x11, 0x22,
+  0xA6, 0x3F, 0xAF, 0xB6, 0x34, 0x46, 0x03, 0xAB, 0xB0, 0xF5, 0x1F, 0x2E, 0x7C, 0x43, 0x44, 0x5F, 0x95,
+  0xB1, 0x82, 0x61, 0xE3, 0x87, 0x89, 0x4E, 0x1B, 0xC7, 0x31, 0xB5, 0xF4, 0xF6, 0x1F, 0x3D, 0x7C, 0xC3,
+  0x5C, 0x30, 0xFF, 0x5C, 0x24, 0x81, 0x50, 0x3A, 0xC3, 0xD3, 0xAE, 0xC3, 0xCC, 0xD1, 0x27, 0xBD, 0x57,
+  0xF4, 0xD2, 0x84, 0xF8, 0xE9, 0x9E, 0x34, 0x05, 0x74, 0xBA, 0x23, 0x59, 0x01, 0xFB, 0x1B, 0x65, 0xBF,
+  0x21
+};
+
+const byte testTrustAnchorExponent[] = { 0x01, 0x00, 0x01 };
+
+#endif
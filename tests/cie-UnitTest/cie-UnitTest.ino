@@ -22,6 +22,7 @@ Check out the links above for our tutorials and wiring diagrams
 #include <cie_PN532.h>
 #include "cie_Nfc_Mock.h"
 #include "cie_Command.h"
+#include <cie_Drbg.h>
 
 //cie_PN532
 test(hasSuccessStatusWord_must_return_true_when_the_last_octets_in_a_response_are_0x9000)
@@ -91,9 +92,477 @@ test(selectIasApplication_must_send_a_select_command_only_if_it_was_not_already_
 
 }
 
+test(poll_must_send_one_command_per_call_until_the_read_is_done) {
+
+  cie_Nfc_Mock *mock = new cie_Nfc_Mock();
+  cie_PN532 cie(mock);
+
+  byte selectIasCommand[] = { 0x00, 0xA4, 0x04, 0x0C, 0x0D, 0xA0, 0x00, 0x00, 0x00, 0x30, 0x80, 0x00, 0x00, 0x00, 0x09, 0x81, 0x60, 0x01 };
+  byte selectCieDfCommand[] = { 0x00, 0xA4, 0x04, 0x0C, 0x06, 0xA0, 0x00, 0x00, 0x00, 0x00, 0x39 };
+  byte readIdServiziCommand[] = { 0x00, 0xB1, 0x00, 0x01, 0x04, 0x54, 0x02, 0x00, 0x00, 0x0E };
+  byte response[] = {0x90, 0x00};
+  byte readResponse[] = {0x53, 0x0C, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x90, 0x00};
+  mock->expectCommands(3);
+  mock->expectCommand(selectIasCommand, 0, sizeof(selectIasCommand), response, sizeof(response));
+  mock->expectCommand(selectCieDfCommand, 0, sizeof(selectCieDfCommand), response, sizeof(response));
+  mock->expectCommand(readIdServiziCommand, 0, sizeof(readIdServiziCommand), readResponse, sizeof(readResponse));
+
+  word bufferLength = EF_ID_SERVIZI_LENGTH;
+  byte buffer[EF_ID_SERVIZI_LENGTH];
+  assertEqual(POLL_IDLE, cie.poll());
+  assertEqual(true, cie.startRead_EF_ID_Servizi(buffer, &bufferLength));
+  assertEqual(POLL_IN_PROGRESS, cie.poll());
+  assertEqual(POLL_IN_PROGRESS, cie.poll());
+  assertEqual(0, cie.readProgress());
+  assertEqual(POLL_DONE, cie.poll());
+  assertEqual(EF_ID_SERVIZI_LENGTH, cie.readProgress());
+  assertEqual(0x0C, buffer[EF_ID_SERVIZI_LENGTH-1]);
+  assertEqual(true, mock->allExpectedCommandsExecuted());
+}
+
+test(decodeBerLength_must_include_tag_and_length_octets) {
+  cie_Nfc_Mock *mock = new cie_Nfc_Mock();
+  cie_PN532 cie(mock);
+
+  byte shortHeader[] = {0x30, 0x10, 0x02, 0x01};
+  byte longHeader[] = {0x77, 0x82, 0x07, 0xB0};
+  byte multiOctetTagHeader[] = {0x7F, 0x49, 0x81, 0x90};
+  byte truncatedHeader[] = {0x7F, 0x49, 0x82, 0x01};
+  word length;
+
+  assertEqual(true, cie.decodeBerLength(shortHeader, sizeof(shortHeader), &length));
+  assertEqual(0x12, length);
+  assertEqual(true, cie.decodeBerLength(longHeader, sizeof(longHeader), &length));
+  assertEqual(0x07B4, length);
+  assertEqual(true, cie.decodeBerLength(multiOctetTagHeader, sizeof(multiOctetTagHeader), &length));
+  assertEqual(0x94, length);
+  assertEqual(false, cie.decodeBerLength(truncatedHeader, sizeof(truncatedHeader), &length));
+}
+
+//cie_RecentCards
+test(recentCards_must_report_a_card_seen_within_the_hold_off_time)
+{
+  cie_RecentCards recentCards;
+  recentCards.setHoldOff(50);
+  byte id1[] = {0x01, 0x02, 0x03, 0x04};
+  byte id2[] = {0x01, 0x02, 0x03, 0x05};
+
+  bool first = recentCards.seen(id1, sizeof(id1));
+  bool repeated = recentCards.seen(id1, sizeof(id1));
+  bool other = recentCards.seen(id2, sizeof(id2));
+  delay(60);
+  bool expired = recentCards.seen(id1, sizeof(id1));
+
+  assertEqual(false, first);
+  assertEqual(true, repeated);
+  assertEqual(false, other);
+  assertEqual(false, expired);
+}
+
+//A 2048-bit test key (not a CIE one) and the response to INTERNAL AUTHENTICATE with an 8 bytes challenge
+const byte testModulus[] = {
+    0xFA, 0x38, 0xD8, 0xBA, 0x0E, 0xD9, 0xA4, 0xF8, 0x1C, 0xE3, 0xC4, 0x9B, 0x6C, 0x8A, 0x83, 0x82,
+    0x75, 0x77, 0x46, 0xBE, 0x7A, 0x81, 0x9E, 0xCD, 0x77, 0xC9, 0x1B, 0x38, 0x9C, 0x34, 0xF6, 0x18,
+    0x1E, 0xCF, 0x0A, 0xF5, 0x7B, 0x92, 0xFD, 0x98, 0x91, 0xE5, 0x9A, 0x88, 0xC7, 0x3C, 0x90, 0xDD,
+    0xC3, 0x54, 0xEA, 0x1A, 0xCD, 0x64, 0xC2, 0xE4, 0xCA, 0xD5, 0xA9, 0x3A, 0x3A, 0x40, 0xCA, 0xF0,
+    0xBC, 0x2C, 0xE2, 0x7C, 0x17, 0x97, 0x29, 0x94, 0xDC, 0x54, 0x5A, 0x9C, 0xD4, 0xA3, 0x71, 0x92,
+    0x49, 0x35, 0x0C, 0x46, 0x9F, 0x68, 0xE8, 0x5F, 0xA0, 0xB3, 0x59, 0xA4, 0x87, 0x31, 0xC9, 0x97,
+    0xEF, 0x9D, 0xB7, 0x9D, 0xDA, 0x45, 0x48, 0xFA, 0xCF, 0x34, 0x7F, 0xD6, 0x8D, 0xB8, 0x63, 0xC0,
+    0x61, 0xE3, 0x3A, 0xCA, 0x1C, 0xB1, 0xA8, 0x60, 0xCD, 0x56, 0x29, 0xE9, 0xCC, 0xE0, 0x12, 0x2A,
+    0x42, 0x09, 0xE0, 0x7F, 0x86, 0x15, 0xD8, 0xD5, 0x53, 0xB5, 0x31, 0xFE, 0xE5, 0x0E, 0x4F, 0x95,
+    0xCB, 0x59, 0xBB, 0x9A, 0x1F, 0x56, 0xE1, 0x3D, 0x7D, 0x21, 0xF6, 0xEB, 0xAE, 0x5F, 0x73, 0x28,
+    0x64, 0x93, 0xE0, 0xB8, 0xCD, 0x58, 0x6D, 0xDD, 0x54, 0x35, 0xA1, 0x21, 0xDE, 0x6F, 0x0A, 0x2B,
+    0xB1, 0x29, 0x47, 0x4F, 0x88, 0x06, 0x75, 0xB3, 0xAC, 0xF4, 0x7B, 0x98, 0xEB, 0x6F, 0xE4, 0x09,
+    0x58, 0xA9, 0x85, 0xCE, 0x57, 0x3F, 0x62, 0x7E, 0x54, 0xBA, 0xC0, 0x77, 0x3E, 0x24, 0x7C, 0x57,
+    0x5A, 0x70, 0xFB, 0xA2, 0xE3, 0x3C, 0xD6, 0x51, 0x86, 0x44, 0x1D, 0xC3, 0x80, 0xD3, 0x28, 0xED,
+    0x79, 0xB3, 0x09, 0x1C, 0x53, 0xD8, 0xE9, 0xA9, 0x20, 0xB4, 0xA6, 0xE2, 0xF1, 0x81, 0x3D, 0x93,
+    0x92, 0xE3, 0xDF, 0x27, 0x87, 0xB6, 0x0E, 0x55, 0xC1, 0xCD, 0xAE, 0xF7, 0xD2, 0xA2, 0x9B, 0x6F
+};
+const byte testSignature[] = {
+    0x6C, 0xEA, 0x92, 0xE0, 0xE2, 0xE2, 0x0A, 0xA6, 0xE4, 0x5C, 0x73, 0x4A, 0x58, 0xEC, 0x38, 0x29,
+    0x89, 0x2F, 0x54, 0x5A, 0x34, 0x23, 0x1B, 0x77, 0x26, 0xB4, 0x41, 0xFD, 0x42, 0xBD, 0xD1, 0x22,
+    0x46, 0x97, 0x7C, 0xB7, 0xED, 0xA7, 0x01, 0x87, 0x09, 0x5A, 0x03, 0x17, 0x72, 0x28, 0x08, 0xEB,
+    0xC5, 0x98, 0x40, 0x09, 0x15, 0x53, 0xA9, 0xC3, 0xD9, 0x70, 0xD0, 0x70, 0x8F, 0x88, 0x25, 0x58,
+    0xEA, 0xB2, 0x9F, 0x9D, 0xDA, 0x97, 0xB6, 0xFF, 0x1A, 0xD8, 0x91, 0x53, 0x44, 0xC1, 0xC8, 0xD2,
+    0x17, 0x03, 0xD3, 0x10, 0xFE, 0x5A, 0x03, 0x62, 0xB8, 0x9B, 0x68, 0x18, 0xB8, 0xC9, 0x13, 0x2F,
+    0x3F, 0xA7, 0x10, 0xDD, 0x5A, 0x55, 0xCD, 0x46, 0x10, 0x3B, 0x64, 0x7F, 0xCA, 0x4A, 0x44, 0xAB,
+    0x3F, 0x33, 0x44, 0xBE, 0x85, 0xBE, 0xFB, 0x78, 0x15, 0x67, 0xE7, 0x47, 0xC8, 0x2A, 0x3F, 0xCA,
+    0x7B, 0x53, 0xA3, 0x6F, 0xF0, 0x7E, 0x75, 0x5A, 0x90, 0x41, 0x9D, 0x64, 0x2B, 0x1E, 0x08, 0x06,
+    0x26, 0xEA, 0x15, 0xEF, 0xE9, 0xC4, 0x5E, 0xAB, 0xFB, 0xE8, 0x3A, 0x8E, 0xF3, 0x85, 0x60, 0x5F,
+    0x30, 0x05, 0x7C, 0x8F, 0x0D, 0xB3, 0x42, 0x26, 0x0C, 0xDD, 0x98, 0xCC, 0xCB, 0xD7, 0x4C, 0x47,
+    0x7D, 0x4E, 0x98, 0x41, 0x2D, 0xD4, 0x42, 0x4C, 0xC3, 0xFE, 0x34, 0xAD, 0x7F, 0x72, 0x7C, 0x6C,
+    0xD6, 0x15, 0xEC, 0xC4, 0x97, 0x54, 0x62, 0xED, 0x08, 0x69, 0xBD, 0x1D, 0xB4, 0x7B, 0xEE, 0x90,
+    0x13, 0x2D, 0xC4, 0x36, 0xC2, 0x88, 0xD0, 0xD1, 0x77, 0xF4, 0x16, 0xE5, 0x53, 0xC3, 0xBD, 0x03,
+    0xE7, 0x74, 0x56, 0x7C, 0xE3, 0x6E, 0xC3, 0x51, 0xE2, 0x00, 0xCF, 0x09, 0x7E, 0xB6, 0xC8, 0x0F,
+    0x08, 0x22, 0x9A, 0xF8, 0x77, 0x71, 0x5A, 0x2F, 0x83, 0xA4, 0xAD, 0xBE, 0xEE, 0xC2, 0xFB, 0x61
+};
+const byte testChallenge[] = { 0x3A, 0x51, 0xC6, 0x0F, 0x8E, 0x27, 0x94, 0xB3 };
+const byte testExponent[] = { 0x01, 0x00, 0x01 };
+
 test(verification_of_a_challenge_response_must_succeed) {
+  cie_Nfc_Mock *mock = new cie_Nfc_Mock();
+  cie_PN532 cie(mock);
+  //As read by readKey: the modulus is preceded by a zero octet
+  byte paddedModulus[sizeof(testModulus) + 1] = { 0x00 };
+  memcpy(paddedModulus + 1, testModulus, sizeof(testModulus));
+  cie_Key key;
+  key.set(paddedModulus, sizeof(paddedModulus), testExponent, sizeof(testExponent));
+  byte signature[sizeof(testSignature)];
+  memcpy(signature, testSignature, sizeof(testSignature));
+
+  bool valid = cie.verifyInternalAuthenticateResponse(&key, signature, sizeof(signature), testChallenge, sizeof(testChallenge));
+  byte otherChallenge[sizeof(testChallenge)];
+  memcpy(otherChallenge, testChallenge, sizeof(testChallenge));
+  otherChallenge[0] ^= 0x01;
+  bool otherChallengeValid = cie.verifyInternalAuthenticateResponse(&key, signature, sizeof(signature), otherChallenge, sizeof(otherChallenge));
+  signature[0x80] ^= 0x01;
+  bool tamperedValid = cie.verifyInternalAuthenticateResponse(&key, signature, sizeof(signature), testChallenge, sizeof(testChallenge));
+
+  assertEqual(true, valid);
+  assertEqual(false, otherChallengeValid);
+  assertEqual(false, tamperedValid);
+  assertTrue(cie.getVerificationCycles() > 0);
+}
+
+test(repeat_verifications_must_reuse_the_precomputed_context) {
+  byte modulus[sizeof(testModulus)];
+  memcpy(modulus, testModulus, sizeof(testModulus));
+  byte otherModulus[sizeof(testModulus)];
+  memcpy(otherModulus, testModulus, sizeof(testModulus));
+  otherModulus[0] ^= 0x01;
+  unsigned long fingerprint = cie_Rsa::fingerprint(modulus, sizeof(modulus));
+  cie_Rsa rsa;
+
+  rsa.setModulus(modulus, sizeof(modulus), fingerprint);
+  bool first = rsa.verify(testSignature, sizeof(testSignature), testExponent, sizeof(testExponent), testChallenge, sizeof(testChallenge));
+  rsa.setModulus(modulus, sizeof(modulus), fingerprint);
+  bool repeated = rsa.verify(testSignature, sizeof(testSignature), testExponent, sizeof(testExponent), testChallenge, sizeof(testChallenge));
+  //Just the setModulus() cycles, the fastest of a few runs so that being preempted doesn't count
+  unsigned long firstCycles = 0xFFFFFFFF;
+  unsigned long repeatedCycles = 0xFFFFFFFF;
+  for (byte i = 0; i < 5; i++) {
+    cie_Rsa fresh;
+    fresh.setModulus(modulus, sizeof(modulus), fingerprint);
+    if (fresh.getCycles() < firstCycles) {
+      firstCycles = fresh.getCycles();
+    }
+    fresh.setModulus(modulus, sizeof(modulus), fingerprint);
+    if (fresh.getCycles() < repeatedCycles) {
+      repeatedCycles = fresh.getCycles();
+    }
+  }
+  //Same fingerprint, but a different modulus: that's a miss
+  rsa.setModulus(otherModulus, sizeof(otherModulus), fingerprint);
+
+  assertEqual(true, first);
+  assertEqual(true, repeated);
+  assertEqual(1, rsa.getCacheHits());
+  assertTrue(repeatedCycles < firstCycles);
+}
+
+//cie_KeyDecoder
+test(key_decoder_must_decode_an_rsa_public_key_split_in_pages) {
+  //RSAPublicKey: SEQUENCE { INTEGER modulus (with a zero octet in front), INTEGER exponent }
+  byte encoded[4 + 5 + sizeof(testModulus) + 2 + sizeof(testExponent)] = { 0x30, 0x82, 0x01, 0x0A, 0x02, 0x82, 0x01, 0x01, 0x00 };
+  memcpy(encoded + 9, testModulus, sizeof(testModulus));
+  encoded[9 + sizeof(testModulus)] = 0x02;
+  encoded[10 + sizeof(testModulus)] = sizeof(testExponent);
+  memcpy(encoded + 11 + sizeof(testModulus), testExponent, sizeof(testExponent));
+  cie_Key key;
+  cie_KeyDecoder decoder(&key);
+  bool decoded = decoder.update(encoded, 7) && decoder.update(encoded + 7, 0xE4) && decoder.update(encoded + 7 + 0xE4, sizeof(encoded) - 7 - 0xE4);
+  decoded = decoder.finish() && decoded;
+  //Truncated
+  cie_Key truncatedKey;
+  cie_KeyDecoder truncatedDecoder(&truncatedKey);
+  truncatedDecoder.update(encoded, sizeof(encoded) - 1);
+  bool truncated = truncatedDecoder.finish();
+
+  assertEqual(true, decoded);
+  assertEqual(sizeof(testModulus) + 1, key.modulusLength);
+  assertEqual(0, memcmp(testModulus, key.modulus + 1, sizeof(testModulus)));
+  assertEqual(sizeof(testExponent), key.exponentLength);
+  assertEqual(0, memcmp(testExponent, key.exponent, sizeof(testExponent)));
+  assertTrue(cie_Rsa::fingerprint(testModulus, sizeof(testModulus)) == key.getFingerprint());
+  assertEqual(false, truncated);
+}
+
+//cie_Hash
+test(sha1_and_sha256_must_match_the_fips_180_test_vectors) {
+  const byte abc[] = { 'a', 'b', 'c' };
+  const byte expectedSha1[] = { 0xA9, 0x99, 0x3E, 0x36, 0x47, 0x06, 0x81, 0x6A, 0xBA, 0x3E, 0x25, 0x71, 0x78, 0x50, 0xC2, 0x6C, 0x9C, 0xD0, 0xD8, 0x9D };
+  const byte expectedSha256[] = {
+    0xBA, 0x78, 0x16, 0xBF, 0x8F, 0x01, 0xCF, 0xEA, 0x41, 0x41, 0x40, 0xDE, 0x5D, 0xAE, 0x22, 0x23,
+    0xB0, 0x03, 0x61, 0xA3, 0x96, 0x17, 0x7A, 0x9C, 0xB4, 0x10, 0xFF, 0x61, 0xF2, 0x00, 0x15, 0xAD
+  };
+  cie_Sha1 sha1;
+  byte digestSha1[SHA1_DIGEST_LENGTH];
+  sha1.begin();
+  sha1.update(abc, 1);
+  sha1.update(abc + 1, 2);
+  sha1.finish(digestSha1);
+  cie_Sha256 sha256;
+  byte digestSha256[SHA256_DIGEST_LENGTH];
+  sha256.begin();
+  sha256.update(abc, sizeof(abc));
+  sha256.finish(digestSha256);
+
+  assertEqual(0, memcmp(expectedSha1, digestSha1, SHA1_DIGEST_LENGTH));
+  assertEqual(0, memcmp(expectedSha256, digestSha256, SHA256_DIGEST_LENGTH));
+}
+
+
+//cie_Drbg
+test(chacha_block_must_match_the_rfc_8439_test_vector) {
+  //RFC 8439, section 2.3.2
+  byte key[CHACHA_KEY_LENGTH];
+  for (byte i = 0; i < CHACHA_KEY_LENGTH; i++) {
+    key[i] = i;
+  }
+  const byte nonce[CHACHA_NONCE_LENGTH] = { 0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 0x4A, 0x00, 0x00, 0x00, 0x00 };
+  const byte expected[] = { 0x10, 0xF1, 0xE7, 0xE4, 0xD1, 0x3B, 0x59, 0x15, 0x50, 0x0F, 0xDD, 0x1F, 0xA3, 0x20, 0x71, 0xC4 };
+  byte block[CHACHA_BLOCK_LENGTH];
+  cie_Drbg::chachaBlock(key, 1, nonce, block);
+  assertEqual(0, memcmp(expected, block, sizeof(expected)));
+  assertEqual(0x4E, block[CHACHA_BLOCK_LENGTH - 1]);
 }
 
+test(challenges_must_be_taken_from_the_pool_once) {
+  cie_Nfc_Mock *mock = new cie_Nfc_Mock();
+  cie_PN532 cie(mock);
+  cie.refillChallenges();
+  byte challenge[CHALLENGE_LENGTH];
+  cie.takeChallenge(challenge);
+
+  assertEqual(CHALLENGE_POOL_SIZE - 1, cie._challengeCount);
+  assertEqual(0x01, challenge[0]);
+  //The used slot must not be left in memory
+  assertEqual(0x00, cie._challenges[cie._challengeCount][0]);
+}
+
+
+//cie_DesSecureMessaging
+test(secure_messaging_must_match_the_icao_9303_worked_example) {
+  //ICAO Doc 9303 part 11, appendix D: mutual authentication cryptogram, then a protected SELECT and its response
+  const byte kEnc[SM_KEY_LENGTH] = { 0xAB, 0x94, 0xFD, 0xEC, 0xF2, 0x67, 0x4F, 0xDF, 0xB9, 0xB3, 0x91, 0xF8, 0x5D, 0x7F, 0x76, 0xF2 };
+  const byte kMac[SM_KEY_LENGTH] = { 0x79, 0x62, 0xD9, 0xEC, 0xE0, 0x3D, 0x1A, 0xCD, 0x4C, 0x76, 0x08, 0x9D, 0xCE, 0x13, 0x15, 0x43 };
+  byte s[] = {
+    0x78, 0x17, 0x23, 0x86, 0x0C, 0x06, 0xC2, 0x26, 0x46, 0x08, 0xF9, 0x19, 0x88, 0x70, 0x22, 0x12,
+    0x0B, 0x79, 0x52, 0x40, 0xCB, 0x70, 0x49, 0xB0, 0x1C, 0x19, 0xB3, 0x3E, 0x32, 0x80, 0x4F, 0x0B
+  };
+  const byte expectedCryptogramEnd[] = { 0xAE, 0x2F, 0x49, 0x8F, 0x76, 0xED, 0x92, 0xF2 };
+  const byte expectedMac[SM_MAC_LENGTH] = { 0x5F, 0x14, 0x48, 0xEE, 0xA8, 0xAD, 0x90, 0xA7 };
+  const byte skEnc[SM_KEY_LENGTH] = { 0x97, 0x9E, 0xC1, 0x3B, 0x1C, 0xBF, 0xE9, 0xDC, 0xD0, 0x1A, 0xB0, 0xFE, 0xD3, 0x07, 0xEA, 0xE5 };
+  const byte skMac[SM_KEY_LENGTH] = { 0xF1, 0xCB, 0x1F, 0x1F, 0xB5, 0xAD, 0xF2, 0x08, 0x80, 0x6B, 0x89, 0xDC, 0x57, 0x9D, 0xC1, 0xF8 };
+  const byte ssc[DES_BLOCK_LENGTH] = { 0x88, 0x70, 0x22, 0x12, 0x0C, 0x06, 0xC2, 0x26 };
+  const byte select[] = { 0x00, 0xA4, 0x02, 0x0C, 0x02, 0x01, 0x1E };
+  const byte expectedSelect[] = {
+    0x0C, 0xA4, 0x02, 0x0C, 0x15, 0x87, 0x09, 0x01, 0x63, 0x75, 0x43, 0x29, 0x08, 0xC0, 0x44, 0xF6,
+    0x8E, 0x08, 0xBF, 0x8B, 0x92, 0xD6, 0x35, 0xFF, 0x24, 0xF8, 0x00
+  };
+  const byte response[] = { 0x99, 0x02, 0x90, 0x00, 0x8E, 0x08, 0xFA, 0x85, 0x5A, 0x5D, 0x4C, 0x50, 0xA8, 0xED, 0x90, 0x00 };
+  cie_DesSecureMessaging session;
+  byte mac[SM_MAC_LENGTH];
+  session.setKeys(kEnc, kMac);
+  session.encrypt(s, sizeof(s));
+  session.computeMac(s, sizeof(s), mac);
+  bool cryptogramMatches = memcmp(expectedCryptogramEnd, s + sizeof(s) - sizeof(expectedCryptogramEnd), sizeof(expectedCryptogramEnd)) == 0;
+
+  session.begin(skEnc, skMac, ssc);
+  byte *frame = session.getBuffer();
+  memcpy(frame, select, sizeof(select));
+  word frameLength = session.wrapCommand(sizeof(select));
+  bool selectMatches = frameLength == sizeof(expectedSelect) && memcmp(expectedSelect, frame, frameLength) == 0;
+  memcpy(frame, response, sizeof(response));
+  word responseLength = sizeof(response);
+  bool authentic = session.unwrapResponse(&responseLength);
+
+  assertEqual(true, cryptogramMatches);
+  assertEqual(0, memcmp(expectedMac, mac, SM_MAC_LENGTH));
+  assertEqual(true, selectMatches);
+  assertEqual(true, authentic);
+  assertEqual(STATUS_WORD_LENGTH, responseLength);
+  assertEqual(0x90, frame[0]);
+}
+
+test(secure_messaging_must_reject_an_unprotected_success) {
+  const byte key[SM_KEY_LENGTH] = { 0 };
+  const byte ssc[DES_BLOCK_LENGTH] = { 0 };
+  const byte select[] = { 0x00, 0xA4, 0x02, 0x0C, 0x02, 0x01, 0x1E };
+  cie_DesSecureMessaging session;
+  byte *frame = session.getBuffer();
+
+  session.begin(key, key, ssc);
+  memcpy(frame, select, sizeof(select));
+  session.wrapCommand(sizeof(select));
+  frame[0] = 0x90;
+  frame[1] = 0x00;
+  word successLength = STATUS_WORD_LENGTH;
+  bool successAccepted = session.unwrapResponse(&successLength);
+  bool activeAfterSuccess = session.isActive();
+  session.begin(key, key, ssc);
+  memcpy(frame, select, sizeof(select));
+  session.wrapCommand(sizeof(select));
+  //File not found
+  frame[0] = 0x6A;
+  frame[1] = 0x82;
+  word errorLength = STATUS_WORD_LENGTH;
+  bool errorAccepted = session.unwrapResponse(&errorLength);
+
+  assertEqual(false, successAccepted);
+  assertEqual(false, activeAfterSuccess);
+  assertEqual(true, errorAccepted);
+  assertEqual(false, session.isActive());
+}
+
+test(calculateSk_must_hash_the_xor_of_the_k_values_with_the_key_counter) {
+  cie_Nfc_Mock *mock = new cie_Nfc_Mock();
+  cie_PN532 cie(mock);
+  byte kIfd[K_LENGTH];
+  byte kIcc[K_LENGTH];
+  memset(kIfd, 0x0F, K_LENGTH);
+  memset(kIcc, 0x0F, K_LENGTH);
+  byte skEnc[SK_LENGTH];
+  byte skLength = 0;
+  cie.calculateSk(SK_ENC, kIfd, kIcc, skEnc, &skLength);
+  //SHA-256 of 32 zeroes followed by 00 00 00 01
+  const byte zeroes[K_LENGTH + 4] = { 0 };
+  byte expected[SHA256_DIGEST_LENGTH];
+  cie_Sha256 sha256;
+  sha256.begin();
+  sha256.update(zeroes, K_LENGTH + 3);
+  const byte counter = SK_ENC;
+  sha256.update(&counter, 1);
+  sha256.finish(expected);
+
+  assertEqual(SK_LENGTH, skLength);
+  assertEqual(0, memcmp(expected, skEnc, SK_LENGTH));
+}
+
+//cie_Aes
+test(aes_must_match_the_fips_197_example) {
+  //FIPS 197 appendix C.1
+  const byte key[AES_KEY_LENGTH] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F };
+  const byte plain[AES_BLOCK_LENGTH] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF };
+  const byte expected[AES_BLOCK_LENGTH] = { 0x69, 0xC4, 0xE0, 0xD8, 0x6A, 0x7B, 0x04, 0x30, 0xD8, 0xCD, 0xB7, 0x80, 0x70, 0xB4, 0xC5, 0x5A };
+  cie_Aes aes;
+  byte block[AES_BLOCK_LENGTH];
+  memcpy(block, plain, AES_BLOCK_LENGTH);
+  aes.setKey(key);
+  aes.encryptBlock(block);
+  bool encrypted = memcmp(expected, block, AES_BLOCK_LENGTH) == 0;
+  aes.decryptBlock(block);
+
+  assertEqual(true, encrypted);
+  assertEqual(0, memcmp(plain, block, AES_BLOCK_LENGTH));
+}
+
+
+//cie_AesSecureMessaging
+test(cmac_must_match_the_rfc_4493_examples) {
+  const byte key[AES_KEY_LENGTH] = { 0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6, 0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C };
+  const byte message[] = {
+    0x6B, 0xC1, 0xBE, 0xE2, 0x2E, 0x40, 0x9F, 0x96, 0xE9, 0x3D, 0x7E, 0x11, 0x73, 0x93, 0x17, 0x2A,
+    0xAE, 0x2D, 0x8A, 0x57, 0x1E, 0x03, 0xAC, 0x9C, 0x9E, 0xB7, 0x6F, 0xAC, 0x45, 0xAF, 0x8E, 0x51,
+    0x30, 0xC8, 0x1C, 0x46, 0xA3, 0x5C, 0xE4, 0x11
+  };
+  const byte expectedEmpty[AES_BLOCK_LENGTH] = { 0xBB, 0x1D, 0x69, 0x29, 0xE9, 0x59, 0x37, 0x28, 0x7F, 0xA3, 0x7D, 0x12, 0x9B, 0x75, 0x67, 0x46 };
+  const byte expectedBlock[AES_BLOCK_LENGTH] = { 0x07, 0x0A, 0x16, 0xB4, 0x6B, 0x4D, 0x41, 0x44, 0xF7, 0x9B, 0xDD, 0x9D, 0xD0, 0x4A, 0x28, 0x7C };
+  const byte expectedPartial[AES_BLOCK_LENGTH] = { 0xDF, 0xA6, 0x67, 0x47, 0xDE, 0x9A, 0xE6, 0x30, 0x30, 0xCA, 0x32, 0x61, 0x14, 0x97, 0xC8, 0x27 };
+  cie_AesSecureMessaging session;
+  byte cmac[AES_BLOCK_LENGTH];
+  session.setKeys(key, key);
+  session.computeCmac(message, 0, cmac);
+  bool emptyMatches = memcmp(expectedEmpty, cmac, AES_BLOCK_LENGTH) == 0;
+  session.computeCmac(message, AES_BLOCK_LENGTH, cmac);
+  bool blockMatches = memcmp(expectedBlock, cmac, AES_BLOCK_LENGTH) == 0;
+  session.computeCmac(message, sizeof(message), cmac);
+
+  assertEqual(true, emptyMatches);
+  assertEqual(true, blockMatches);
+  assertEqual(0, memcmp(expectedPartial, cmac, AES_BLOCK_LENGTH));
+}
+
+
+//cie_Ecc
+test(ecc_must_multiply_the_generator_of_both_pace_curves) {
+  const byte scalar[ECC_SCALAR_LENGTH] = {
+    0x01, 0x23, 0x45, 0x67, 0x89, 0x0A, 0xBC, 0xDE, 0xF1, 0x23, 0x45, 0x67, 0x89, 0x0A, 0xBC, 0xDE,
+    0xF1, 0x23, 0x45, 0x67, 0x89, 0x0A, 0xBC, 0xDE, 0xF1, 0x23, 0x45, 0x67, 0x89, 0x0A, 0xBC, 0xDE
+  };
+  const byte expectedP256[ECC_POINT_LENGTH] = {
+    0x04, 0xAF, 0xC7, 0xFC, 0x78, 0xAB, 0xED, 0x66, 0xC3, 0x7C, 0x95, 0x09, 0xA1, 0xC7, 0x5C, 0x3F,
+    0x27, 0x77, 0x3E, 0x70, 0x8F, 0x4D, 0x77, 0xE1, 0xBA, 0x81, 0xFC, 0xC1, 0x77, 0x3E, 0xBC, 0x97,
+    0x80, 0x15, 0x67, 0x5A, 0x55, 0xA6, 0xC6, 0x0A, 0x24, 0x9B, 0x36, 0x0E, 0xC0, 0x23, 0xBE, 0xA1,
+    0xCD, 0xF3, 0xCE, 0x96, 0xAB, 0x5B, 0x57, 0x15, 0xE3, 0xA3, 0xED, 0x9D, 0x6F, 0x71, 0xD1, 0x4E,
+    0xBF
+  };
+  const byte expectedBrainpool[ECC_POINT_LENGTH] = {
+    0x04, 0x18, 0x0C, 0x74, 0x54, 0xE5, 0xA6, 0x82, 0xD4, 0x9C, 0xEA, 0x18, 0xA6, 0x2E, 0x4F, 0x9E,
+    0x0B, 0xB8, 0x21, 0x66, 0x66, 0x11, 0x95, 0x5B, 0xEC, 0xA4, 0x73, 0xD7, 0xE8, 0x31, 0x20, 0xBB,
+    0x70, 0x85, 0xBC, 0xCD, 0x9C, 0x00, 0x14, 0xED, 0x87, 0x24, 0x5E, 0x1D, 0x1A, 0x88, 0x64, 0x4B,
+    0x7E, 0x5E, 0x23, 0x05, 0xC1, 0x4A, 0xB2, 0x51, 0x40, 0x9E, 0x0D, 0x68, 0x41, 0x76, 0x61, 0x85,
+    0xA4
+  };
+  cie_Ecc ecc;
+  byte point[ECC_POINT_LENGTH];
+  ecc.setCurve(ECC_CURVE_NIST_P256);
+  bool p256Multiplied = ecc.multiply(scalar, NULL, point);
+  bool p256Matches = memcmp(expectedP256, point, ECC_POINT_LENGTH) == 0;
+  //A point off the curve must be refused
+  point[ECC_POINT_LENGTH - 1] ^= 0x01;
+  bool offCurve = ecc.isOnCurve(point);
+  ecc.setCurve(ECC_CURVE_BRAINPOOL_P256R1);
+  bool brainpoolMultiplied = ecc.multiply(scalar, NULL, point);
+
+  assertEqual(true, p256Multiplied);
+  assertEqual(true, p256Matches);
+  assertEqual(false, offCurve);
+  assertEqual(true, brainpoolMultiplied);
+  assertEqual(0, memcmp(expectedBrainpool, point, ECC_POINT_LENGTH));
+}
+
+test(ecc_must_refuse_scalars_out_of_range) {
+  byte scalar[ECC_SCALAR_LENGTH];
+  cie_Ecc ecc;
+  ecc.setCurve(ECC_CURVE_NIST_P256);
+  memset(scalar, 0x00, ECC_SCALAR_LENGTH);
+  bool zero = ecc.isValidScalar(scalar);
+  memset(scalar, 0xFF, ECC_SCALAR_LENGTH);
+  bool tooLarge = ecc.isValidScalar(scalar);
+  scalar[0] = 0x7F;
+
+  assertEqual(false, zero);
+  assertEqual(false, tooLarge);
+  assertEqual(true, ecc.isValidScalar(scalar));
+}
+
+test(metrics_must_bucket_latencies_by_powers_of_two) {
+  cie_Metrics metrics;
+  byte success[] = { 0x90, 0x00 };
+  byte warning[] = { 0x62, 0x82 };
+  metrics.record(0xB1, true, success, sizeof(success), 100, 511);
+  metrics.record(0xB0, true, warning, sizeof(warning), 100, 512);
+  metrics.record(0x84, false, success, sizeof(success), 100, 100000);
+  const cie_InsMetrics *readBinary = metrics.get(METRICS_INS_READ_BINARY);
+  const cie_InsMetrics *other = metrics.get(METRICS_INS_OTHER);
+
+  assertEqual(0, cie_Metrics::bucket(0));
+  assertEqual(0, cie_Metrics::bucket(511));
+  assertEqual(1, cie_Metrics::bucket(512));
+  assertEqual(2, cie_Metrics::bucket(1024));
+  assertEqual(METRICS_BUCKET_COUNT - 1, cie_Metrics::bucket(0xFFFFFFFF));
+  assertEqual(512, cie_Metrics::bucketLimit(0));
+  assertEqual(2, readBinary->count);
+  assertEqual(1, readBinary->cardHistogram[0]);
+  assertEqual(1, readBinary->cardHistogram[1]);
+  assertEqual(2, readBinary->transportHistogram[0]);
+  assertEqual(1023, readBinary->cardMicros);
+  assertEqual(1, readBinary->statusWords[METRICS_SW_SUCCESS]);
+  assertEqual(1, readBinary->statusWords[METRICS_SW_WARNING]);
+  assertEqual(1, other->statusWords[METRICS_SW_NO_RESPONSE]);
+  assertEqual(1, other->cardHistogram[METRICS_BUCKET_COUNT - 1]);
+}
 
 void setup(void) {
   #ifndef ESP8266
@@ -9,12 +9,28 @@
 
 	@section  HISTORY
 
+	v1.1  - Host build fixes: the expected commands are allocated and the response length is set
 	v1.0  - Allows the setup of expected commands and baked responses
 */
 /**************************************************************************/
 #include "cie_Nfc_Mock.h"
 
 
+/**************************************************************************/
+/*!
+  @brief  Create with no expected commands
+*/
+/**************************************************************************/
+cie_Nfc_Mock::cie_Nfc_Mock() :
+_expectedCommands(NULL),
+_expectedCommandsCapacity(0),
+_expectedCommandsCount(0),
+_executedCommandsCount(0),
+_attemptedCommandsCount(0)
+{
+}
+
+
 /**************************************************************************/
 /*!
   @brief  Does nothing
@@ -44,7 +60,7 @@ bool cie_Nfc_Mock::detectCard() {
   @param  command A pointer to the APDU command bytes
   @param  commandLength Length of the command
   @param  response A pointer to the buffer which will contain the response bytes
-  @param  responseLength The length of the desired response
+  @param  responseLength The length of the desired response, then the length of the baked response
 
   @returns  A boolean value indicating whether the operation succeeded or not
 */
@@ -59,7 +75,13 @@ bool cie_Nfc_Mock::sendCommand(byte *command, byte commandLength, byte *response
   
   bool isSameCommand = areEqual(command, _expectedCommands[_executedCommandsCount].command, _expectedCommands[_executedCommandsCount].commandOffset, _expectedCommands[_executedCommandsCount].commandLength);
   if (isSameCommand) {
-    memcpy(response, _expectedCommands[_executedCommandsCount].response, *responseLength);
+    cie_Command *expected = &_expectedCommands[_executedCommandsCount];
+    if (expected->responseLength > *responseLength) {
+      Serial.println(F("The baked response doesn't fit the response buffer"));
+      return false;
+    }
+    memcpy(response, expected->response, expected->responseLength);
+    *responseLength = expected->responseLength;
     _executedCommandsCount += 1;
     return true;
   } else {
@@ -89,6 +111,8 @@ void cie_Nfc_Mock::generateRandomBytes(byte *buffer, const word offset, const by
 /**************************************************************************/
 /*!
   @brief Sets the number of commands to expect from the NFC library
+
+  @param count The number of commands, each one set up with expectCommand()
 */
 /**************************************************************************/
 void cie_Nfc_Mock::expectCommands(const byte count) {
@@ -96,7 +120,8 @@ void cie_Nfc_Mock::expectCommands(const byte count) {
   _executedCommandsCount = 0;
   _attemptedCommandsCount = 0;
   _expectedCommandsCount = 0;
-  _expectedCommands = new cie_Command[_expectedCommandsCount];
+  _expectedCommandsCapacity = count;
+  _expectedCommands = new cie_Command[count];
 }
 
 
@@ -113,6 +138,10 @@ void cie_Nfc_Mock::expectCommands(const byte count) {
 */
 /**************************************************************************/
 void cie_Nfc_Mock::expectCommand(byte *command, const byte commandOffset, const byte commandLength, byte *response, const byte responseLength) {
+  if (_expectedCommandsCount >= _expectedCommandsCapacity) {
+    Serial.println(F("More commands set up than announced with expectCommands()"));
+    return;
+  }
   _expectedCommands[_expectedCommandsCount].command = command;
   _expectedCommands[_expectedCommandsCount].commandLength = commandLength;
   _expectedCommands[_expectedCommandsCount].commandOffset = commandOffset;
@@ -154,9 +183,9 @@ bool cie_Nfc_Mock::areEqual(byte *originalBuffer, byte *comparedBuffer, const by
       Serial.print(F(" was not expected (byte "));
       Serial.print(i);
       Serial.print(F(" was different: expected "));
-      printHex(comparedBuffer[i], 1);
+      printHex(&comparedBuffer[i], 1);
       Serial.print(F(" but received "));
-      printHex(originalBuffer[i+offset], 1);
+      printHex(&originalBuffer[i+offset], 1);
       Serial.println(F(")"));
       return false;
     }
@@ -167,15 +196,13 @@ bool cie_Nfc_Mock::areEqual(byte *originalBuffer, byte *comparedBuffer, const by
 
 /**************************************************************************/
 /*!
-  @brief  Frees resources
+  @brief  Frees resources. The commands and the responses belong to the test
 */
 /**************************************************************************/
 void cie_Nfc_Mock::clear() {
-  for (byte i = 0; i < _expectedCommandsCount; i++) {
-    delete [] _expectedCommands[i].command;
-    delete [] _expectedCommands[i].response;
-  }
   delete [] _expectedCommands;
+  _expectedCommands = NULL;
+  _expectedCommandsCapacity = 0;
 }
 
 
@@ -6,6 +6,7 @@
 
 class cie_Nfc_Mock: public cie_Nfc {
   public:
+    cie_Nfc_Mock();
     ~cie_Nfc_Mock();
     void begin();
     bool detectCard();
@@ -13,7 +14,7 @@ class cie_Nfc_Mock: public cie_Nfc {
 
     //unit testing helper functions
     void expectCommands(const byte count);
-    void expectCommand(byte *command, const byte commandLength, const byte commandOffset, word *response, const byte responseLength);
+    void expectCommand(byte *command, const byte commandOffset, const byte commandLength, byte *response, const byte responseLength);
     bool allExpectedCommandsExecuted();
 
   private:
@@ -23,6 +24,7 @@ class cie_Nfc_Mock: public cie_Nfc {
     void generateRandomBytes(byte *buffer, const word offset, const byte length);
 
     cie_Command *_expectedCommands;
+    byte _expectedCommandsCapacity;
     byte _expectedCommandsCount;
     byte _executedCommandsCount;
     byte _attemptedCommandsCount;